@@ -0,0 +1,84 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <print>
+#include <span>
+#include <variant>
+#include <vector>
+
+#include "serpent/arena.hpp"
+#include "serpent/binary.hpp"
+#include "serpent/layout.hpp"
+#include "serpent/value.hpp"
+
+constexpr size_t Iterations = 20;
+
+/// Runs `func` Iterations times and prints the throughput over `bytes` of encoded data
+template <typename TFunc>
+void Measure(char const *name, size_t bytes, TFunc &&func) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < Iterations; i++)
+        func();
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::println("{:<32} {:>8.3f} GB/s", name, double(bytes * Iterations) / elapsed / 1e9);
+}
+
+/// Encodes into a reused buffer, then decodes it back
+template <typename THandle, typename TLayout>
+void Compare(char const *type, THandle const &value, TLayout const &layout) {
+    std::vector<std::byte> buffer {};
+    size_t bytes = Serpent::Encode(value, buffer);
+
+    std::println("{} ({} bytes)", type, bytes);
+
+    Measure("  encode", bytes, [&] {
+        buffer.clear();
+        Serpent::Encode(value, buffer);
+    });
+    Measure("  decode", bytes, [&] {
+        std::span<std::byte const> input {buffer};
+        auto decoded = Serpent::Decode(layout, input);
+    });
+    Measure("  decode, in an ArenaScope", bytes, [&] {
+        Serpent::ArenaScope scope {};
+        std::span<std::byte const> input {buffer};
+        auto decoded = Serpent::Decode(layout, input);
+    });
+}
+
+int main(int argc, char **argv) {
+    constexpr size_t Length = 1 << 22;
+
+    auto floats = Serpent::ArrayLayout::Of(Serpent::FloatingLayout::Float32);
+    auto samples = Serpent::ArrayHandle::Create(floats, Length);
+    for (size_t i = 0; i < Length; i++)
+        samples.Set(i, float(i));
+
+    Compare("Float32 array", samples, floats);
+
+    auto particle = *Serpent::ObjectLayout::Of({
+        Serpent::NamedLayout("x", Serpent::FloatingLayout::Float32),
+        Serpent::NamedLayout("y", Serpent::FloatingLayout::Float32),
+        Serpent::NamedLayout("z", Serpent::FloatingLayout::Float32),
+        Serpent::NamedLayout("vx", Serpent::FloatingLayout::Float32),
+        Serpent::NamedLayout("vy", Serpent::FloatingLayout::Float32),
+        Serpent::NamedLayout("vz", Serpent::FloatingLayout::Float32),
+        Serpent::NamedLayout("age", Serpent::FloatingLayout::Float64),
+        Serpent::NamedLayout("id", Serpent::IntegralLayout::UInt64),
+        Serpent::NamedLayout("color", Serpent::IntegralLayout::UInt32),
+        Serpent::NamedLayout("flags", Serpent::IntegralLayout::UInt16),
+        Serpent::NamedLayout("alive", Serpent::IntegralLayout::Bool),
+    });
+    auto particles = Serpent::ArrayLayout::Of(Serpent::ValueLayout(particle));
+    auto system = Serpent::ArrayHandle::Create(particles, Length / 64);
+    for (size_t i = 0; i < Length / 64; i++) {
+        auto value = Serpent::GcHandle::Create(particle);
+        value.Set("id", uint64_t(i));
+        system.Set(i, value);
+    }
+
+    Compare("Particle object array", system, particles);
+
+    return 0;
+}
@@ -0,0 +1,92 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <print>
+#include <span>
+#include <vector>
+
+#include "serpent/arena.hpp"
+#include "serpent/binary.hpp"
+#include "serpent/bitpack.hpp"
+#include "serpent/layout.hpp"
+#include "serpent/value.hpp"
+
+constexpr size_t Iterations = 20;
+
+/// Runs `func` Iterations times and prints the throughput in entities and in encoded bytes
+template <typename TFunc>
+void Measure(char const *name, size_t entities, size_t bytes, TFunc &&func) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < Iterations; i++)
+        func();
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::println("{:<32} {:>8.2f} M entities/s {:>8.3f} GB/s", name, double(entities * Iterations) / elapsed / 1e6, double(bytes * Iterations) / elapsed / 1e9);
+}
+
+int main(int argc, char **argv) {
+    constexpr size_t Entities = 1 << 16;
+
+    auto state = *Serpent::EnumLayout::Of({"Idle", "Walk", "Run", "Jump", "Attack", "Dead"}, Serpent::IntegralLayout::UInt8);
+    auto team = *Serpent::EnumLayout::Of({"Red", "Blue"}, Serpent::IntegralLayout::UInt8);
+    auto entity = *Serpent::ObjectLayout::Of({
+        Serpent::NamedLayout("id", Serpent::IntegralLayout::UInt32),
+        Serpent::NamedLayout("x", Serpent::FloatingLayout::Float32),
+        Serpent::NamedLayout("y", Serpent::FloatingLayout::Float32),
+        Serpent::NamedLayout("z", Serpent::FloatingLayout::Float32),
+        Serpent::NamedLayout("yaw", Serpent::FloatingLayout::Float32),
+        Serpent::NamedLayout("vx", Serpent::FloatingLayout::Float32),
+        Serpent::NamedLayout("vy", Serpent::FloatingLayout::Float32),
+        Serpent::NamedLayout("health", Serpent::IntegralLayout::Int16),
+        Serpent::NamedLayout("ammo", Serpent::IntegralLayout::UInt16),
+        Serpent::NamedLayout("state", state),
+        Serpent::NamedLayout("team", team),
+        Serpent::NamedLayout("crouching", Serpent::IntegralLayout::Bool),
+        Serpent::NamedLayout("firing", Serpent::IntegralLayout::Bool),
+    });
+
+    auto codec = *Serpent::BitCodec::Of({
+        {entity, "x", -4096, 4096, 20},
+        {entity, "y", -4096, 4096, 20},
+        {entity, "z", -512, 512, 16},
+        {entity, "yaw", -3.1416, 3.1416, 10},
+        {entity, "vx", -64, 64, 12},
+        {entity, "vy", -64, 64, 12},
+    });
+
+    auto snapshot = Serpent::ArrayLayout::Of(Serpent::ValueLayout(entity));
+    auto entities = Serpent::ArrayHandle::Create(snapshot, Entities);
+    for (size_t i = 0; i < Entities; i++) {
+        auto value = Serpent::GcHandle::Create(entity);
+        value.Set("id", uint32_t(i));
+        value.Set("x", float(i % 4000));
+        value.Set("y", float(i % 3000) - 1500);
+        value.Set("yaw", 0.5f);
+        value.Set("vx", 3.25f);
+        value.Set("health", int16_t(100 - i % 100));
+        value.Set("ammo", uint16_t(i % 30));
+        value.Set("state", uint8_t(i % 6));
+        value.Set("team", uint8_t(i % 2));
+        entities.Set(i, value);
+    }
+
+    std::vector<std::byte> buffer {};
+    size_t bytes = codec.Encode(entities, buffer);
+    std::println("Entity snapshot, {} entities: {} bytes bit-packed, {} bytes binary", Entities, bytes, Serpent::EncodedSize(entities));
+
+    Measure("  encode", Entities, bytes, [&] {
+        buffer.clear();
+        codec.Encode(entities, buffer);
+    });
+    Measure("  decode", Entities, bytes, [&] {
+        std::span<std::byte const> input {buffer};
+        auto decoded = codec.Decode(snapshot, input);
+    });
+    Measure("  decode, in an ArenaScope", Entities, bytes, [&] {
+        Serpent::ArenaScope scope {};
+        std::span<std::byte const> input {buffer};
+        auto decoded = codec.Decode(snapshot, input);
+    });
+
+    return 0;
+}
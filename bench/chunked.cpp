@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <print>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "serpent/binary.hpp"
+#include "serpent/layout.hpp"
+#include "serpent/pool.hpp"
+#include "serpent/value.hpp"
+
+constexpr size_t Iterations = 10;
+
+/// Runs `func` Iterations times and returns the throughput over `bytes` of encoded data, in GB/s
+template <typename TFunc>
+double Measure(size_t bytes, TFunc &&func) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < Iterations; i++)
+        func();
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    return double(bytes * Iterations) / elapsed / 1e9;
+}
+
+/// Compares the serial encoding against the chunked one on pools of increasing size
+template <typename TLayout>
+void Compare(char const *type, Serpent::ArrayHandle const &value, TLayout const &layout) {
+    std::vector<std::byte> buffer {};
+    size_t bytes = Serpent::Encode(value, buffer);
+
+    std::println("{} ({} bytes)", type, bytes);
+    std::println("  {:<12} {:>12} {:>12}", "threads", "encode GB/s", "decode GB/s");
+
+    double encode = Measure(bytes, [&] {
+        buffer.clear();
+        Serpent::Encode(value, buffer);
+    });
+    double decode = Measure(bytes, [&] {
+        std::span<std::byte const> input {buffer};
+        auto decoded = Serpent::Decode(layout, input);
+    });
+    std::println("  {:<12} {:>12.3f} {:>12.3f}", "serial", encode, decode);
+
+    size_t hardware = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    for (size_t threads = 1; threads <= hardware; threads *= 2) {
+        Serpent::ThreadPool pool {threads};
+
+        encode = Measure(bytes, [&] {
+            buffer.clear();
+            Serpent::EncodeChunked(value, buffer, 0, pool);
+        });
+        decode = Measure(bytes, [&] {
+            std::span<std::byte const> input {buffer};
+            auto decoded = Serpent::DecodeChunked(layout, input, pool);
+        });
+        std::println("  {:<12} {:>12.3f} {:>12.3f}", threads, encode, decode);
+    }
+}
+
+int main(int argc, char **argv) {
+    constexpr size_t Length = 1 << 24;
+
+    // A 4096x4096 heightmap
+    auto floats = Serpent::ArrayLayout::Of(Serpent::FloatingLayout::Float32);
+    auto terrain = Serpent::ArrayHandle::Create(floats, Length);
+    for (size_t i = 0; i < Length; i++)
+        terrain.Set(i, float(i % 4096) * 0.25f);
+
+    Compare("Terrain heightmap", terrain, floats);
+
+    auto entity = *Serpent::ObjectLayout::Of({
+        Serpent::NamedLayout("x", Serpent::FloatingLayout::Float32),
+        Serpent::NamedLayout("y", Serpent::FloatingLayout::Float32),
+        Serpent::NamedLayout("z", Serpent::FloatingLayout::Float32),
+        Serpent::NamedLayout("yaw", Serpent::FloatingLayout::Float32),
+        Serpent::NamedLayout("health", Serpent::IntegralLayout::Int32),
+        Serpent::NamedLayout("id", Serpent::IntegralLayout::UInt64),
+        Serpent::NamedLayout("name", Serpent::PrimitiveLayout::String),
+        Serpent::NamedLayout("alive", Serpent::IntegralLayout::Bool),
+    });
+    auto entities = Serpent::ArrayLayout::Of(Serpent::ValueLayout(entity));
+    auto list = Serpent::ArrayHandle::Create(entities, Length / 64);
+    for (size_t i = 0; i < Length / 64; i++) {
+        auto value = Serpent::GcHandle::Create(entity);
+        value.Set("id", uint64_t(i));
+        value.Set("name", Serpent::InternedString(i % 2 ? "orc" : "goblin"));
+        list.Set(i, value);
+    }
+
+    Compare("Entity list", list, entities);
+
+    return 0;
+}
@@ -0,0 +1,77 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <print>
+#include <variant>
+#include <vector>
+
+#include "serpent/index.hpp"
+#include "serpent/layout.hpp"
+#include "serpent/value.hpp"
+
+constexpr size_t Entities = 1 << 17;
+constexpr size_t Lookups = 1 << 12;
+/// Scans take long enough that fewer of them are needed
+constexpr size_t Scans = 1 << 6;
+
+/// Runs func count times and returns the average time per call in nanoseconds
+template <typename TFunc>
+double Measure(size_t count, TFunc &&func) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; i++)
+        func(i);
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    return elapsed / double(count);
+}
+
+int main(int argc, char **argv) {
+    auto entity = *Serpent::ObjectLayout::Of({
+        Serpent::NamedLayout("id", Serpent::IntegralLayout::UInt64),
+        Serpent::NamedLayout("owner", Serpent::IntegralLayout::UInt32),
+        Serpent::NamedLayout("health", Serpent::FloatingLayout::Float32),
+    });
+
+    auto entities = Serpent::ArrayHandle::Create(Serpent::ArrayLayout::Of(entity), Entities);
+    for (size_t i = 0; i < Entities; i++) {
+        auto value = Serpent::GcHandle::Create(entity);
+        // Ids are scattered so the array isn't accidentally sorted by them
+        value.Set("id", uint64_t(i * 2654435761u % Entities));
+        value.Set("owner", uint32_t(i % 1024));
+        value.Set("health", float(i % 100));
+        entities.Set(i, value);
+    }
+
+    auto byId = *Serpent::FieldIndex::Of(entities, "id", Serpent::IndexKind::Hash);
+    auto byHealth = *Serpent::FieldIndex::Of(entities, "health", Serpent::IndexKind::Sorted);
+    volatile size_t sink = 0;
+
+    double scan = Measure(Scans, [&](size_t i) {
+        uint64_t id = i * 7919 % Entities;
+        for (size_t j = 0; j < Entities; j++) {
+            auto value = std::get<Serpent::GcHandle>(entities.Get(j));
+            if (std::get<uint64_t>(value.Get(size_t(0))) == id) {
+                sink = j;
+                break;
+            }
+        }
+    });
+    double hashed = Measure(Lookups, [&](size_t i) {
+        sink = *byId.Find(uint64_t(i * 7919 % Entities));
+    });
+
+    std::vector<size_t> positions {};
+    double ranged = Measure(Lookups, [&](size_t i) {
+        positions.clear();
+        float low = float(i % 99);
+        byHealth.Range(low, low + 1.0f, positions);
+        sink = positions.size();
+    });
+
+    std::println("{:<24} {:>16}", "lookup", "ns per lookup");
+    std::println("{:<24} {:>16.1f}", "scan by id", scan);
+    std::println("{:<24} {:>16.1f}", "hash index by id", hashed);
+    std::println("{:<24} {:>16.1f}", "sorted range of health", ranged);
+
+    return 0;
+}
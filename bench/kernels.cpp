@@ -0,0 +1,109 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <print>
+#include <variant>
+
+#include "serpent/kernels.hpp"
+#include "serpent/layout.hpp"
+#include "serpent/value.hpp"
+
+constexpr size_t Length = 1 << 20;
+constexpr size_t Iterations = 20;
+
+/// Runs `func` Iterations times and prints the average time per element
+template <typename TFunc>
+void Measure(char const *name, TFunc &&func) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < Iterations; i++)
+        func();
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    std::println("{:<32} {:>8.3f} ns/element", name, elapsed / double(Iterations * Length));
+}
+
+template <typename T>
+void Compare(char const *type, Serpent::ValueLayout element) {
+    auto array = Serpent::ArrayHandle::Create(Serpent::ArrayLayout::Of(std::move(element)), Length);
+    auto other = Serpent::ArrayHandle::Create(Serpent::ArrayLayout::Of(Serpent::ValueLayout(array.Layout())), Length);
+    volatile T sink = 0;
+
+    std::println("{}", type);
+
+    Measure("  fill, per-element Set", [&] {
+        for (size_t i = 0; i < Length; i++)
+            array.Set(i, T(1));
+    });
+    Measure("  fill, kernel", [&] {
+        Serpent::Fill(array, T(1));
+        Serpent::Fill(other, T(2));
+    });
+
+    Measure("  sum, per-element Get", [&] {
+        T sum = 0;
+        for (size_t i = 0; i < Length; i++)
+            sum += std::get<T>(array.Get(i));
+        sink = sum;
+    });
+    Measure("  sum, kernel", [&] {
+        auto sum = Serpent::Sum(array);
+        sink = std::visit([](auto value) -> T {
+            if constexpr (std::is_arithmetic_v<decltype(value)>)
+                return T(value);
+            else
+                return 0;
+        }, sum);
+    });
+
+    Measure("  max, per-element Get", [&] {
+        T max = std::get<T>(array.Get(0));
+        for (size_t i = 1; i < Length; i++)
+            max = std::max(max, std::get<T>(array.Get(i)));
+        sink = max;
+    });
+    Measure("  max, kernel", [&] {
+        sink = std::get<T>(Serpent::Max(array));
+    });
+
+    Measure("  add, per-element Get/Set", [&] {
+        for (size_t i = 0; i < Length; i++)
+            array.Set(i, T(std::get<T>(array.Get(i)) + T(1)));
+    });
+    Measure("  add, kernel", [&] {
+        Serpent::Add(array, T(1));
+    });
+
+    Measure("  clamp, per-element Get/Set", [&] {
+        for (size_t i = 0; i < Length; i++)
+            array.Set(i, std::clamp(std::get<T>(array.Get(i)), T(0), T(8)));
+    });
+    Measure("  clamp, kernel", [&] {
+        Serpent::Clamp(array, T(0), T(8));
+    });
+
+    Measure("  dot, per-element Get", [&] {
+        T sum = 0;
+        for (size_t i = 0; i < Length; i++)
+            sum += std::get<T>(array.Get(i)) * std::get<T>(other.Get(i));
+        sink = sum;
+    });
+    Measure("  dot, kernel", [&] {
+        auto dot = Serpent::Dot(array, other);
+        sink = std::visit([](auto value) -> T {
+            if constexpr (std::is_arithmetic_v<decltype(value)>)
+                return T(value);
+            else
+                return 0;
+        }, dot);
+    });
+}
+
+int main(int argc, char **argv) {
+    Compare<float>("Float32", Serpent::FloatingLayout::Float32);
+    Compare<double>("Float64", Serpent::FloatingLayout::Float64);
+    Compare<int32_t>("Int32", Serpent::IntegralLayout::Int32);
+    Compare<uint8_t>("UInt8", Serpent::IntegralLayout::UInt8);
+
+    return 0;
+}
@@ -0,0 +1,100 @@
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <print>
+#include <thread>
+#include <variant>
+
+#include "serpent/layout.hpp"
+#include "serpent/pool.hpp"
+#include "serpent/value.hpp"
+
+constexpr size_t Length = 1 << 20;
+constexpr size_t Iterations = 10;
+
+/// Mirrors the particle layout below
+struct Particle {
+    float x, y, z;
+    float vx, vy, vz;
+    float life;
+    uint32_t flags;
+};
+
+/// Runs `func` Iterations times and returns the average time per element, in nanoseconds
+template <typename TFunc>
+double Measure(TFunc &&func) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < Iterations; i++)
+        func();
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    return elapsed / double(Iterations * Length);
+}
+
+int main(int argc, char **argv) {
+    auto particle = *Serpent::ObjectLayout::Of({
+        Serpent::NamedLayout("x", Serpent::FloatingLayout::Float32),
+        Serpent::NamedLayout("y", Serpent::FloatingLayout::Float32),
+        Serpent::NamedLayout("z", Serpent::FloatingLayout::Float32),
+        Serpent::NamedLayout("vx", Serpent::FloatingLayout::Float32),
+        Serpent::NamedLayout("vy", Serpent::FloatingLayout::Float32),
+        Serpent::NamedLayout("vz", Serpent::FloatingLayout::Float32),
+        Serpent::NamedLayout("life", Serpent::FloatingLayout::Float32),
+        Serpent::NamedLayout("flags", Serpent::IntegralLayout::UInt32),
+    });
+
+    auto particles = Serpent::ArrayHandle::Create(Serpent::ArrayLayout::Of(Serpent::ValueLayout(particle)), Length);
+    for (size_t i = 0; i < Length; i++) {
+        auto value = Serpent::GcHandle::Create(particle);
+        value.Set("vx", std::sin(float(i)));
+        value.Set("vy", 1.0f);
+        value.Set("vz", std::cos(float(i)));
+        value.Set("life", 10.0f);
+        particles.Set(i, value);
+    }
+
+    auto floats = Serpent::ArrayLayout::Of(Serpent::FloatingLayout::Float32);
+    auto heights = Serpent::ArrayHandle::Create(floats, Length);
+    auto slopes = Serpent::ArrayHandle::Create(floats, Length);
+
+    std::println("{:<10} {:>16} {:>16} {:>16} {:>16}", "threads", "update ns/elem", "sum ns/elem", "erode ns/elem", "speed-up");
+
+    double baseline = 0;
+    size_t hardware = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    for (size_t threads = 1; threads <= hardware; threads *= 2) {
+        Serpent::ThreadPool pool {threads};
+
+        double update = Measure([&] {
+            pool.ForEach<Particle>(particles, [](Particle &p) {
+                p.vy -= 9.81f / 60.0f;
+                p.x += p.vx / 60.0f;
+                p.y += p.vy / 60.0f;
+                p.z += p.vz / 60.0f;
+                p.life -= 1.0f / 60.0f;
+                p.flags |= p.life <= 0.0f;
+            });
+        });
+
+        volatile double sink = 0;
+        double sum = Measure([&] {
+            sink = *pool.Reduce<Particle>(
+                particles,
+                0.0,
+                [](double energy, Particle const &p) { return energy + double(p.vx * p.vx + p.vy * p.vy + p.vz * p.vz); },
+                [](double lhs, double rhs) { return lhs + rhs; }
+            );
+        });
+
+        double erode = Measure([&] {
+            pool.Map<float, float>(heights, slopes, [](float height) { return std::sqrt(std::abs(height) + 1.0f) * 0.5f; });
+        });
+
+        if (threads == 1)
+            baseline = update;
+
+        std::println("{:<10} {:>16.3f} {:>16.3f} {:>16.3f} {:>15.2f}x", threads, update, sum, erode, baseline / update);
+    }
+
+    return 0;
+}
@@ -0,0 +1,79 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <print>
+#include <span>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+#include "serpent/layout.hpp"
+#include "serpent/query.hpp"
+#include "serpent/value.hpp"
+
+constexpr size_t Entities = 1 << 17;
+constexpr size_t Iterations = 1 << 6;
+
+/// Runs func count times and returns the average time per call in nanoseconds
+template <typename TFunc>
+double Measure(size_t count, TFunc &&func) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; i++)
+        func(i);
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    return elapsed / double(count);
+}
+
+int main(int argc, char **argv) {
+    auto entity = *Serpent::ObjectLayout::Of({
+        Serpent::NamedLayout("id", Serpent::IntegralLayout::UInt64),
+        Serpent::NamedLayout("team", Serpent::IntegralLayout::UInt32),
+        Serpent::NamedLayout("health", Serpent::FloatingLayout::Float32),
+    });
+
+    auto entities = Serpent::ArrayHandle::Create(Serpent::ArrayLayout::Of(Serpent::ValueLayout(entity)), Entities);
+    for (size_t i = 0; i < Entities; i++) {
+        auto value = Serpent::GcHandle::Create(entity);
+        value.Set("id", uint64_t(i));
+        value.Set("team", uint32_t(i * 2654435761u % 4));
+        value.Set("health", float(i * 40503u % 100));
+        entities.Set(i, value);
+    }
+
+    Serpent::Predicate predicates[] = {
+        {"health", Serpent::CompareOp::Less, 10.0f},
+        {"team", Serpent::CompareOp::Equal, uint32_t(2)},
+    };
+    auto query = *Serpent::Query::Of(entity, predicates);
+
+    std::string_view fields[] = {"id"};
+    auto projection = *Serpent::Projection::Of(entity, fields);
+
+    std::vector<uint64_t> ids(Entities);
+    volatile size_t sink = 0;
+
+    double handles = Measure(Iterations, [&](size_t) {
+        size_t count = 0;
+        for (size_t j = 0; j < Entities; j++) {
+            auto value = std::get<Serpent::GcHandle>(entities.Get(j));
+            if (std::get<float>(value.Get(size_t(2))) < 10.0f && std::get<uint32_t>(value.Get(size_t(1))) == 2)
+                ids[count++] = std::get<uint64_t>(value.Get(size_t(0)));
+        }
+        sink = count;
+    });
+
+    Serpent::Selection selection {};
+    std::span<std::byte> columns[] = {std::as_writable_bytes(std::span(ids))};
+    double queried = Measure(Iterations, [&](size_t) {
+        query.Select(entities, selection);
+        projection.Project(entities, selection, columns);
+        sink = selection.Count();
+    });
+
+    std::println("{:<24} {:>16} {:>16}", "filter", "us per pass", "ns per element");
+    std::println("{:<24} {:>16.1f} {:>16.2f}", "handles", handles / 1000, handles / Entities);
+    std::println("{:<24} {:>16.1f} {:>16.2f}", "query and projection", queried / 1000, queried / Entities);
+
+    return 0;
+}
@@ -0,0 +1,113 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <print>
+#include <thread>
+#include <vector>
+
+#include "serpent/layout.hpp"
+#include "serpent/queue.hpp"
+
+constexpr size_t Records = 1 << 21;
+
+/// Mirrors the damage event layout below
+struct Damage {
+    uint32_t source;
+    uint32_t target;
+    float amount;
+    uint32_t kind;
+};
+
+/// Runs producers that emit Records events in total while the calling thread consumes them, returns millions of records per second
+template <typename TProduce, typename TConsume>
+double Measure(size_t producers, TProduce &&produce, TConsume &&consume) {
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::jthread> threads {};
+    for (size_t i = 0; i < producers; i++)
+        threads.emplace_back([&produce, i, producers] { produce(i, Records / producers); });
+
+    size_t consumed = 0;
+    while (consumed < Records) {
+        size_t count = consume();
+        if (count == 0)
+            std::this_thread::yield();
+
+        consumed += count;
+    }
+
+    threads.clear();
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    return double(Records) / elapsed / 1e6;
+}
+
+int main(int argc, char **argv) {
+    auto damage = *Serpent::ObjectLayout::Of({
+        Serpent::NamedLayout("source", Serpent::IntegralLayout::UInt32),
+        Serpent::NamedLayout("target", Serpent::IntegralLayout::UInt32),
+        Serpent::NamedLayout("amount", Serpent::FloatingLayout::Float32),
+        Serpent::NamedLayout("kind", Serpent::IntegralLayout::UInt32),
+    });
+
+    std::println("{:<12} {:>20} {:>20}", "producers", "mutex M records/s", "queue M records/s");
+
+    for (size_t producers : {1, 2, 4, 8}) {
+        std::mutex mutex {};
+        std::vector<Damage> pending {};
+        std::vector<Damage> drained {};
+        volatile float sink = 0;
+
+        double locked = Measure(
+            producers,
+            [&](size_t source, size_t count) {
+                for (size_t i = 0; i < count; i++) {
+                    std::unique_lock<std::mutex> lock {mutex};
+                    pending.push_back(Damage {uint32_t(source), uint32_t(i), 1.0f, 0});
+                }
+            },
+            [&] {
+                {
+                    std::unique_lock<std::mutex> lock {mutex};
+                    drained.swap(pending);
+                }
+
+                for (auto const &event : drained)
+                    sink = sink + event.amount;
+
+                size_t count = drained.size();
+                drained.clear();
+                return count;
+            }
+        );
+
+        auto queue = *Serpent::RecordQueue::Of(damage, 4096);
+        double lockFree = Measure(
+            producers,
+            [&](size_t source, size_t count) {
+                for (size_t i = 0; i < count;) {
+                    bool pushed = queue.Push([&](void *record) {
+                        Damage event {uint32_t(source), uint32_t(i), 1.0f, 0};
+                        std::memcpy(record, &event, sizeof(event));
+                    });
+
+                    if (pushed)
+                        i++;
+                    else
+                        std::this_thread::yield();
+                }
+            },
+            [&] {
+                return queue.Drain([&](void const *record) {
+                    sink = sink + static_cast<Damage const *>(record)->amount;
+                });
+            }
+        );
+
+        std::println("{:<12} {:>20.2f} {:>20.2f}", producers, locked, lockFree);
+    }
+
+    return 0;
+}
@@ -0,0 +1,121 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <print>
+#include <thread>
+#include <variant>
+#include <vector>
+
+#include "serpent/layout.hpp"
+#include "serpent/refcount.hpp"
+#include "serpent/value.hpp"
+
+constexpr size_t Entities = 1 << 12;
+constexpr size_t Iterations = 200;
+constexpr size_t Threads = 4;
+
+struct Layouts final {
+    Serpent::Rc<Serpent::GcLayout const> transform;
+    Serpent::Rc<Serpent::GcLayout const> entity;
+};
+
+/// Field indices, so that the measurement isn't dominated by name lookups
+size_t TransformField = 0;
+size_t XField = 0;
+
+Layouts MakeLayouts() {
+    auto transform = *Serpent::ObjectLayout::Of({
+        Serpent::NamedLayout("x", Serpent::FloatingLayout::Float32),
+        Serpent::NamedLayout("y", Serpent::FloatingLayout::Float32),
+    });
+    auto entity = *Serpent::ObjectLayout::Of({
+        Serpent::NamedLayout("transform", transform),
+        Serpent::NamedLayout("id", Serpent::IntegralLayout::Int32),
+    });
+
+    TransformField = *std::get<Serpent::ObjectLayout>(*entity).IndexOf(Serpent::InternedString("transform"));
+    XField = *std::get<Serpent::ObjectLayout>(*transform).IndexOf(Serpent::InternedString("x"));
+
+    return {transform, entity};
+}
+
+std::vector<Serpent::GcHandle> MakeEntities(Layouts const &layouts) {
+    std::vector<Serpent::GcHandle> entities {};
+    entities.reserve(Entities);
+
+    for (size_t i = 0; i < Entities; i++) {
+        auto entity = Serpent::GcHandle::Create(layouts.entity);
+        entity.Set("transform", Serpent::GcHandle::Create(layouts.transform));
+        entity.Set("id", int32_t(i));
+        entities.push_back(std::move(entity));
+    }
+
+    return entities;
+}
+
+/// Creates the entities on a thread that exits straight away, so every reference count goes through the shared atomic count,
+/// which is what every reference count did before biasing
+std::vector<Serpent::GcHandle> MakeForeignEntities(Layouts const &layouts) {
+    std::vector<Serpent::GcHandle> entities {};
+    std::thread([&] { entities = MakeEntities(layouts); }).join();
+
+    return entities;
+}
+
+/// A script-like update, every step copies handles around the way a script binding would
+void Update(std::vector<Serpent::GcHandle> const &entities) {
+    for (size_t i = 0; i < Iterations; i++) {
+        for (auto const &entity : entities) {
+            Serpent::GcHandle self = entity;
+            auto transform = std::get<Serpent::GcHandle>(self.Get(TransformField));
+            transform.Set(XField, std::get<float>(transform.Get(XField)) + 1.0f);
+            self.Set(TransformField, transform);
+        }
+    }
+}
+
+template <typename TFunc>
+void Measure(char const *name, size_t operations, TFunc &&func) {
+    auto start = std::chrono::steady_clock::now();
+    func();
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    std::println("{:<40} {:>8.3f} ns/update", name, elapsed / double(operations));
+}
+
+int main(int argc, char **argv) {
+    auto layouts = MakeLayouts();
+
+    {
+        auto owned = MakeEntities(layouts);
+        auto foreign = MakeForeignEntities(layouts);
+
+        Measure("1 thread, atomic counts", Entities * Iterations, [&] { Update(foreign); });
+        Measure("1 thread, biased counts", Entities * Iterations, [&] { Update(owned); });
+    }
+
+    {
+        std::vector<std::vector<Serpent::GcHandle>> foreign {};
+        for (size_t i = 0; i < Threads; i++)
+            foreign.push_back(MakeForeignEntities(layouts));
+
+        Measure("4 threads, atomic counts", Threads * Entities * Iterations, [&] {
+            std::vector<std::jthread> threads {};
+            for (size_t i = 0; i < Threads; i++)
+                threads.emplace_back([&, i] { Update(foreign[i]); });
+        });
+    }
+
+    Measure("4 threads, biased counts", Threads * Entities * Iterations, [&] {
+        std::vector<std::jthread> threads {};
+        for (size_t i = 0; i < Threads; i++) {
+            threads.emplace_back([&] {
+                auto owned = MakeEntities(layouts);
+                Update(owned);
+                Serpent::MergeReleased();
+            });
+        }
+    });
+
+    return 0;
+}
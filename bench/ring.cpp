@@ -0,0 +1,94 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <print>
+#include <span>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include "serpent/binary.hpp"
+#include "serpent/image.hpp"
+#include "serpent/layout.hpp"
+#include "serpent/ring.hpp"
+#include "serpent/value.hpp"
+
+constexpr size_t Records = 1 << 18;
+constexpr size_t Batch = 64;
+
+/// Runs func Records / Batch times, each handing over Batch records, returns millions of records per second
+template <typename TFunc>
+double Measure(TFunc &&func) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < Records / Batch; i++)
+        func();
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    return double(Records) / elapsed / 1e6;
+}
+
+int main(int argc, char **argv) {
+    auto position = *Serpent::ObjectLayout::Of({
+        Serpent::NamedLayout("x", Serpent::FloatingLayout::Float32),
+        Serpent::NamedLayout("y", Serpent::FloatingLayout::Float32),
+        Serpent::NamedLayout("z", Serpent::FloatingLayout::Float32),
+    });
+    auto update = *Serpent::ObjectLayout::Of({
+        Serpent::NamedLayout("entity", Serpent::IntegralLayout::UInt64),
+        Serpent::NamedLayout("zone", Serpent::PrimitiveLayout::String),
+        Serpent::NamedLayout("position", position),
+    });
+
+    std::vector<Serpent::GcHandle> values {};
+    for (size_t i = 0; i < Batch; i++) {
+        auto at = Serpent::GcHandle::Create(position);
+        at.Set("x", float(i));
+
+        auto value = Serpent::GcHandle::Create(update);
+        value.Set("entity", uint64_t(i));
+        value.Set("zone", Serpent::InternedString("zone-" + std::to_string(i % 8)));
+        value.Set("position", at);
+        values.push_back(value);
+    }
+
+    volatile float sink = 0;
+
+    // Binary encoding through a buffer, which the reader decodes into new values before reading them
+    std::vector<std::byte> buffer {};
+    double encoded = Measure([&] {
+        buffer.clear();
+        for (auto const &value : values)
+            Serpent::Encode(value, buffer);
+
+        std::span<std::byte const> input {buffer};
+        for (size_t i = 0; i < Batch; i++) {
+            auto decoded = Serpent::Decode(update, input);
+            auto at = std::get<Serpent::GcHandle>(decoded->Get(2));
+            sink = sink + std::get<float>(at.Get(0));
+        }
+    });
+
+    // Shared ring, which the reader reads in place
+    Serpent::SharedRing::Unlink("serpent_bench_ring");
+    auto ring = *Serpent::SharedRing::Create("serpent_bench_ring", update, size_t(1) << 20);
+    Serpent::SharedRing::Unlink("serpent_bench_ring");
+
+    double shared = Measure([&] {
+        for (auto const &value : values)
+            ring.Push(value);
+
+        for (size_t i = 0; i < Batch; i++) {
+            auto image = ring.Front();
+            auto root = std::get<Serpent::ImageObject>(image->Root());
+            auto at = std::get<Serpent::ImageObject>(root.Get(2));
+            sink = sink + std::get<float>(at.Get(0));
+            ring.Pop();
+        }
+    });
+
+    std::println("{:<12} {:>20}", "transport", "M records/s");
+    std::println("{:<12} {:>20.2f}", "binary", encoded);
+    std::println("{:<12} {:>20.2f}", "ring", shared);
+
+    return 0;
+}
@@ -0,0 +1,112 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <print>
+#include <span>
+#include <variant>
+#include <vector>
+
+#include "serpent/layout.hpp"
+#include "serpent/value.hpp"
+#include "serpent/vertex.hpp"
+
+constexpr size_t Length = 1 << 18;
+constexpr size_t Iterations = 20;
+
+/// Runs `func` Iterations times and prints the average time per vertex
+template <typename TFunc>
+void Measure(char const *name, TFunc &&func) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < Iterations; i++)
+        func();
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    std::println("{:<40} {:>8.3f} ns/vertex", name, elapsed / double(Iterations * Length));
+}
+
+int16_t Snorm16(double value) {
+    return int16_t(std::lround(std::clamp(value, -1.0, 1.0) * 32767.0));
+}
+
+int main(int argc, char **argv) {
+    // A mesh as an editor or importer keeps it, in double precision
+    auto vertex = *Serpent::ObjectLayout::Of({
+        Serpent::NamedLayout("px", Serpent::FloatingLayout::Float64),
+        Serpent::NamedLayout("py", Serpent::FloatingLayout::Float64),
+        Serpent::NamedLayout("pz", Serpent::FloatingLayout::Float64),
+        Serpent::NamedLayout("nx", Serpent::FloatingLayout::Float64),
+        Serpent::NamedLayout("ny", Serpent::FloatingLayout::Float64),
+        Serpent::NamedLayout("nz", Serpent::FloatingLayout::Float64),
+        Serpent::NamedLayout("u", Serpent::FloatingLayout::Float32),
+        Serpent::NamedLayout("v", Serpent::FloatingLayout::Float32),
+    });
+
+    auto mesh = Serpent::ArrayHandle::Create(Serpent::ArrayLayout::Of(Serpent::ValueLayout(vertex)), Length);
+    for (size_t i = 0; i < Length; i++) {
+        auto value = Serpent::GcHandle::Create(vertex);
+        double angle = double(i) * 0.001;
+        value.Set("px", std::cos(angle) * 10.0);
+        value.Set("py", double(i % 512) * 0.1);
+        value.Set("pz", std::sin(angle) * 10.0);
+        value.Set("nx", std::cos(angle));
+        value.Set("nz", std::sin(angle));
+        value.Set("u", float(i % 1024) / 1024.0f);
+        value.Set("v", float(i / 1024) / 256.0f);
+        mesh.Set(i, value);
+    }
+
+    // Float32 positions, Int16 normalized normals padded to 4 bytes and Float32 uvs, 28 bytes per vertex
+    Serpent::VertexAttribute const attributes[] {
+        {{"px", "py", "pz"}, Serpent::FloatingLayout::Float32},
+        {{"nx", "ny", "nz"}, Serpent::IntegralLayout::Int16, {.normalized = true}},
+        {{"u", "v"}, Serpent::FloatingLayout::Float32},
+    };
+
+    auto interleaved = *Serpent::VertexFormat::Of(vertex, attributes);
+    auto separate = *Serpent::VertexFormat::Of(vertex, attributes, Serpent::VertexStreams::Separate);
+
+    std::vector<std::byte> buffer(interleaved.Stride(0) * Length);
+    std::vector<std::vector<std::byte>> buffers {};
+    std::vector<std::span<std::byte>> spans {};
+    for (size_t i = 0; i < separate.Streams(); i++)
+        buffers.emplace_back(separate.Stride(i) * Length);
+    for (auto &stream : buffers)
+        spans.emplace_back(stream);
+
+    std::println("Vertex export, {} bytes per vertex", interleaved.Stride(0));
+
+    Measure("  interleaved, per-vertex Get", [&] {
+        for (size_t i = 0; i < Length; i++) {
+            auto value = std::get<Serpent::GcHandle>(mesh.Get(i));
+            std::byte *out = buffer.data() + i * 28;
+
+            float position[3] {
+                float(std::get<double>(value.Get("px"))),
+                float(std::get<double>(value.Get("py"))),
+                float(std::get<double>(value.Get("pz"))),
+            };
+            int16_t normal[3] {
+                Snorm16(std::get<double>(value.Get("nx"))),
+                Snorm16(std::get<double>(value.Get("ny"))),
+                Snorm16(std::get<double>(value.Get("nz"))),
+            };
+            float uv[2] {std::get<float>(value.Get("u")), std::get<float>(value.Get("v"))};
+
+            std::memcpy(out, position, sizeof(position));
+            std::memcpy(out + 12, normal, sizeof(normal));
+            std::memcpy(out + 20, uv, sizeof(uv));
+        }
+    });
+    Measure("  interleaved, VertexFormat", [&] {
+        std::span<std::byte> const streams[] {buffer};
+        interleaved.Export(mesh, streams);
+    });
+    Measure("  separate, VertexFormat", [&] {
+        separate.Export(mesh, spans);
+    });
+
+    return 0;
+}
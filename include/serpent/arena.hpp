@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+#include "serpent/api.hpp"
+#include "serpent/value.hpp"
+
+namespace Serpent {
+    struct Arena;
+
+    /// While a scope is alive, every GC value the thread creates is bump allocated from the scope's memory, for values that only live for a frame or a packet.
+    /// Arena values are never freed by reference counting, the scope frees them all at once when it ends, only releasing what they reference outside the arena.
+    /// Scopes nest, each new scope takes over allocation until it ends, and must end on the thread that started it and before its parent.
+    /// A thread can nest at most 255 scopes, starting another one aborts.
+    ///
+    /// A value may only reference values that live at least as long as it does, so Set refuses to store an arena value into a heap value or into a value from an outer scope.
+    /// Values that need to outlive the scope are copied out with Promote. Every handle to an arena value must be dropped before its scope ends,
+    /// debug builds assert when a scope ends with any left.
+    /// Arena values still count the handles and values sharing them, so MakeUnique, GetUnique and writes after a Snapshot copy them like heap values.
+    /// The copies are made in the same scope, which means arena values may only be copied on the thread that started it
+    struct SERPENT_API ArenaScope final {
+        private:
+        std::unique_ptr<Arena> arena;
+
+        public:
+        explicit ArenaScope(size_t chunkSize = 64 * 1024);
+        ArenaScope(ArenaScope const &copy) = delete;
+        ArenaScope(ArenaScope &&move) = delete;
+
+        ~ArenaScope();
+
+        ArenaScope &operator = (ArenaScope const &copy) = delete;
+        ArenaScope &operator = (ArenaScope &&move) = delete;
+
+        /// Bytes handed out to values so far
+        size_t Used() const;
+    };
+
+    /// Copies the arena values in the graph to the heap, heap and frozen values are shared with the original.
+    /// Values already on the heap are returned as they are
+    SERPENT_API GcHandle Promote(GcHandle const &value);
+    SERPENT_API ArrayHandle Promote(ArrayHandle const &value);
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "serpent/api.hpp"
+#include "serpent/layout.hpp"
+#include "serpent/pool.hpp"
+#include "serpent/value.hpp"
+
+namespace Serpent {
+    /// Compact binary encoding of values, driven by a plan compiled once per layout.
+    /// Fields are written in declaration order without padding, and everything is little endian regardless of the host.
+    /// Plain fields that sit next to each other in memory are copied as a single run, so on little endian hosts scalar-heavy values encode with memcpy.
+    /// Strings are a uint32 byte count followed by the bytes. Object and array fields are a presence byte, then the value if it's 1.
+    /// Arrays are a uint64 length followed by their elements, a variant is its tag at its TagSize followed by the active payload.
+    /// Values are written as trees, a child referenced from two fields is written twice and decodes as two separate values.
+    ///
+    /// The encoding carries no layout information, the decoder must be given the same layout the value was encoded with.
+
+    /// Number of bytes Encode writes for the value
+    SERPENT_API size_t EncodedSize(GcHandle const &value);
+    SERPENT_API size_t EncodedSize(ArrayHandle const &value);
+
+    /// Appends the value's encoding to out, returns the number of bytes appended
+    SERPENT_API size_t Encode(GcHandle const &value, std::vector<std::byte> &out);
+    SERPENT_API size_t Encode(ArrayHandle const &value, std::vector<std::byte> &out);
+
+    /// Decodes a value from the front of input, then advances input past it. Values are created inside the current ArenaScope, if any.
+    /// Returns nullopt and leaves input untouched if it's truncated or malformed: presence bytes other than 0 or 1,
+    /// Bools other than 0 or 1, enum values without a name, or variant tags out of range
+    SERPENT_API std::optional<GcHandle> Decode(Rc<GcLayout const> const &layout, std::span<std::byte const> &input);
+    SERPENT_API std::optional<ArrayHandle> Decode(ArrayLayout const &layout, std::span<std::byte const> &input);
+
+    /// Chunked encoding of arrays, for large arrays that are encoded and decoded in parallel on a ThreadPool.
+    /// The elements are split into chunks of chunkLength elements, the last one shorter, and each chunk holds its elements as an array's would, without the length.
+    /// An index comes first: the uint64 length, the uint64 chunkLength, then the uint64 byte size of each chunk. The chunks follow in order.
+    /// Chunks are measured and written in parallel, then decoded in parallel straight into the one array, so nothing has to be stitched together afterwards.
+
+    /// Appends the array's chunked encoding to out, returns the number of bytes appended.
+    /// A chunkLength of 0 picks one that gives each of the pool's threads a few chunks
+    SERPENT_API size_t EncodeChunked(ArrayHandle const &value, std::vector<std::byte> &out, size_t chunkLength = 0, ThreadPool &pool = ThreadPool::Default());
+
+    /// Decodes a chunked array from the front of input, then advances input past it. The array is created inside the current ArenaScope, if any,
+    /// but elements decoded on the pool's threads are created on the heap. Returns nullopt and leaves input untouched if it's truncated or malformed,
+    /// including a chunk whose elements don't take up exactly its byte size
+    SERPENT_API std::optional<ArrayHandle> DecodeChunked(ArrayLayout const &layout, std::span<std::byte const> &input, ThreadPool &pool = ThreadPool::Default());
+}
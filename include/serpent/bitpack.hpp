@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "serpent/api.hpp"
+#include "serpent/layout.hpp"
+#include "serpent/value.hpp"
+
+namespace Serpent {
+    struct BitCodecState;
+
+    /// Stores the floating field `field` of an ObjectLayout as an unsigned integer of `bits` bits, spread evenly over [min, max].
+    /// Values outside the range are clamped, and NaN is stored as min
+    struct Quantization final {
+        Rc<GcLayout const> layout;
+        std::string_view field;
+        double min;
+        double max;
+        uint8_t bits;
+    };
+
+    /// Bit-level encoding for bandwidth-bound traffic, laid out like the binary encoding in binary.hpp but with every field packed as tightly as its layout allows.
+    /// Bits are written least significant first, and the last byte is padded with zero bits.
+    /// - Bools take 1 bit, enums ceil(log2(n)) bits for n names, and variant tags ceil(log2(n)) bits for n variants
+    /// - UInt8 and Int8 take 8 bits. Wider unsigned integers are varints, 7 bits per group plus a continuation bit, and wider signed integers are zigzag encoded first
+    /// - Floats take their full width unless quantized
+    /// - Strings and array lengths are a varint length followed by the contents, object and array fields a presence bit
+    ///
+    /// A codec is immutable once built, and can be shared between threads. Plans are compiled per layout the first time it's encoded or decoded.
+    /// Decoding must use a codec with the same quantizations the value was encoded with
+    struct SERPENT_API BitCodec final {
+        private:
+        std::unique_ptr<BitCodecState> state;
+
+        BitCodec(std::unique_ptr<BitCodecState> state);
+
+        public:
+        BitCodec(BitCodec &&move);
+
+        ~BitCodec();
+
+        BitCodec &operator = (BitCodec &&move);
+
+        /// Returns nullopt if a quantization doesn't name a floating field of an ObjectLayout, names one twice,
+        /// has an empty range, or takes more than 32 bits or none
+        static std::optional<BitCodec> Of(std::initializer_list<Quantization> quantizations = {});
+
+        /// Appends the value's encoding to out, returns the number of bytes appended
+        size_t Encode(GcHandle const &value, std::vector<std::byte> &out) const;
+        size_t Encode(ArrayHandle const &value, std::vector<std::byte> &out) const;
+
+        /// Decodes a value from the front of input, then advances input past it, including the padding bits. Values are created inside the current ArenaScope, if any.
+        /// Returns nullopt and leaves input untouched if it's truncated or malformed, follows the same rules as Decode in binary.hpp
+        std::optional<GcHandle> Decode(Rc<GcLayout const> const &layout, std::span<std::byte const> &input) const;
+        std::optional<ArrayHandle> Decode(ArrayLayout const &layout, std::span<std::byte const> &input) const;
+    };
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+
+#include "serpent/api.hpp"
+#include "serpent/layout.hpp"
+#include "serpent/value.hpp"
+
+namespace Serpent {
+    enum struct Overflow : uint8_t {
+        /// Out of range values clamp to the destination's range, infinities included.
+        /// NaN becomes 0 when converted to an integer
+        Saturate,
+        /// Integers keep their low bits. Floats are truncated, then wrapped the same way, and NaN or infinities become 0.
+        /// Float64 to Float32 rounds as a plain cast does
+        Wrap,
+    };
+
+    struct SERPENT_API ConvertOptions final {
+        Overflow overflow = Overflow::Saturate;
+        /// Integers map to floats in [-1, 1] if signed, or [0, 1] if unsigned, and floats map back by rounding to nearest.
+        /// Normalized float to integer conversions always saturate. Integer to integer and float to float conversions ignore this
+        bool normalized = false;
+    };
+
+    /// Converts between arrays of IntegralLayout or FloatingLayout elements, writing straight into the destination.
+    /// Any value converted to Bool becomes 1 if it's non-zero.
+    /// Returns false if either array isn't numeric, the lengths differ or the destination is frozen
+    SERPENT_API bool Convert(ArrayHandle const &source, ArrayHandle const &destination, ConvertOptions options = {});
+
+    /// Converts into a newly allocated array with the given element layout.
+    /// Returns nullopt if either layout isn't numeric
+    SERPENT_API std::optional<ArrayHandle> Convert(ArrayHandle const &source, ValueLayout const &destination, ConvertOptions options = {});
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+
+#include "serpent/api.hpp"
+#include "serpent/value.hpp"
+
+namespace Serpent {
+    /// Deep copies, comparisons and hashes of value graphs, driven by a plan compiled once per layout.
+    /// Plain fields are copied, compared and hashed as runs of bytes, so floats compare bitwise: NaNs with the same bits are equal, and 0.0 isn't equal to -0.0.
+    /// Strings compare by their interned index. Object and array fields are recursed into, comparing values as trees,
+    /// so a child shared between two fields is equal to two separate but equal children.
+    /// Layouts can't refer to themselves, so the recursion always terminates.
+
+    /// Frozen values are immutable, so the copy shares them rather than copying them.
+    /// Children shared within the graph stay shared in the copy. The copy is made on the heap, even inside an ArenaScope
+    SERPENT_API GcHandle Clone(GcHandle const &value);
+    SERPENT_API ArrayHandle Clone(ArrayHandle const &value);
+
+    /// Values of different layouts are never equal
+    SERPENT_API bool Equals(GcHandle const &lhs, GcHandle const &rhs);
+    SERPENT_API bool Equals(ArrayHandle const &lhs, ArrayHandle const &rhs);
+
+    /// Equal values hash equally. Hashes depend on how strings were interned, so they're only stable within a process
+    SERPENT_API uint64_t Hash(GcHandle const &value);
+    SERPENT_API uint64_t Hash(ArrayHandle const &value);
+}
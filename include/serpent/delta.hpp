@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "serpent/api.hpp"
+#include "serpent/value.hpp"
+
+namespace Serpent {
+    /// Deltas carry only the fields that changed between two values of the same ObjectLayout or TupleLayout, for replicating state that mostly stays put.
+    /// A delta is a bitmask with one bit per field, least significant bit first, padded to whole bytes,
+    /// followed by the value of each changed field in declaration order, in the encoding described in binary.hpp.
+    /// Scalars and strings are compared by their bytes, over the whole value at once. Object and array fields count as changed if they're not Equals.
+    ///
+    /// Like the binary encoding, deltas carry no layout information, and only apply to values of the layout they were taken from.
+
+    /// Appends the delta that turns `from` into `to`, returns the number of bytes appended.
+    /// Returns nullopt if the values don't share the same layout, or if it's a VariantLayout
+    SERPENT_API std::optional<size_t> EncodeDelta(GcHandle const &from, GcHandle const &to, std::vector<std::byte> &out);
+
+    /// Applies a delta from the front of input to target, then advances input past it.
+    /// Object and array fields are decoded inside the current ArenaScope, if any, the same as Decode.
+    /// Returns false and leaves both untouched if the delta is truncated or malformed, if target is frozen or a VariantLayout,
+    /// or if target would outlive the arena values decoded into it
+    SERPENT_API bool ApplyDelta(GcHandle const &target, std::span<std::byte const> &input);
+}
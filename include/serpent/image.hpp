@@ -0,0 +1,148 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+#include "serpent/api.hpp"
+#include "serpent/layout.hpp"
+#include "serpent/value.hpp"
+
+namespace Serpent {
+    struct ImageState;
+    struct ImageObject;
+    struct ImageArray;
+
+    /// Like Handle, but strings are views into the image
+    using ImageHandle = std::variant<
+        std::monostate,
+        std::nullopt_t,
+        int8_t,
+        uint8_t,
+        int16_t,
+        uint16_t,
+        int32_t,
+        uint32_t,
+        int64_t,
+        uint64_t,
+        float,
+        double,
+        std::string_view,
+        ImageObject,
+        ImageArray
+    >;
+
+    /// Images store a value graph in the layouts' native memory layout, so they can be read in place straight out of a memory mapped file.
+    /// Every object, array and string is a record at an 8 byte aligned offset. Reference fields hold the signed distance from the field to its record,
+    /// and 0 for empty fields or the empty string. Values shared within the graph are written once, and stay shared.
+    /// Arrays are a uint64 length followed by their elements, aligned to the element's alignment. Strings are a uint64 byte count followed by the bytes.
+    /// Since the data is native, an image is only readable on hosts with the same endianness and word size, which Open checks.
+    ///
+    /// Nothing is parsed up front. Each record is validated the first time it's reached, checking its bounds, alignment, Bools, enums and variant tags,
+    /// so opening and reading from a large image only costs as much as the records actually touched.
+    /// A record that fails validation reads as std::monostate, and marks the image as corrupt.
+    SERPENT_API std::vector<std::byte> WriteImage(GcHandle const &root);
+    SERPENT_API std::vector<std::byte> WriteImage(ArrayHandle const &root);
+
+    /// Read-only view of an image. The bytes must stay alive and unchanged for as long as the image or any handles read from it,
+    /// and must be 8 byte aligned, which memory mapped files and std::vector buffers always are
+    struct SERPENT_API Image final {
+        private:
+        std::unique_ptr<ImageState> state;
+
+        Image(std::unique_ptr<ImageState> state);
+
+        public:
+        Image(Image &&move);
+
+        ~Image();
+
+        Image &operator = (Image &&move);
+
+        /// The root layout must be an object layout or an ArrayLayout, matching what the image was written from.
+        /// Returns nullopt if the header is invalid, was written on an incompatible host, or doesn't match the root layout
+        static std::optional<Image> Open(std::span<std::byte const> bytes, ValueLayout const &root);
+
+        /// ImageObject or ImageArray, or std::monostate if the root record is invalid
+        ImageHandle Root() const;
+        /// Returns true if any record touched so far failed validation
+        bool IsCorrupt() const;
+    };
+
+    /// Read-only handle to an object in an image, only valid as long as the Image is.
+    /// Get follows the same conventions as GcHandle
+    struct SERPENT_API ImageObject final {
+        private:
+        ImageState const *image;
+        GcLayout const *layout;
+        size_t offset;
+
+        ImageObject(ImageState const *image, GcLayout const *layout, size_t offset);
+
+        friend struct ImageState;
+
+        public:
+        GcLayout const &Layout() const;
+        /// The object's memory, laid out as described by Layout(). Reference fields hold offsets rather than pointers
+        void const *Data() const;
+
+        ImageHandle Get(std::string_view key) const;
+        ImageHandle Get(size_t index) const;
+
+        bool PointerEq(ImageObject const &other) const;
+    };
+
+    /// Read-only handle to an array in an image, only valid as long as the Image is
+    struct SERPENT_API ImageArray final {
+        private:
+        ImageState const *image;
+        ValueLayout const *layout;
+        size_t offset;
+        size_t size;
+
+        ImageArray(ImageState const *image, ValueLayout const *layout, size_t offset, size_t size);
+
+        friend struct ImageState;
+
+        public:
+        ValueLayout const &Layout() const;
+        size_t Size() const;
+        /// The elements' memory. Reference elements hold offsets rather than pointers
+        void const *Data() const;
+
+        ImageHandle Get(size_t index) const;
+
+        bool PointerEq(ImageArray const &other) const;
+    };
+
+    /// A read-only memory mapping of a whole file
+    struct SERPENT_API MappedFile final {
+        private:
+        void const *data;
+        size_t size;
+        /// Platform handle kept open alongside the mapping, if the platform needs one
+        void *handle;
+
+        MappedFile(void const *data, size_t size, void *handle);
+
+        public:
+        MappedFile(MappedFile const &copy) = delete;
+        MappedFile(MappedFile &&move);
+
+        ~MappedFile();
+
+        MappedFile &operator = (MappedFile const &copy) = delete;
+        MappedFile &operator = (MappedFile &&move);
+
+        /// Returns nullopt if the file can't be opened or is empty
+        static std::optional<MappedFile> Open(std::filesystem::path const &path);
+
+        std::span<std::byte const> Bytes() const;
+    };
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "serpent/api.hpp"
+#include "serpent/value.hpp"
+
+namespace Serpent {
+    struct FieldIndexState;
+
+    enum struct IndexKind : uint8_t {
+        /// Equality lookups in constant time
+        Hash,
+        /// Equality and range lookups in logarithmic time, in key order
+        Sorted,
+    };
+
+    /// Secondary index over an array of objects, mapping the values of one field to the positions of the elements holding them,
+    /// so looking elements up by id, owner or name doesn't scan the whole array.
+    /// The field may be IntegralLayout, FloatingLayout, an enum or a string. Empty elements aren't indexed, and neither are NaN keys.
+    /// String keys are hashed by their interned index, without touching their bytes, and sorted by their bytes.
+    /// Keys are passed as the handle type Get returns for the field, see GcHandle.
+    ///
+    /// The index keeps itself up to date through its own Set, which sets the element in the array and re-indexes that one position.
+    /// Setting an empty slot adds an element, and setting nullopt removes one, which is how arrays with a fixed length grow and shrink in place.
+    /// Changes made to the array or its elements some other way, such as setting the key field through the element's own handle,
+    /// must be followed by Update for the positions they touched, or by Rebuild.
+    /// Like the array itself, the index must not be used from several threads while it's being written
+    struct SERPENT_API FieldIndex final {
+        private:
+        std::unique_ptr<FieldIndexState> state;
+
+        FieldIndex(std::unique_ptr<FieldIndexState> state);
+
+        public:
+        FieldIndex(FieldIndex &&move);
+
+        ~FieldIndex();
+
+        FieldIndex &operator = (FieldIndex &&move);
+
+        /// Indexes every element of the array by the named field.
+        /// Returns nullopt if the elements aren't of an ObjectLayout, or if the field doesn't exist or isn't numeric, an enum or a string
+        static std::optional<FieldIndex> Of(ArrayHandle const &array, std::string_view field, IndexKind kind = IndexKind::Hash);
+
+        /// The array being indexed, shared with the caller
+        ArrayHandle const &Array() const;
+        IndexKind Kind() const;
+        /// Number of elements indexed
+        size_t Size() const;
+
+        /// Sets the element at position in the array, then re-indexes it.
+        /// Returns false if the array rejects the element, see ArrayHandle::Set
+        bool Set(size_t position, Handle element);
+        /// Re-reads the key of the element at position, after it changed without going through Set
+        void Update(size_t position);
+        /// Re-reads every element's key
+        void Rebuild();
+
+        /// Position of an element whose key equals key, the lowest one if several do.
+        /// Returns nullopt if there isn't one, or if key isn't the field's handle type
+        std::optional<size_t> Find(Handle const &key) const;
+        /// Appends the position of every element whose key equals key to out, in ascending order, returns the number appended.
+        /// Returns nullopt if key isn't the field's handle type
+        std::optional<size_t> FindAll(Handle const &key, std::vector<size_t> &out) const;
+        /// Appends the position of every element whose key is within [lower, upper] to out, in key order, returns the number appended.
+        /// NaN bounds sort after every other value.
+        /// Returns nullopt if the index isn't Sorted, or if a bound isn't the field's handle type
+        std::optional<size_t> Range(Handle const &lower, Handle const &upper, std::vector<size_t> &out) const;
+    };
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "serpent/api.hpp"
+#include "serpent/layout.hpp"
+#include "serpent/value.hpp"
+
+namespace Serpent {
+    /// JSON is read straight into layout memory, without building a document first. Keys are matched against a table compiled once per layout,
+    /// and each value is parsed directly into its field.
+    /// - Integral fields take integers that fit their type, Bools take true or false, floating fields take any number, or null as NaN
+    /// - Strings are interned, enums take one of their names as a string, Unit takes null
+    /// - Object fields are JSON objects, missing fields keep their default and unknown keys are skipped. Tuples are JSON arrays of exactly their length
+    /// - Object and array fields also take null, which leaves them empty
+    /// - Variants follow VariantLayout: `{"SomeVariant": 5}`, or `{"type": "SomeVariant", "value": 5}` with a variant field name.
+    ///   Unit variants may also be written as `"SomeVariant"`, or without a "value" key
+    ///
+    /// Values are created inside the current ArenaScope, if any.
+    /// Returns nullopt if the text isn't a single well-formed JSON value matching the layout, trailing whitespace aside
+    SERPENT_API std::optional<GcHandle> ReadJson(Rc<GcLayout const> const &layout, std::string_view json);
+    SERPENT_API std::optional<ArrayHandle> ReadJson(ArrayLayout const &layout, std::string_view json);
+
+    /// Receives WriteJson's output in chunks of up to a few kilobytes, in order
+    struct JsonSink final {
+        void *context;
+        void (*write)(void *context, std::string_view chunk);
+    };
+
+    /// Writes values as compact JSON in the form ReadJson reads. Field names, enum names and variant tags are escaped once per layout and copied as is,
+    /// and numbers are written with std::to_chars, in their shortest form that reads back exactly. Non-finite floats are written as null, and read back as NaN.
+    /// Values are written as trees, a child referenced from two fields is written twice.
+    /// Output goes through a fixed buffer, nothing is allocated per value
+    ///
+    /// Appends to out, which can be cleared and reused to keep its capacity. Returns the number of bytes written
+    SERPENT_API size_t WriteJson(GcHandle const &value, std::string &out);
+    SERPENT_API size_t WriteJson(ArrayHandle const &value, std::string &out);
+    SERPENT_API size_t WriteJson(GcHandle const &value, JsonSink sink);
+    SERPENT_API size_t WriteJson(ArrayHandle const &value, JsonSink sink);
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "serpent/api.hpp"
+#include "serpent/value.hpp"
+
+namespace Serpent {
+    /// Bulk numeric operations over arrays whose elements are IntegralLayout or FloatingLayout.
+    /// Each call dispatches once on the element layout, then runs a vectorized loop over the whole array.
+    /// Scalar arguments take the same handle type ArrayHandle::Set would, Bool arrays take uint8_t 0 or 1. Enum arrays aren't numeric.
+    /// Integer arithmetic wraps on overflow. Min, Max and Clamp don't define which operand wins on NaN.
+    /// Operations that write to the array return false if it's frozen.
+
+    /// Returns false if the array isn't numeric or the value doesn't match the element layout
+    SERPENT_API bool Fill(ArrayHandle const &array, Handle const &value);
+
+    /// Signed integers sum into int64_t, unsigned integers into uint64_t and floats into their own type.
+    /// Returns std::monostate if the array isn't numeric
+    SERPENT_API Handle Sum(ArrayHandle const &array);
+
+    /// Returns std::monostate if the array isn't numeric or is empty
+    SERPENT_API Handle Min(ArrayHandle const &array);
+    /// Returns std::monostate if the array isn't numeric or is empty
+    SERPENT_API Handle Max(ArrayHandle const &array);
+
+    /// Multiplies every element by factor.
+    /// Returns false if the array isn't numeric, is Bool or the factor doesn't match the element layout
+    SERPENT_API bool Scale(ArrayHandle const &array, Handle const &factor);
+    /// Adds addend to every element.
+    /// Returns false if the array isn't numeric, is Bool or the addend doesn't match the element layout
+    SERPENT_API bool Add(ArrayHandle const &array, Handle const &addend);
+    /// Returns false if the array isn't numeric or the bounds don't match the element layout
+    SERPENT_API bool Clamp(ArrayHandle const &array, Handle const &min, Handle const &max);
+
+    /// Accumulates the same way as Sum.
+    /// Returns std::monostate if the arrays aren't numeric, or differ in element layout or length
+    SERPENT_API Handle Dot(ArrayHandle const &lhs, ArrayHandle const &rhs);
+}
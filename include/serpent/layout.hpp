@@ -5,6 +5,7 @@
 #include <initializer_list>
 #include <memory>
 #include <optional>
+#include <span>
 #include <string_view>
 #include <variant>
 
@@ -68,28 +69,58 @@ namespace Serpent {
     SERPENT_API size_t GetSize(ValueLayout const &layout);
     SERPENT_API size_t GetAlign(ValueLayout const &layout);
 
+    /// How an object's or tuple's fields are placed in memory.
+    /// The GPU rules place fields the way shaders read a buffer block declared with the same members in the same order,
+    /// so a value's data can be copied straight into a mapped uniform or storage buffer.
+    /// Values store nested objects, arrays and strings by reference, so under the GPU rules every field must be a scalar stored inline:
+    /// a 32 or 64 bit integer, float or enum. Bool is rejected since shader booleans take 32 bits, use UInt32 instead.
+    ///
+    /// An object declares a vector as one field per component, the first one carrying the component count, see NamedLayout.
+    /// Std140 and Std430 align a vector of 2 to twice its component's size and a vector of 3 or 4 to four times, Scalar aligns it like its components.
+    /// A matrix is a vector per column. Std140 pads each column to 16 bytes like an array element, so declare columns of two 32 bit components as vectors of 4 there.
+    /// Tuples have no way to declare vectors, their fields are always placed as plain scalars.
+    /// Structs and arrays can't be members, but an array of objects laid out by these rules has the stride a shader gives an array of the matching struct
+    enum struct LayoutRules : uint8_t {
+        /// C-style natural alignment, any field
+        Native,
+        /// GLSL std140, for uniform buffers: like Std430, but the object's alignment and size are rounded up to 16 bytes
+        Std140,
+        /// GLSL std430, for storage buffers: each scalar aligned to its size, the object aligned to its widest field
+        Std430,
+        /// Vulkan scalar block layout: as Std430, but 8 and 16 bit integers and enums are also allowed
+        Scalar,
+    };
+
     struct SERPENT_API ObjectLayout final {
-        private:
         struct Field;
 
+        private:
         RcArray<Field> fields;
         InternedMap<size_t> indices;
         size_t size;
         size_t align;
+        LayoutRules rules;
 
         ObjectLayout(
             RcArray<Field> fields,
             InternedMap<size_t> indices,
             size_t size,
-            size_t align
+            size_t align,
+            LayoutRules rules
         );
         
         public:
-        /// Returns nullopt if there are duplicated field names
-        static std::optional<Rc<GcLayout const>> Of(std::initializer_list<NamedLayout> fields); 
+        /// Returns nullopt if there are duplicated field names, a field the rules don't allow, or a vector that's too long or whose components don't match
+        static std::optional<Rc<GcLayout const>> Of(std::initializer_list<NamedLayout> fields, LayoutRules rules = LayoutRules::Native); 
+        static std::optional<Rc<GcLayout const>> Of(std::span<NamedLayout const> fields, LayoutRules rules = LayoutRules::Native);
 
         size_t Size() const;
         size_t Align() const;
+        LayoutRules Rules() const;
+
+        RcArray<Field> const &Fields() const;
+        /// Returns nullopt if there is no field with the given name
+        std::optional<size_t> IndexOf(InternedString const &name) const;
 
         void Initialize(void *root) const;
 
@@ -97,24 +128,33 @@ namespace Serpent {
     };
 
     struct SERPENT_API TupleLayout final {
-        private:
         struct Field;
 
+        private:
         RcArray<Field> fields;
         size_t size;
         size_t align;
+        LayoutRules rules;
 
         TupleLayout(
             RcArray<Field> fields,
             size_t size,
-            size_t align
+            size_t align,
+            LayoutRules rules
         );
         
         public:
         static Rc<GcLayout const> Of(std::initializer_list<ValueLayout> fields); 
+        static Rc<GcLayout const> Of(std::span<ValueLayout const> fields);
+        /// Returns nullopt if there is a field the rules don't allow
+        static std::optional<Rc<GcLayout const>> Of(std::initializer_list<ValueLayout> fields, LayoutRules rules); 
+        static std::optional<Rc<GcLayout const>> Of(std::span<ValueLayout const> fields, LayoutRules rules);
 
         size_t Size() const;
         size_t Align() const;
+        LayoutRules Rules() const;
+
+        RcArray<Field> const &Fields() const;
 
         void Initialize(void *root) const;
 
@@ -140,14 +180,25 @@ namespace Serpent {
         );
         
         public:
-        /// Returns nullopt if there are duplicated field names
+        /// Returns nullopt if there are duplicated field names, or a variant declared as a vector
         /// if variantFieldName is nullopt, it uses the name of the variant as a key
         /// `{"SomeVariant": 5}` vs `{"type": "SomeVariant", "value": 5}`
         static std::optional<Rc<GcLayout const>> Of(std::initializer_list<NamedLayout> fields, std::optional<std::string_view> variantFieldName = std::nullopt);
+        static std::optional<Rc<GcLayout const>> Of(std::span<NamedLayout const> fields, std::optional<std::string_view> variantFieldName = std::nullopt);
 
         size_t Size() const;
         size_t Align() const;
 
+        RcArray<NamedLayout> const &Variants() const;
+        /// Returns nullopt if there is no variant with the given name
+        std::optional<size_t> IndexOf(InternedString const &name) const;
+        std::optional<InternedString> const &VariantFieldName() const;
+
+        /// The tag is stored at offset 0 as an unsigned integer of this size
+        size_t TagSize() const;
+        /// The active variant's value is stored at this offset
+        size_t PayloadOffset() const;
+
         void Initialize(void *root) const;
 
         bool operator == (VariantLayout const &other) const = default;
@@ -185,9 +236,14 @@ namespace Serpent {
         public:
         /// Returns nullopt if there are duplicated field names
         static std::optional<Rc<EnumLayout const>> Of(std::initializer_list<std::string_view> names, IntegralLayout backing = IntegralLayout::UInt32);
+        static std::optional<Rc<EnumLayout const>> Of(std::span<std::string_view const> names, IntegralLayout backing = IntegralLayout::UInt32);
 
         IntegralLayout Backing() const;
 
+        RcArray<InternedString> const &Names() const;
+        /// Returns nullopt if there is no name with the given value
+        std::optional<size_t> IndexOf(InternedString const &name) const;
+
         bool operator == (EnumLayout const &other) const = default;
     };
 
@@ -195,12 +251,17 @@ namespace Serpent {
         private:
         InternedString name;
         ValueLayout layout;
+        uint8_t vector;
 
         public:
-        NamedLayout(std::string_view name, ValueLayout layout);
+        /// A vector of more than 1 starts a shader vector of that many components, at most 4: this field and the ones after it, which must share its layout.
+        /// Only ObjectLayout takes vectors, see LayoutRules
+        NamedLayout(std::string_view name, ValueLayout layout, uint8_t vector = 1);
 
         std::string_view Name() const;
+        InternedString const &InternedName() const;
         ValueLayout const &Layout() const;
+        uint8_t Vector() const;
 
         bool operator == (NamedLayout const &rhs) const = default;
     };
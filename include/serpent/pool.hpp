@@ -0,0 +1,235 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+#include "serpent/api.hpp"
+#include "serpent/value.hpp"
+
+namespace Serpent {
+    struct ThreadPoolState;
+
+    /// Work-stealing thread pool for data parallel loops over large arrays.
+    /// For splits its range in halves on demand: a thread keeps working on the front half and leaves the back half in its own queue,
+    /// where idle threads steal it from, so uneven work balances itself without the caller picking chunk sizes up front.
+    /// The calling thread works alongside the pool until its whole range is done, so For may be called from inside another For.
+    ///
+    /// ForEach, Map and Reduce run over an array's elements, split into chunks whose slots start on a cache line, so threads writing neighbouring chunks don't share lines.
+    /// T is how each element is seen: its scalar type for arrays of IntegralLayout, FloatingLayout or enums,
+    /// with Bool arrays taking uint8_t, or a trivially copyable struct mirroring the object layout for arrays of objects, which must have the same size.
+    /// Object elements are reached through their references, and empty ones are skipped.
+    /// Elements are written in place, the way the bulk kernels in kernels.hpp write, so writes to an array a snapshot shares show through it.
+    /// Writing fails on a frozen array, skips frozen objects, and fails on variants and on objects with string, object or array fields, whose tags and references raw writes would corrupt.
+    /// Making T const only reads, which works on frozen values and any object layout.
+    ///
+    /// Values created on worker threads are owned by them, see refcount.hpp. Workers call MergeReleased whenever they run out of work
+    struct SERPENT_API ThreadPool final {
+        private:
+        enum struct ElementKind : uint8_t {
+            Unsigned,
+            Signed,
+            Floating,
+            Object,
+        };
+
+        /// Where an array's elements are, and how they're split into chunks
+        struct Elements final {
+            std::byte *data;
+            size_t stride;
+            size_t length;
+            /// Elements are references to objects, whose data starts this far into each value
+            bool objects;
+            size_t dataOffset;
+            /// Elements in each chunk, a whole number of cache lines
+            size_t chunk;
+            /// Chunks are laid out as if this many elements came before the first, which lines the rest of them up with cache lines
+            size_t shift;
+            size_t chunks;
+        };
+
+        /// Object pointers resolved per call to Resolve
+        static constexpr size_t Batch = 64;
+
+        std::unique_ptr<ThreadPoolState> state;
+
+        void Run(size_t count, size_t grain, void *context, void (*func)(void *context, size_t begin, size_t end));
+
+        /// Returns nullopt if elements of this kind, size and alignment don't match the array's,
+        /// or if writes are asked of a frozen array or of objects holding references
+        std::optional<Elements> Describe(ArrayHandle const &array, ElementKind kind, size_t size, size_t align, bool writes) const;
+        /// Fills out with the data of each object in [begin, end), or null for empty objects and, if writing, frozen ones
+        static void Resolve(Elements const &elements, size_t begin, size_t end, bool writes, void **out);
+
+        template <typename T>
+        static constexpr ElementKind KindOf() {
+            if constexpr (std::is_floating_point_v<T>)
+                return ElementKind::Floating;
+            else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+                return ElementKind::Signed;
+            else if constexpr (std::is_integral_v<T>)
+                return ElementKind::Unsigned;
+            else
+                return ElementKind::Object;
+        }
+
+        template <typename T>
+        std::optional<Elements> Describe(ArrayHandle const &array) const {
+            static_assert(std::is_trivially_copyable_v<std::remove_const_t<T>>, "elements are viewed in place, so T must be trivially copyable");
+
+            return Describe(array, KindOf<std::remove_const_t<T>>(), sizeof(T), alignof(T), !std::is_const_v<T>);
+        }
+
+        /// Calls func(chunk, begin, end) for every chunk of the elements, in parallel
+        template <typename TFunc>
+        void Chunks(Elements const &elements, TFunc &&func) {
+            For(elements.chunks, 1, [&elements, &func](size_t begin, size_t end) {
+                for (size_t chunk = begin; chunk < end; chunk++) {
+                    size_t first = chunk * elements.chunk;
+                    size_t last = first + elements.chunk;
+                    func(chunk, first > elements.shift ? first - elements.shift : 0, std::min(last - elements.shift, elements.length));
+                }
+            });
+        }
+
+        /// Fills out with a pointer to each element in [begin, end), null for the ones to skip
+        template <typename T>
+        static void Pointers(Elements const &elements, size_t begin, size_t end, T **out) {
+            if (elements.objects) {
+                Resolve(elements, begin, end, !std::is_const_v<T>, reinterpret_cast<void **>(const_cast<std::remove_const_t<T> **>(out)));
+            } else {
+                for (size_t i = begin; i < end; i++)
+                    out[i - begin] = reinterpret_cast<T *>(elements.data + i * elements.stride);
+            }
+        }
+
+        /// Calls func(element) for each element in [begin, end) that isn't skipped
+        template <typename T, typename TFunc>
+        static void Visit(Elements const &elements, size_t begin, size_t end, TFunc &&func) {
+            if (!elements.objects) {
+                T *data = reinterpret_cast<T *>(elements.data);
+                for (size_t i = begin; i < end; i++)
+                    func(data[i]);
+
+                return;
+            }
+
+            T *pointers[Batch];
+            for (size_t first = begin; first < end; first += Batch) {
+                size_t last = std::min(first + Batch, end);
+                Pointers(elements, first, last, pointers);
+
+                for (size_t i = 0; i < last - first; i++) {
+                    if (pointers[i])
+                        func(*pointers[i]);
+                }
+            }
+        }
+
+        public:
+        /// Starts enough workers for `concurrency` threads to work on a For, counting the caller, or one per hardware thread if 0
+        explicit ThreadPool(size_t concurrency = 0);
+        ThreadPool(ThreadPool const &copy) = delete;
+        ThreadPool(ThreadPool &&move) = delete;
+
+        ~ThreadPool();
+
+        ThreadPool &operator = (ThreadPool const &copy) = delete;
+        ThreadPool &operator = (ThreadPool &&move) = delete;
+
+        /// Process-wide pool with the default number of threads, started on first use
+        static ThreadPool &Default();
+
+        /// Number of threads that work on a For, the workers plus the caller
+        size_t Concurrency() const;
+
+        /// Calls func(begin, end) for disjoint ranges that together cover [0, count), none longer than grain, and returns once they're all done.
+        /// Ranges run concurrently on any of the pool's threads, including the caller's
+        template <typename TFunc>
+        void For(size_t count, size_t grain, TFunc &&func) {
+            using T = std::remove_reference_t<TFunc>;
+            Run(count, grain, const_cast<void *>(static_cast<void const *>(&func)), [](void *context, size_t begin, size_t end) {
+                (*static_cast<T *>(context))(begin, end);
+            });
+        }
+
+        /// Calls func(T &element) for every element.
+        /// Returns false if T doesn't match the elements, or if T isn't const and the array is frozen or its objects hold references
+        template <typename T, typename TFunc>
+        bool ForEach(ArrayHandle const &array, TFunc &&func) {
+            auto elements = Describe<T>(array);
+            if (!elements)
+                return false;
+
+            Chunks(*elements, [&elements, &func](size_t, size_t begin, size_t end) {
+                Visit<T>(*elements, begin, end, func);
+            });
+
+            return true;
+        }
+
+        /// Sets each element of destination to func(T const &element) of the source element at the same index, which must convert to U.
+        /// Elements skipped on either side leave the destination element as it was.
+        /// Returns false if T or U don't match their arrays, if the lengths differ, or if destination is frozen or its objects hold references
+        template <typename T, typename U, typename TFunc>
+        bool Map(ArrayHandle const &source, ArrayHandle const &destination, TFunc &&func) {
+            auto from = Describe<T const>(source);
+            auto to = Describe<std::remove_const_t<U>>(destination);
+            if (!from || !to || from->length != to->length)
+                return false;
+
+            // Destination chunks line up with its own cache lines, the source is read wherever they fall
+            Chunks(*to, [&from, &to, &func](size_t, size_t begin, size_t end) {
+                T const *sources[Batch];
+                std::remove_const_t<U> *targets[Batch];
+
+                for (size_t first = begin; first < end; first += Batch) {
+                    size_t last = std::min(first + Batch, end);
+                    Pointers(*from, first, last, sources);
+                    Pointers(*to, first, last, targets);
+
+                    for (size_t i = 0; i < last - first; i++) {
+                        if (sources[i] && targets[i])
+                            *targets[i] = func(*sources[i]);
+                    }
+                }
+            });
+
+            return true;
+        }
+
+        /// Folds each chunk's elements with func(TAcc accumulator, T const &element), starting from identity,
+        /// then folds the chunks' results together in index order with combine(TAcc lhs, TAcc rhs).
+        /// The result only depends on how elements are chunked if combine isn't associative or identity isn't its identity.
+        /// Returns nullopt if T doesn't match the elements
+        template <typename T, typename TAcc, typename TFunc, typename TCombine>
+        std::optional<TAcc> Reduce(ArrayHandle const &array, TAcc identity, TFunc &&func, TCombine &&combine) {
+            auto elements = Describe<T const>(array);
+            if (!elements)
+                return std::nullopt;
+
+            // Padded so threads don't write the same cache line
+            struct alignas(64) Partial {
+                TAcc value;
+            };
+
+            std::vector<Partial> partials(elements->chunks, Partial {identity});
+            Chunks(*elements, [&elements, &func, &partials](size_t chunk, size_t begin, size_t end) {
+                TAcc accumulator = partials[chunk].value;
+                Visit<T const>(*elements, begin, end, [&accumulator, &func](T const &element) {
+                    accumulator = func(std::move(accumulator), element);
+                });
+                partials[chunk].value = std::move(accumulator);
+            });
+
+            for (auto &partial : partials)
+                identity = combine(std::move(identity), std::move(partial.value));
+
+            return identity;
+        }
+    };
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "serpent/api.hpp"
+#include "serpent/layout.hpp"
+#include "serpent/types/rc_array.hpp"
+#include "serpent/value.hpp"
+
+namespace Serpent {
+    enum struct CompareOp : uint8_t {
+        Less,
+        LessEqual,
+        Greater,
+        GreaterEqual,
+        Equal,
+        NotEqual,
+    };
+
+    constexpr size_t CompareOpCount = 6;
+
+    /// Compares a field of each element against a constant, e.g. {"health", CompareOp::Less, 10.0f}
+    struct SERPENT_API Predicate final {
+        /// An IntegralLayout, FloatingLayout or enum field of the element
+        std::string_view field;
+        CompareOp op;
+        /// Takes the same handle type GcHandle::Set would for the field, Bool takes uint8_t and enums their backing type
+        Handle value;
+    };
+
+    /// A set of array positions, one bit per position, least significant bit first
+    struct SERPENT_API Selection final {
+        std::vector<uint64_t> words {};
+        /// Length of the array the positions are in
+        size_t length = 0;
+
+        size_t Count() const;
+        bool Contains(size_t position) const;
+
+        /// Keeps only the positions also in other, which must have the same length
+        void And(Selection const &other);
+        /// Adds the positions in other, which must have the same length
+        void Or(Selection const &other);
+
+        /// Appends every position to out, in ascending order, returns the number appended
+        size_t Positions(std::vector<size_t> &out) const;
+    };
+
+    /// Filters arrays of objects by predicates on their numeric fields, for loops like "every entity with health < 10 and team == 2".
+    /// Predicates are resolved against the layout once, into the field's offset and type and the constant in the same type,
+    /// so evaluating them does no lookups or conversions.
+    /// Elements are evaluated a block at a time: each predicate's field is gathered into a packed run,
+    /// then compared by a vectorized kernel for the field's type, which packs the results straight into the selection's bits.
+    /// Later predicates skip blocks where nothing matches anymore.
+    ///
+    /// Comparisons follow C++: NaN fields only match NotEqual.
+    /// The resulting Selection combines with others through And and Or, and with Projection to read the fields of what it selected
+    struct SERPENT_API Query final {
+        /// A resolved predicate
+        struct Term;
+
+        private:
+        Rc<GcLayout const> layout;
+        RcArray<Term> terms;
+
+        Query(Rc<GcLayout const> layout, RcArray<Term> terms);
+
+        public:
+        /// Builds a query matching the elements for which every predicate holds.
+        /// Returns nullopt if the layout isn't an ObjectLayout, if a field doesn't exist or isn't IntegralLayout, FloatingLayout or an enum,
+        /// or if a value isn't the field's handle type
+        static std::optional<Query> Of(Rc<GcLayout const> const &layout, std::span<Predicate const> predicates);
+
+        Rc<GcLayout const> const &Layout() const;
+        RcArray<Term> const &Terms() const;
+
+        /// Replaces selection with the positions of the matching elements. Empty elements never match, and every other element matches an empty query.
+        /// Returns false if the array's elements aren't of the query's layout
+        bool Select(ArrayHandle const &array, Selection &selection) const;
+        /// Appends the positions of the matching elements to out, in ascending order, returns the number appended.
+        /// Returns nullopt if the array's elements aren't of the query's layout
+        std::optional<size_t> Select(ArrayHandle const &array, std::vector<size_t> &out) const;
+    };
+
+    struct SERPENT_API Query::Term final {
+        /// Offset of the field in the element
+        size_t offset;
+        /// The field's type, see Simd::ScalarKind
+        uint8_t kind;
+        CompareOp op;
+        /// The constant, stored in the field's type in the leading bytes
+        uint64_t value;
+    };
+
+    /// Copies numeric fields of selected elements out into packed columns, one per field, the way a query's results are usually consumed.
+    /// Fields are resolved once, like Query's
+    struct SERPENT_API Projection final {
+        /// A field being projected
+        struct Column;
+
+        private:
+        Rc<GcLayout const> layout;
+        RcArray<Column> columns;
+
+        Projection(Rc<GcLayout const> layout, RcArray<Column> columns);
+
+        public:
+        /// Returns nullopt if the layout isn't an ObjectLayout, or if a field doesn't exist or isn't IntegralLayout, FloatingLayout or an enum
+        static std::optional<Projection> Of(Rc<GcLayout const> const &layout, std::span<std::string_view const> fields);
+
+        Rc<GcLayout const> const &Layout() const;
+        RcArray<Column> const &Columns() const;
+
+        /// Writes the fields of every selected element into the columns, one span per field in the order they were named,
+        /// each holding the selected elements' values back to back in position order, in the field's own type.
+        /// Each column must hold at least Columns()[i].size * selection.Count() bytes. Empty elements are never selected by a query, and project as zeros.
+        /// Returns false without writing anything if the array's elements aren't of this projection's layout, if the selection is for an array of another length,
+        /// or if there are too few columns or one is too small
+        bool Project(ArrayHandle const &array, Selection const &selection, std::span<std::span<std::byte> const> columns) const;
+    };
+
+    struct SERPENT_API Projection::Column final {
+        /// Offset of the field in the element
+        size_t offset;
+        /// Bytes each value takes in the column
+        size_t size;
+        ValueLayout layout;
+    };
+}
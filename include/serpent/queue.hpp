@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <type_traits>
+
+#include "serpent/api.hpp"
+#include "serpent/layout.hpp"
+
+namespace Serpent {
+    struct RecordQueueState;
+
+    /// Bounded lock-free queue of records that share a layout, written by any number of threads and read by one.
+    /// Records are stored inline in a ring of slots, Stride() bytes apart and laid out as the layout's data, so producers write fields in place
+    /// at the layout's field offsets, or through a struct that mirrors it, and nothing is allocated per record.
+    /// Only layouts without strings, objects or arrays can be queued, since a record's bytes are its whole value.
+    ///
+    /// A producer claims a slot, writes the record, then publishes it. Slots are claimed in order with a single compare and swap,
+    /// and the consumer only sees a record once it's published, so a slow producer holds up the records claimed after it but never corrupts them.
+    /// The consumer drains published records in batches, handed out as runs of consecutive slots, then frees all of them at once
+    struct SERPENT_API RecordQueue final {
+        /// A claimed slot, to be written and then published
+        struct Slot final {
+            void *data;
+            uint64_t position;
+        };
+
+        private:
+        std::unique_ptr<RecordQueueState> state;
+
+        RecordQueue(std::unique_ptr<RecordQueueState> state);
+
+        size_t Drain(size_t max, void *context, void (*func)(void *context, std::byte const *records, size_t count));
+
+        public:
+        RecordQueue(RecordQueue &&move);
+
+        ~RecordQueue();
+
+        RecordQueue &operator = (RecordQueue &&move);
+
+        /// Capacity is rounded up to a power of two.
+        /// Returns nullopt if the layout holds strings, objects or arrays, or if capacity is 0
+        static std::optional<RecordQueue> Of(Rc<GcLayout const> const &layout, size_t capacity);
+
+        Rc<GcLayout const> const &Layout() const;
+        size_t Capacity() const;
+        /// Bytes between consecutive slots, the layout's size rounded up to its alignment
+        size_t Stride() const;
+
+        /// Claims the next slot, with every field set to its default. Safe to call from any thread.
+        /// Returns nullopt if the queue is full
+        std::optional<Slot> Claim();
+        /// Hands a claimed slot to the consumer. Every claimed slot must be published, or the consumer stops at it
+        void Publish(Slot const &slot);
+
+        /// Claims a slot, calls write(void *record) on it, then publishes it.
+        /// Returns false without calling write if the queue is full
+        template <typename TFunc>
+        bool Push(TFunc &&write) {
+            auto slot = Claim();
+            if (!slot)
+                return false;
+
+            write(slot->data);
+            Publish(*slot);
+
+            return true;
+        }
+
+        /// Calls read(void const *record) for up to max published records in order, then frees their slots, returns the number read.
+        /// Only one thread may drain at a time
+        template <typename TFunc>
+        size_t Drain(TFunc &&read, size_t max = SIZE_MAX) {
+            using T = std::remove_reference_t<TFunc>;
+            struct Context {
+                T *read;
+                size_t stride;
+            } context {&read, Stride()};
+
+            return Drain(max, &context, [](void *context, std::byte const *records, size_t count) {
+                auto &batch = *static_cast<Context *>(context);
+                for (size_t i = 0; i < count; i++)
+                    (*batch.read)(static_cast<void const *>(records + i * batch.stride));
+            });
+        }
+    };
+}
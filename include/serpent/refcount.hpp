@@ -0,0 +1,11 @@
+#pragma once
+
+#include "serpent/api.hpp"
+
+namespace Serpent {
+    /// GC values use biased reference counting, the thread that creates a value counts its own references without atomics.
+    /// When another thread releases a reference the creating thread counted, the value is queued for the creating thread to merge.
+    /// Queues are processed whenever the thread creates a value and when it exits.
+    /// Threads that keep values alive for long periods without creating new ones should call this periodically, such as once per frame
+    SERPENT_API void MergeReleased();
+}
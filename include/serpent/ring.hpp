@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+
+#include "serpent/api.hpp"
+#include "serpent/image.hpp"
+#include "serpent/layout.hpp"
+#include "serpent/types/interner.hpp"
+#include "serpent/value.hpp"
+
+namespace Serpent {
+    struct SharedRingState;
+
+    /// Ring of values sharing an object layout, in named shared memory, for handing values from one process to another.
+    /// Each record is an image, see image.hpp, so references inside it are offsets and it reads the same wherever the memory is mapped:
+    /// the consumer reads records in place, straight out of the shared memory, without decoding or copying them.
+    ///
+    /// Strings aren't copied into every record. The segment also holds a string table, which each distinct string is added to once
+    /// for the life of the segment, and records refer to it by id. Strings read from a record are views into the table,
+    /// and Intern turns them into the consumer's own interned strings, looking each one up only once.
+    /// Once the table is full, new strings are written into the records instead.
+    ///
+    /// One process pushes and one process pops at a time, which may be the same one. Positions are atomics in the shared memory,
+    /// so pushing and popping never block or make system calls. Both sides must agree on the layout, which Open checks by its fingerprint
+    struct SERPENT_API SharedRing final {
+        private:
+        std::unique_ptr<SharedRingState> state;
+
+        SharedRing(std::unique_ptr<SharedRingState> state);
+
+        public:
+        SharedRing(SharedRing &&move);
+
+        ~SharedRing();
+
+        SharedRing &operator = (SharedRing &&move);
+
+        /// Creates a segment with room for capacity bytes of records and stringCapacity bytes of strings, each rounded up to a multiple of 8.
+        /// Names are passed to shm_open with a leading slash, or to CreateFileMapping on Windows.
+        /// Returns nullopt if capacity is 0, or if the segment exists or can't be created
+        static std::optional<SharedRing> Create(
+            std::string_view name,
+            Rc<GcLayout const> const &layout,
+            size_t capacity,
+            size_t stringCapacity = size_t(1) << 20
+        );
+        /// Opens a segment made by Create, usually in another process.
+        /// Returns nullopt if it doesn't exist, is still being created, was created on an incompatible host, or for a different layout
+        static std::optional<SharedRing> Open(std::string_view name, Rc<GcLayout const> const &layout);
+        /// Removes the name, the segment itself lives on until every process has closed it.
+        /// Windows removes segments along with their last handle, so this does nothing there
+        static bool Unlink(std::string_view name);
+
+        Rc<GcLayout const> const &Layout() const;
+        /// Bytes of records the ring holds, each taking 8 bytes plus its image rounded up to 8
+        size_t Capacity() const;
+
+        /// Appends a copy of the value.
+        /// Returns false without appending if the value isn't of the ring's layout, or if the ring doesn't have room for it
+        bool Push(GcHandle const &value);
+
+        /// The oldest record, read in place. It, and strings read from it, stay valid until Pop, and the ring must outlive it.
+        /// Returns nullopt if the ring is empty or corrupt
+        std::optional<Image> Front();
+        /// Frees the oldest record for the producer, does nothing if the ring is empty
+        void Pop();
+        /// Returns true if a record's framing or image header was found to be malformed, after which Front always returns nullopt
+        bool IsCorrupt() const;
+
+        /// Turns a string read from one of this ring's records into an interned string. Strings from the table are translated once
+        /// and remembered, so the same string in later records costs a lookup rather than a hash of its bytes
+        InternedString Intern(std::string_view view);
+    };
+}
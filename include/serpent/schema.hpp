@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "serpent/api.hpp"
+#include "serpent/layout.hpp"
+#include "serpent/value.hpp"
+
+namespace Serpent {
+    struct SchemaRegistryState;
+    struct WireEncoderState;
+    struct WireDecoderState;
+
+    /// Layout definitions describe a layout's structure on the wire, nested layouts included, so a peer can rebuild it without sharing any code.
+    /// Every layout starts with a kind byte, then:
+    /// - IntegralLayout, FloatingLayout and PrimitiveLayout: the enum's value as a byte
+    /// - ArrayLayout: the element's definition
+    /// - EnumLayout: the backing IntegralLayout as a byte, a uint32 count, then the names
+    /// - ObjectLayout: its LayoutRules as a byte, a uint32 count, then each field's name, its NamedLayout vector count as a byte, and its definition
+    /// - TupleLayout: its LayoutRules as a byte, a uint32 count, then each field's definition
+    /// - VariantLayout: a presence byte followed by the variant field name if there is one, a uint32 count, then each variant's name and definition
+    /// Names are a uint32 byte count followed by the bytes, and everything is little endian like the binary encoding.
+    ///
+    /// Appends the layout's definition to out, returns the number of bytes appended
+    SERPENT_API size_t EncodeLayout(Rc<GcLayout const> const &layout, std::vector<std::byte> &out);
+    /// Decodes a definition from the front of input, then advances input past it.
+    /// Returns nullopt and leaves input untouched if it's truncated, malformed, nested too deeply, or describes a layout Of would refuse
+    SERPENT_API std::optional<Rc<GcLayout const>> DecodeLayout(std::span<std::byte const> &input);
+
+    /// Structural fingerprint of a layout, a 64 bit FNV-1a hash of its definition.
+    /// Layouts compare equal exactly when their definitions do, so equal layouts share a fingerprint in every process and on every host
+    SERPENT_API uint64_t Fingerprint(Rc<GcLayout const> const &layout);
+
+    /// Maps fingerprints to layouts, keeping one canonical layout per fingerprint so values decoded from every connection share compiled plans.
+    /// Safe to share between threads
+    struct SERPENT_API SchemaRegistry final {
+        private:
+        std::unique_ptr<SchemaRegistryState> state;
+
+        public:
+        SchemaRegistry();
+        SchemaRegistry(SchemaRegistry const &copy) = delete;
+        SchemaRegistry(SchemaRegistry &&move);
+
+        ~SchemaRegistry();
+
+        SchemaRegistry &operator = (SchemaRegistry const &copy) = delete;
+        SchemaRegistry &operator = (SchemaRegistry &&move);
+
+        /// Returns the canonical layout for the layout's fingerprint, registering it if there isn't one yet.
+        /// Returns nullopt if a different layout already holds the same fingerprint
+        std::optional<Rc<GcLayout const>> Register(Rc<GcLayout const> const &layout);
+        /// Returns nullopt if nothing is registered under the fingerprint
+        std::optional<Rc<GcLayout const>> Find(uint64_t fingerprint) const;
+    };
+
+    /// The sending end of a connection. Each message is a value in the binary encoding from binary.hpp, preceded by its layout's definition
+    /// the first time the connection sends that layout, then by the layout's fingerprint every time.
+    /// Strings go through a per-connection dictionary: the first time a string is sent it's written out and given the next index,
+    /// and every time after that it's written as that index. Once the dictionary holds `capacity` strings, new strings are written out without being added.
+    ///
+    /// On the wire, a message is a sequence of records, each starting with a kind byte:
+    /// - 1, a definition: the uint64 fingerprint, a uint32 byte count, then the layout's definition
+    /// - 0, a value: the uint64 fingerprint, then the value. Strings are a uint32 marker, 0 for a string that stays out of the dictionary and 1 for one that's added,
+    ///   each followed by a uint32 byte count and the bytes, or the string's dictionary index plus 2
+    ///
+    /// Messages must reach the WireDecoder in the order they were encoded, and neither end may be used from two threads at once
+    struct SERPENT_API WireEncoder final {
+        private:
+        std::unique_ptr<WireEncoderState> state;
+
+        public:
+        explicit WireEncoder(size_t capacity = 64 * 1024);
+        WireEncoder(WireEncoder const &copy) = delete;
+        WireEncoder(WireEncoder &&move);
+
+        ~WireEncoder();
+
+        WireEncoder &operator = (WireEncoder const &copy) = delete;
+        WireEncoder &operator = (WireEncoder &&move);
+
+        /// Appends a message holding the value to out, returns the number of bytes appended
+        size_t Encode(GcHandle const &value, std::vector<std::byte> &out);
+    };
+
+    /// The receiving end of a connection. Definitions are checked against their fingerprints, and registered with the registry once the message holding them decodes.
+    /// Ones the registry already knows are skipped without being decoded.
+    /// Each connection decodes at most `definitions` layouts over its lifetime, rejected messages included, so a peer can't grow the registry
+    /// or the compiled plans without bound. Messages bringing further definitions are rejected
+    struct SERPENT_API WireDecoder final {
+        private:
+        std::unique_ptr<WireDecoderState> state;
+
+        public:
+        /// The registry must outlive the decoder. capacity must match the encoder's
+        explicit WireDecoder(SchemaRegistry &registry, size_t capacity = 64 * 1024, size_t definitions = 1024);
+        WireDecoder(WireDecoder const &copy) = delete;
+        WireDecoder(WireDecoder &&move);
+
+        ~WireDecoder();
+
+        WireDecoder &operator = (WireDecoder const &copy) = delete;
+        WireDecoder &operator = (WireDecoder &&move);
+
+        /// Decodes a message from the front of input, then advances input past it. Values are created inside the current ArenaScope, if any.
+        /// Returns nullopt and leaves input and the dictionary untouched if the message is truncated or malformed, its fingerprint is unknown,
+        /// a definition doesn't match its fingerprint or is past the connection's limit, or a string refers past the dictionary.
+        /// Definitions in a rejected message aren't registered
+        std::optional<GcHandle> Decode(std::span<std::byte const> &input);
+    };
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+
+#include "serpent/api.hpp"
+#include "serpent/value.hpp"
+
+namespace Serpent {
+    struct StreamDecoderState;
+
+    enum struct StreamStatus : uint8_t {
+        /// The chunk was used up before the value was complete
+        NeedMore,
+        /// The value is complete, and the chunk was advanced just past it
+        Done,
+        /// The input is malformed, by the same rules as Decode in binary.hpp
+        Malformed,
+        /// A string split across chunks is longer than the budget, an array is longer than the maximum length, or values nest deeper than 64 levels
+        OverBudget,
+    };
+
+    /// Decodes the binary encoding from binary.hpp as it arrives in chunks of any size, straight into an existing value, without ever holding the whole input.
+    /// Scalars are copied into place as their bytes arrive. The only bytes the decoder keeps are strings split across chunks,
+    /// which must fit in the budget given when it's created, so its memory use is fixed up front.
+    /// Arrays are allocated as soon as their length arrives, so the input can't announce arrays longer than the maximum length.
+    ///
+    /// Object and array fields reuse the value already in the target where they can: a child that nothing else references is decoded into in place,
+    /// and so is an array of the same length. Anything else is replaced by a new value on the heap, even inside an ArenaScope.
+    /// Variants keep their payload if the decoded tag matches the current one.
+    ///
+    /// The target is written field by field, so after anything but Done it holds a mix of old and new fields, though every field always holds a valid value.
+    /// Nothing else should read or write the target while a value is being decoded into it
+    struct SERPENT_API StreamDecoder final {
+        private:
+        std::unique_ptr<StreamDecoderState> state;
+
+        StreamDecoder(std::unique_ptr<StreamDecoderState> state);
+
+        public:
+        StreamDecoder(StreamDecoder &&move);
+
+        ~StreamDecoder();
+
+        StreamDecoder &operator = (StreamDecoder &&move);
+
+        /// Returns nullopt if target is frozen
+        static std::optional<StreamDecoder> Into(GcHandle const &target, size_t budget = 64 * 1024, size_t maxLength = 1024 * 1024);
+
+        /// Decodes from the front of chunk, advancing it past the bytes used. Once a value is complete, malformed or over budget,
+        /// the decoder stops there and keeps returning the same status without using any more input until it's Reset
+        StreamStatus Feed(std::span<std::byte const> &chunk);
+        /// Starts decoding another value into the same target
+        void Reset();
+
+        GcHandle const &Target() const;
+    };
+}
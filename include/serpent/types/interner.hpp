@@ -54,6 +54,9 @@ namespace Serpent {
         InternedString(std::string_view view);
         InternedString();
 
+        /// Acquires a new reference to an already interned string
+        static InternedString FromIndex(size_t index);
+
         InternedString(InternedString const &copy);
         InternedString(InternedString &&move);
 
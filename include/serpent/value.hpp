@@ -2,6 +2,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <initializer_list>
 #include <memory>
 #include <optional>
 #include <string_view>
@@ -10,6 +11,7 @@
 
 #include "serpent/api.hpp"
 #include "serpent/types/interner.hpp"
+#include "serpent/types/rc_array.hpp"
 #include "serpent/layout.hpp"
 
 namespace Serpent {
@@ -34,8 +36,76 @@ namespace Serpent {
         ArrayHandle
     >;
 
+    /// A fixed selection of an object layout's fields, resolved once so that GetMany and SetMany can move them without any lookups.
+    /// The fields are packed into a flat buffer in the order they were named, each aligned to its own layout.
+    /// Reference fields are stored in the buffer the same way the value stores them:
+    /// strings as their interned index, objects and arrays as raw pointers that are null when empty.
+    struct SERPENT_API FieldSet final {
+        /// A run of plain bytes, moved with a single copy
+        struct Run;
+        /// A field holding a reference, which needs its count adjusted when moved
+        struct Reference;
+
+        private:
+        Rc<GcLayout const> layout;
+        RcArray<size_t> offsets;
+        RcArray<Run> runs;
+        RcArray<Reference> references;
+        size_t size;
+        size_t align;
+
+        FieldSet(
+            Rc<GcLayout const> layout,
+            RcArray<size_t> offsets,
+            RcArray<Run> runs,
+            RcArray<Reference> references,
+            size_t size,
+            size_t align
+        );
+
+        friend struct GcHandle;
+
+        public:
+        /// Returns nullopt if the layout isn't an ObjectLayout, or if a name isn't one of its fields
+        static std::optional<FieldSet> Of(Rc<GcLayout const> const &layout, std::initializer_list<std::string_view> names);
+
+        Rc<GcLayout const> const &Layout() const;
+
+        /// Size and alignment the buffer needs
+        size_t Size() const;
+        size_t Align() const;
+
+        /// Offset in the buffer of the field at `index`, in the order the names were given
+        size_t Offset(size_t index) const;
+
+        /// Drops the references GetMany acquired into the buffer
+        void Release(void *buffer) const;
+    };
+
     struct GcValue;
 
+    /// Values can be shared between a writer and readers as copy on write snapshots.
+    /// Snapshot is O(1), it marks the value as shared and returns another reference to it. From then on the writer never changes a value a snapshot can see:
+    /// Set and SetMany first swap the handle for a shallow copy if anything else still references a marked value,
+    /// and GetUnique unshares the path from the handle's value down to an object or array field before returning it, so a write only copies the values on the path to the field it touches.
+    /// The children of a copy are shared with the snapshot, so they're marked too, and so are children fetched with Get from a value that's still shared.
+    /// A write through such a child's handle copies the child and leaves its parent pointing at the original, use GetUnique to write a field in place.
+    /// Handles to fields fetched before the snapshot was taken still write through to what the snapshot sees.
+    /// Values that were never snapshotted are written in place, whoever else references them.
+    /// Bulk operations that write through a const handle, such as Fill, Convert or ApplyDelta, always write in place, call MakeUnique before handing them a snapshotted value.
+    /// Readers never block the writer, they keep seeing the values as they were when the snapshot was taken.
+    ///
+    /// Freeze marks a value and everything it references as immutable and immortal, for data built once and then read from many threads.
+    /// Copying or dropping handles to a frozen value never touches its refcount, and it can be read concurrently without synchronization, apart from the interner lookups string fields already do.
+    /// Writes to a frozen value fail, GetUnique behaves like Get, and MakeUnique swaps in a mutable copy. Frozen values are never freed.
+    ///
+    /// Values created while an ArenaScope is alive live in the scope's memory instead, see ArenaScope. Freeze leaves arena values mutable.
+    ///
+    /// Get returns std::monostate if the key or index doesn't exist, if the field is Unit, or if the variant isn't active.
+    /// Get returns std::nullopt for empty object or array fields.
+    /// Set returns false if the key or index doesn't exist, if the handle doesn't match the field's layout or is out of range for a Bool or enum, or if it's an arena value that won't outlive this one.
+    /// A rejected Set leaves the value as it was, without copying it.
+    /// Integral fields take the handle type of the same width and signedness, Bool takes uint8_t and enums take their backing type.
     struct SERPENT_API GcHandle final {
         private:
         GcValue *value;
@@ -43,23 +113,58 @@ namespace Serpent {
         GcHandle(GcValue *value);
 
         public:
+        GcHandle(GcHandle const &copy);
+        GcHandle(GcHandle &&move);
+
         ~GcHandle();
 
-        static GcHandle Create(std::shared_ptr<GcLayout const> &layout);
+        GcHandle &operator = (GcHandle const &copy);
+        GcHandle &operator = (GcHandle &&move);
+
+        static GcHandle Create(Rc<GcLayout const> const &layout);
         static GcHandle FromRaw(GcValue *SERPENT_NONNULL raw);
 
+        Rc<GcLayout const> const &Layout() const;
+        /// Pointer to the value's memory, laid out as described by Layout()
+        void *Data() const;
+
         Handle Get(std::string_view key);
         Handle Get(size_t index);
 
+        /// Setting a variant by key makes it the active variant
         bool Set(std::string_view key, Handle value);
         bool Set(size_t index, Handle value);
 
+        /// Copies the set's fields into buffer, which must be at least set.Size() bytes and aligned to set.Align().
+        /// The references copied into the buffer are acquired, call set.Release(buffer) once done with them.
+        /// Returns false if the set was built for a different layout
+        bool GetMany(FieldSet const &set, void *buffer);
+        /// Copies the set's fields out of buffer. The value acquires its own references, the buffer's are left untouched.
+        /// Returns false if the set was built for a different layout, or the buffer holds an object or array whose layout doesn't match its field,
+        /// or an arena value that won't outlive this one
+        bool SetMany(FieldSet const &set, void const *buffer);
+
+        void Freeze();
+        bool IsFrozen() const;
+
+        GcHandle Snapshot() const;
+        /// Swaps this handle for a shallow copy if anything else references the value, whether or not it was snapshotted.
+        /// Returns true if the value was shared, and this handle now references a copy
+        bool MakeUnique();
+        /// Like Get, but an object or array field referenced from anywhere else is first replaced with a copy.
+        /// The returned handle is itself a reference, write through it directly rather than calling MakeUnique on it
+        Handle GetUnique(std::string_view key);
+        Handle GetUnique(size_t index);
+
         /// Leaks the value into a raw GcValue pointer. To reacquire the value, call FromRaw
         GcValue *SERPENT_NONNULL IntoRaw();
+
+        bool PointerEq(GcHandle const &other) const;
     };
 
     struct ArrayValue;
 
+    /// Get and Set follow the same conventions as GcHandle
     struct SERPENT_API ArrayHandle final {
         private:
         ArrayValue *value;
@@ -67,17 +172,60 @@ namespace Serpent {
         ArrayHandle(ArrayValue *value);
 
         public:
+        ArrayHandle(ArrayHandle const &copy);
+        ArrayHandle(ArrayHandle &&move);
+
         ~ArrayHandle();
 
-        static ArrayHandle Create(ArrayLayout &layout);
-        static GcHandle FromRaw(ArrayValue *SERPENT_NONNULL raw);
+        ArrayHandle &operator = (ArrayHandle const &copy);
+        ArrayHandle &operator = (ArrayHandle &&move);
+
+        /// Creates an array of `length` default initialized elements
+        static ArrayHandle Create(ArrayLayout const &layout, size_t length = 0);
+        static ArrayHandle FromRaw(ArrayValue *SERPENT_NONNULL raw);
 
-        size_t Length();
+        /// The layout of a single element
+        ValueLayout const &Layout() const;
+        /// Pointer to the first element. Elements are contiguous, with a stride of GetSize(Layout())
+        void *Data() const;
+
+        size_t Length() const;
 
         Handle Get(size_t index);
 
         bool Set(size_t index, Handle value);
+
+        /// Freeze, Snapshot, MakeUnique and GetUnique follow the same conventions as GcHandle
+        void Freeze();
+        bool IsFrozen() const;
+
+        ArrayHandle Snapshot() const;
+        bool MakeUnique();
+        Handle GetUnique(size_t index);
+
         /// Leaks the value into a raw ArrayValue pointer. To reacquire the value, call FromRaw
         ArrayValue *SERPENT_NONNULL IntoRaw();
+
+        bool PointerEq(ArrayHandle const &other) const;
+    };
+
+    struct SERPENT_API FieldSet::Run final {
+        size_t source;
+        size_t target;
+        size_t size;
+    };
+
+    struct SERPENT_API FieldSet::Reference final {
+        enum struct Kind : uint8_t {
+            String,
+            Object,
+            Array,
+        };
+
+        size_t source;
+        size_t target;
+        Kind kind;
+        /// The field's layout, objects and arrays stored into it must match it like they would for Set
+        ValueLayout layout;
     };
 }
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "serpent/api.hpp"
+#include "serpent/convert.hpp"
+#include "serpent/layout.hpp"
+#include "serpent/types/rc_array.hpp"
+#include "serpent/value.hpp"
+
+namespace Serpent {
+    enum struct VertexStreams : uint8_t {
+        /// Every attribute in a single stream, one vertex after another
+        Interleaved,
+        /// One tightly packed stream per attribute
+        Separate,
+    };
+
+    /// An attribute the caller asks for, resolved against the element layout by VertexFormat::Of
+    struct SERPENT_API VertexAttribute final {
+        /// Numeric fields of the element holding the attribute's components, 1 to 4 of them, e.g. {"nx", "ny", "nz"}
+        std::vector<std::string_view> fields;
+        /// IntegralLayout or FloatingLayout each component is converted to on export
+        ValueLayout format;
+        /// How components are converted, normalized turns Float32 normals into Int16 or UInt8 colors into Float32, see convert.hpp
+        ConvertOptions options {};
+    };
+
+    /// Exports an array of objects as vertex buffers, converting each attribute's components to its format on the way.
+    /// The format is resolved once, so exporting does no lookups. Components are gathered a block of vertices at a time
+    /// and converted with the same kernels as Convert in convert.hpp, then written to the stream at the attribute's offset and stride.
+    ///
+    /// Attributes are placed in the order they were given, each aligned to its component size.
+    /// Attributes() describes where each one ended up, which is what a vertex input binding needs
+    struct SERPENT_API VertexFormat final {
+        /// Where an attribute sits in the exported streams
+        struct Attribute;
+        /// A single component's source field and conversion
+        struct Component;
+
+        private:
+        Rc<GcLayout const> layout;
+        RcArray<Attribute> attributes;
+        RcArray<Component> components;
+        RcArray<size_t> strides;
+
+        VertexFormat(
+            Rc<GcLayout const> layout,
+            RcArray<Attribute> attributes,
+            RcArray<Component> components,
+            RcArray<size_t> strides
+        );
+
+        public:
+        /// A stride of 0 packs the interleaved stream as tightly as alignment allows, a larger one pads each vertex to it.
+        /// Separate streams are always tightly packed and ignore the stride.
+        /// Returns nullopt if the layout isn't an ObjectLayout, if there are no attributes, if an attribute has no fields or more than 4,
+        /// if a field doesn't exist or isn't IntegralLayout or FloatingLayout, if a format isn't numeric, or if the stride is too small
+        static std::optional<VertexFormat> Of(
+            Rc<GcLayout const> const &layout,
+            std::span<VertexAttribute const> attributes,
+            VertexStreams streams = VertexStreams::Interleaved,
+            size_t stride = 0
+        );
+
+        Rc<GcLayout const> const &Layout() const;
+        RcArray<Attribute> const &Attributes() const;
+
+        /// Number of streams, 1 if interleaved, or one per attribute
+        size_t Streams() const;
+        /// Bytes between consecutive vertices in a stream, which must hold at least Stride(stream) * vertex count bytes
+        size_t Stride(size_t stream) const;
+
+        /// Writes every vertex of the array into the streams, one span per stream, such as mapped GPU buffers.
+        /// Padding between attributes is left untouched, and empty elements export as zeros.
+        /// Returns false without writing anything if the array's elements aren't of this format's layout, or if there are too few streams or one is too small
+        bool Export(ArrayHandle const &vertices, std::span<std::span<std::byte> const> streams) const;
+    };
+
+    struct SERPENT_API VertexFormat::Attribute final {
+        /// Index of the stream holding the attribute
+        size_t stream;
+        /// Offset of the first component from the start of each vertex
+        size_t offset;
+        /// Bytes between the same attribute of consecutive vertices
+        size_t stride;
+        size_t components;
+        ValueLayout format;
+        bool normalized;
+    };
+
+    struct SERPENT_API VertexFormat::Component final {
+        /// Offset of the field in the element
+        size_t source;
+        /// Offset of the component in its stream's vertex
+        size_t target;
+        size_t stream;
+        uint8_t from;
+        uint8_t to;
+        uint8_t mode;
+    };
+}
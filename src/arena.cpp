@@ -0,0 +1,179 @@
+#include <algorithm>
+#include <concepts>
+#include <cassert>
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+#include "serpent/arena.hpp"
+#include "gc.hpp"
+
+struct Serpent::Arena final {
+    Arena *parent;
+    uint8_t depth;
+    size_t chunkSize;
+    size_t used = 0;
+
+    std::vector<std::unique_ptr<std::byte[]>> chunks {};
+    std::byte *cursor = nullptr;
+    std::byte *end = nullptr;
+
+    /// Every value allocated here, released and destroyed when the scope ends
+    std::vector<GcHeader *> values {};
+
+    void *Bump(size_t size, size_t align) {
+        used += size;
+
+        auto aligned = [align](std::byte *ptr) {
+            return reinterpret_cast<std::byte *>((reinterpret_cast<size_t>(ptr) + align - 1) & ~(align - 1));
+        };
+
+        if (cursor) {
+            std::byte *start = aligned(cursor);
+            if (start + size <= end) {
+                cursor = start + size;
+                return start;
+            }
+        }
+
+        // Oversized requests get a chunk of their own, leaving the current one to fill up
+        if (size + align > chunkSize) {
+            chunks.push_back(std::make_unique_for_overwrite<std::byte[]>(size + align));
+            return aligned(chunks.back().get());
+        }
+
+        chunks.push_back(std::make_unique_for_overwrite<std::byte[]>(chunkSize));
+        cursor = chunks.back().get();
+        end = cursor + chunkSize;
+
+        std::byte *start = aligned(cursor);
+        cursor = start + size;
+
+        return start;
+    }
+
+    template <typename TFunc>
+    void ForEachValue(TFunc &&func) {
+        for (GcHeader *header : values) {
+            if (header->flags.load(std::memory_order_relaxed) & GcHeader::Array)
+                func(reinterpret_cast<ArrayValue *>(header));
+            else
+                func(reinterpret_cast<GcValue *>(header));
+        }
+    }
+
+    ~Arena() {
+        // Arena children go with the scope, only heap children and strings hold references that need releasing
+        ForEachValue([](auto *value) {
+            if constexpr (std::same_as<std::remove_pointer_t<decltype(value)>, ArrayValue>) {
+                if (!IsTraceable(value->layout) && !std::holds_alternative<PrimitiveLayout>(value->layout))
+                    return;
+            }
+
+            ForEachSlot(value, [](ValueLayout const &layout, void *slot) {
+                if (auto child = ChildIn(layout, slot); child && child->IsArena()) {
+#if defined(SERPENT_ARENA_CHECKS)
+                    // Dropped only so the check below can tell references from inside the arena apart from leftover handles
+                    child->RemoveRef();
+#endif
+                    return;
+                }
+
+                Release(layout, slot);
+            });
+        });
+
+#if defined(SERPENT_ARENA_CHECKS)
+        // Every reference from inside the arena is gone now, anything left is a handle or a value from an outer scope that outlived the scope
+        for (GcHeader *header : values)
+            assert(header->Count() == 0 && "arena value still referenced after its ArenaScope ended");
+#endif
+
+        // Only the layouts are left to release, the memory goes with the chunks
+        ForEachValue([](auto *value) {
+            using T = std::remove_pointer_t<decltype(value)>;
+            value->~T();
+        });
+    }
+};
+
+Serpent::Arena *Serpent::ArenaOf(GcHeader const &header) {
+    if (!header.IsArena())
+        return nullptr;
+
+    Arena *arena = localArena;
+    while (arena && arena->depth != header.region)
+        arena = arena->parent;
+
+    assert(arena && "arena value used on a thread other than its ArenaScope's");
+
+    return arena;
+}
+
+Serpent::GcValue *Serpent::Allocate(Arena *arena, Rc<GcLayout const> const &layout) {
+    auto [size, align] = std::visit([](auto const &layout) { return std::pair {layout.Size(), layout.Align()}; }, *layout);
+
+    void *memory = arena->Bump(GcValue::DataOffset(align) + size, std::max(alignof(GcValue), align));
+    auto value = new (memory) GcValue {
+        .header = GcHeader::InArena(0, arena->depth),
+        .layout = layout,
+    };
+    arena->values.push_back(&value->header);
+
+    return value;
+}
+
+Serpent::ArrayValue *Serpent::Allocate(Arena *arena, ValueLayout const &element, size_t length) {
+    size_t stride = GetSize(element);
+
+    void *data = nullptr;
+    if (stride * length > 0)
+        data = arena->Bump(stride * length, GetAlign(element));
+
+    auto value = new (arena->Bump(sizeof(ArrayValue), alignof(ArrayValue))) ArrayValue {
+        .header = GcHeader::InArena(GcHeader::Array, arena->depth),
+        .layout = element,
+        .size = length,
+        .data = data,
+    };
+    arena->values.push_back(&value->header);
+
+    return value;
+}
+
+Serpent::ArenaScope::ArenaScope(size_t chunkSize) {
+    // The depth would wrap to a region shared with an outer scope, and MayReference would let values outlive what they reference
+    if (localArena && localArena->depth == UINT8_MAX)
+        std::abort();
+
+    arena.reset(new Arena {
+        .parent = localArena,
+        .depth = uint8_t(localArena ? localArena->depth + 1 : 1),
+        .chunkSize = std::max(chunkSize, size_t(1024)),
+    });
+
+    localArena = arena.get();
+}
+
+Serpent::ArenaScope::~ArenaScope() {
+    assert(localArena == arena.get() && "ArenaScope ended out of order or on another thread");
+
+    localArena = arena->parent;
+    arena.reset();
+}
+
+size_t Serpent::ArenaScope::Used() const {
+    return arena->used;
+}
+
+Serpent::GcHandle Serpent::Promote(GcHandle const &value) {
+    return WithRaw(value, [](GcValue *raw) { return GcHandle::FromRaw(DeepCopy(raw, CopyMode::Promote)); });
+}
+
+Serpent::ArrayHandle Serpent::Promote(ArrayHandle const &value) {
+    return WithRaw(value, [](ArrayValue *raw) { return ArrayHandle::FromRaw(DeepCopy(raw, CopyMode::Promote)); });
+}
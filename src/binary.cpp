@@ -0,0 +1,591 @@
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+#include "serpent/binary.hpp"
+#include "serpent/types/interner.hpp"
+#include "binary.hpp"
+#include "gc.hpp"
+#include "plan_cache.hpp"
+
+namespace {
+    using namespace Serpent;
+    using namespace Serpent::Binary;
+
+    void const *Offset(void const *data, size_t offset) {
+        return reinterpret_cast<void const *>(reinterpret_cast<size_t>(data) + offset);
+    }
+
+    void *Offset(void *data, size_t offset) {
+        return reinterpret_cast<void *>(reinterpret_cast<size_t>(data) + offset);
+    }
+
+    template <typename T>
+    T Read(void const *slot) {
+        T value;
+        std::memcpy(&value, slot, sizeof(T));
+
+        return value;
+    }
+
+    size_t Measure(GcValue *value, Plan const &plan);
+    size_t Measure(ArrayValue *value);
+
+    size_t MeasureSlot(Op const &op, void const *slot) {
+        switch (op.kind) {
+            case SlotKind::Bytes:
+                return op.size;
+            case SlotKind::String:
+                if (auto strings = Binary::localStrings)
+                    return strings->measure(strings->context, Read<size_t>(slot));
+
+                return sizeof(uint32_t) + Interner::Instance().Get(Read<size_t>(slot)).size();
+            case SlotKind::Object: {
+                auto child = Read<GcValue *>(slot);
+                return 1 + (child ? Measure(child, PlanOf(child->layout)) : 0);
+            }
+            case SlotKind::Array: {
+                auto child = Read<ArrayValue *>(slot);
+                return 1 + (child ? Measure(child) : 0);
+            }
+        }
+
+        return 0;
+    }
+
+    size_t Measure(GcValue *value, Plan const &plan) {
+        void const *data = value->Data();
+        size_t size = plan.fixed;
+
+        if (plan.references) {
+            for (auto const &op : plan.ops) {
+                if (op.kind != SlotKind::Bytes)
+                    size += MeasureSlot(op, Offset(data, op.offset));
+            }
+        }
+
+        if (plan.tagSize > 0) {
+            auto const &payload = plan.payloads[LoadUnsigned(data, plan.tagSize)];
+            size += plan.tagSize + MeasureSlot(payload, Offset(data, payload.offset));
+        }
+
+        return size;
+    }
+
+    /// Bytes the elements in [begin, end) take on the wire
+    size_t MeasureElements(ArrayValue *value, size_t begin, size_t end) {
+        size_t size = 0;
+        size_t stride = GetSize(value->layout);
+        Op op = OpOf(value->layout, 0);
+
+        switch (op.kind) {
+            case SlotKind::Bytes:
+                return op.size * (end - begin);
+            case SlotKind::Object: {
+                // Every element shares the array's layout, so the plan is only looked up once
+                auto const &plan = PlanOf(std::get<Rc<GcLayout const>>(value->layout));
+                for (size_t i = begin; i < end; i++) {
+                    auto child = Read<GcValue *>(Offset(value->data, i * stride));
+                    size += 1 + (child ? Measure(child, plan) : 0);
+                }
+                return size;
+            }
+            default:
+                for (size_t i = begin; i < end; i++)
+                    size += MeasureSlot(op, Offset(value->data, i * stride));
+                return size;
+        }
+    }
+
+    size_t Measure(ArrayValue *value) {
+        return sizeof(uint64_t) + MeasureElements(value, 0, value->size);
+    }
+
+    template <std::unsigned_integral T>
+    void WriteInt(std::byte *&cursor, T value) {
+        CopyScalars(cursor, &value, sizeof(T), sizeof(T));
+        cursor += sizeof(T);
+    }
+
+    void Write(GcValue *value, Plan const &plan, std::byte *&cursor);
+    void Write(ArrayValue *value, std::byte *&cursor);
+
+    void WriteSlot(Op const &op, void const *slot, std::byte *&cursor) {
+        switch (op.kind) {
+            case SlotKind::Bytes:
+                CopyScalars(cursor, slot, op.size, op.width);
+                cursor += op.size;
+                break;
+            case SlotKind::String: {
+                if (auto strings = Binary::localStrings) {
+                    strings->write(strings->context, Read<size_t>(slot), cursor);
+                    break;
+                }
+
+                auto view = Interner::Instance().Get(Read<size_t>(slot));
+                WriteInt(cursor, uint32_t(view.size()));
+                std::memcpy(cursor, view.data(), view.size());
+                cursor += view.size();
+                break;
+            }
+            case SlotKind::Object: {
+                auto child = Read<GcValue *>(slot);
+                *cursor++ = std::byte(child != nullptr);
+                if (child)
+                    Write(child, PlanOf(child->layout), cursor);
+                break;
+            }
+            case SlotKind::Array: {
+                auto child = Read<ArrayValue *>(slot);
+                *cursor++ = std::byte(child != nullptr);
+                if (child)
+                    Write(child, cursor);
+                break;
+            }
+        }
+    }
+
+    void Write(GcValue *value, Plan const &plan, std::byte *&cursor) {
+        void const *data = value->Data();
+
+        for (auto const &op : plan.ops)
+            WriteSlot(op, Offset(data, op.offset), cursor);
+
+        if (plan.tagSize > 0) {
+            auto const &payload = plan.payloads[LoadUnsigned(data, plan.tagSize)];
+            CopyScalars(cursor, data, plan.tagSize, plan.tagSize);
+            cursor += plan.tagSize;
+            WriteSlot(payload, Offset(data, payload.offset), cursor);
+        }
+    }
+
+    void WriteElements(ArrayValue *value, size_t begin, size_t end, std::byte *&cursor) {
+        size_t stride = GetSize(value->layout);
+        Op op = OpOf(value->layout, 0);
+
+        switch (op.kind) {
+            case SlotKind::Bytes:
+                if (value->data) {
+                    CopyScalars(cursor, Offset(value->data, begin * stride), op.size * (end - begin), op.width);
+                    cursor += op.size * (end - begin);
+                }
+                break;
+            case SlotKind::Object: {
+                auto const &plan = PlanOf(std::get<Rc<GcLayout const>>(value->layout));
+                for (size_t i = begin; i < end; i++) {
+                    auto child = Read<GcValue *>(Offset(value->data, i * stride));
+                    *cursor++ = std::byte(child != nullptr);
+                    if (child)
+                        Write(child, plan, cursor);
+                }
+                break;
+            }
+            default:
+                for (size_t i = begin; i < end; i++)
+                    WriteSlot(op, Offset(value->data, i * stride), cursor);
+                break;
+        }
+    }
+
+    void Write(ArrayValue *value, std::byte *&cursor) {
+        WriteInt(cursor, uint64_t(value->size));
+        WriteElements(value, 0, value->size, cursor);
+    }
+
+    struct Reader final {
+        std::byte const *cursor;
+        std::byte const *end;
+
+        size_t Remaining() const {
+            return size_t(end - cursor);
+        }
+
+        template <std::unsigned_integral T>
+        bool ReadInt(T &value) {
+            if (Remaining() < sizeof(T))
+                return false;
+
+            CopyScalars(&value, cursor, sizeof(T), sizeof(T));
+            cursor += sizeof(T);
+
+            return true;
+        }
+
+        /// Reads a presence byte, returns nullopt if it's neither 0 nor 1
+        std::optional<bool> ReadPresence() {
+            if (Remaining() < 1 || uint8_t(*cursor) > 1)
+                return std::nullopt;
+
+            return uint8_t(*cursor++) == 1;
+        }
+    };
+
+    GcValue *DecodeValue(Rc<GcLayout const> const &layout, Plan const &plan, Reader &reader);
+    ArrayValue *DecodeArray(ArrayLayout const &layout, Reader &reader);
+
+    /// Decodes into an initialized slot
+    bool DecodeSlot(Op const &op, void *slot, Reader &reader) {
+        switch (op.kind) {
+            case SlotKind::Bytes:
+                if (reader.Remaining() < op.size)
+                    return false;
+
+                CopyScalars(slot, reader.cursor, op.size, op.width);
+                reader.cursor += op.size;
+                return true;
+            case SlotKind::String: {
+                auto &interner = Interner::Instance();
+                size_t index = 0;
+
+                if (auto strings = Binary::localStrings) {
+                    auto read = strings->read(strings->context, reader.cursor, reader.end);
+                    if (!read)
+                        return false;
+
+                    index = *read;
+                } else {
+                    uint32_t size = 0;
+                    if (!reader.ReadInt(size) || reader.Remaining() < size)
+                        return false;
+
+                    index = interner.Acquire(std::string_view(reinterpret_cast<char const *>(reader.cursor), size));
+                    reader.cursor += size;
+                }
+
+                interner.RemoveRef(Read<size_t>(slot));
+                std::memcpy(slot, &index, sizeof(size_t));
+                return true;
+            }
+            case SlotKind::Object: {
+                auto present = reader.ReadPresence();
+                if (!present)
+                    return false;
+                if (!*present)
+                    return true;
+
+                auto const &layout = std::get<Rc<GcLayout const>>(*op.layout);
+                GcValue *child = DecodeValue(layout, PlanOf(layout), reader);
+                std::memcpy(slot, &child, sizeof(GcValue *));
+                return child != nullptr;
+            }
+            case SlotKind::Array: {
+                auto present = reader.ReadPresence();
+                if (!present)
+                    return false;
+                if (!*present)
+                    return true;
+
+                ArrayValue *child = DecodeArray(std::get<ArrayLayout>(*op.layout), reader);
+                std::memcpy(slot, &child, sizeof(ArrayValue *));
+                return child != nullptr;
+            }
+        }
+
+        return false;
+    }
+
+    bool DecodeInto(GcValue *value, Plan const &plan, Reader &reader) {
+        void *data = value->Data();
+
+        for (auto const &op : plan.ops) {
+            if (!DecodeSlot(op, Offset(data, op.offset), reader))
+                return false;
+        }
+        for (auto const &check : plan.checks) {
+            if (!Passes(check, data))
+                return false;
+        }
+
+        if (plan.tagSize > 0) {
+            alignas(uint64_t) std::byte buffer[sizeof(uint64_t)] {};
+            if (reader.Remaining() < plan.tagSize)
+                return false;
+
+            CopyScalars(buffer, reader.cursor, plan.tagSize, plan.tagSize);
+            uint64_t tag = LoadUnsigned(buffer, plan.tagSize);
+            if (tag >= plan.payloads.size())
+                return false;
+            reader.cursor += plan.tagSize;
+
+            auto const &payload = plan.payloads[tag];
+            void *slot = Offset(data, payload.offset);
+
+            // Initialize made the first variant active
+            if (tag != 0) {
+                auto const &variants = std::get<VariantLayout>(*value->layout).Variants();
+                Release(variants[0].Layout(), slot);
+                std::memcpy(data, buffer, plan.tagSize);
+                DefaultInitialize(variants[tag].Layout(), slot);
+            }
+
+            if (!DecodeSlot(payload, slot, reader))
+                return false;
+            if (plan.payloadChecks[tag] && !Passes(*plan.payloadChecks[tag], data))
+                return false;
+        }
+
+        return true;
+    }
+
+    /// Returns null if the input is malformed
+    GcValue *DecodeValue(Rc<GcLayout const> const &layout, Plan const &plan, Reader &reader) {
+        GcValue *value = localArena ? Allocate(localArena, layout) : Allocate(layout);
+
+        // Every byte of a plain value is about to be overwritten, anything else must be valid in case decoding stops halfway
+        if (plan.references || plan.tagSize > 0)
+            std::visit([value](auto const &layout) { layout.Initialize(value->Data()); }, *layout);
+
+        if (DecodeInto(value, plan, reader))
+            return value;
+
+        GcHandle::FromRaw(value);
+        return nullptr;
+    }
+
+    /// Fewest bytes an element of this op takes on the wire, 0 for elements that take none
+    size_t MinimumSize(Op const &op) {
+        return op.kind == SlotKind::Bytes ? op.size : op.kind == SlotKind::String ? sizeof(uint32_t) : 1;
+    }
+
+    /// Rejects lengths the rest of the input can't hold before anything is allocated for them
+    bool Fits(Op const &op, uint64_t length, size_t remaining) {
+        size_t minimum = MinimumSize(op);
+        return minimum > 0 ? length <= remaining / minimum : length <= std::numeric_limits<uint32_t>::max();
+    }
+
+    /// Allocates an array whose elements are all valid, ready to decode into
+    ArrayValue *AllocateArray(ValueLayout const &element, size_t length) {
+        Op op = OpOf(element, 0);
+        ArrayValue *value = localArena ? Allocate(localArena, element, length) : Allocate(element, length);
+        size_t stride = GetSize(element);
+
+        if (op.kind == SlotKind::String) {
+            for (size_t i = 0; i < value->size; i++)
+                DefaultInitialize(element, Offset(value->data, i * stride));
+        } else if (op.kind != SlotKind::Bytes && value->data) {
+            std::memset(value->data, 0, stride * value->size);
+        }
+
+        return value;
+    }
+
+    /// Decodes the elements in [begin, end), returns false if the input is malformed
+    bool DecodeElements(ArrayValue *value, size_t begin, size_t end, Reader &reader) {
+        auto const &element = value->layout;
+        Op op = OpOf(element, 0);
+        size_t stride = GetSize(element);
+
+        switch (op.kind) {
+            case SlotKind::Bytes: {
+                size_t size = op.size * (end - begin);
+                if (reader.Remaining() < size)
+                    return false;
+
+                if (value->data) {
+                    CopyScalars(Offset(value->data, begin * stride), reader.cursor, size, op.width);
+                    reader.cursor += size;
+                }
+
+                auto check = CheckOf(element, 0);
+                for (size_t i = begin; check && i < end; i++) {
+                    if (!Passes(*check, Offset(value->data, i * stride)))
+                        return false;
+                }
+                return true;
+            }
+            case SlotKind::Object: {
+                auto const &child = std::get<Rc<GcLayout const>>(element);
+                auto const &plan = PlanOf(child);
+
+                for (size_t i = begin; i < end; i++) {
+                    auto present = reader.ReadPresence();
+                    if (!present)
+                        return false;
+                    if (!*present)
+                        continue;
+
+                    GcValue *decoded = DecodeValue(child, plan, reader);
+                    std::memcpy(Offset(value->data, i * stride), &decoded, sizeof(GcValue *));
+                    if (!decoded)
+                        return false;
+                }
+                return true;
+            }
+            default:
+                for (size_t i = begin; i < end; i++) {
+                    if (!DecodeSlot(op, Offset(value->data, i * stride), reader))
+                        return false;
+                }
+                return true;
+        }
+    }
+
+    ArrayValue *DecodeArray(ArrayLayout const &layout, Reader &reader) {
+        uint64_t length = 0;
+        if (!reader.ReadInt(length) || !Fits(OpOf(layout.Layout(), 0), length, reader.Remaining()))
+            return nullptr;
+
+        ArrayValue *value = AllocateArray(layout.Layout(), size_t(length));
+        if (DecodeElements(value, 0, value->size, reader))
+            return value;
+
+        ArrayHandle::FromRaw(value);
+        return nullptr;
+    }
+}
+
+size_t Serpent::EncodedSize(GcHandle const &value) {
+    return WithRaw(value, [](GcValue *raw) { return Measure(raw, PlanOf(raw->layout)); });
+}
+
+size_t Serpent::EncodedSize(ArrayHandle const &value) {
+    return WithRaw(value, [](ArrayValue *raw) { return Measure(raw); });
+}
+
+size_t Serpent::Encode(GcHandle const &value, std::vector<std::byte> &out) {
+    return WithRaw(value, [&out](GcValue *raw) {
+        auto const &plan = PlanOf(raw->layout);
+        size_t size = Measure(raw, plan);
+        size_t start = out.size();
+        out.resize(start + size);
+
+        std::byte *cursor = out.data() + start;
+        Write(raw, plan, cursor);
+
+        return size;
+    });
+}
+
+size_t Serpent::Encode(ArrayHandle const &value, std::vector<std::byte> &out) {
+    return WithRaw(value, [&out](ArrayValue *raw) {
+        size_t size = Measure(raw);
+        size_t start = out.size();
+        out.resize(start + size);
+
+        std::byte *cursor = out.data() + start;
+        Write(raw, cursor);
+
+        return size;
+    });
+}
+
+std::optional<Serpent::GcHandle> Serpent::Decode(Rc<GcLayout const> const &layout, std::span<std::byte const> &input) {
+    Reader reader {input.data(), input.data() + input.size()};
+    GcValue *value = DecodeValue(layout, PlanOf(layout), reader);
+    if (!value)
+        return std::nullopt;
+
+    input = input.subspan(size_t(reader.cursor - input.data()));
+    return GcHandle::FromRaw(value);
+}
+
+std::optional<Serpent::ArrayHandle> Serpent::Decode(ArrayLayout const &layout, std::span<std::byte const> &input) {
+    Reader reader {input.data(), input.data() + input.size()};
+    ArrayValue *value = DecodeArray(layout, reader);
+    if (!value)
+        return std::nullopt;
+
+    input = input.subspan(size_t(reader.cursor - input.data()));
+    return ArrayHandle::FromRaw(value);
+}
+
+size_t Serpent::EncodeChunked(ArrayHandle const &value, std::vector<std::byte> &out, size_t chunkLength, ThreadPool &pool) {
+    return WithRaw(value, [&out, chunkLength, &pool](ArrayValue *raw) {
+        constexpr size_t ChunksPerThread = 4;
+
+        size_t length = raw->size;
+        size_t stride = chunkLength > 0 ? chunkLength : std::max(length / (ChunksPerThread * pool.Concurrency()), size_t(1));
+        size_t chunks = length == 0 ? 0 : (length - 1) / stride + 1;
+        auto bounds = [length, stride](size_t chunk) { return std::pair {chunk * stride, chunk * stride + std::min(stride, length - chunk * stride)}; };
+
+        // Chunk c ends up at offsets[c], measured in parallel, then added up
+        std::vector<size_t> offsets(chunks + 1);
+        pool.For(chunks, 1, [raw, &offsets, &bounds](size_t begin, size_t end) {
+            for (size_t chunk = begin; chunk < end; chunk++) {
+                auto [first, last] = bounds(chunk);
+                offsets[chunk + 1] = MeasureElements(raw, first, last);
+            }
+        });
+        for (size_t chunk = 0; chunk < chunks; chunk++)
+            offsets[chunk + 1] += offsets[chunk];
+
+        size_t index = (2 + chunks) * sizeof(uint64_t);
+        size_t start = out.size();
+        out.resize(start + index + offsets[chunks]);
+
+        std::byte *cursor = out.data() + start;
+        WriteInt(cursor, uint64_t(length));
+        WriteInt(cursor, uint64_t(stride));
+        for (size_t chunk = 0; chunk < chunks; chunk++)
+            WriteInt(cursor, uint64_t(offsets[chunk + 1] - offsets[chunk]));
+
+        pool.For(chunks, 1, [raw, cursor, &offsets, &bounds](size_t begin, size_t end) {
+            for (size_t chunk = begin; chunk < end; chunk++) {
+                auto [first, last] = bounds(chunk);
+                std::byte *target = cursor + offsets[chunk];
+                WriteElements(raw, first, last, target);
+            }
+        });
+
+        return index + offsets[chunks];
+    });
+}
+
+std::optional<Serpent::ArrayHandle> Serpent::DecodeChunked(ArrayLayout const &layout, std::span<std::byte const> &input, ThreadPool &pool) {
+    Reader reader {input.data(), input.data() + input.size()};
+
+    uint64_t length = 0;
+    uint64_t stride = 0;
+    if (!reader.ReadInt(length) || !reader.ReadInt(stride) || (length > 0 && stride == 0))
+        return std::nullopt;
+
+    uint64_t chunks = length == 0 ? 0 : (length - 1) / stride + 1;
+    if (chunks > reader.Remaining() / sizeof(uint64_t))
+        return std::nullopt;
+
+    Op op = OpOf(layout.Layout(), 0);
+    auto bounds = [length, stride](size_t chunk) { return std::pair {size_t(chunk * stride), size_t(chunk * stride + std::min(stride, length - chunk * stride))}; };
+
+    // The whole index is checked against the input before the array is allocated
+    std::vector<size_t> offsets(chunks + 1);
+    for (size_t chunk = 0; chunk < chunks; chunk++) {
+        uint64_t size = 0;
+        reader.ReadInt(size);
+
+        auto [first, last] = bounds(chunk);
+        if (size > reader.Remaining() || !Fits(op, last - first, size_t(size)))
+            return std::nullopt;
+
+        offsets[chunk + 1] = offsets[chunk] + size_t(size);
+    }
+    if (offsets[chunks] > reader.Remaining() || !Fits(op, length, offsets[chunks]))
+        return std::nullopt;
+
+    ArrayValue *value = AllocateArray(layout.Layout(), size_t(length));
+    std::byte const *body = reader.cursor;
+    std::atomic_bool failed = false;
+
+    pool.For(chunks, 1, [value, body, &offsets, &bounds, &failed](size_t begin, size_t end) {
+        for (size_t chunk = begin; chunk < end && !failed.load(std::memory_order_relaxed); chunk++) {
+            auto [first, last] = bounds(chunk);
+            Reader part {body + offsets[chunk], body + offsets[chunk + 1]};
+            if (!DecodeElements(value, first, last, part) || part.Remaining() != 0)
+                failed.store(true, std::memory_order_relaxed);
+        }
+    });
+
+    if (failed.load()) {
+        ArrayHandle::FromRaw(value);
+        return std::nullopt;
+    }
+
+    input = input.subspan(size_t(body - input.data()) + offsets[chunks]);
+    return ArrayHandle::FromRaw(value);
+}
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <variant>
+#include <vector>
+
+#include "serpent/layout.hpp"
+#include "gc.hpp"
+#include "plan_cache.hpp"
+
+/// Internals of the binary encoding in binary.hpp, shared with the translation units that speak the same format
+namespace Serpent::Binary {
+    enum struct SlotKind : uint8_t {
+        Bytes,
+        String,
+        Object,
+        Array,
+    };
+
+    struct Op final {
+        SlotKind kind;
+        size_t offset;
+        /// Length of a Bytes run
+        size_t size;
+        /// Width of the scalars in a Bytes run. Big endian hosts swap them one at a time, so runs only merge scalars of the same width there
+        size_t width;
+        /// The field's layout for Object and Array, kept alive along with the plan
+        ValueLayout const *layout;
+    };
+
+    /// A decoded field that needs validating, the unsigned integer of this width at this offset must be below count
+    struct Check final {
+        size_t offset;
+        size_t width;
+        uint64_t count;
+    };
+
+    inline Op OpOf(ValueLayout const &layout, size_t offset) {
+        if (std::holds_alternative<PrimitiveLayout>(layout) && std::get<PrimitiveLayout>(layout) == PrimitiveLayout::String)
+            return {SlotKind::String, offset, sizeof(size_t), 0, &layout};
+        if (std::holds_alternative<Rc<GcLayout const>>(layout))
+            return {SlotKind::Object, offset, sizeof(GcValue *), 0, &layout};
+        if (std::holds_alternative<ArrayLayout>(layout))
+            return {SlotKind::Array, offset, sizeof(ArrayValue *), 0, &layout};
+
+        size_t size = GetSize(layout);
+        return {SlotKind::Bytes, offset, size, size, nullptr};
+    }
+
+    inline std::optional<Check> CheckOf(ValueLayout const &layout, size_t offset) {
+        if (std::holds_alternative<IntegralLayout>(layout) && std::get<IntegralLayout>(layout) == IntegralLayout::Bool)
+            return Check {offset, 1, 2};
+        if (auto en = std::get_if<Rc<EnumLayout const>>(&layout))
+            return Check {offset, GetSize(layout), (*en)->Names().size()};
+
+        return std::nullopt;
+    }
+
+    /// Copies scalars of the given width between memory and the wire, which is little endian
+    inline void CopyScalars(void *target, void const *source, size_t size, size_t width) {
+        if constexpr (std::endian::native == std::endian::little) {
+            std::memcpy(target, source, size);
+        } else {
+            auto out = static_cast<std::byte *>(target);
+            auto in = static_cast<std::byte const *>(source);
+
+            for (size_t i = 0; i < size; i += width) {
+                for (size_t j = 0; j < width; j++)
+                    out[i + j] = in[i + width - 1 - j];
+            }
+        }
+    }
+
+    inline uint64_t LoadUnsigned(void const *slot, size_t width) {
+        switch (width) {
+            case 1: {
+                uint8_t value;
+                std::memcpy(&value, slot, 1);
+                return value;
+            }
+            case 2: {
+                uint16_t value;
+                std::memcpy(&value, slot, 2);
+                return value;
+            }
+            case 4: {
+                uint32_t value;
+                std::memcpy(&value, slot, 4);
+                return value;
+            }
+            default: {
+                uint64_t value;
+                std::memcpy(&value, slot, 8);
+                return value;
+            }
+        }
+    }
+
+    /// Everything encoding and decoding need to know about a GcLayout, flattened into a list of ops.
+    /// Plain fields that sit next to each other are merged into a single Bytes op
+    struct Plan final {
+        std::vector<Op> ops {};
+        std::vector<Check> checks {};
+        /// Only for VariantLayout, whose tag is handled on its own, then one op for each variant's payload
+        size_t tagSize = 0;
+        std::vector<Op> payloads {};
+        std::vector<std::optional<Check>> payloadChecks {};
+        /// Bytes the Bytes ops take on the wire
+        size_t fixed = 0;
+        /// Any ops other than Bytes
+        bool references = false;
+
+        void Push(ValueLayout const &layout, size_t offset) {
+            if (auto check = CheckOf(layout, offset))
+                checks.push_back(*check);
+
+            Op op = OpOf(layout, offset);
+            if (op.kind == SlotKind::Bytes) {
+                if (op.size == 0)
+                    return;
+
+                fixed += op.size;
+
+                if (!ops.empty()) {
+                    auto &last = ops.back();
+                    bool sameWidth = std::endian::native == std::endian::little || last.width == op.width;
+                    if (last.kind == SlotKind::Bytes && last.offset + last.size == op.offset && sameWidth) {
+                        last.size += op.size;
+                        return;
+                    }
+                }
+            } else {
+                references = true;
+            }
+
+            ops.push_back(op);
+        }
+
+        static Plan Compile(GcLayout const &layout) {
+            Plan plan {};
+
+            std::visit(
+                [&plan](auto const &layout) {
+                    using T = std::decay_t<decltype(layout)>;
+                    if constexpr (std::same_as<T, ObjectLayout>) {
+                        for (auto const &field : layout.Fields())
+                            plan.Push(field.layout.Layout(), field.offset);
+                    } else if constexpr (std::same_as<T, TupleLayout>) {
+                        for (auto const &field : layout.Fields())
+                            plan.Push(field.layout, field.offset);
+                    } else {
+                        plan.tagSize = layout.TagSize();
+
+                        for (auto const &variant : layout.Variants()) {
+                            auto op = OpOf(variant.Layout(), layout.PayloadOffset());
+                            plan.references |= op.kind != SlotKind::Bytes;
+                            plan.payloads.push_back(op);
+                            plan.payloadChecks.push_back(CheckOf(variant.Layout(), layout.PayloadOffset()));
+                        }
+                    }
+                },
+                layout
+            );
+
+            return plan;
+        }
+    };
+
+    inline Plan const &PlanOf(Rc<GcLayout const> const &layout) {
+        return PlanCache<Plan>::Instance().Of(layout);
+    }
+
+    inline bool Passes(Check const &check, void const *data) {
+        return LoadUnsigned(static_cast<std::byte const *>(data) + check.offset, check.width) < check.count;
+    }
+
+    /// Replaces how Encode and Decode in binary.hpp put strings on the wire, so a connection can send each string once, see schema.cpp.
+    /// Encode measures a value before writing it, and calls measure and write for its strings in the same order
+    struct StringTable final {
+        void *context;
+        /// Bytes the string with this interned index takes on the wire
+        size_t (*measure)(void *context, size_t index);
+        void (*write)(void *context, size_t index, std::byte *&cursor);
+        /// Reads a string and advances cursor past it, returns a new reference to its interned index, or nullopt if the input is truncated or malformed.
+        /// A string always takes at least 4 bytes on the wire
+        std::optional<size_t> (*read)(void *context, std::byte const *&cursor, std::byte const *end);
+    };
+
+    /// The calling thread's string table, or null to write strings inline
+    inline thread_local StringTable const *localStrings = nullptr;
+}
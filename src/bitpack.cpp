@@ -0,0 +1,755 @@
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+#include "serpent/bitpack.hpp"
+#include "serpent/types/interner.hpp"
+#include "gc.hpp"
+#include "plan_cache.hpp"
+
+namespace {
+    using namespace Serpent;
+
+    enum struct OpKind : uint8_t {
+        /// A fixed number of bits, the low bits of an unsigned integer of the field's width
+        Fixed,
+        Unsigned,
+        Signed,
+        Quantized,
+        String,
+        Object,
+        Array,
+    };
+
+    struct Op final {
+        OpKind kind;
+        size_t offset;
+        /// Bytes the field takes in memory
+        size_t width;
+        /// Bits on the wire, for Fixed and Quantized
+        size_t bits;
+        /// Fixed fields must decode to a value below this, 0 if any value is valid
+        uint64_t count;
+        /// For Quantized, the value of a step and its inverse
+        double min;
+        double step;
+        double inverse;
+        /// The field's layout for Object and Array, kept alive along with the plan
+        ValueLayout const *layout;
+    };
+
+    /// Bits needed to tell count values apart
+    size_t BitsFor(size_t count) {
+        return count <= 1 ? 0 : size_t(std::bit_width(count - 1));
+    }
+
+    Op OpOf(ValueLayout const &layout, size_t offset) {
+        Op op {OpKind::Fixed, offset, GetSize(layout), 0, 0, 0, 0, 0, &layout};
+
+        std::visit(
+            [&op](auto const &layout) {
+                using T = std::decay_t<decltype(layout)>;
+                if constexpr (std::same_as<T, IntegralLayout>) {
+                    switch (layout) {
+                        case IntegralLayout::Bool:
+                            op.bits = 1;
+                            op.count = 2;
+                            break;
+                        case IntegralLayout::UInt8:
+                        case IntegralLayout::Int8:
+                            op.bits = 8;
+                            break;
+                        case IntegralLayout::UInt16:
+                        case IntegralLayout::UInt32:
+                        case IntegralLayout::UInt64:
+                            op.kind = OpKind::Unsigned;
+                            break;
+                        case IntegralLayout::Int16:
+                        case IntegralLayout::Int32:
+                        case IntegralLayout::Int64:
+                            op.kind = OpKind::Signed;
+                            break;
+                    }
+                } else if constexpr (std::same_as<T, FloatingLayout>) {
+                    op.bits = op.width * 8;
+                } else if constexpr (std::same_as<T, PrimitiveLayout>) {
+                    if (layout == PrimitiveLayout::String)
+                        op.kind = OpKind::String;
+                } else if constexpr (std::same_as<T, Rc<EnumLayout const>>) {
+                    op.count = layout->Names().size();
+                    op.bits = BitsFor(op.count);
+                } else if constexpr (std::same_as<T, Rc<GcLayout const>>) {
+                    op.kind = OpKind::Object;
+                } else {
+                    op.kind = OpKind::Array;
+                }
+            },
+            layout
+        );
+
+        return op;
+    }
+
+    /// Fewest bits an element of this op can take, for rejecting array lengths the input can't hold
+    size_t MinimumBits(Op const &op) {
+        switch (op.kind) {
+            case OpKind::Fixed:
+            case OpKind::Quantized:
+                return op.bits;
+            case OpKind::Unsigned:
+            case OpKind::Signed:
+            case OpKind::String:
+                return 8;
+            case OpKind::Object:
+            case OpKind::Array:
+                return 1;
+        }
+
+        return 0;
+    }
+}
+
+struct Serpent::BitCodecState final {
+    struct Rule final {
+        Rc<GcLayout const> layout;
+        size_t index;
+        double min;
+        double max;
+        uint8_t bits;
+    };
+
+    std::vector<Rule> rules;
+
+    struct Plan final {
+        std::vector<Op> ops {};
+        /// Only for VariantLayout, whose tag is handled on its own, then one op for each variant's payload
+        bool variant = false;
+        size_t tagSize = 0;
+        size_t tagBits = 0;
+        std::vector<Op> payloads {};
+        /// Any ops holding references, or a variant tag
+        bool references = false;
+
+        static Plan Compile(GcLayout const &layout, BitCodecState const &codec) {
+            Plan plan {};
+
+            std::visit(
+                [&plan, &layout, &codec](auto const &fields) {
+                    using T = std::decay_t<decltype(fields)>;
+                    if constexpr (std::same_as<T, ObjectLayout>) {
+                        for (auto const &field : fields.Fields())
+                            plan.ops.push_back(OpOf(field.layout.Layout(), field.offset));
+
+                        // Rules match layouts structurally, so an equal layout built elsewhere is quantized the same
+                        for (auto const &rule : codec.rules) {
+                            if (*rule.layout != layout)
+                                continue;
+
+                            auto &op = plan.ops[rule.index];
+                            double steps = double((uint64_t(1) << rule.bits) - 1);
+                            op.kind = OpKind::Quantized;
+                            op.bits = rule.bits;
+                            op.min = rule.min;
+                            op.step = (rule.max - rule.min) / steps;
+                            op.inverse = steps / (rule.max - rule.min);
+                            op.count = uint64_t(steps);
+                        }
+                    } else if constexpr (std::same_as<T, TupleLayout>) {
+                        for (auto const &field : fields.Fields())
+                            plan.ops.push_back(OpOf(field.layout, field.offset));
+                    } else {
+                        plan.variant = true;
+                        plan.tagSize = fields.TagSize();
+                        plan.tagBits = BitsFor(fields.Variants().size());
+
+                        for (auto const &variant : fields.Variants())
+                            plan.payloads.push_back(OpOf(variant.Layout(), fields.PayloadOffset()));
+                    }
+                },
+                layout
+            );
+
+            plan.references = plan.variant;
+            for (auto const &op : plan.ops)
+                plan.references |= op.kind == OpKind::String || op.kind == OpKind::Object || op.kind == OpKind::Array;
+
+            return plan;
+        }
+    };
+
+    PlanCache<Plan> plans {};
+
+    Plan const &PlanOf(Rc<GcLayout const> const &layout) {
+        return plans.Of(layout, *this);
+    }
+};
+
+namespace {
+    using Plan = BitCodecState::Plan;
+
+    void *Offset(void *data, size_t offset) {
+        return reinterpret_cast<void *>(reinterpret_cast<size_t>(data) + offset);
+    }
+
+    uint64_t LoadUnsigned(void const *slot, size_t width) {
+        switch (width) {
+            case 0:
+                return 0;
+            case 1: {
+                uint8_t value;
+                std::memcpy(&value, slot, 1);
+                return value;
+            }
+            case 2: {
+                uint16_t value;
+                std::memcpy(&value, slot, 2);
+                return value;
+            }
+            case 4: {
+                uint32_t value;
+                std::memcpy(&value, slot, 4);
+                return value;
+            }
+            default: {
+                uint64_t value;
+                std::memcpy(&value, slot, 8);
+                return value;
+            }
+        }
+    }
+
+    int64_t LoadSigned(void const *slot, size_t width) {
+        switch (width) {
+            case 2: {
+                int16_t value;
+                std::memcpy(&value, slot, 2);
+                return value;
+            }
+            case 4: {
+                int32_t value;
+                std::memcpy(&value, slot, 4);
+                return value;
+            }
+            default: {
+                int64_t value;
+                std::memcpy(&value, slot, 8);
+                return value;
+            }
+        }
+    }
+
+    /// Stores the low bytes of value, Signed fields store their two's complement bits the same way
+    void StoreUnsigned(void *slot, size_t width, uint64_t value) {
+        switch (width) {
+            case 0:
+                break;
+            case 1: {
+                auto narrow = uint8_t(value);
+                std::memcpy(slot, &narrow, 1);
+                break;
+            }
+            case 2: {
+                auto narrow = uint16_t(value);
+                std::memcpy(slot, &narrow, 2);
+                break;
+            }
+            case 4: {
+                auto narrow = uint32_t(value);
+                std::memcpy(slot, &narrow, 4);
+                break;
+            }
+            default:
+                std::memcpy(slot, &value, 8);
+                break;
+        }
+    }
+
+    /// The low `bits` bits set
+    uint64_t MaskOf(size_t bits) {
+        return bits >= 64 ? ~uint64_t(0) : (uint64_t(1) << bits) - 1;
+    }
+
+    uint64_t ToLittle(uint64_t value) {
+        if constexpr (std::endian::native == std::endian::big)
+            return std::byteswap(value);
+        else
+            return value;
+    }
+
+    struct BitWriter final {
+        std::vector<std::byte> &out;
+        /// Bytes of out written so far, out itself grows ahead of it
+        size_t used;
+        /// Bits not yet written to out, fewer than 32 between calls
+        uint64_t pending = 0;
+        size_t count = 0;
+
+        /// bits is at most 32, and value must fit in them
+        void Write(uint64_t value, size_t bits) {
+            pending |= value << count;
+            count += bits;
+
+            if (count >= 32) {
+                if (used + sizeof(uint64_t) > out.size())
+                    out.resize(std::max(out.size() * 2, used + 64));
+
+                uint64_t word = ToLittle(pending);
+                std::memcpy(out.data() + used, &word, sizeof(uint32_t));
+                used += sizeof(uint32_t);
+                pending >>= 32;
+                count -= 32;
+            }
+        }
+
+        void WriteWide(uint64_t value, size_t bits) {
+            if (bits > 32) {
+                Write(value & 0xFFFFFFFF, 32);
+                Write(value >> 32, bits - 32);
+            } else {
+                Write(value, bits);
+            }
+        }
+
+        void WriteVarint(uint64_t value) {
+            while (value >= 0x80) {
+                Write((value & 0x7F) | 0x80, 8);
+                value >>= 7;
+            }
+            Write(value, 8);
+        }
+
+        void WriteBytes(std::string_view bytes) {
+            for (char c : bytes)
+                Write(uint8_t(c), 8);
+        }
+
+        /// Pads the last byte and trims out to what was written
+        void Finish() {
+            size_t bytes = (count + 7) / 8;
+            out.resize(used + sizeof(uint64_t));
+
+            uint64_t word = ToLittle(pending);
+            std::memcpy(out.data() + used, &word, sizeof(uint64_t));
+            used += bytes;
+            out.resize(used);
+        }
+    };
+
+    struct BitReader final {
+        std::byte const *data;
+        size_t size;
+        /// In bits
+        size_t position = 0;
+
+        size_t Remaining() const {
+            return size * 8 - position;
+        }
+
+        /// bits is at most 32
+        bool Read(size_t bits, uint64_t &value) {
+            if (bits > Remaining())
+                return false;
+            if (bits == 0) {
+                value = 0;
+                return true;
+            }
+
+            size_t byte = position / 8;
+            uint64_t word = 0;
+            std::memcpy(&word, data + byte, std::min(sizeof(uint64_t), size - byte));
+
+            value = (ToLittle(word) >> (position % 8)) & MaskOf(bits);
+            position += bits;
+            return true;
+        }
+
+        bool ReadWide(size_t bits, uint64_t &value) {
+            if (bits <= 32)
+                return Read(bits, value);
+
+            uint64_t high = 0;
+            if (!Read(32, value) || !Read(bits - 32, high))
+                return false;
+
+            value |= high << 32;
+            return true;
+        }
+
+        /// Rejects varints that overflow 64 bits, or the field's width
+        bool ReadVarint(uint64_t &value, size_t width) {
+            value = 0;
+
+            for (size_t shift = 0;; shift += 7) {
+                uint64_t group = 0;
+                if (shift >= 64 || !Read(8, group))
+                    return false;
+
+                uint64_t bits = group & 0x7F;
+                if (shift > 57 && bits >> (64 - shift) != 0)
+                    return false;
+
+                value |= bits << shift;
+                if ((group & 0x80) == 0)
+                    break;
+            }
+
+            return width >= sizeof(uint64_t) || value >> (8 * width) == 0;
+        }
+    };
+
+    /// Holds a string read one byte at a time, reused between calls on the same thread
+    thread_local std::string scratch {};
+
+    void Write(BitCodecState &codec, GcValue *value, Plan const &plan, BitWriter &writer);
+    void Write(BitCodecState &codec, ArrayValue *value, BitWriter &writer);
+
+    void WriteSlot(BitCodecState &codec, Op const &op, void *slot, BitWriter &writer) {
+        switch (op.kind) {
+            case OpKind::Fixed:
+                writer.WriteWide(LoadUnsigned(slot, op.width) & MaskOf(op.bits), op.bits);
+                break;
+            case OpKind::Unsigned:
+                writer.WriteVarint(LoadUnsigned(slot, op.width));
+                break;
+            case OpKind::Signed: {
+                int64_t value = LoadSigned(slot, op.width);
+                writer.WriteVarint(uint64_t(value) << 1 ^ uint64_t(value >> 63));
+                break;
+            }
+            case OpKind::Quantized: {
+                double value = 0;
+                if (op.width == sizeof(float)) {
+                    float narrow;
+                    std::memcpy(&narrow, slot, sizeof(float));
+                    value = narrow;
+                } else {
+                    std::memcpy(&value, slot, sizeof(double));
+                }
+
+                double steps = std::isnan(value) ? 0 : std::nearbyint((value - op.min) * op.inverse);
+                writer.Write(uint64_t(std::clamp(steps, 0.0, double(op.count))), op.bits);
+                break;
+            }
+            case OpKind::String: {
+                auto view = Interner::Instance().Get(LoadUnsigned(slot, sizeof(size_t)));
+                writer.WriteVarint(view.size());
+                writer.WriteBytes(view);
+                break;
+            }
+            case OpKind::Object: {
+                GcValue *child = nullptr;
+                std::memcpy(&child, slot, sizeof(GcValue *));
+                writer.Write(child != nullptr, 1);
+                if (child)
+                    Write(codec, child, codec.PlanOf(child->layout), writer);
+                break;
+            }
+            case OpKind::Array: {
+                ArrayValue *child = nullptr;
+                std::memcpy(&child, slot, sizeof(ArrayValue *));
+                writer.Write(child != nullptr, 1);
+                if (child)
+                    Write(codec, child, writer);
+                break;
+            }
+        }
+    }
+
+    void Write(BitCodecState &codec, GcValue *value, Plan const &plan, BitWriter &writer) {
+        void *data = value->Data();
+
+        for (auto const &op : plan.ops)
+            WriteSlot(codec, op, Offset(data, op.offset), writer);
+
+        if (plan.variant) {
+            uint64_t tag = LoadUnsigned(data, plan.tagSize);
+            writer.Write(tag, plan.tagBits);
+            auto const &payload = plan.payloads[tag];
+            WriteSlot(codec, payload, Offset(data, payload.offset), writer);
+        }
+    }
+
+    void Write(BitCodecState &codec, ArrayValue *value, BitWriter &writer) {
+        writer.WriteVarint(value->size);
+
+        size_t stride = GetSize(value->layout);
+        Op op = OpOf(value->layout, 0);
+
+        if (op.kind == OpKind::Object) {
+            // Every element shares the array's layout, so the plan is only looked up once
+            auto const &plan = codec.PlanOf(std::get<Rc<GcLayout const>>(value->layout));
+            for (size_t i = 0; i < value->size; i++) {
+                GcValue *child = nullptr;
+                std::memcpy(&child, Offset(value->data, i * stride), sizeof(GcValue *));
+                writer.Write(child != nullptr, 1);
+                if (child)
+                    Write(codec, child, plan, writer);
+            }
+        } else {
+            for (size_t i = 0; i < value->size; i++)
+                WriteSlot(codec, op, Offset(value->data, i * stride), writer);
+        }
+    }
+
+    GcValue *ReadValue(BitCodecState &codec, Rc<GcLayout const> const &layout, Plan const &plan, BitReader &reader);
+    ArrayValue *ReadArray(BitCodecState &codec, ArrayLayout const &layout, BitReader &reader);
+
+    /// Reads into an initialized slot
+    bool ReadSlot(BitCodecState &codec, Op const &op, void *slot, BitReader &reader) {
+        uint64_t value = 0;
+
+        switch (op.kind) {
+            case OpKind::Fixed:
+                if (!reader.ReadWide(op.bits, value) || (op.count > 0 && value >= op.count))
+                    return false;
+
+                StoreUnsigned(slot, op.width, value);
+                return true;
+            case OpKind::Unsigned:
+                if (!reader.ReadVarint(value, op.width))
+                    return false;
+
+                StoreUnsigned(slot, op.width, value);
+                return true;
+            case OpKind::Signed:
+                if (!reader.ReadVarint(value, op.width))
+                    return false;
+
+                StoreUnsigned(slot, op.width, (value >> 1) ^ (~(value & 1) + 1));
+                return true;
+            case OpKind::Quantized: {
+                if (!reader.Read(op.bits, value))
+                    return false;
+
+                double decoded = op.min + double(value) * op.step;
+                if (op.width == sizeof(float)) {
+                    auto narrow = float(decoded);
+                    std::memcpy(slot, &narrow, sizeof(float));
+                } else {
+                    std::memcpy(slot, &decoded, sizeof(double));
+                }
+                return true;
+            }
+            case OpKind::String: {
+                if (!reader.ReadVarint(value, sizeof(uint64_t)) || value > reader.Remaining() / 8)
+                    return false;
+
+                scratch.resize(size_t(value));
+                for (auto &c : scratch) {
+                    uint64_t byte = 0;
+                    reader.Read(8, byte);
+                    c = char(byte);
+                }
+
+                auto &interner = Interner::Instance();
+                size_t index = interner.Acquire(scratch);
+                interner.RemoveRef(LoadUnsigned(slot, sizeof(size_t)));
+                std::memcpy(slot, &index, sizeof(size_t));
+                return true;
+            }
+            case OpKind::Object: {
+                if (!reader.Read(1, value))
+                    return false;
+                if (value == 0)
+                    return true;
+
+                auto const &layout = std::get<Rc<GcLayout const>>(*op.layout);
+                GcValue *child = ReadValue(codec, layout, codec.PlanOf(layout), reader);
+                std::memcpy(slot, &child, sizeof(GcValue *));
+                return child != nullptr;
+            }
+            case OpKind::Array: {
+                if (!reader.Read(1, value))
+                    return false;
+                if (value == 0)
+                    return true;
+
+                ArrayValue *child = ReadArray(codec, std::get<ArrayLayout>(*op.layout), reader);
+                std::memcpy(slot, &child, sizeof(ArrayValue *));
+                return child != nullptr;
+            }
+        }
+
+        return false;
+    }
+
+    bool ReadInto(BitCodecState &codec, GcValue *value, Plan const &plan, BitReader &reader) {
+        void *data = value->Data();
+
+        for (auto const &op : plan.ops) {
+            if (!ReadSlot(codec, op, Offset(data, op.offset), reader))
+                return false;
+        }
+
+        if (plan.variant) {
+            uint64_t tag = 0;
+            if (!reader.Read(plan.tagBits, tag) || tag >= plan.payloads.size())
+                return false;
+
+            auto const &payload = plan.payloads[tag];
+            void *slot = Offset(data, payload.offset);
+
+            // Initialize made the first variant active
+            if (tag != 0) {
+                auto const &variants = std::get<VariantLayout>(*value->layout).Variants();
+                Release(variants[0].Layout(), slot);
+                StoreUnsigned(data, plan.tagSize, tag);
+                DefaultInitialize(variants[tag].Layout(), slot);
+            }
+
+            if (!ReadSlot(codec, payload, slot, reader))
+                return false;
+        }
+
+        return true;
+    }
+
+    /// Returns null if the input is malformed
+    GcValue *ReadValue(BitCodecState &codec, Rc<GcLayout const> const &layout, Plan const &plan, BitReader &reader) {
+        GcValue *value = localArena ? Allocate(localArena, layout) : Allocate(layout);
+
+        // Every byte of a plain value's fields is about to be overwritten, anything else must be valid in case reading stops halfway
+        if (plan.references)
+            std::visit([value](auto const &layout) { layout.Initialize(value->Data()); }, *layout);
+
+        if (ReadInto(codec, value, plan, reader))
+            return value;
+
+        GcHandle::FromRaw(value);
+        return nullptr;
+    }
+
+    ArrayValue *ReadArray(BitCodecState &codec, ArrayLayout const &layout, BitReader &reader) {
+        auto const &element = layout.Layout();
+        Op op = OpOf(element, 0);
+
+        size_t stride = GetSize(element);
+        uint64_t length = 0;
+        if (!reader.ReadVarint(length, sizeof(uint64_t)))
+            return nullptr;
+
+        // Rejects lengths the rest of the input can't hold before allocating anything.
+        // Elements that take no bits, like Unit or single name enums, are capped at 4 GiB of memory instead
+        size_t minimum = MinimumBits(op);
+        if (minimum > 0 ? length > reader.Remaining() / minimum : length > std::numeric_limits<uint32_t>::max() / std::max<size_t>(stride, 1))
+            return nullptr;
+
+        ArrayValue *value = localArena ? Allocate(localArena, element, size_t(length)) : Allocate(element, size_t(length));
+
+        if (op.kind == OpKind::String) {
+            for (size_t i = 0; i < value->size; i++)
+                DefaultInitialize(element, Offset(value->data, i * stride));
+        } else if (op.kind != OpKind::Fixed && op.kind != OpKind::Unsigned && op.kind != OpKind::Signed && value->data) {
+            std::memset(value->data, 0, stride * value->size);
+        }
+
+        bool success = true;
+        if (op.kind == OpKind::Object) {
+            auto const &child = std::get<Rc<GcLayout const>>(element);
+            auto const &plan = codec.PlanOf(child);
+
+            for (size_t i = 0; success && i < value->size; i++) {
+                uint64_t present = 0;
+                success = reader.Read(1, present);
+                if (success && present) {
+                    GcValue *decoded = ReadValue(codec, child, plan, reader);
+                    std::memcpy(Offset(value->data, i * stride), &decoded, sizeof(GcValue *));
+                    success = decoded != nullptr;
+                }
+            }
+        } else {
+            for (size_t i = 0; success && i < value->size; i++)
+                success = ReadSlot(codec, op, Offset(value->data, i * stride), reader);
+        }
+
+        if (success)
+            return value;
+
+        ArrayHandle::FromRaw(value);
+        return nullptr;
+    }
+
+    /// Runs a read, then advances input past every byte it touched
+    template <typename TValue, typename TFunc>
+    std::optional<TValue> Run(std::span<std::byte const> &input, TFunc &&func) {
+        BitReader reader {input.data(), input.size()};
+        auto raw = func(reader);
+        if (!raw)
+            return std::nullopt;
+
+        input = input.subspan((reader.position + 7) / 8);
+        return TValue::FromRaw(raw);
+    }
+}
+
+Serpent::BitCodec::BitCodec(std::unique_ptr<BitCodecState> state) :
+    state(std::move(state)) {}
+
+Serpent::BitCodec::BitCodec(BitCodec &&move) = default;
+
+Serpent::BitCodec::~BitCodec() = default;
+
+Serpent::BitCodec &Serpent::BitCodec::operator = (BitCodec &&move) = default;
+
+std::optional<Serpent::BitCodec> Serpent::BitCodec::Of(std::initializer_list<Quantization> quantizations) {
+    auto state = std::make_unique<BitCodecState>();
+
+    for (auto const &quantization : quantizations) {
+        auto object = std::get_if<ObjectLayout>(&*quantization.layout);
+        if (!object)
+            return std::nullopt;
+
+        auto index = object->IndexOf(InternedString(quantization.field));
+        if (!index || !std::holds_alternative<FloatingLayout>(object->Fields()[*index].layout.Layout()))
+            return std::nullopt;
+        if (quantization.bits == 0 || quantization.bits > 32 || !(quantization.min < quantization.max) || !std::isfinite(quantization.max - quantization.min))
+            return std::nullopt;
+
+        for (auto const &rule : state->rules) {
+            if (*rule.layout == *quantization.layout && rule.index == *index)
+                return std::nullopt;
+        }
+
+        state->rules.push_back({quantization.layout, *index, quantization.min, quantization.max, quantization.bits});
+    }
+
+    return BitCodec(std::move(state));
+}
+
+size_t Serpent::BitCodec::Encode(GcHandle const &value, std::vector<std::byte> &out) const {
+    return WithRaw(value, [this, &out](GcValue *raw) {
+        size_t start = out.size();
+        BitWriter writer {out, start};
+        Write(*state, raw, state->PlanOf(raw->layout), writer);
+        writer.Finish();
+
+        return out.size() - start;
+    });
+}
+
+size_t Serpent::BitCodec::Encode(ArrayHandle const &value, std::vector<std::byte> &out) const {
+    return WithRaw(value, [this, &out](ArrayValue *raw) {
+        size_t start = out.size();
+        BitWriter writer {out, start};
+        Write(*state, raw, writer);
+        writer.Finish();
+
+        return out.size() - start;
+    });
+}
+
+std::optional<Serpent::GcHandle> Serpent::BitCodec::Decode(Rc<GcLayout const> const &layout, std::span<std::byte const> &input) const {
+    return Run<GcHandle>(input, [this, &layout](BitReader &reader) { return ReadValue(*state, layout, state->PlanOf(layout), reader); });
+}
+
+std::optional<Serpent::ArrayHandle> Serpent::BitCodec::Decode(ArrayLayout const &layout, std::span<std::byte const> &input) const {
+    return Run<ArrayHandle>(input, [this, &layout](BitReader &reader) { return ReadArray(*state, layout, reader); });
+}
@@ -0,0 +1,56 @@
+#include <cstddef>
+#include <optional>
+
+#include "serpent/convert.hpp"
+#include "serpent/layout.hpp"
+#include "serpent/value.hpp"
+#include "convert/table.hpp"
+#include "simd/cpu.hpp"
+#include "simd/scalar.hpp"
+
+Serpent::Simd::ConvertTable const &Serpent::Simd::Conversions() {
+    static ConvertTable const &table = []() -> ConvertTable const & {
+        if (Detect() == Isa::Avx2) {
+            if (auto avx2 = Avx2Conversions())
+                return *avx2;
+        }
+
+        return BaselineConversions();
+    }();
+
+    return table;
+}
+
+size_t Serpent::Simd::ModeOf(ConvertOptions const &options) {
+    size_t mode = ConvertWrap;
+    if (options.overflow == Overflow::Saturate)
+        mode |= ConvertSaturate;
+    if (options.normalized)
+        mode |= ConvertNormalized;
+
+    return mode;
+}
+
+bool Serpent::Convert(ArrayHandle const &source, ArrayHandle const &destination, ConvertOptions options) {
+    auto from = Simd::KindOf(source.Layout());
+    auto to = Simd::KindOf(destination.Layout());
+    if (!from || !to || source.Length() != destination.Length() || destination.IsFrozen())
+        return false;
+
+    if (source.PointerEq(destination))
+        return true;
+
+    Simd::Conversions().Get(*from, *to, Simd::ModeOf(options))(source.Data(), destination.Data(), source.Length());
+
+    return true;
+}
+
+std::optional<Serpent::ArrayHandle> Serpent::Convert(ArrayHandle const &source, ValueLayout const &destination, ConvertOptions options) {
+    if (!Simd::KindOf(source.Layout()) || !Simd::KindOf(destination))
+        return std::nullopt;
+
+    auto result = ArrayHandle::Create(ArrayLayout::Of(ValueLayout(destination)), source.Length());
+    Convert(source, result, options);
+
+    return result;
+}
@@ -0,0 +1,15 @@
+#include "table.hpp"
+
+#if defined(__AVX2__)
+#include "impl.hpp"
+#endif
+
+Serpent::Simd::ConvertTable const *Serpent::Simd::Avx2Conversions() {
+#if defined(__AVX2__)
+    static ConvertTable const table = MakeConvertTable();
+
+    return &table;
+#else
+    return nullptr;
+#endif
+}
@@ -0,0 +1,8 @@
+#include "impl.hpp"
+#include "table.hpp"
+
+Serpent::Simd::ConvertTable const &Serpent::Simd::BaselineConversions() {
+    static ConvertTable const table = MakeConvertTable();
+
+    return table;
+}
@@ -0,0 +1,396 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+#include "../simd/scalar.hpp"
+#include "../simd/vec.hpp"
+#include "table.hpp"
+
+/// Conversion bodies shared by every ISA translation unit, see kernels/impl.hpp.
+/// Each kernel converts as many leading elements as it can with vector code, then finishes the tail with ConvertOne,
+/// so the vector paths must agree with ConvertOne bit for bit.
+namespace {
+    using Serpent::Simd::ConvertNormalized;
+    using Serpent::Simd::ConvertSaturate;
+
+    template <typename S, typename D, size_t Mode, bool ToBool>
+    D ConvertOne(S value) {
+        constexpr bool saturate = Mode & ConvertSaturate;
+        constexpr bool normalized = Mode & ConvertNormalized;
+        constexpr D min = std::numeric_limits<D>::lowest();
+        constexpr D max = std::numeric_limits<D>::max();
+
+        if constexpr (ToBool) {
+            return value != S(0) ? 1 : 0;
+        } else if constexpr (std::is_integral_v<S> && std::is_integral_v<D>) {
+            if constexpr (saturate) {
+                if (std::cmp_less(value, min))
+                    return min;
+                if (std::cmp_greater(value, max))
+                    return max;
+            }
+
+            return static_cast<D>(value);
+        } else if constexpr (std::is_integral_v<S>) {
+            if constexpr (normalized) {
+                D scaled = static_cast<D>(value) / static_cast<D>(std::numeric_limits<S>::max());
+                if constexpr (std::is_signed_v<S>)
+                    return scaled < D(-1) ? D(-1) : scaled;
+                else
+                    return scaled;
+            }
+
+            return static_cast<D>(value);
+        } else if constexpr (std::is_integral_v<D>) {
+            if (value != value)
+                return 0;
+
+            if constexpr (normalized) {
+                constexpr S lo = std::is_signed_v<D> ? S(-1) : S(0);
+                S clamped = value < lo ? lo : (value > S(1) ? S(1) : value);
+                // Scaling by the maximum can round past it for 32 and 64 bit destinations, the saturating branch below catches that
+                return ConvertOne<S, D, ConvertSaturate, false>(std::nearbyint(clamped * static_cast<S>(max)));
+            } else if constexpr (saturate) {
+                if (value <= static_cast<S>(min))
+                    return min;
+                if (value >= static_cast<S>(max))
+                    return max;
+
+                return static_cast<D>(value);
+            } else {
+                if (!std::isfinite(value))
+                    return 0;
+
+                constexpr double range = 18446744073709551616.0;
+                double wrapped = std::fmod(std::trunc(static_cast<double>(value)), range);
+                uint64_t bits = wrapped < 0 ? uint64_t(0) - static_cast<uint64_t>(-wrapped) : static_cast<uint64_t>(wrapped);
+
+                return static_cast<D>(bits);
+            }
+        } else {
+            if constexpr (saturate && sizeof(D) < sizeof(S)) {
+                if (value > static_cast<S>(max))
+                    return max;
+                if (value < -static_cast<S>(max))
+                    return -max;
+            }
+
+            return static_cast<D>(value);
+        }
+    }
+
+#if defined(SERPENT_SIMD_SSE2)
+    template <typename T>
+    __m128i LoadLow32(T const *ptr) {
+        int32_t bits;
+        std::memcpy(&bits, ptr, sizeof(bits));
+
+        return _mm_cvtsi32_si128(bits);
+    }
+
+    template <typename T>
+    __m128i LoadLow64(T const *ptr) {
+        return _mm_loadl_epi64(reinterpret_cast<__m128i const *>(ptr));
+    }
+
+    template <typename T>
+    void StoreLow64(T *ptr, __m128i value) {
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(ptr), value);
+    }
+
+    /// Loads four integers of type S, sign or zero extended into 32 bit lanes
+    template <typename S>
+    __m128i LoadInt32x4(S const *src) {
+        __m128i zero = _mm_setzero_si128();
+
+        if constexpr (std::is_same_v<S, int8_t>) {
+            __m128i bytes = LoadLow32(src);
+            __m128i words = _mm_unpacklo_epi8(bytes, bytes);
+            return _mm_srai_epi32(_mm_unpacklo_epi16(words, words), 24);
+        } else if constexpr (std::is_same_v<S, uint8_t>) {
+            return _mm_unpacklo_epi16(_mm_unpacklo_epi8(LoadLow32(src), zero), zero);
+        } else if constexpr (std::is_same_v<S, int16_t>) {
+            __m128i words = LoadLow64(src);
+            return _mm_srai_epi32(_mm_unpacklo_epi16(words, words), 16);
+        } else if constexpr (std::is_same_v<S, uint16_t>) {
+            return _mm_unpacklo_epi16(LoadLow64(src), zero);
+        } else {
+            return _mm_loadu_si128(reinterpret_cast<__m128i const *>(src));
+        }
+    }
+
+    /// Narrows two vectors of 32 bit lanes that are already within D's range into eight D lanes, in the low bytes of the result
+    template <typename D>
+    __m128i PackInt32x8(__m128i lo, __m128i hi) {
+        if constexpr (std::is_same_v<D, int16_t>) {
+            return _mm_packs_epi32(lo, hi);
+        } else if constexpr (std::is_same_v<D, uint16_t>) {
+            // SSE2 can only pack with signed saturation, so bias into the signed range and back
+            __m128i bias = _mm_set1_epi32(32768);
+            __m128i packed = _mm_packs_epi32(_mm_sub_epi32(lo, bias), _mm_sub_epi32(hi, bias));
+            return _mm_xor_si128(packed, _mm_set1_epi16(static_cast<short>(0x8000)));
+        } else if constexpr (std::is_same_v<D, int8_t>) {
+            __m128i words = _mm_packs_epi32(lo, hi);
+            return _mm_packs_epi16(words, words);
+        } else {
+            __m128i words = _mm_packs_epi32(lo, hi);
+            return _mm_packus_epi16(words, words);
+        }
+    }
+
+    /// Keeps the low bits of each lane, so the following signed pack never saturates
+    template <size_t FromBits, size_t ToBits>
+    __m128i TruncateLanes(__m128i value) {
+        if constexpr (FromBits == 32)
+            return _mm_srai_epi32(_mm_slli_epi32(value, 32 - ToBits), 32 - ToBits);
+        else
+            return _mm_srai_epi16(_mm_slli_epi16(value, 16 - ToBits), 16 - ToBits);
+    }
+
+    template <typename S, typename D, size_t Mode>
+    size_t ConvertVector(S const *src, D *dst, size_t count) {
+        constexpr bool saturate = Mode & ConvertSaturate;
+        constexpr bool normalized = Mode & ConvertNormalized;
+        constexpr bool intToInt = std::is_integral_v<S> && std::is_integral_v<D>;
+        size_t i = 0;
+
+        if constexpr (std::is_same_v<S, double> && std::is_same_v<D, float>) {
+            // min/max return their second operand on NaN, so NaN passes through the clamp untouched
+#if defined(SERPENT_SIMD_AVX2)
+            __m256d hi = _mm256_set1_pd(std::numeric_limits<float>::max());
+            __m256d lo = _mm256_set1_pd(-std::numeric_limits<float>::max());
+            for (; i + 4 <= count; i += 4) {
+                __m256d value = _mm256_loadu_pd(src + i);
+                if constexpr (saturate)
+                    value = _mm256_max_pd(lo, _mm256_min_pd(hi, value));
+                _mm_storeu_ps(dst + i, _mm256_cvtpd_ps(value));
+            }
+#else
+            __m128d hi = _mm_set1_pd(std::numeric_limits<float>::max());
+            __m128d lo = _mm_set1_pd(-std::numeric_limits<float>::max());
+            for (; i + 4 <= count; i += 4) {
+                __m128d a = _mm_loadu_pd(src + i);
+                __m128d b = _mm_loadu_pd(src + i + 2);
+                if constexpr (saturate) {
+                    a = _mm_max_pd(lo, _mm_min_pd(hi, a));
+                    b = _mm_max_pd(lo, _mm_min_pd(hi, b));
+                }
+                _mm_storeu_ps(dst + i, _mm_movelh_ps(_mm_cvtpd_ps(a), _mm_cvtpd_ps(b)));
+            }
+#endif
+        } else if constexpr (std::is_same_v<S, float> && std::is_same_v<D, double>) {
+#if defined(SERPENT_SIMD_AVX2)
+            for (; i + 4 <= count; i += 4)
+                _mm256_storeu_pd(dst + i, _mm256_cvtps_pd(_mm_loadu_ps(src + i)));
+#else
+            for (; i + 4 <= count; i += 4) {
+                __m128 value = _mm_loadu_ps(src + i);
+                _mm_storeu_pd(dst + i, _mm_cvtps_pd(value));
+                _mm_storeu_pd(dst + i + 2, _mm_cvtps_pd(_mm_movehl_ps(value, value)));
+            }
+#endif
+        } else if constexpr (std::is_integral_v<S> && sizeof(S) <= 4 && !std::is_same_v<S, uint32_t> && std::is_same_v<D, float>) {
+            __m128 divisor = _mm_set1_ps(static_cast<float>(std::numeric_limits<S>::max()));
+            __m128 negativeOne = _mm_set1_ps(-1.0f);
+
+#if defined(SERPENT_SIMD_AVX2)
+            __m256 divisor8 = _mm256_set1_ps(static_cast<float>(std::numeric_limits<S>::max()));
+            __m256 negativeOne8 = _mm256_set1_ps(-1.0f);
+
+            for (; i + 8 <= count; i += 8) {
+                __m256i ints;
+                if constexpr (std::is_same_v<S, int8_t>)
+                    ints = _mm256_cvtepi8_epi32(LoadLow64(src + i));
+                else if constexpr (std::is_same_v<S, uint8_t>)
+                    ints = _mm256_cvtepu8_epi32(LoadLow64(src + i));
+                else if constexpr (std::is_same_v<S, int16_t>)
+                    ints = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const *>(src + i)));
+                else if constexpr (std::is_same_v<S, uint16_t>)
+                    ints = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const *>(src + i)));
+                else
+                    ints = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(src + i));
+
+                __m256 value = _mm256_cvtepi32_ps(ints);
+                if constexpr (normalized) {
+                    value = _mm256_div_ps(value, divisor8);
+                    if constexpr (std::is_signed_v<S>)
+                        value = _mm256_max_ps(value, negativeOne8);
+                }
+                _mm256_storeu_ps(dst + i, value);
+            }
+#endif
+
+            for (; i + 4 <= count; i += 4) {
+                __m128 value = _mm_cvtepi32_ps(LoadInt32x4(src + i));
+                if constexpr (normalized) {
+                    value = _mm_div_ps(value, divisor);
+                    if constexpr (std::is_signed_v<S>)
+                        value = _mm_max_ps(value, negativeOne);
+                }
+                _mm_storeu_ps(dst + i, value);
+            }
+        } else if constexpr (intToInt && sizeof(D) == 2 * sizeof(S) && (std::is_unsigned_v<S> || std::is_signed_v<D> || !saturate)) {
+            // Widening is exact unless a negative value saturates to an unsigned destination
+            __m128i zero = _mm_setzero_si128();
+            constexpr size_t lanes = 16 / sizeof(S);
+
+            for (; i + lanes <= count; i += lanes) {
+                __m128i value = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + i));
+                __m128i extension = zero;
+
+                if constexpr (std::is_same_v<S, int8_t>) {
+                    extension = _mm_cmpgt_epi8(zero, value);
+                } else if constexpr (std::is_same_v<S, int16_t>) {
+                    extension = _mm_cmpgt_epi16(zero, value);
+                } else if constexpr (std::is_same_v<S, int32_t>) {
+                    extension = _mm_cmpgt_epi32(zero, value);
+                }
+
+                __m128i *out = reinterpret_cast<__m128i *>(dst + i);
+                if constexpr (sizeof(S) == 1) {
+                    _mm_storeu_si128(out, _mm_unpacklo_epi8(value, extension));
+                    _mm_storeu_si128(out + 1, _mm_unpackhi_epi8(value, extension));
+                } else if constexpr (sizeof(S) == 2) {
+                    _mm_storeu_si128(out, _mm_unpacklo_epi16(value, extension));
+                    _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(value, extension));
+                } else {
+                    _mm_storeu_si128(out, _mm_unpacklo_epi32(value, extension));
+                    _mm_storeu_si128(out + 1, _mm_unpackhi_epi32(value, extension));
+                }
+            }
+        } else if constexpr (std::is_same_v<S, float> && (std::is_same_v<D, int32_t> ? (saturate && !normalized) : (std::is_integral_v<D> && sizeof(D) <= 2 && (saturate || normalized)))) {
+            constexpr float lo = normalized ? (std::is_signed_v<D> ? -1.0f : 0.0f) : static_cast<float>(std::numeric_limits<D>::lowest());
+            constexpr float hi = normalized ? 1.0f : static_cast<float>(std::numeric_limits<D>::max());
+            __m128 loV = _mm_set1_ps(lo);
+            __m128 hiV = _mm_set1_ps(hi);
+            __m128 scale = _mm_set1_ps(static_cast<float>(std::numeric_limits<D>::max()));
+
+            auto convert = [&](__m128 value) {
+                value = _mm_and_ps(value, _mm_cmpord_ps(value, value));
+
+                if constexpr (std::is_same_v<D, int32_t>) {
+                    // Out of range lanes convert to INT32_MIN, flip the ones that overflowed upwards to INT32_MAX
+                    __m128 overflow = _mm_cmpge_ps(value, _mm_set1_ps(2147483648.0f));
+                    return _mm_xor_si128(_mm_cvttps_epi32(value), _mm_castps_si128(overflow));
+                }
+
+                value = _mm_min_ps(_mm_max_ps(value, loV), hiV);
+                if constexpr (normalized)
+                    return _mm_cvtps_epi32(_mm_mul_ps(value, scale));
+                else
+                    return _mm_cvttps_epi32(value);
+            };
+
+            if constexpr (std::is_same_v<D, int32_t>) {
+                for (; i + 4 <= count; i += 4)
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), convert(_mm_loadu_ps(src + i)));
+            } else {
+                for (; i + 8 <= count; i += 8) {
+                    __m128i packed = PackInt32x8<D>(convert(_mm_loadu_ps(src + i)), convert(_mm_loadu_ps(src + i + 4)));
+                    if constexpr (sizeof(D) == 2)
+                        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), packed);
+                    else
+                        StoreLow64(dst + i, packed);
+                }
+            }
+        } else if constexpr (intToInt && sizeof(S) == 4 && sizeof(D) < 4 && (!saturate || std::is_same_v<S, int32_t>)) {
+            // Saturating narrows rely on signed packs, so only signed sources can use them
+            if constexpr (saturate && std::is_same_v<D, uint16_t>)
+                return 0;
+
+            for (; i + 8 <= count; i += 8) {
+                __m128i lo = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + i));
+                __m128i hi = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + i + 4));
+
+                if constexpr (!saturate) {
+                    lo = TruncateLanes<32, sizeof(D) * 8>(lo);
+                    hi = TruncateLanes<32, sizeof(D) * 8>(hi);
+                }
+
+                __m128i packed;
+                if constexpr (sizeof(D) == 2) {
+                    packed = _mm_packs_epi32(lo, hi);
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), packed);
+                } else {
+                    __m128i words = _mm_packs_epi32(lo, hi);
+                    packed = std::is_signed_v<D> || !saturate ? _mm_packs_epi16(words, words) : _mm_packus_epi16(words, words);
+                    StoreLow64(dst + i, packed);
+                }
+            }
+        } else if constexpr (intToInt && sizeof(S) == 2 && sizeof(D) == 1 && (!saturate || std::is_same_v<S, int16_t>)) {
+            for (; i + 16 <= count; i += 16) {
+                __m128i lo = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + i));
+                __m128i hi = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + i + 8));
+
+                __m128i packed;
+                if constexpr (!saturate)
+                    packed = _mm_packs_epi16(TruncateLanes<16, 8>(lo), TruncateLanes<16, 8>(hi));
+                else if constexpr (std::is_signed_v<D>)
+                    packed = _mm_packs_epi16(lo, hi);
+                else
+                    packed = _mm_packus_epi16(lo, hi);
+
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), packed);
+            }
+        }
+
+        return i;
+    }
+#else
+    template <typename S, typename D, size_t Mode>
+    size_t ConvertVector(S const *, D *, size_t) {
+        return 0;
+    }
+#endif
+
+    template <Serpent::Simd::ScalarKind Source, Serpent::Simd::ScalarKind Destination, size_t Mode>
+    void Convert(void const *source, void *destination, size_t count) {
+        using S = Serpent::Simd::Scalar<Source>;
+        using D = Serpent::Simd::Scalar<Destination>;
+        constexpr bool toBool = Destination == Serpent::Simd::ScalarKind::Bool;
+        constexpr bool bitCopy = std::is_same_v<S, D> || (std::is_integral_v<S> && std::is_integral_v<D> && sizeof(S) == sizeof(D) && !(Mode & ConvertSaturate));
+
+        S const *src = reinterpret_cast<S const *>(source);
+        D *dst = reinterpret_cast<D *>(destination);
+
+        if constexpr (bitCopy && (!toBool || Source == Serpent::Simd::ScalarKind::Bool)) {
+            std::memcpy(destination, source, count * sizeof(S));
+            return;
+        }
+
+        size_t i = 0;
+        if constexpr (!toBool)
+            i = ConvertVector<S, D, Mode>(src, dst, count);
+
+        for (; i < count; i++)
+            dst[i] = ConvertOne<S, D, Mode, toBool>(src[i]);
+    }
+
+    template <size_t Source, size_t Destination, size_t ...Modes>
+    void FillModes(Serpent::Simd::ConvertTable &table, std::index_sequence<Modes...>) {
+        ((table.kernels[Source][Destination][Modes] = Convert<Serpent::Simd::ScalarKind(Source), Serpent::Simd::ScalarKind(Destination), Modes>), ...);
+    }
+
+    template <size_t Source, size_t ...Destinations>
+    void FillDestinations(Serpent::Simd::ConvertTable &table, std::index_sequence<Destinations...>) {
+        (FillModes<Source, Destinations>(table, std::make_index_sequence<Serpent::Simd::ConvertModeCount> {}), ...);
+    }
+
+    template <size_t ...Sources>
+    void FillSources(Serpent::Simd::ConvertTable &table, std::index_sequence<Sources...>) {
+        (FillDestinations<Sources>(table, std::make_index_sequence<Serpent::Simd::ScalarKindCount> {}), ...);
+    }
+
+    Serpent::Simd::ConvertTable MakeConvertTable() {
+        Serpent::Simd::ConvertTable table {};
+        FillSources(table, std::make_index_sequence<Serpent::Simd::ScalarKindCount> {});
+
+        return table;
+    }
+}
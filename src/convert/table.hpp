@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+
+#include "serpent/convert.hpp"
+#include "../simd/scalar.hpp"
+
+namespace Serpent::Simd {
+    using ConvertKernel = void (*)(void const *source, void *destination, size_t count);
+
+    /// Conversion modes, combined as flags
+    enum ConvertMode : size_t {
+        ConvertWrap = 0,
+        ConvertSaturate = 1,
+        ConvertNormalized = 2,
+    };
+
+    constexpr size_t ConvertModeCount = 4;
+
+    struct ConvertTable final {
+        /// Indexed by source kind, destination kind, then mode
+        ConvertKernel kernels[ScalarKindCount][ScalarKindCount][ConvertModeCount];
+
+        ConvertKernel Get(ScalarKind source, ScalarKind destination, size_t mode) const {
+            return kernels[size_t(source)][size_t(destination)][mode];
+        }
+    };
+
+    ConvertTable const &BaselineConversions();
+    /// Returns nullptr if the library was built without AVX2 kernels
+    ConvertTable const *Avx2Conversions();
+
+    /// The table for the widest instruction set the CPU supports, picked on first use
+    ConvertTable const &Conversions();
+
+    size_t ModeOf(ConvertOptions const &options);
+}
@@ -0,0 +1,431 @@
+#include <bit>
+#include <cstring>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "serpent/deep.hpp"
+#include "serpent/types/interner.hpp"
+#include "gc.hpp"
+#include "plan_cache.hpp"
+
+namespace {
+    using namespace Serpent;
+
+    enum struct SlotKind : uint8_t {
+        Bytes,
+        String,
+        Object,
+        Array,
+    };
+
+    struct Op final {
+        SlotKind kind;
+        size_t offset;
+        size_t size;
+    };
+
+    Op OpOf(ValueLayout const &layout, size_t offset) {
+        if (std::holds_alternative<PrimitiveLayout>(layout) && std::get<PrimitiveLayout>(layout) == PrimitiveLayout::String)
+            return {SlotKind::String, offset, sizeof(size_t)};
+        if (std::holds_alternative<Rc<GcLayout const>>(layout))
+            return {SlotKind::Object, offset, sizeof(GcValue *)};
+        if (std::holds_alternative<ArrayLayout>(layout))
+            return {SlotKind::Array, offset, sizeof(ArrayValue *)};
+
+        return {SlotKind::Bytes, offset, GetSize(layout)};
+    }
+
+    /// Everything Clone, Equals and Hash need to know about a GcLayout, flattened into a list of ops.
+    /// Plain fields that sit next to each other are merged into a single Bytes op
+    struct Plan final {
+        std::vector<Op> ops {};
+        /// Only for VariantLayout, which has a single Bytes op for its tag, then one op for each variant's payload
+        std::vector<Op> payloads {};
+        size_t tagSize = 0;
+        /// Any ops other than Bytes
+        bool references = false;
+
+        void Push(Op op) {
+            if (op.kind == SlotKind::Bytes) {
+                if (op.size == 0)
+                    return;
+                if (!ops.empty() && ops.back().kind == SlotKind::Bytes && ops.back().offset + ops.back().size == op.offset) {
+                    ops.back().size += op.size;
+                    return;
+                }
+            } else {
+                references = true;
+            }
+
+            ops.push_back(op);
+        }
+
+        static Plan Compile(GcLayout const &layout) {
+            Plan plan {};
+
+            std::visit(
+                [&plan](auto const &layout) {
+                    using T = std::decay_t<decltype(layout)>;
+                    if constexpr (std::same_as<T, ObjectLayout>) {
+                        for (auto const &field : layout.Fields())
+                            plan.Push(OpOf(field.layout.Layout(), field.offset));
+                    } else if constexpr (std::same_as<T, TupleLayout>) {
+                        for (auto const &field : layout.Fields())
+                            plan.Push(OpOf(field.layout, field.offset));
+                    } else {
+                        plan.tagSize = layout.TagSize();
+                        plan.ops.push_back({SlotKind::Bytes, 0, layout.TagSize()});
+
+                        for (auto const &variant : layout.Variants()) {
+                            auto op = OpOf(variant.Layout(), layout.PayloadOffset());
+                            plan.references |= op.kind != SlotKind::Bytes;
+                            plan.payloads.push_back(op);
+                        }
+                    }
+                },
+                layout
+            );
+
+            return plan;
+        }
+
+        /// Calls func(op) for every op that applies to the value's data, including the active variant's payload
+        template <typename TFunc>
+        void ForEach(void const *data, TFunc &&func) const {
+            for (auto const &op : ops)
+                func(op);
+
+            if (tagSize > 0) {
+                size_t tag = 0;
+                std::memcpy(&tag, data, tagSize);
+                if (payloads[tag].size > 0)
+                    func(payloads[tag]);
+            }
+        }
+    };
+
+    void const *Offset(void const *data, size_t offset) {
+        return reinterpret_cast<void const *>(reinterpret_cast<size_t>(data) + offset);
+    }
+
+    void *Offset(void *data, size_t offset) {
+        return reinterpret_cast<void *>(reinterpret_cast<size_t>(data) + offset);
+    }
+
+    template <typename T>
+    T Read(void const *slot) {
+        T value;
+        std::memcpy(&value, slot, sizeof(T));
+
+        return value;
+    }
+
+    struct Copies final {
+        CopyMode mode;
+        /// Original to copy, so that shared children stay shared
+        std::unordered_map<void const *, void *> copies {};
+    };
+
+    GcValue *CloneValue(GcValue *value, Copies &copies);
+    ArrayValue *CloneValue(ArrayValue *value, Copies &copies);
+
+    /// Replaces a slot copied byte for byte from the original with its own reference
+    void CloneSlot(SlotKind kind, void *slot, Copies &copies) {
+        switch (kind) {
+            case SlotKind::Bytes:
+                break;
+            case SlotKind::String:
+                Interner::Instance().AddRef(Read<size_t>(slot));
+                break;
+            case SlotKind::Object:
+                if (auto child = Read<GcValue *>(slot))
+                    *reinterpret_cast<GcValue **>(slot) = CloneValue(child, copies);
+                break;
+            case SlotKind::Array:
+                if (auto child = Read<ArrayValue *>(slot))
+                    *reinterpret_cast<ArrayValue **>(slot) = CloneValue(child, copies);
+                break;
+        }
+    }
+
+    template <typename TValue>
+    TValue *Reuse(TValue *value, Copies &copies) {
+        bool shared = copies.mode == CopyMode::Clone ? value->header.IsFrozen() : !value->header.IsArena();
+        if (shared) {
+            value->AddRef();
+            return value;
+        }
+
+        auto it = copies.copies.find(value);
+        if (it == copies.copies.end())
+            return nullptr;
+
+        auto copy = static_cast<TValue *>(it->second);
+        copy->AddRef();
+
+        return copy;
+    }
+
+    GcValue *CloneValue(GcValue *value, Copies &copies) {
+        if (auto reused = Reuse(value, copies))
+            return reused;
+
+        auto const &plan = PlanCache<Plan>::Instance().Of(value->layout);
+        GcValue *copy = Allocate(value->layout);
+        copies.copies.insert({value, copy});
+
+        void *data = copy->Data();
+        std::memcpy(data, value->Data(), std::visit([](auto const &layout) { return layout.Size(); }, *value->layout));
+
+        if (plan.references)
+            plan.ForEach(data, [data, &copies](Op const &op) { CloneSlot(op.kind, Offset(data, op.offset), copies); });
+
+        return copy;
+    }
+
+    ArrayValue *CloneValue(ArrayValue *value, Copies &copies) {
+        if (auto reused = Reuse(value, copies))
+            return reused;
+
+        ArrayValue *copy = Allocate(value->layout, value->size);
+        copies.copies.insert({value, copy});
+
+        size_t stride = GetSize(value->layout);
+        if (copy->data)
+            std::memcpy(copy->data, value->data, stride * value->size);
+
+        auto kind = OpOf(value->layout, 0).kind;
+        if (kind != SlotKind::Bytes) {
+            for (size_t i = 0; i < value->size; i++)
+                CloneSlot(kind, Offset(copy->data, i * stride), copies);
+        }
+
+        return copy;
+    }
+
+    bool EqualValues(GcValue *lhs, GcValue *rhs);
+    bool EqualValues(ArrayValue *lhs, ArrayValue *rhs);
+
+    bool EqualSlots(Op const &op, void const *lhs, void const *rhs) {
+        switch (op.kind) {
+            case SlotKind::Bytes:
+                return std::memcmp(lhs, rhs, op.size) == 0;
+            case SlotKind::String:
+                return Read<size_t>(lhs) == Read<size_t>(rhs);
+            case SlotKind::Object: {
+                auto a = Read<GcValue *>(lhs);
+                auto b = Read<GcValue *>(rhs);
+                return a == b || (a && b && EqualValues(a, b));
+            }
+            case SlotKind::Array: {
+                auto a = Read<ArrayValue *>(lhs);
+                auto b = Read<ArrayValue *>(rhs);
+                return a == b || (a && b && EqualValues(a, b));
+            }
+        }
+
+        std::unreachable();
+    }
+
+    bool EqualValues(GcValue *lhs, GcValue *rhs) {
+        if (lhs == rhs)
+            return true;
+        if (lhs->layout != rhs->layout)
+            return false;
+
+        auto const &plan = PlanCache<Plan>::Instance().Of(lhs->layout);
+        void const *a = lhs->Data();
+        void const *b = rhs->Data();
+
+        // The tag is the first op, so the payloads only get compared once the tags are known to match
+        bool equal = true;
+        plan.ForEach(a, [&](Op const &op) {
+            equal = equal && EqualSlots(op, Offset(a, op.offset), Offset(b, op.offset));
+        });
+
+        return equal;
+    }
+
+    bool EqualValues(ArrayValue *lhs, ArrayValue *rhs) {
+        if (lhs == rhs)
+            return true;
+        if (lhs->size != rhs->size || lhs->layout != rhs->layout)
+            return false;
+
+        size_t stride = GetSize(lhs->layout);
+        auto op = OpOf(lhs->layout, 0);
+        if (op.kind == SlotKind::Bytes)
+            return stride * lhs->size == 0 || std::memcmp(lhs->data, rhs->data, stride * lhs->size) == 0;
+
+        for (size_t i = 0; i < lhs->size; i++) {
+            if (!EqualSlots(op, Offset(lhs->data, i * stride), Offset(rhs->data, i * stride)))
+                return false;
+        }
+
+        return true;
+    }
+
+    /// Streaming hash over 4 independent 64 bit lanes, so that long runs of bytes keep several multipliers busy at once
+    struct Hasher final {
+        static constexpr uint64_t Prime1 = 0x9E3779B185EBCA87ull;
+        static constexpr uint64_t Prime2 = 0xC2B2AE3D27D4EB4Full;
+        static constexpr uint64_t Prime3 = 0x165667B19E3779F9ull;
+
+        uint64_t lanes[4] = {Prime1 + Prime2, Prime2, 0, 0 - Prime1};
+        uint64_t length = 0;
+
+        static uint64_t Round(uint64_t lane, uint64_t word) {
+            return std::rotl(lane + word * Prime2, 31) * Prime1;
+        }
+
+        void Bytes(void const *data, size_t size) {
+            auto bytes = static_cast<unsigned char const *>(data);
+            length += size;
+
+            for (; size >= 32; bytes += 32, size -= 32) {
+                for (size_t lane = 0; lane < 4; lane++)
+                    lanes[lane] = Round(lanes[lane], Read<uint64_t>(bytes + lane * 8));
+            }
+
+            for (; size >= 8; bytes += 8, size -= 8)
+                lanes[0] = Round(lanes[0], Read<uint64_t>(bytes));
+
+            if (size > 0) {
+                uint64_t tail = 0;
+                std::memcpy(&tail, bytes, size);
+                lanes[1] = Round(lanes[1], tail ^ (uint64_t(size) << 56));
+            }
+        }
+
+        void Word(uint64_t word) {
+            length += sizeof(word);
+            lanes[2] = Round(lanes[2], word);
+        }
+
+        uint64_t Finish() const {
+            uint64_t hash = std::rotl(lanes[0], 1) + std::rotl(lanes[1], 7) + std::rotl(lanes[2], 12) + std::rotl(lanes[3], 18);
+            hash = (hash ^ length) * Prime3;
+
+            hash ^= hash >> 33;
+            hash *= Prime2;
+            hash ^= hash >> 29;
+            hash *= Prime3;
+            hash ^= hash >> 32;
+
+            return hash;
+        }
+    };
+
+    /// Children hashed once, so shared children are only walked once
+    using Hashes = std::unordered_map<void const *, uint64_t>;
+
+    uint64_t HashValue(GcValue *value, Hashes &hashes);
+    uint64_t HashValue(ArrayValue *value, Hashes &hashes);
+
+    void HashSlot(Hasher &hasher, Op const &op, void const *slot, Hashes &hashes) {
+        switch (op.kind) {
+            case SlotKind::Bytes:
+                hasher.Bytes(slot, op.size);
+                break;
+            case SlotKind::String:
+                hasher.Word(Read<size_t>(slot));
+                break;
+            case SlotKind::Object: {
+                auto child = Read<GcValue *>(slot);
+                hasher.Word(child ? HashValue(child, hashes) : 0);
+                break;
+            }
+            case SlotKind::Array: {
+                auto child = Read<ArrayValue *>(slot);
+                hasher.Word(child ? HashValue(child, hashes) : 0);
+                break;
+            }
+        }
+    }
+
+    uint64_t HashValue(GcValue *value, Hashes &hashes) {
+        if (auto it = hashes.find(value); it != hashes.end())
+            return it->second;
+
+        auto const &plan = PlanCache<Plan>::Instance().Of(value->layout);
+        void const *data = value->Data();
+
+        Hasher hasher {};
+        plan.ForEach(data, [&](Op const &op) { HashSlot(hasher, op, Offset(data, op.offset), hashes); });
+
+        uint64_t hash = hasher.Finish();
+        hashes.insert({value, hash});
+
+        return hash;
+    }
+
+    uint64_t HashValue(ArrayValue *value, Hashes &hashes) {
+        if (auto it = hashes.find(value); it != hashes.end())
+            return it->second;
+
+        size_t stride = GetSize(value->layout);
+        auto op = OpOf(value->layout, 0);
+
+        Hasher hasher {};
+        hasher.Word(value->size);
+        if (op.kind == SlotKind::Bytes) {
+            if (value->size > 0)
+                hasher.Bytes(value->data, stride * value->size);
+        } else {
+            for (size_t i = 0; i < value->size; i++)
+                HashSlot(hasher, op, Offset(value->data, i * stride), hashes);
+        }
+
+        uint64_t hash = hasher.Finish();
+        hashes.insert({value, hash});
+
+        return hash;
+    }
+}
+
+Serpent::GcValue *Serpent::DeepCopy(GcValue *value, CopyMode mode) {
+    Copies copies {mode};
+
+    return CloneValue(value, copies);
+}
+
+Serpent::ArrayValue *Serpent::DeepCopy(ArrayValue *value, CopyMode mode) {
+    Copies copies {mode};
+
+    return CloneValue(value, copies);
+}
+
+Serpent::GcHandle Serpent::Clone(GcHandle const &value) {
+    return WithRaw(value, [](GcValue *raw) { return GcHandle::FromRaw(DeepCopy(raw, CopyMode::Clone)); });
+}
+
+Serpent::ArrayHandle Serpent::Clone(ArrayHandle const &value) {
+    return WithRaw(value, [](ArrayValue *raw) { return ArrayHandle::FromRaw(DeepCopy(raw, CopyMode::Clone)); });
+}
+
+bool Serpent::Equals(GcHandle const &lhs, GcHandle const &rhs) {
+    return WithRaw(lhs, [&rhs](GcValue *a) {
+        return WithRaw(rhs, [a](GcValue *b) { return EqualValues(a, b); });
+    });
+}
+
+bool Serpent::Equals(ArrayHandle const &lhs, ArrayHandle const &rhs) {
+    return WithRaw(lhs, [&rhs](ArrayValue *a) {
+        return WithRaw(rhs, [a](ArrayValue *b) { return EqualValues(a, b); });
+    });
+}
+
+uint64_t Serpent::Hash(GcHandle const &value) {
+    return WithRaw(value, [](GcValue *raw) {
+        Hashes hashes {};
+        return HashValue(raw, hashes);
+    });
+}
+
+uint64_t Serpent::Hash(ArrayHandle const &value) {
+    return WithRaw(value, [](ArrayValue *raw) {
+        Hashes hashes {};
+        return HashValue(raw, hashes);
+    });
+}
@@ -0,0 +1,407 @@
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <variant>
+#include <vector>
+
+#include "serpent/binary.hpp"
+#include "serpent/deep.hpp"
+#include "serpent/delta.hpp"
+#include "serpent/types/interner.hpp"
+#include "delta/table.hpp"
+#include "gc.hpp"
+#include "plan_cache.hpp"
+#include "simd/cpu.hpp"
+
+namespace {
+    using namespace Serpent;
+
+    Simd::DeltaKernels const &Kernels() {
+        static Simd::DeltaKernels const &kernels = []() -> Simd::DeltaKernels const & {
+            if (Simd::Detect() == Simd::Isa::Avx2) {
+                if (auto avx2 = Simd::Avx2DeltaKernels())
+                    return *avx2;
+            }
+
+            return Simd::BaselineDeltaKernels();
+        }();
+
+        return kernels;
+    }
+
+    enum struct FieldKind : uint8_t {
+        Plain,
+        String,
+        Object,
+        Array,
+    };
+
+    struct Field final {
+        FieldKind kind;
+        size_t offset;
+        size_t size;
+        /// Kept alive along with the plan
+        ValueLayout const *layout;
+        /// For Bools and enums, decoded values must be below this. 0 if any value is valid
+        uint64_t count;
+    };
+
+    Field FieldOf(ValueLayout const &layout, size_t offset) {
+        if (std::holds_alternative<PrimitiveLayout>(layout) && std::get<PrimitiveLayout>(layout) == PrimitiveLayout::String)
+            return {FieldKind::String, offset, sizeof(size_t), &layout, 0};
+        if (std::holds_alternative<Rc<GcLayout const>>(layout))
+            return {FieldKind::Object, offset, sizeof(GcValue *), &layout, 0};
+        if (std::holds_alternative<ArrayLayout>(layout))
+            return {FieldKind::Array, offset, sizeof(ArrayValue *), &layout, 0};
+
+        uint64_t count = 0;
+        if (std::holds_alternative<IntegralLayout>(layout) && std::get<IntegralLayout>(layout) == IntegralLayout::Bool)
+            count = 2;
+        else if (auto en = std::get_if<Rc<EnumLayout const>>(&layout))
+            count = (*en)->Names().size();
+
+        return {FieldKind::Plain, offset, GetSize(layout), &layout, count};
+    }
+
+    struct Plan final {
+        std::vector<Field> fields {};
+        /// Bytes of the value's memory, all compared at once
+        size_t size = 0;
+        /// Variants have no fields to diff
+        bool supported = false;
+
+        static Plan Compile(GcLayout const &layout) {
+            Plan plan {};
+
+            std::visit(
+                [&plan](auto const &layout) {
+                    using T = std::decay_t<decltype(layout)>;
+                    if constexpr (std::same_as<T, ObjectLayout>) {
+                        for (auto const &field : layout.Fields())
+                            plan.fields.push_back(FieldOf(field.layout.Layout(), field.offset));
+                    } else if constexpr (std::same_as<T, TupleLayout>) {
+                        for (auto const &field : layout.Fields())
+                            plan.fields.push_back(FieldOf(field.layout, field.offset));
+                    }
+
+                    plan.size = layout.Size();
+                    plan.supported = !std::same_as<T, VariantLayout>;
+                },
+                layout
+            );
+
+            return plan;
+        }
+    };
+
+    Plan const &PlanOf(Rc<GcLayout const> const &layout) {
+        return PlanCache<Plan>::Instance().Of(layout);
+    }
+
+    void *Offset(void *data, size_t offset) {
+        return reinterpret_cast<void *>(reinterpret_cast<size_t>(data) + offset);
+    }
+
+    /// Copies a scalar between memory and the wire, which is little endian
+    void CopyScalar(void *target, void const *source, size_t size) {
+        if constexpr (std::endian::native == std::endian::little) {
+            std::memcpy(target, source, size);
+        } else {
+            auto out = static_cast<std::byte *>(target);
+            auto in = static_cast<std::byte const *>(source);
+
+            for (size_t i = 0; i < size; i++)
+                out[i] = in[size - 1 - i];
+        }
+    }
+
+    uint64_t LoadUnsigned(void const *slot, size_t width) {
+        switch (width) {
+            case 1: {
+                uint8_t value;
+                std::memcpy(&value, slot, 1);
+                return value;
+            }
+            case 2: {
+                uint16_t value;
+                std::memcpy(&value, slot, 2);
+                return value;
+            }
+            case 4: {
+                uint32_t value;
+                std::memcpy(&value, slot, 4);
+                return value;
+            }
+            default: {
+                uint64_t value;
+                std::memcpy(&value, slot, 8);
+                return value;
+            }
+        }
+    }
+
+    /// Returns true if any of the size bits from offset are set. size is at most 8, so the bits span at most two words
+    bool AnyBit(uint64_t const *mask, size_t offset, size_t size) {
+        if (size == 0)
+            return false;
+
+        uint64_t bits = mask[offset / 64] >> (offset % 64);
+        if (offset % 64 + size > 64)
+            bits |= mask[offset / 64 + 1] << (64 - offset % 64);
+
+        return (bits & (~uint64_t(0) >> (64 - size))) != 0;
+    }
+
+    bool Changed(GcHandle &from, GcHandle &to, size_t index) {
+        auto lhs = from.Get(index);
+        auto rhs = to.Get(index);
+        if (lhs.index() != rhs.index())
+            return true;
+
+        if (auto object = std::get_if<GcHandle>(&lhs))
+            return !Equals(*object, std::get<GcHandle>(rhs));
+        if (auto array = std::get_if<ArrayHandle>(&lhs))
+            return !Equals(*array, std::get<ArrayHandle>(rhs));
+
+        return false;
+    }
+
+    void Append(std::vector<std::byte> &out, void const *data, size_t size) {
+        size_t start = out.size();
+        out.resize(start + size);
+        if (size > 0)
+            std::memcpy(out.data() + start, data, size);
+    }
+
+    void EncodeField(GcHandle &to, size_t index, Field const &field, std::vector<std::byte> &out) {
+        void const *slot = Offset(to.Data(), field.offset);
+
+        switch (field.kind) {
+            case FieldKind::Plain: {
+                size_t start = out.size();
+                out.resize(start + field.size);
+                CopyScalar(out.data() + start, slot, field.size);
+                break;
+            }
+            case FieldKind::String: {
+                size_t string = 0;
+                std::memcpy(&string, slot, sizeof(size_t));
+
+                auto view = Interner::Instance().Get(string);
+                uint8_t length[sizeof(uint32_t)];
+                uint32_t size = uint32_t(view.size());
+                CopyScalar(length, &size, sizeof(uint32_t));
+                Append(out, length, sizeof(uint32_t));
+                Append(out, view.data(), view.size());
+                break;
+            }
+            case FieldKind::Object:
+            case FieldKind::Array: {
+                auto value = to.Get(index);
+                out.push_back(std::byte(!std::holds_alternative<std::nullopt_t>(value)));
+
+                if (auto object = std::get_if<GcHandle>(&value))
+                    Encode(*object, out);
+                else if (auto array = std::get_if<ArrayHandle>(&value))
+                    Encode(*array, out);
+                break;
+            }
+        }
+    }
+
+    struct Reader final {
+        std::byte const *cursor;
+        std::byte const *end;
+
+        size_t Remaining() const {
+            return size_t(end - cursor);
+        }
+
+        /// Reads into a staging slot, which is left holding a reference for reference fields
+        bool ReadField(Field const &field, void *slot) {
+            switch (field.kind) {
+                case FieldKind::Plain: {
+                    if (Remaining() < field.size)
+                        return false;
+
+                    CopyScalar(slot, cursor, field.size);
+                    if (field.count > 0 && LoadUnsigned(slot, field.size) >= field.count)
+                        return false;
+
+                    cursor += field.size;
+                    return true;
+                }
+                case FieldKind::String: {
+                    uint32_t size = 0;
+                    if (Remaining() < sizeof(uint32_t))
+                        return false;
+
+                    CopyScalar(&size, cursor, sizeof(uint32_t));
+                    if (Remaining() - sizeof(uint32_t) < size)
+                        return false;
+
+                    cursor += sizeof(uint32_t);
+                    size_t index = Interner::Instance().Acquire(std::string_view(reinterpret_cast<char const *>(cursor), size));
+                    std::memcpy(slot, &index, sizeof(size_t));
+                    cursor += size;
+                    return true;
+                }
+                case FieldKind::Object:
+                case FieldKind::Array: {
+                    void *raw = nullptr;
+                    if (Remaining() < 1 || uint8_t(*cursor) > 1)
+                        return false;
+
+                    if (uint8_t(*cursor++) == 1) {
+                        std::span<std::byte const> input {cursor, end};
+                        if (field.kind == FieldKind::Object) {
+                            auto decoded = Decode(std::get<Rc<GcLayout const>>(*field.layout), input);
+                            if (!decoded)
+                                return false;
+                            raw = decoded->IntoRaw();
+                        } else {
+                            auto decoded = Decode(std::get<ArrayLayout>(*field.layout), input);
+                            if (!decoded)
+                                return false;
+                            raw = decoded->IntoRaw();
+                        }
+                        cursor = input.data();
+                    }
+
+                    std::memcpy(slot, &raw, sizeof(void *));
+                    return true;
+                }
+            }
+
+            return false;
+        }
+    };
+
+    GcHeader const *HeaderOf(Field const &field, void const *slot) {
+        void *raw = nullptr;
+        std::memcpy(&raw, slot, sizeof(void *));
+        if (!raw)
+            return nullptr;
+
+        if (field.kind == FieldKind::Object)
+            return &static_cast<GcValue *>(raw)->header;
+
+        return &static_cast<ArrayValue *>(raw)->header;
+    }
+
+    /// Scratch space reused between calls on the same thread. One bit per byte of the values, set where they differ
+    thread_local std::vector<uint64_t> mask {};
+    /// Where ApplyDelta decodes the changed fields
+    thread_local std::vector<std::byte> staging {};
+    /// Indices of the changed fields
+    thread_local std::vector<size_t> changes {};
+}
+
+std::optional<size_t> Serpent::EncodeDelta(GcHandle const &from, GcHandle const &to, std::vector<std::byte> &out) {
+    if (from.Layout() != to.Layout())
+        return std::nullopt;
+
+    auto const &plan = PlanOf(to.Layout());
+    if (!plan.supported)
+        return std::nullopt;
+
+    mask.assign(plan.size / 64 + 1, 0);
+    Kernels().diff(from.Data(), to.Data(), plan.size, mask.data());
+
+    GcHandle lhs = from;
+    GcHandle rhs = to;
+    size_t start = out.size();
+    size_t bitmask = start;
+    out.resize(start + (plan.fields.size() + 7) / 8);
+    std::memset(out.data() + start, 0, out.size() - start);
+
+    for (size_t i = 0; i < plan.fields.size(); i++) {
+        auto const &field = plan.fields[i];
+        if (!AnyBit(mask.data(), field.offset, field.size))
+            continue;
+        // Different references may still hold equal values
+        if ((field.kind == FieldKind::Object || field.kind == FieldKind::Array) && !Changed(lhs, rhs, i))
+            continue;
+
+        out[bitmask + i / 8] |= std::byte(1 << (i % 8));
+        EncodeField(rhs, i, field, out);
+    }
+
+    return out.size() - start;
+}
+
+bool Serpent::ApplyDelta(GcHandle const &target, std::span<std::byte const> &input) {
+    if (target.IsFrozen())
+        return false;
+
+    auto const &plan = PlanOf(target.Layout());
+    if (!plan.supported)
+        return false;
+
+    Reader reader {input.data(), input.data() + input.size()};
+    size_t bitmask = (plan.fields.size() + 7) / 8;
+    if (reader.Remaining() < bitmask)
+        return false;
+
+    changes.clear();
+    for (size_t i = 0; i < bitmask * 8; i++) {
+        if ((uint8_t(reader.cursor[i / 8]) >> (i % 8)) & 1) {
+            // Padding bits must be clear
+            if (i >= plan.fields.size())
+                return false;
+            changes.push_back(i);
+        }
+    }
+    reader.cursor += bitmask;
+
+    // Everything is decoded into staging first, so a malformed delta leaves target untouched
+    staging.resize(plan.size);
+    size_t decoded = 0;
+    bool success = true;
+    for (; success && decoded < changes.size(); decoded++) {
+        auto const &field = plan.fields[changes[decoded]];
+        success = reader.ReadField(field, Offset(staging.data(), field.offset));
+    }
+    if (!success)
+        decoded--;
+
+    if (success) {
+        success = WithRaw(target, [&plan](GcValue *raw) {
+            for (size_t index : changes) {
+                auto const &field = plan.fields[index];
+                if (field.kind != FieldKind::Object && field.kind != FieldKind::Array)
+                    continue;
+
+                auto child = HeaderOf(field, Offset(staging.data(), field.offset));
+                if (child && !MayReference(raw->header, *child))
+                    return false;
+            }
+
+            return true;
+        });
+    }
+
+    if (!success) {
+        for (size_t i = 0; i < decoded; i++) {
+            auto const &field = plan.fields[changes[i]];
+            if (field.kind != FieldKind::Plain)
+                Release(*field.layout, Offset(staging.data(), field.offset));
+        }
+        return false;
+    }
+
+    void *data = target.Data();
+    for (size_t index : changes) {
+        auto const &field = plan.fields[index];
+        void *slot = Offset(data, field.offset);
+
+        if (field.kind != FieldKind::Plain)
+            Release(*field.layout, slot);
+        std::memcpy(slot, Offset(staging.data(), field.offset), field.size);
+    }
+
+    input = input.subspan(size_t(reader.cursor - input.data()));
+    return true;
+}
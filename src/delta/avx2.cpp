@@ -0,0 +1,15 @@
+#include "table.hpp"
+
+#if defined(__AVX2__)
+#include "impl.hpp"
+#endif
+
+Serpent::Simd::DeltaKernels const *Serpent::Simd::Avx2DeltaKernels() {
+#if defined(__AVX2__)
+    static DeltaKernels const kernels = MakeDeltaKernels();
+
+    return &kernels;
+#else
+    return nullptr;
+#endif
+}
@@ -0,0 +1,8 @@
+#include "impl.hpp"
+#include "table.hpp"
+
+Serpent::Simd::DeltaKernels const &Serpent::Simd::BaselineDeltaKernels() {
+    static DeltaKernels const kernels = MakeDeltaKernels();
+
+    return kernels;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "../simd/vec.hpp"
+#include "table.hpp"
+
+/// Kernel bodies shared by every ISA translation unit, see kernels/impl.hpp
+namespace {
+    void Diff(void const *lhs, void const *rhs, size_t size, uint64_t *mask) {
+        auto a = static_cast<uint8_t const *>(lhs);
+        auto b = static_cast<uint8_t const *>(rhs);
+        size_t i = 0;
+
+        if constexpr (HasMask<uint8_t>) {
+            using V = Vec<uint8_t>;
+            // Lanes divides 64, so a chunk's bits never straddle two words
+            constexpr uint64_t Lanes = V::Lanes == 64 ? ~uint64_t(0) : (uint64_t(1) << V::Lanes) - 1;
+
+            for (; i + V::Lanes <= size; i += V::Lanes) {
+                uint64_t differs = ~uint64_t(V::Mask(V::Eq(V::Load(a + i), V::Load(b + i)))) & Lanes;
+                mask[i / 64] |= differs << (i % 64);
+            }
+        }
+
+        for (; i < size; i++) {
+            if (a[i] != b[i])
+                mask[i / 64] |= uint64_t(1) << (i % 64);
+        }
+    }
+
+    Serpent::Simd::DeltaKernels MakeDeltaKernels() {
+        return {
+            .diff = Diff,
+        };
+    }
+}
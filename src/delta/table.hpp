@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Serpent::Simd {
+    struct DeltaKernels final {
+        /// Sets bit i of mask for each byte i that differs between lhs and rhs. Mask must be zeroed and hold at least size bits
+        void (*diff)(void const *lhs, void const *rhs, size_t size, uint64_t *mask);
+    };
+
+    DeltaKernels const &BaselineDeltaKernels();
+    /// Returns nullptr if the library was built without AVX2 kernels
+    DeltaKernels const *Avx2DeltaKernels();
+}
@@ -0,0 +1,114 @@
+#include <algorithm>
+#include <vector>
+
+#include "serpent/value.hpp"
+#include "gc.hpp"
+
+Serpent::FieldSet::FieldSet(
+    Rc<GcLayout const> layout,
+    RcArray<size_t> offsets,
+    RcArray<Run> runs,
+    RcArray<Reference> references,
+    size_t size,
+    size_t align
+) :
+    layout(layout),
+    offsets(offsets),
+    runs(runs),
+    references(references),
+    size(size),
+    align(align)
+{}
+
+std::optional<Serpent::FieldSet> Serpent::FieldSet::Of(Rc<GcLayout const> const &layout, std::initializer_list<std::string_view> names) {
+    auto object = std::get_if<ObjectLayout>(&*layout);
+    if (!object)
+        return std::nullopt;
+
+    std::vector<size_t> offsets {};
+    std::vector<Run> runs {};
+    std::vector<Reference> references {};
+    size_t size = 0;
+    size_t align = 1;
+
+    for (auto name : names) {
+        auto index = object->IndexOf(InternedString(name));
+        if (!index)
+            return std::nullopt;
+
+        auto const &field = object->Fields()[*index];
+        auto const &fieldLayout = field.layout.Layout();
+        size_t const fieldAlign = GetAlign(fieldLayout);
+        size_t const fieldSize = GetSize(fieldLayout);
+
+        size = (size + fieldAlign - 1) & ~(fieldAlign - 1);
+        offsets.push_back(size);
+
+        if (std::holds_alternative<PrimitiveLayout>(fieldLayout) && std::get<PrimitiveLayout>(fieldLayout) == PrimitiveLayout::String) {
+            references.push_back({field.offset, size, Reference::Kind::String, fieldLayout});
+        } else if (std::holds_alternative<Rc<GcLayout const>>(fieldLayout)) {
+            references.push_back({field.offset, size, Reference::Kind::Object, fieldLayout});
+        } else if (std::holds_alternative<ArrayLayout>(fieldLayout)) {
+            references.push_back({field.offset, size, Reference::Kind::Array, fieldLayout});
+        } else if (fieldSize > 0) {
+            // Fields that sit next to each other in both the value and the buffer share a single copy
+            if (!runs.empty() && runs.back().source + runs.back().size == field.offset && runs.back().target + runs.back().size == size)
+                runs.back().size += fieldSize;
+            else
+                runs.push_back({field.offset, size, fieldSize});
+        }
+
+        size += fieldSize;
+        align = std::max(align, fieldAlign);
+    }
+
+    size = (size + align - 1) & ~(align - 1);
+
+    return FieldSet(
+        layout,
+        RcArray<size_t>::Create(offsets),
+        RcArray<Run>::Create(runs),
+        RcArray<Reference>::Create(references),
+        size,
+        align
+    );
+}
+
+Serpent::Rc<Serpent::GcLayout const> const &Serpent::FieldSet::Layout() const {
+    return layout;
+}
+
+size_t Serpent::FieldSet::Size() const {
+    return size;
+}
+
+size_t Serpent::FieldSet::Align() const {
+    return align;
+}
+
+size_t Serpent::FieldSet::Offset(size_t index) const {
+    return offsets[index];
+}
+
+void Serpent::FieldSet::Release(void *buffer) const {
+    for (auto const &reference : references) {
+        void *slot = reinterpret_cast<void *>(reinterpret_cast<size_t>(buffer) + reference.target);
+
+        switch (reference.kind) {
+            case Reference::Kind::String:
+                Serpent::Release(PrimitiveLayout::String, slot);
+                *reinterpret_cast<size_t *>(slot) = 0;
+                break;
+            case Reference::Kind::Object:
+                if (auto value = *reinterpret_cast<GcValue **>(slot); value && value->RemoveRef())
+                    Destroy(value);
+                *reinterpret_cast<GcValue **>(slot) = nullptr;
+                break;
+            case Reference::Kind::Array:
+                if (auto value = *reinterpret_cast<ArrayValue **>(slot); value && value->RemoveRef())
+                    Destroy(value);
+                *reinterpret_cast<ArrayValue **>(slot) = nullptr;
+                break;
+        }
+    }
+}
@@ -0,0 +1,358 @@
+#pragma once
+
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <variant>
+
+#include "serpent/layout.hpp"
+#include "serpent/types/rc.hpp"
+
+/// Debug builds check that no arena value is still referenced when its ArenaScope ends
+#if !defined(NDEBUG)
+#define SERPENT_ARENA_CHECKS
+#endif
+
+/// Runtime representation of GC values, shared by the translation units that need to look inside them
+namespace Serpent {
+    struct GcValue;
+    struct ArrayValue;
+
+    /// Per-thread state for biased refcounting, see GcHeader
+    struct RefOwner;
+
+    /// The calling thread's RefOwner, or null if the thread hasn't created any GC values yet
+    inline thread_local RefOwner *localOwner = nullptr;
+
+    /// The calling thread's RefOwner, registering the thread if needed
+    RefOwner *LocalOwner();
+
+    struct GcHeader;
+
+    /// Queues a value whose shared count went negative, for its owner to merge.
+    /// If the owner already exited the value is merged straight away, returns true if it's then unreferenced
+    bool QueueMerge(RefOwner *owner, GcHeader *header);
+
+    /// Biased reference counting, most values are only ever touched by the thread that created them.
+    /// The owning thread counts its references in `biased` without atomics, every other thread uses the atomic `shared` count.
+    /// A value is only unreferenced once both counts are merged: either the owner's count reaches 0 and it gives up ownership,
+    /// or another thread drives the shared count negative and queues the value for its owner to merge.
+    ///
+    /// Reference counting alone frees every value, since values can't form cycles: layouts are immutable and only built from layouts
+    /// that already exist, so no layout can reach itself, and a value can only reference values of the layouts its own is built from.
+    struct GcHeader final {
+        enum Flags : uint8_t {
+            /// The header belongs to an ArrayValue rather than a GcValue
+            Array = 1 << 0,
+            /// The value is immutable and immortal, reference counting skips it entirely
+            Frozen = 1 << 1,
+            /// The value lives in an ArenaScope's memory and is freed along with it. Its count only tracks sharing, it's never freed by it
+            Arena = 1 << 2,
+            /// A snapshot may share the value, so a write through a handle copies it first unless that handle holds the only reference
+            Snapshotted = 1 << 3,
+        };
+
+        /// The low bits of `shared` are flags, the count is stored above them
+        enum SharedFlags : intptr_t {
+            /// The owner gave up ownership, `shared` is now the only count
+            Merged = 1 << 0,
+            /// The value is in its owner's merge queue
+            Queued = 1 << 1,
+        };
+
+        static constexpr intptr_t SharedOne = 1 << 2;
+
+        /// Null once merged
+        std::atomic<RefOwner *> owner;
+        size_t biased;
+        std::atomic_intptr_t shared;
+        std::atomic_uint8_t flags;
+        /// Nesting depth of the ArenaScope the value lives in, 0 for the heap.
+        /// A value may only reference values at the same or a lower depth, which live at least as long
+        uint8_t region;
+
+        /// Header for a new value with a single reference, owned by the calling thread
+        static GcHeader Owned(uint8_t flags) {
+            return GcHeader {
+                .owner = LocalOwner(),
+                .biased = 1,
+                .shared = 0,
+                .flags = flags,
+                .region = 0,
+            };
+        }
+
+        /// Header for a new value in the arena at the given depth.
+        /// Arena values never leave the thread that started their scope, so they count in `biased` alone
+        static GcHeader InArena(uint8_t flags, uint8_t region) {
+            return GcHeader {
+                .owner = nullptr,
+                .biased = 1,
+                .shared = Merged,
+                .flags = uint8_t(flags | Arena),
+                .region = region,
+            };
+        }
+
+        bool IsFrozen() const {
+            return flags.load(std::memory_order_relaxed) & Frozen;
+        }
+
+        bool IsArena() const {
+            return flags.load(std::memory_order_relaxed) & Arena;
+        }
+
+        /// Frozen values skip reference counting, and arena values only keep a share count in `biased`
+        bool IsUncounted() const {
+            return flags.load(std::memory_order_relaxed) & (Frozen | Arena);
+        }
+
+        bool IsOwned() const {
+            auto current = owner.load(std::memory_order_relaxed);
+            return current && current == localOwner;
+        }
+
+        /// Total number of references. Only exact while no other thread is touching the value
+        size_t Count() const {
+            return biased + size_t(shared.load() >> 2);
+        }
+
+        void AddRef() {
+            if (IsUncounted()) {
+                if (IsArena())
+                    biased += 1;
+                return;
+            }
+
+            if (IsOwned())
+                biased += 1;
+            else
+                shared.fetch_add(SharedOne, std::memory_order_relaxed);
+        }
+
+        /// Returns true if the value is now unreferenced, and should be destroyed by the caller
+        bool RemoveRef() {
+            if (IsUncounted()) {
+                if (IsArena())
+                    biased -= 1;
+                return false;
+            }
+
+            if (IsOwned()) {
+                if (--biased > 0)
+                    return false;
+
+                owner.store(nullptr, std::memory_order_relaxed);
+                intptr_t old = shared.fetch_or(Merged, std::memory_order_acq_rel);
+
+                // A queued value is destroyed when the queue is processed
+                return (old >> 2) == 0 && !(old & Queued);
+            }
+
+            intptr_t old = shared.fetch_sub(SharedOne, std::memory_order_acq_rel);
+            if (old & Merged)
+                return (old >> 2) == 1 && !(old & Queued);
+
+            // Only the owner can account for this reference now
+            if ((old >> 2) <= 0 && !(old & Queued) && !(shared.fetch_or(Queued) & Queued))
+                return QueueMerge(owner.load(std::memory_order_relaxed), this);
+
+            return false;
+        }
+
+        /// Returns true if only one reference to the value exists.
+        /// Other threads may drop references concurrently, so this can report a unique value as shared but never the other way around
+        bool IsUnique() const {
+            if (IsUncounted())
+                return IsArena() && biased == 1;
+
+            if (IsOwned())
+                return biased + size_t(shared.load(std::memory_order_acquire) >> 2) == 1;
+
+            // The owner's count can't be read from another thread until it's merged
+            intptr_t current = shared.load(std::memory_order_acquire);
+            return (current & Merged) && (current >> 2) == 1;
+        }
+    };
+
+    /// Both value types start with their GcHeader, so a header can be cast back to its value using the Array flag
+    struct GcValue final {
+        GcHeader header;
+        Rc<GcLayout const> layout;
+
+        void AddRef() {
+            header.AddRef();
+        }
+
+        bool RemoveRef() {
+            return header.RemoveRef();
+        }
+
+        static size_t DataOffset(size_t align) {
+            return (sizeof(GcValue) + align - 1) & ~(align - 1);
+        }
+
+        void *Data() {
+            size_t align = std::visit([](auto const &layout) { return layout.Align(); }, *layout);
+            return reinterpret_cast<void *>(reinterpret_cast<size_t>(this) + DataOffset(align));
+        }
+    };
+
+    struct ArrayValue final {
+        GcHeader header;
+        ValueLayout layout;
+        size_t size;
+        /// Elements are stored out of line, so that the ArrayValue itself never moves
+        void *data;
+
+        void AddRef() {
+            header.AddRef();
+        }
+
+        bool RemoveRef() {
+            return header.RemoveRef();
+        }
+    };
+
+    /// Returns true if values of this layout can hold references to GC values
+    bool IsTraceable(ValueLayout const &layout);
+    bool IsTraceable(GcLayout const &layout);
+
+    /// Header of the value the slot references, or null if the slot is empty or doesn't hold an object or array
+    inline GcHeader *ChildIn(ValueLayout const &layout, void *slot) {
+        if (std::holds_alternative<Rc<GcLayout const>>(layout)) {
+            if (auto value = *reinterpret_cast<GcValue **>(slot))
+                return &value->header;
+        } else if (std::holds_alternative<ArrayLayout>(layout)) {
+            if (auto value = *reinterpret_cast<ArrayValue **>(slot))
+                return &value->header;
+        }
+
+        return nullptr;
+    }
+
+    /// Releases anything the slot holds a reference to, leaving the slot uninitialized
+    void Release(ValueLayout const &layout, void *slot);
+    /// Adds a reference to anything the slot holds, for a slot whose bytes were copied from another
+    void Acquire(ValueLayout const &layout, void *slot);
+
+    /// Marks the value and everything it references as frozen. Arena values are left as they are
+    void Freeze(GcHeader *root);
+
+    /// Allocates a value owned by the calling thread, with its data left uninitialized
+    GcValue *Allocate(Rc<GcLayout const> const &layout);
+    ArrayValue *Allocate(ValueLayout const &element, size_t length);
+
+    /// State of an ArenaScope
+    struct Arena;
+
+    /// The calling thread's innermost ArenaScope, or null
+    inline thread_local Arena *localArena = nullptr;
+
+    /// The ArenaScope an arena value lives in, found among the calling thread's scopes by the value's depth. Null for heap values
+    Arena *ArenaOf(GcHeader const &header);
+
+    /// Allocates a value in the arena, with its data left uninitialized
+    GcValue *Allocate(Arena *arena, Rc<GcLayout const> const &layout);
+    ArrayValue *Allocate(Arena *arena, ValueLayout const &element, size_t length);
+
+    /// Returns true if the value may hold a reference to child, which must live at least as long
+    inline bool MayReference(GcHeader const &parent, GcHeader const &child) {
+        return child.region <= parent.region;
+    }
+
+    /// Which values DeepCopy copies, the rest are shared
+    enum struct CopyMode {
+        /// Everything but frozen values
+        Clone,
+        /// Only arena values
+        Promote,
+    };
+
+    /// Copies the graph to the heap, see Clone and Promote
+    GcValue *DeepCopy(GcValue *value, CopyMode mode);
+    ArrayValue *DeepCopy(ArrayValue *value, CopyMode mode);
+
+    /// Copies the value, the copy shares everything the original references and is owned by the calling thread.
+    /// Arena values are copied into the same ArenaScope, so the copy can keep referencing the original's arena children
+    GcValue *ShallowCopy(GcValue *value);
+    ArrayValue *ShallowCopy(ArrayValue *value);
+
+    /// Releases every reference the value holds, without freeing the value itself
+    void ReleaseFields(GcValue *value);
+    void ReleaseFields(ArrayValue *value);
+
+    /// Frees the value's memory, its fields must already be released
+    void Free(GcValue *value);
+    void Free(ArrayValue *value);
+
+    /// Releases the value's fields, then frees it
+    void Destroy(GcValue *value);
+    void Destroy(ArrayValue *value);
+
+    /// Calls visit(layout, slot) for every field of the value, only the active variant is visited
+    template <typename TVisit>
+    void ForEachSlot(GcValue *value, TVisit &&visit) {
+        void *data = value->Data();
+
+        std::visit(
+            [data, &visit](auto const &layout) {
+                using T = std::decay_t<decltype(layout)>;
+                if constexpr (std::same_as<T, ObjectLayout> || std::same_as<T, TupleLayout>) {
+                    for (auto const &field : layout.Fields()) {
+                        void *slot = reinterpret_cast<void *>(reinterpret_cast<size_t>(data) + field.offset);
+                        if constexpr (std::same_as<T, ObjectLayout>)
+                            visit(field.layout.Layout(), slot);
+                        else
+                            visit(field.layout, slot);
+                    }
+                } else {
+                    size_t tag = 0;
+                    std::memcpy(&tag, data, layout.TagSize());
+                    visit(layout.Variants()[tag].Layout(), reinterpret_cast<void *>(reinterpret_cast<size_t>(data) + layout.PayloadOffset()));
+                }
+            },
+            *value->layout
+        );
+    }
+
+    template <typename TVisit>
+    void ForEachSlot(ArrayValue *value, TVisit &&visit) {
+        size_t stride = GetSize(value->layout);
+
+        for (size_t i = 0; i < value->size; i++)
+            visit(value->layout, reinterpret_cast<void *>(reinterpret_cast<size_t>(value->data) + i * stride));
+    }
+
+    /// Calls visit(GcValue *) or visit(ArrayValue *) for every non-null reference the value holds
+    template <typename TValue, typename TVisit>
+    void ForEachChild(TValue *value, TVisit &&visit) {
+        if constexpr (std::same_as<TValue, ArrayValue>) {
+            if (!IsTraceable(value->layout))
+                return;
+        }
+
+        ForEachSlot(value, [&visit](ValueLayout const &layout, void *slot) {
+            if (std::holds_alternative<Rc<GcLayout const>>(layout)) {
+                if (auto child = *reinterpret_cast<GcValue **>(slot))
+                    visit(child);
+            } else if (std::holds_alternative<ArrayLayout>(layout)) {
+                if (auto child = *reinterpret_cast<ArrayValue **>(slot))
+                    visit(child);
+            }
+        });
+    }
+
+    /// Runs func on the handle's raw value, without giving up the handle's reference
+    template <typename THandle, typename TFunc>
+    auto WithRaw(THandle const &handle, TFunc &&func) {
+        THandle copy = handle;
+        auto raw = copy.IntoRaw();
+        auto result = func(raw);
+        THandle::FromRaw(raw);
+
+        return result;
+    }
+}
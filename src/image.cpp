@@ -0,0 +1,693 @@
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <variant>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "serpent/image.hpp"
+#include "serpent/types/interner.hpp"
+#include "gc.hpp"
+#include "image.hpp"
+
+namespace {
+    using namespace Serpent;
+
+    struct Header final {
+        char magic[4];
+        uint8_t version;
+        uint8_t littleEndian;
+        uint8_t wordSize;
+        /// 0 for an object, 1 for an array
+        uint8_t rootKind;
+        uint64_t size;
+        uint64_t root;
+        /// Size of the root object, or stride of the root array's elements
+        uint64_t rootSize;
+    };
+
+    constexpr char Magic[4] = {'S', 'R', 'P', 'I'};
+    constexpr uint8_t Version = 1;
+    constexpr size_t RecordAlign = 8;
+
+    size_t AlignUp(size_t value, size_t align) {
+        return (value + align - 1) & ~(align - 1);
+    }
+
+    /// Offset of an array record's elements from the start of the record
+    size_t ElementsOffset(ValueLayout const &element) {
+        return AlignUp(sizeof(uint64_t), GetAlign(element));
+    }
+
+    size_t RecordAlignOf(size_t align) {
+        return std::max(RecordAlign, align);
+    }
+
+    uint64_t LoadUnsigned(void const *slot, size_t width) {
+        switch (width) {
+            case 1: {
+                uint8_t value;
+                std::memcpy(&value, slot, 1);
+                return value;
+            }
+            case 2: {
+                uint16_t value;
+                std::memcpy(&value, slot, 2);
+                return value;
+            }
+            case 4: {
+                uint32_t value;
+                std::memcpy(&value, slot, 4);
+                return value;
+            }
+            default: {
+                uint64_t value;
+                std::memcpy(&value, slot, 8);
+                return value;
+            }
+        }
+    }
+
+    struct Writer final {
+        std::vector<std::byte> out {};
+        /// Values already written, so that shared values stay shared
+        std::unordered_map<void const *, size_t> records {};
+        std::unordered_map<size_t, size_t> strings {};
+
+        /// Appends a zeroed record, returns its offset
+        size_t Reserve(size_t size, size_t align) {
+            size_t offset = AlignUp(out.size(), align);
+            out.resize(offset + std::max(size, RecordAlign));
+
+            return offset;
+        }
+
+        template <typename T>
+        void Put(size_t offset, T value) {
+            std::memcpy(out.data() + offset, &value, sizeof(T));
+        }
+
+        size_t String(size_t index) {
+            auto it = strings.find(index);
+            if (it != strings.end())
+                return it->second;
+
+            auto view = Interner::Instance().Get(index);
+            size_t offset = Reserve(sizeof(uint64_t) + view.size(), RecordAlign);
+            Put(offset, uint64_t(view.size()));
+            std::memcpy(out.data() + offset + sizeof(uint64_t), view.data(), view.size());
+
+            strings.insert({index, offset});
+            return offset;
+        }
+
+        /// Replaces a reference slot copied from the value with the distance to its record
+        void Patch(ValueLayout const &layout, void const *source, size_t slot) {
+            size_t target = 0;
+
+            if (std::holds_alternative<PrimitiveLayout>(layout)) {
+                if (std::get<PrimitiveLayout>(layout) != PrimitiveLayout::String)
+                    return;
+
+                size_t index;
+                std::memcpy(&index, source, sizeof(size_t));
+                if (Interner::Instance().Get(index).empty()) {
+                    Put(slot, ptrdiff_t(0));
+                    return;
+                }
+
+                if (auto strings = Images::localStrings) {
+                    if (auto id = strings->add(strings->context, index)) {
+                        Put(slot, uint64_t((*id << 1) | 1));
+                        return;
+                    }
+                }
+
+                target = String(index);
+            } else if (std::holds_alternative<Rc<GcLayout const>>(layout)) {
+                if (auto child = *reinterpret_cast<GcValue * const *>(source))
+                    target = Value(child);
+            } else if (std::holds_alternative<ArrayLayout>(layout)) {
+                if (auto child = *reinterpret_cast<ArrayValue * const *>(source))
+                    target = Value(child);
+            } else {
+                return;
+            }
+
+            Put(slot, target ? ptrdiff_t(target - slot) : ptrdiff_t(0));
+        }
+
+        size_t Value(GcValue *value) {
+            auto it = records.find(value);
+            if (it != records.end())
+                return it->second;
+
+            auto [size, align] = std::visit([](auto const &layout) { return std::pair {layout.Size(), layout.Align()}; }, *value->layout);
+            size_t offset = Reserve(size, RecordAlignOf(align));
+            records.insert({value, offset});
+
+            // Field by field rather than in one copy, so padding and whatever an inactive variant left in the payload stay zeroed instead of ending up in the image
+            auto data = static_cast<std::byte const *>(value->Data());
+            if (auto variant = std::get_if<VariantLayout>(&*value->layout))
+                std::memcpy(out.data() + offset, data, variant->TagSize());
+
+            ForEachSlot(value, [this, data, offset](ValueLayout const &layout, void *slot) {
+                size_t target = offset + size_t(static_cast<std::byte const *>(slot) - data);
+                std::memcpy(out.data() + target, slot, GetSize(layout));
+                Patch(layout, slot, target);
+            });
+
+            return offset;
+        }
+
+        size_t Value(ArrayValue *value) {
+            auto it = records.find(value);
+            if (it != records.end())
+                return it->second;
+
+            size_t stride = GetSize(value->layout);
+            size_t elements = ElementsOffset(value->layout);
+            size_t offset = Reserve(elements + stride * value->size, RecordAlignOf(GetAlign(value->layout)));
+            records.insert({value, offset});
+
+            Put(offset, uint64_t(value->size));
+            if (value->data)
+                std::memcpy(out.data() + offset + elements, value->data, stride * value->size);
+
+            if (IsTraceable(value->layout) || std::holds_alternative<PrimitiveLayout>(value->layout)) {
+                for (size_t i = 0; i < value->size; i++) {
+                    auto source = reinterpret_cast<void const *>(reinterpret_cast<size_t>(value->data) + i * stride);
+                    Patch(value->layout, source, offset + elements + i * stride);
+                }
+            }
+
+            return offset;
+        }
+
+        template <typename TValue>
+        std::vector<std::byte> Finish(TValue *root, uint8_t rootKind, size_t rootSize) {
+            Reserve(sizeof(Header), RecordAlign);
+            size_t offset = Value(root);
+
+            Header header {
+                .magic = {Magic[0], Magic[1], Magic[2], Magic[3]},
+                .version = Version,
+                .littleEndian = std::endian::native == std::endian::little,
+                .wordSize = sizeof(size_t),
+                .rootKind = rootKind,
+                .size = out.size(),
+                .root = offset,
+                .rootSize = rootSize,
+            };
+            Put(0, header);
+
+            return std::move(out);
+        }
+    };
+
+    struct RecordKey final {
+        size_t offset;
+        void const *layout;
+
+        bool operator == (RecordKey const &other) const = default;
+    };
+
+    struct RecordKeyHash final {
+        size_t operator () (RecordKey const &key) const noexcept {
+            return std::hash<size_t> {}(key.offset) ^ (std::hash<void const *> {}(key.layout) * 31);
+        }
+    };
+}
+
+struct Serpent::ImageState final {
+    std::span<std::byte const> bytes;
+    ValueLayout root;
+    size_t rootOffset;
+    /// Table for strings kept outside the image, captured when it's opened
+    Images::StringTable const *strings;
+
+    mutable std::atomic_bool corrupt = false;
+    /// Arrays of Bools or enums already validated, along with the element layout they were validated against.
+    /// Every other record validates in constant time, and isn't remembered
+    mutable std::shared_mutex mutex {};
+    mutable std::unordered_set<RecordKey, RecordKeyHash> validated {};
+
+    /// Once this many arrays are remembered, further ones are validated again on every access instead
+    static constexpr size_t MaxValidated = 4096;
+
+    template <typename T>
+    T Read(size_t offset) const {
+        T value;
+        std::memcpy(&value, bytes.data() + offset, sizeof(T));
+
+        return value;
+    }
+
+    bool Fail() const {
+        corrupt.store(true, std::memory_order_relaxed);
+
+        return false;
+    }
+
+    bool InBounds(size_t offset, size_t size) const {
+        return offset >= sizeof(Header) && offset <= bytes.size() && size <= bytes.size() - offset;
+    }
+
+    bool IsValidated(size_t offset, void const *layout) const {
+        std::shared_lock<std::shared_mutex> lock {mutex};
+
+        return validated.contains({offset, layout});
+    }
+
+    bool MarkValidated(size_t offset, void const *layout) const {
+        std::unique_lock<std::shared_mutex> lock {mutex};
+        if (validated.size() < MaxValidated)
+            validated.insert({offset, layout});
+
+        return true;
+    }
+
+    /// Returns true if IsValidScalar has anything to check for the layout
+    static bool IsRestricted(ValueLayout const &layout) {
+        return std::holds_alternative<Rc<EnumLayout const>>(layout) ||
+            (std::holds_alternative<IntegralLayout>(layout) && std::get<IntegralLayout>(layout) == IntegralLayout::Bool);
+    }
+
+    /// Bools must be 0 or 1 and enums must name one of their values, anything else is always valid
+    bool IsValidScalar(ValueLayout const &layout, size_t offset) const {
+        if (std::holds_alternative<IntegralLayout>(layout) && std::get<IntegralLayout>(layout) == IntegralLayout::Bool)
+            return Read<uint8_t>(offset) <= 1;
+        if (auto en = std::get_if<Rc<EnumLayout const>>(&layout))
+            return LoadUnsigned(bytes.data() + offset, GetSize(layout)) < (*en)->Names().size();
+
+        return true;
+    }
+
+    /// References are validated when they're loaded, so this only checks the object's own bytes
+    bool ValidateObject(GcLayout const &layout, size_t offset) const {
+        auto [size, align] = std::visit([](auto const &layout) { return std::pair {layout.Size(), layout.Align()}; }, layout);
+        if (offset % RecordAlignOf(align) != 0 || !InBounds(offset, size))
+            return Fail();
+
+        bool valid = std::visit(
+            [this, offset](auto const &layout) {
+                using T = std::decay_t<decltype(layout)>;
+                if constexpr (std::same_as<T, ObjectLayout>) {
+                    return std::ranges::all_of(layout.Fields(), [this, offset](auto const &field) { return IsValidScalar(field.layout.Layout(), offset + field.offset); });
+                } else if constexpr (std::same_as<T, TupleLayout>) {
+                    return std::ranges::all_of(layout.Fields(), [this, offset](auto const &field) { return IsValidScalar(field.layout, offset + field.offset); });
+                } else {
+                    uint64_t tag = LoadUnsigned(bytes.data() + offset, layout.TagSize());
+                    return tag < layout.Variants().size() && IsValidScalar(layout.Variants()[tag].Layout(), offset + layout.PayloadOffset());
+                }
+            },
+            layout
+        );
+
+        return valid || Fail();
+    }
+
+    /// Only arrays of Bools or enums check their elements up front, references are validated per element when they're loaded
+    bool ValidateArray(ValueLayout const &element, size_t offset) const {
+        bool restricted = IsRestricted(element);
+        if (restricted && IsValidated(offset, &element))
+            return true;
+
+        if (offset % RecordAlignOf(GetAlign(element)) != 0 || !InBounds(offset, sizeof(uint64_t)))
+            return Fail();
+
+        uint64_t length = Read<uint64_t>(offset);
+        size_t stride = GetSize(element);
+        size_t start = offset + ElementsOffset(element);
+        if (start > bytes.size() || (stride > 0 && length > (bytes.size() - start) / stride))
+            return Fail();
+
+        if (!restricted)
+            return true;
+
+        for (size_t i = 0; i < length; i++) {
+            if (!IsValidScalar(element, start + i * stride))
+                return Fail();
+        }
+
+        return MarkValidated(offset, &element);
+    }
+
+    ImageHandle Object(GcLayout const &layout, size_t offset) const {
+        if (!ValidateObject(layout, offset))
+            return std::monostate {};
+
+        return ImageObject(this, &layout, offset);
+    }
+
+    ImageHandle Array(ValueLayout const &element, size_t offset) const {
+        if (!ValidateArray(element, offset))
+            return std::monostate {};
+
+        return ImageArray(this, &element, offset + ElementsOffset(element), size_t(Read<uint64_t>(offset)));
+    }
+
+    template <typename T>
+    ImageHandle LoadScalar(size_t offset) const {
+        return Read<T>(offset);
+    }
+
+    ImageHandle Load(ValueLayout const &layout, size_t slot) const {
+        if (std::holds_alternative<IntegralLayout>(layout) || std::holds_alternative<Rc<EnumLayout const>>(layout)) {
+            auto integral = std::holds_alternative<IntegralLayout>(layout) ? std::get<IntegralLayout>(layout) : std::get<Rc<EnumLayout const>>(layout)->Backing();
+            switch (integral) {
+                case IntegralLayout::Bool:
+                case IntegralLayout::UInt8:
+                    return LoadScalar<uint8_t>(slot);
+                case IntegralLayout::Int8:
+                    return LoadScalar<int8_t>(slot);
+                case IntegralLayout::UInt16:
+                    return LoadScalar<uint16_t>(slot);
+                case IntegralLayout::Int16:
+                    return LoadScalar<int16_t>(slot);
+                case IntegralLayout::UInt32:
+                    return LoadScalar<uint32_t>(slot);
+                case IntegralLayout::Int32:
+                    return LoadScalar<int32_t>(slot);
+                case IntegralLayout::UInt64:
+                    return LoadScalar<uint64_t>(slot);
+                case IntegralLayout::Int64:
+                    return LoadScalar<int64_t>(slot);
+            }
+        } else if (auto floating = std::get_if<FloatingLayout>(&layout)) {
+            switch (*floating) {
+                case FloatingLayout::Float32:
+                    return LoadScalar<float>(slot);
+                case FloatingLayout::Float64:
+                    return LoadScalar<double>(slot);
+            }
+        } else if (auto primitive = std::get_if<PrimitiveLayout>(&layout)) {
+            if (*primitive == PrimitiveLayout::Unit)
+                return std::monostate {};
+
+            auto distance = Read<ptrdiff_t>(slot);
+            if (distance == 0)
+                return std::string_view {};
+
+            if (distance & 1) {
+                std::optional<std::string_view> view {};
+                if (strings)
+                    view = strings->get(strings->context, uint64_t(distance) >> 1);
+
+                if (!view) {
+                    Fail();
+                    return std::monostate {};
+                }
+
+                return *view;
+            }
+
+            size_t offset = slot + size_t(distance);
+            if (offset % RecordAlign != 0 || !InBounds(offset, sizeof(uint64_t)) || !InBounds(offset + sizeof(uint64_t), Read<uint64_t>(offset))) {
+                Fail();
+                return std::monostate {};
+            }
+
+            uint64_t size = Read<uint64_t>(offset);
+
+            return std::string_view(reinterpret_cast<char const *>(bytes.data() + offset + sizeof(uint64_t)), size_t(size));
+        } else {
+            auto distance = Read<ptrdiff_t>(slot);
+            if (distance == 0)
+                return std::nullopt;
+
+            if (auto object = std::get_if<Rc<GcLayout const>>(&layout))
+                return Object(**object, slot + size_t(distance));
+
+            return Array(std::get<ArrayLayout>(layout).Layout(), slot + size_t(distance));
+        }
+
+        return std::monostate {};
+    }
+};
+
+std::vector<std::byte> Serpent::WriteImage(GcHandle const &root) {
+    return WithRaw(root, [](GcValue *raw) {
+        size_t size = std::visit([](auto const &layout) { return layout.Size(); }, *raw->layout);
+
+        return Writer {}.Finish(raw, 0, size);
+    });
+}
+
+std::vector<std::byte> Serpent::WriteImage(ArrayHandle const &root) {
+    return WithRaw(root, [](ArrayValue *raw) { return Writer {}.Finish(raw, 1, GetSize(raw->layout)); });
+}
+
+void Serpent::Images::WriteImage(GcHandle const &root, std::vector<std::byte> &buffer) {
+    buffer.clear();
+
+    buffer = WithRaw(root, [&buffer](GcValue *raw) {
+        size_t size = std::visit([](auto const &layout) { return layout.Size(); }, *raw->layout);
+
+        return Writer {.out = std::move(buffer)}.Finish(raw, 0, size);
+    });
+}
+
+Serpent::Image::Image(std::unique_ptr<ImageState> state) :
+    state(std::move(state))
+{}
+
+Serpent::Image::Image(Image &&move) = default;
+
+Serpent::Image::~Image() = default;
+
+Serpent::Image &Serpent::Image::operator = (Image &&move) = default;
+
+std::optional<Serpent::Image> Serpent::Image::Open(std::span<std::byte const> bytes, ValueLayout const &root) {
+    if (bytes.size() < sizeof(Header) || reinterpret_cast<size_t>(bytes.data()) % RecordAlign != 0)
+        return std::nullopt;
+
+    Header header;
+    std::memcpy(&header, bytes.data(), sizeof(Header));
+
+    bool compatible = std::memcmp(header.magic, Magic, sizeof(Magic)) == 0 && header.version == Version &&
+        header.littleEndian == (std::endian::native == std::endian::little) && header.wordSize == sizeof(size_t);
+    if (!compatible || header.size != bytes.size())
+        return std::nullopt;
+
+    if (auto object = std::get_if<Rc<GcLayout const>>(&root)) {
+        size_t size = std::visit([](auto const &layout) { return layout.Size(); }, **object);
+        if (header.rootKind != 0 || header.rootSize != size)
+            return std::nullopt;
+    } else if (auto array = std::get_if<ArrayLayout>(&root)) {
+        if (header.rootKind != 1 || header.rootSize != GetSize(array->Layout()))
+            return std::nullopt;
+    } else {
+        return std::nullopt;
+    }
+
+    auto state = std::make_unique<ImageState>(bytes, root, size_t(header.root), Images::localStrings);
+
+    return Image(std::move(state));
+}
+
+Serpent::ImageHandle Serpent::Image::Root() const {
+    if (auto object = std::get_if<Rc<GcLayout const>>(&state->root))
+        return state->Object(**object, state->rootOffset);
+
+    return state->Array(std::get<ArrayLayout>(state->root).Layout(), state->rootOffset);
+}
+
+bool Serpent::Image::IsCorrupt() const {
+    return state->corrupt.load(std::memory_order_relaxed);
+}
+
+Serpent::ImageObject::ImageObject(ImageState const *image, GcLayout const *layout, size_t offset) :
+    image(image),
+    layout(layout),
+    offset(offset)
+{}
+
+Serpent::GcLayout const &Serpent::ImageObject::Layout() const {
+    return *layout;
+}
+
+void const *Serpent::ImageObject::Data() const {
+    return image->bytes.data() + offset;
+}
+
+Serpent::ImageHandle Serpent::ImageObject::Get(std::string_view key) const {
+    InternedString name = key;
+
+    return std::visit(
+        [this, &name](auto const &layout) -> ImageHandle {
+            using T = std::decay_t<decltype(layout)>;
+            if constexpr (std::same_as<T, TupleLayout>) {
+                return std::monostate {};
+            } else {
+                auto index = layout.IndexOf(name);
+                if (!index)
+                    return std::monostate {};
+
+                return Get(*index);
+            }
+        },
+        *layout
+    );
+}
+
+Serpent::ImageHandle Serpent::ImageObject::Get(size_t index) const {
+    return std::visit(
+        [this, index](auto const &layout) -> ImageHandle {
+            using T = std::decay_t<decltype(layout)>;
+            if constexpr (std::same_as<T, ObjectLayout> || std::same_as<T, TupleLayout>) {
+                auto const &fields = layout.Fields();
+                if (index >= fields.size())
+                    return std::monostate {};
+
+                auto const &field = fields[index];
+                if constexpr (std::same_as<T, ObjectLayout>)
+                    return image->Load(field.layout.Layout(), offset + field.offset);
+                else
+                    return image->Load(field.layout, offset + field.offset);
+            } else {
+                if (index >= layout.Variants().size() || LoadUnsigned(Data(), layout.TagSize()) != index)
+                    return std::monostate {};
+
+                return image->Load(layout.Variants()[index].Layout(), offset + layout.PayloadOffset());
+            }
+        },
+        *layout
+    );
+}
+
+bool Serpent::ImageObject::PointerEq(ImageObject const &other) const {
+    return image == other.image && offset == other.offset;
+}
+
+Serpent::ImageArray::ImageArray(ImageState const *image, ValueLayout const *layout, size_t offset, size_t size) :
+    image(image),
+    layout(layout),
+    offset(offset),
+    size(size)
+{}
+
+Serpent::ValueLayout const &Serpent::ImageArray::Layout() const {
+    return *layout;
+}
+
+size_t Serpent::ImageArray::Size() const {
+    return size;
+}
+
+void const *Serpent::ImageArray::Data() const {
+    return image->bytes.data() + offset;
+}
+
+Serpent::ImageHandle Serpent::ImageArray::Get(size_t index) const {
+    if (index >= size)
+        return std::monostate {};
+
+    return image->Load(*layout, offset + index * GetSize(*layout));
+}
+
+bool Serpent::ImageArray::PointerEq(ImageArray const &other) const {
+    return image == other.image && offset == other.offset;
+}
+
+Serpent::MappedFile::MappedFile(void const *data, size_t size, void *handle) :
+    data(data),
+    size(size),
+    handle(handle)
+{}
+
+Serpent::MappedFile::MappedFile(MappedFile &&move) :
+    data(std::exchange(move.data, nullptr)),
+    size(std::exchange(move.size, 0)),
+    handle(std::exchange(move.handle, nullptr))
+{}
+
+Serpent::MappedFile::~MappedFile() {
+    if (!data)
+        return;
+
+#if defined(_WIN32)
+    UnmapViewOfFile(data);
+    CloseHandle(handle);
+#else
+    munmap(const_cast<void *>(data), size);
+#endif
+    data = nullptr;
+}
+
+Serpent::MappedFile &Serpent::MappedFile::operator = (MappedFile &&move) {
+    if (this != &move) {
+        this->~MappedFile();
+        data = std::exchange(move.data, nullptr);
+        size = std::exchange(move.size, 0);
+        handle = std::exchange(move.handle, nullptr);
+    }
+
+    return *this;
+}
+
+std::optional<Serpent::MappedFile> Serpent::MappedFile::Open(std::filesystem::path const &path) {
+#if defined(_WIN32)
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return std::nullopt;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return std::nullopt;
+    }
+
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping)
+        return std::nullopt;
+
+    void const *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!data) {
+        CloseHandle(mapping);
+        return std::nullopt;
+    }
+
+    return MappedFile(data, size_t(size.QuadPart), mapping);
+#else
+    int file = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file < 0)
+        return std::nullopt;
+
+    struct stat info;
+    if (fstat(file, &info) != 0 || info.st_size <= 0) {
+        close(file);
+        return std::nullopt;
+    }
+
+    void *data = mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (data == MAP_FAILED)
+        return std::nullopt;
+
+    return MappedFile(data, size_t(info.st_size), nullptr);
+#endif
+}
+
+std::span<std::byte const> Serpent::MappedFile::Bytes() const {
+    return {static_cast<std::byte const *>(data), size};
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "serpent/value.hpp"
+
+/// Internals of the image format in image.hpp, shared with the translation units that build on it
+namespace Serpent::Images {
+    /// Lets images refer to strings kept outside of them, in a table shared by many images, see ring.cpp.
+    /// A string field referring to the table holds the string's id shifted left once with the low bit set,
+    /// which never collides with the distance to a record, as those are multiples of 8
+    struct StringTable final {
+        void *context;
+        /// Returns the table's id for the string with this interned index, adding it if needed, or nullopt to write the string into the image instead
+        std::optional<uint64_t> (*add)(void *context, size_t index);
+        /// Returns nullopt if the table has no string with this id
+        std::optional<std::string_view> (*get)(void const *context, uint64_t id);
+    };
+
+    /// The calling thread's string table, or null to keep strings inside images.
+    /// WriteImage adds strings to it, and Image::Open captures it, so it must outlive images opened while it's set
+    inline thread_local StringTable const *localStrings = nullptr;
+
+    /// Like WriteImage, but writes into buffer, replacing its contents, so its capacity can be reused across images
+    void WriteImage(GcHandle const &root, std::vector<std::byte> &buffer);
+}
@@ -0,0 +1,374 @@
+#include <bit>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <set>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+#include "serpent/index.hpp"
+#include "serpent/layout.hpp"
+#include "serpent/types/interner.hpp"
+#include "binary.hpp"
+#include "gc.hpp"
+
+namespace {
+    using namespace Serpent;
+
+    enum struct KeyKind : uint8_t {
+        Unsigned,
+        Signed,
+        Floating,
+        String,
+    };
+
+    constexpr uint64_t SignBit = uint64_t(1) << 63;
+    /// Every NaN maps here, which sorts after +inf and is never indexed
+    constexpr uint64_t NaN = UINT64_MAX;
+
+    bool IsSigned(IntegralLayout layout) {
+        return layout == IntegralLayout::Int8 || layout == IntegralLayout::Int16 || layout == IntegralLayout::Int32 || layout == IntegralLayout::Int64;
+    }
+
+    /// Keys are mapped to uint64 so that comparing them as unsigned integers orders them the same way as their values
+    uint64_t FromSigned(int64_t value) {
+        return uint64_t(value) ^ SignBit;
+    }
+
+    uint64_t FromFloating(double value) {
+        if (std::isnan(value))
+            return NaN;
+        // -0 and +0 are equal, so they must share a key
+        if (value == 0)
+            value = 0;
+
+        auto bits = std::bit_cast<uint64_t>(value);
+
+        return bits & SignBit ? ~bits : bits | SignBit;
+    }
+
+    /// An indexed element, ordered by key, then by position.
+    /// String keys hold their interned index, and are ordered by text instead
+    struct Entry final {
+        uint64_t key;
+        std::string_view text;
+        size_t position;
+    };
+
+    struct Order final {
+        bool strings;
+
+        bool operator () (Entry const &lhs, Entry const &rhs) const {
+            if (strings) {
+                if (int compared = lhs.text.compare(rhs.text))
+                    return compared < 0;
+            } else if (lhs.key != rhs.key) {
+                return lhs.key < rhs.key;
+            }
+
+            return lhs.position < rhs.position;
+        }
+    };
+}
+
+struct Serpent::FieldIndexState final {
+    /// The key each position was last indexed under
+    struct Slot final {
+        uint64_t key;
+        bool indexed;
+    };
+
+    ArrayHandle array;
+    IndexKind kind;
+    KeyKind keyKind;
+    size_t keySize;
+    /// Offset of the key from the start of each element's GcValue
+    size_t offset;
+
+    std::vector<Slot> slots;
+    /// Positions holding each key, ordered so the lowest one is found first and any one is erased in logarithmic time
+    std::unordered_map<uint64_t, std::set<size_t>> hash {};
+    std::set<Entry, Order> sorted;
+    /// Number of positions indexed
+    size_t size = 0;
+
+    FieldIndexState(ArrayHandle const &array, IndexKind kind, KeyKind keyKind, size_t keySize, size_t offset) :
+        array(array),
+        kind(kind),
+        keyKind(keyKind),
+        keySize(keySize),
+        offset(offset),
+        slots(array.Length(), Slot {0, false}),
+        sorted(Order {keyKind == KeyKind::String})
+    {}
+
+    ~FieldIndexState() {
+        for (size_t i = 0; i < slots.size(); i++)
+            Remove(i);
+    }
+
+    Entry EntryOf(uint64_t key, size_t position) const {
+        std::string_view text {};
+        if (keyKind == KeyKind::String)
+            text = Interner::Instance().Get(size_t(key));
+
+        return Entry {key, text, position};
+    }
+
+    /// Reads the key of the element at position, or nullopt if it's empty or NaN
+    std::optional<uint64_t> Read(size_t position) const {
+        auto element = static_cast<GcValue *const *>(array.Data())[position];
+        if (!element)
+            return std::nullopt;
+
+        auto slot = reinterpret_cast<std::byte const *>(element) + offset;
+        uint64_t bits = Binary::LoadUnsigned(slot, keySize);
+
+        switch (keyKind) {
+            case KeyKind::Unsigned:
+            case KeyKind::String:
+                return bits;
+            case KeyKind::Signed: {
+                // Sign extends from the key's width
+                size_t shift = 64 - keySize * 8;
+                return FromSigned(int64_t(bits << shift) >> shift);
+            }
+            case KeyKind::Floating: {
+                uint64_t key = keySize == sizeof(float) ? FromFloating(std::bit_cast<float>(uint32_t(bits))) : FromFloating(std::bit_cast<double>(bits));
+                if (key == NaN)
+                    return std::nullopt;
+
+                return key;
+            }
+        }
+
+        return std::nullopt;
+    }
+
+    /// Maps a key handle to its key, or nullopt if it isn't the field's handle type
+    std::optional<uint64_t> KeyOf(Handle const &key) const {
+        return std::visit(
+            [this](auto const &value) -> std::optional<uint64_t> {
+                using T = std::decay_t<decltype(value)>;
+                if constexpr (std::is_integral_v<T>) {
+                    if (keyKind != (std::is_signed_v<T> ? KeyKind::Signed : KeyKind::Unsigned) || keySize != sizeof(T))
+                        return std::nullopt;
+
+                    if constexpr (std::is_signed_v<T>)
+                        return FromSigned(value);
+                    else
+                        return uint64_t(value);
+                } else if constexpr (std::is_floating_point_v<T>) {
+                    if (keyKind != KeyKind::Floating || keySize != sizeof(T))
+                        return std::nullopt;
+
+                    return FromFloating(value);
+                } else if constexpr (std::same_as<T, InternedString>) {
+                    if (keyKind != KeyKind::String)
+                        return std::nullopt;
+
+                    return uint64_t(value.Index());
+                } else {
+                    return std::nullopt;
+                }
+            },
+            key
+        );
+    }
+
+    void Remove(size_t position) {
+        auto &slot = slots[position];
+        if (!slot.indexed)
+            return;
+
+        if (kind == IndexKind::Hash) {
+            auto it = hash.find(slot.key);
+            it->second.erase(position);
+            if (it->second.empty())
+                hash.erase(it);
+        } else {
+            sorted.erase(EntryOf(slot.key, position));
+        }
+
+        // The index held a reference to string keys, so their interned index couldn't be reused while indexed
+        if (keyKind == KeyKind::String)
+            Interner::Instance().RemoveRef(size_t(slot.key));
+
+        slot.indexed = false;
+        size--;
+    }
+
+    void Update(size_t position) {
+        auto key = Read(position);
+        auto &slot = slots[position];
+        if (key && slot.indexed && slot.key == *key)
+            return;
+
+        Remove(position);
+        if (!key)
+            return;
+
+        if (keyKind == KeyKind::String)
+            Interner::Instance().AddRef(size_t(*key));
+
+        if (kind == IndexKind::Hash)
+            hash[*key].insert(position);
+        else
+            sorted.insert(EntryOf(*key, position));
+
+        slot = Slot {*key, true};
+        size++;
+    }
+
+    /// Appends the positions of entries within [lower, upper], in key order
+    size_t Collect(uint64_t lower, uint64_t upper, std::vector<size_t> &out) const {
+        auto first = sorted.lower_bound(EntryOf(lower, 0));
+        auto last = sorted.upper_bound(EntryOf(upper, SIZE_MAX));
+
+        size_t count = 0;
+        // Bounds out of order give an empty range, rather than a reversed one
+        if (first != sorted.end() && (last == sorted.end() || !sorted.key_comp()(*last, *first))) {
+            for (auto it = first; it != last; ++it, count++)
+                out.push_back(it->position);
+        }
+
+        return count;
+    }
+};
+
+Serpent::FieldIndex::FieldIndex(std::unique_ptr<FieldIndexState> state) :
+    state(std::move(state))
+{}
+
+Serpent::FieldIndex::FieldIndex(FieldIndex &&move) = default;
+
+Serpent::FieldIndex::~FieldIndex() = default;
+
+Serpent::FieldIndex &Serpent::FieldIndex::operator = (FieldIndex &&move) = default;
+
+std::optional<Serpent::FieldIndex> Serpent::FieldIndex::Of(ArrayHandle const &array, std::string_view field, IndexKind kind) {
+    auto element = std::get_if<Rc<GcLayout const>>(&array.Layout());
+    if (!element)
+        return std::nullopt;
+
+    auto object = std::get_if<ObjectLayout>(&**element);
+    if (!object)
+        return std::nullopt;
+
+    auto index = object->IndexOf(InternedString(field));
+    if (!index)
+        return std::nullopt;
+
+    auto const &layout = object->Fields()[*index].layout.Layout();
+    KeyKind keyKind;
+    size_t keySize = GetSize(layout);
+
+    if (auto integral = std::get_if<IntegralLayout>(&layout)) {
+        keyKind = IsSigned(*integral) ? KeyKind::Signed : KeyKind::Unsigned;
+    } else if (auto en = std::get_if<Rc<EnumLayout const>>(&layout)) {
+        keyKind = IsSigned((*en)->Backing()) ? KeyKind::Signed : KeyKind::Unsigned;
+    } else if (std::holds_alternative<FloatingLayout>(layout)) {
+        keyKind = KeyKind::Floating;
+    } else if (std::holds_alternative<PrimitiveLayout>(layout) && std::get<PrimitiveLayout>(layout) == PrimitiveLayout::String) {
+        keyKind = KeyKind::String;
+    } else {
+        return std::nullopt;
+    }
+
+    size_t offset = GcValue::DataOffset(object->Align()) + object->Fields()[*index].offset;
+    auto state = std::make_unique<FieldIndexState>(array, kind, keyKind, keySize, offset);
+
+    if (kind == IndexKind::Hash)
+        state->hash.reserve(array.Length());
+
+    for (size_t i = 0; i < array.Length(); i++)
+        state->Update(i);
+
+    return FieldIndex(std::move(state));
+}
+
+Serpent::ArrayHandle const &Serpent::FieldIndex::Array() const {
+    return state->array;
+}
+
+Serpent::IndexKind Serpent::FieldIndex::Kind() const {
+    return state->kind;
+}
+
+size_t Serpent::FieldIndex::Size() const {
+    return state->size;
+}
+
+bool Serpent::FieldIndex::Set(size_t position, Handle element) {
+    if (!state->array.Set(position, std::move(element)))
+        return false;
+
+    state->Update(position);
+
+    return true;
+}
+
+void Serpent::FieldIndex::Update(size_t position) {
+    if (position < state->slots.size())
+        state->Update(position);
+}
+
+void Serpent::FieldIndex::Rebuild() {
+    for (size_t i = 0; i < state->slots.size(); i++)
+        state->Update(i);
+}
+
+std::optional<size_t> Serpent::FieldIndex::Find(Handle const &key) const {
+    auto bits = state->KeyOf(key);
+    if (!bits)
+        return std::nullopt;
+
+    if (state->kind == IndexKind::Sorted) {
+        auto it = state->sorted.lower_bound(state->EntryOf(*bits, 0));
+        if (it == state->sorted.end() || it->key != *bits)
+            return std::nullopt;
+
+        return it->position;
+    }
+
+    auto it = state->hash.find(*bits);
+    if (it == state->hash.end())
+        return std::nullopt;
+
+    return *it->second.begin();
+}
+
+std::optional<size_t> Serpent::FieldIndex::FindAll(Handle const &key, std::vector<size_t> &out) const {
+    auto bits = state->KeyOf(key);
+    if (!bits)
+        return std::nullopt;
+
+    if (state->kind == IndexKind::Sorted)
+        return state->Collect(*bits, *bits, out);
+
+    auto it = state->hash.find(*bits);
+    if (it == state->hash.end())
+        return 0;
+
+    out.insert(out.end(), it->second.begin(), it->second.end());
+
+    return it->second.size();
+}
+
+std::optional<size_t> Serpent::FieldIndex::Range(Handle const &lower, Handle const &upper, std::vector<size_t> &out) const {
+    if (state->kind != IndexKind::Sorted)
+        return std::nullopt;
+
+    auto from = state->KeyOf(lower);
+    auto to = state->KeyOf(upper);
+    if (!from || !to)
+        return std::nullopt;
+
+    return state->Collect(*from, *to, out);
+}
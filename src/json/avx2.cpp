@@ -0,0 +1,15 @@
+#include "table.hpp"
+
+#if defined(__AVX2__)
+#include "impl.hpp"
+#endif
+
+Serpent::Simd::JsonScanners const *Serpent::Simd::Avx2JsonScanners() {
+#if defined(__AVX2__)
+    static JsonScanners const scanners = MakeJsonScanners();
+
+    return &scanners;
+#else
+    return nullptr;
+#endif
+}
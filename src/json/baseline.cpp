@@ -0,0 +1,8 @@
+#include "impl.hpp"
+#include "table.hpp"
+
+Serpent::Simd::JsonScanners const &Serpent::Simd::BaselineJsonScanners() {
+    static JsonScanners const scanners = MakeJsonScanners();
+
+    return scanners;
+}
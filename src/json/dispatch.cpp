@@ -0,0 +1,15 @@
+#include "../simd/cpu.hpp"
+#include "table.hpp"
+
+Serpent::Simd::JsonScanners const &Serpent::Simd::JsonScannersForCpu() {
+    static JsonScanners const &scanners = []() -> JsonScanners const & {
+        if (Detect() == Isa::Avx2) {
+            if (auto avx2 = Avx2JsonScanners())
+                return *avx2;
+        }
+
+        return BaselineJsonScanners();
+    }();
+
+    return scanners;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+#include "../simd/vec.hpp"
+#include "table.hpp"
+
+/// Scanner bodies shared by every ISA translation unit, see kernels/impl.hpp
+namespace {
+    bool IsStringSpecial(uint8_t c) {
+        return c == '"' || c == '\\' || c < 0x20;
+    }
+
+    bool IsWhitespace(uint8_t c) {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    size_t StringEnd(char const *data, size_t size) {
+        auto bytes = reinterpret_cast<uint8_t const *>(data);
+        size_t i = 0;
+
+        if constexpr (HasMask<uint8_t>) {
+            using V = Vec<uint8_t>;
+            auto quote = V::Splat('"');
+            auto backslash = V::Splat('\\');
+            auto control = V::Splat(0x1F);
+
+            for (; i + V::Lanes <= size; i += V::Lanes) {
+                auto chunk = V::Load(bytes + i);
+                // Unsigned min equals the chunk wherever a byte is at most 0x1F
+                auto special = V::Or(V::Or(V::Eq(chunk, quote), V::Eq(chunk, backslash)), V::Eq(V::Min(chunk, control), chunk));
+                if (uint32_t mask = V::Mask(special))
+                    return i + size_t(std::countr_zero(mask));
+            }
+        }
+
+        for (; i < size; i++) {
+            if (IsStringSpecial(bytes[i]))
+                return i;
+        }
+
+        return size;
+    }
+
+    size_t SkipWhitespace(char const *data, size_t size) {
+        auto bytes = reinterpret_cast<uint8_t const *>(data);
+        size_t i = 0;
+
+        // Most values are preceded by a single space or none, only indentation is worth a vector
+        for (; i < size && i < 4; i++) {
+            if (!IsWhitespace(bytes[i]))
+                return i;
+        }
+
+        if constexpr (HasMask<uint8_t>) {
+            using V = Vec<uint8_t>;
+            constexpr uint32_t Lanes = V::Lanes == 32 ? ~uint32_t(0) : (uint32_t(1) << V::Lanes) - 1;
+            auto space = V::Splat(' ');
+            auto tab = V::Splat('\t');
+            auto newline = V::Splat('\n');
+            auto carriage = V::Splat('\r');
+
+            for (; i + V::Lanes <= size; i += V::Lanes) {
+                auto chunk = V::Load(bytes + i);
+                auto whitespace = V::Or(V::Or(V::Eq(chunk, space), V::Eq(chunk, tab)), V::Or(V::Eq(chunk, newline), V::Eq(chunk, carriage)));
+                if (uint32_t mask = ~V::Mask(whitespace) & Lanes)
+                    return i + size_t(std::countr_zero(mask));
+            }
+        }
+
+        for (; i < size; i++) {
+            if (!IsWhitespace(bytes[i]))
+                return i;
+        }
+
+        return size;
+    }
+
+    Serpent::Simd::JsonScanners MakeJsonScanners() {
+        return {
+            .stringEnd = StringEnd,
+            .skipWhitespace = SkipWhitespace,
+        };
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <variant>
+
+#include "serpent/layout.hpp"
+
+namespace Serpent::Json {
+    /// What a field holds, as far as reading and writing JSON is concerned. The first nine match IntegralLayout
+    enum struct SlotKind : uint8_t {
+        Bool,
+        UInt8,
+        Int8,
+        UInt16,
+        Int16,
+        UInt32,
+        Int32,
+        UInt64,
+        Int64,
+        Float32,
+        Float64,
+        String,
+        Unit,
+        Enum,
+        Object,
+        Array,
+    };
+
+    struct Slot final {
+        SlotKind kind;
+        size_t offset;
+        /// The field's layout, kept alive along with the plan
+        ValueLayout const *layout;
+    };
+
+    inline Slot SlotOf(ValueLayout const &layout, size_t offset) {
+        SlotKind kind = std::visit(
+            [](auto const &layout) {
+                using T = std::decay_t<decltype(layout)>;
+                if constexpr (std::same_as<T, IntegralLayout>) {
+                    return SlotKind(layout);
+                } else if constexpr (std::same_as<T, FloatingLayout>) {
+                    return layout == FloatingLayout::Float32 ? SlotKind::Float32 : SlotKind::Float64;
+                } else if constexpr (std::same_as<T, PrimitiveLayout>) {
+                    return layout == PrimitiveLayout::String ? SlotKind::String : SlotKind::Unit;
+                } else if constexpr (std::same_as<T, Rc<EnumLayout const>>) {
+                    return SlotKind::Enum;
+                } else if constexpr (std::same_as<T, Rc<GcLayout const>>) {
+                    return SlotKind::Object;
+                } else {
+                    return SlotKind::Array;
+                }
+            },
+            layout
+        );
+
+        return {kind, offset, &layout};
+    }
+
+    inline bool IsReference(SlotKind kind) {
+        return kind == SlotKind::String || kind == SlotKind::Object || kind == SlotKind::Array;
+    }
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+
+namespace Serpent::Simd {
+    /// Scanners for the hot loops of JSON parsing
+    struct JsonScanners final {
+        /// Index of the first '"', '\\' or control character, or size if there's none
+        size_t (*stringEnd)(char const *data, size_t size);
+        /// Index of the first byte that isn't JSON whitespace, or size if there's none
+        size_t (*skipWhitespace)(char const *data, size_t size);
+    };
+
+    JsonScanners const &BaselineJsonScanners();
+    /// Returns nullptr if the library was built without AVX2 kernels
+    JsonScanners const *Avx2JsonScanners();
+    /// The fastest scanners the CPU supports, shared by the reader and the writer
+    JsonScanners const &JsonScannersForCpu();
+}
@@ -0,0 +1,788 @@
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+#include "serpent/json.hpp"
+#include "serpent/types/interner.hpp"
+#include "gc.hpp"
+#include "json/slot.hpp"
+#include "json/table.hpp"
+#include "plan_cache.hpp"
+
+namespace {
+    using namespace Serpent;
+    using namespace Serpent::Json;
+
+    /// Fields of an object or tuple, or payloads of a variant, with names matched as plain string views so keys never need interning.
+    /// The views point into the layout's interned names, which the cache keeps alive
+    struct Plan final {
+        std::vector<Slot> slots {};
+        std::vector<std::string_view> names {};
+        std::unordered_map<std::string_view, size_t> indices {};
+        /// Only for VariantLayout
+        size_t tagSize = 0;
+        std::optional<std::string_view> variantField {};
+
+        static Plan Compile(GcLayout const &layout) {
+            Plan plan {};
+
+            std::visit(
+                [&plan](auto const &layout) {
+                    using T = std::decay_t<decltype(layout)>;
+                    if constexpr (std::same_as<T, ObjectLayout>) {
+                        for (auto const &field : layout.Fields()) {
+                            plan.indices.emplace(field.layout.Name(), plan.slots.size());
+                            plan.names.push_back(field.layout.Name());
+                            plan.slots.push_back(SlotOf(field.layout.Layout(), field.offset));
+                        }
+                    } else if constexpr (std::same_as<T, TupleLayout>) {
+                        for (auto const &field : layout.Fields())
+                            plan.slots.push_back(SlotOf(field.layout, field.offset));
+                    } else {
+                        plan.tagSize = layout.TagSize();
+                        if (layout.VariantFieldName())
+                            plan.variantField = layout.VariantFieldName()->Value();
+
+                        for (auto const &variant : layout.Variants()) {
+                            plan.indices.emplace(variant.Name(), plan.slots.size());
+                            plan.names.push_back(variant.Name());
+                            plan.slots.push_back(SlotOf(variant.Layout(), layout.PayloadOffset()));
+                        }
+                    }
+                },
+                layout
+            );
+
+            return plan;
+        }
+
+        /// Keys usually come in declaration order, so the expected field is compared before falling back to the map
+        std::optional<size_t> Find(std::string_view key, size_t expected) const {
+            if (expected < names.size() && names[expected] == key)
+                return expected;
+
+            auto it = indices.find(key);
+            if (it == indices.end())
+                return std::nullopt;
+
+            return it->second;
+        }
+    };
+
+    struct EnumPlan final {
+        std::unordered_map<std::string_view, uint64_t> indices {};
+        size_t width = 0;
+
+        static EnumPlan Compile(EnumLayout const &layout) {
+            EnumPlan plan {};
+            plan.width = GetSize(layout.Backing());
+
+            auto const &names = layout.Names();
+            for (size_t i = 0; i < names.size(); i++)
+                plan.indices.emplace(names[i].Value(), i);
+
+            return plan;
+        }
+    };
+
+    Plan const &PlanOf(Rc<GcLayout const> const &layout) {
+        return PlanCache<Plan>::Instance().Of(layout);
+    }
+
+    EnumPlan const &PlanOf(Rc<EnumLayout const> const &layout) {
+        return PlanCache<EnumPlan, EnumLayout>::Instance().Of(layout);
+    }
+
+    void *Offset(void *data, size_t offset) {
+        return reinterpret_cast<void *>(reinterpret_cast<size_t>(data) + offset);
+    }
+
+    template <typename T>
+    void Write(void *slot, T value) {
+        std::memcpy(slot, &value, sizeof(T));
+    }
+
+    /// Tags and enum values are stored as unsigned integers in the low bytes, see WriteTag in value.cpp
+    void WriteUnsigned(void *slot, size_t width, uint64_t value) {
+        std::memcpy(slot, &value, width);
+    }
+
+    uint64_t ReadUnsigned(void const *slot, size_t width) {
+        uint64_t value = 0;
+        std::memcpy(&value, slot, width);
+
+        return value;
+    }
+
+    bool IsDigit(char c) {
+        return c >= '0' && c <= '9';
+    }
+
+    /// Whether the number from_chars parsed between start and end is also valid JSON.
+    /// from_chars also takes inf, nan, leading zeros and a '.' without digits on either side, none of which are JSON
+    bool IsJsonNumber(char const *start, char const *end) {
+        char const *digits = start + (*start == '-');
+        if (digits == end || !IsDigit(*digits) || (*digits == '0' && end - digits > 1 && IsDigit(digits[1])))
+            return false;
+
+        char const *dot = std::find(digits, end, '.');
+        return dot == end || (end - dot > 1 && IsDigit(dot[1]));
+    }
+
+    /// Whether a number from_chars found out of range is too close to zero rather than too large, going by where its first significant digit lands
+    bool IsUnderflow(char const *start, char const *end) {
+        char const *exponent = std::find_if(start, end, [](char c) { return c == 'e' || c == 'E'; });
+        char const *digit = std::find_if(start, exponent, [](char c) { return c >= '1' && c <= '9'; });
+        char const *dot = std::find(start, exponent, '.');
+
+        // Out of range numbers are hundreds of orders of magnitude away from 1, so the scale only needs to be roughly right
+        int64_t scale = digit < dot ? dot - digit : -(digit - dot);
+        if (exponent != end) {
+            char const *digits = exponent + 1 + (exponent[1] == '-' || exponent[1] == '+');
+            int64_t power = 0;
+            if (std::from_chars(digits, end, power).ec != std::errc {})
+                power = std::numeric_limits<int32_t>::max();
+
+            scale += exponent[1] == '-' ? -power : power;
+        }
+
+        return scale < 0;
+    }
+
+    int HexDigit(char c) {
+        if (IsDigit(c))
+            return c - '0';
+        if (c >= 'a' && c <= 'f')
+            return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F')
+            return c - 'A' + 10;
+
+        return -1;
+    }
+
+    void AppendUtf8(std::string &out, uint32_t codepoint) {
+        if (codepoint < 0x80) {
+            out.push_back(char(codepoint));
+        } else if (codepoint < 0x800) {
+            out.push_back(char(0xC0 | (codepoint >> 6)));
+            out.push_back(char(0x80 | (codepoint & 0x3F)));
+        } else if (codepoint < 0x10000) {
+            out.push_back(char(0xE0 | (codepoint >> 12)));
+            out.push_back(char(0x80 | ((codepoint >> 6) & 0x3F)));
+            out.push_back(char(0x80 | (codepoint & 0x3F)));
+        } else {
+            out.push_back(char(0xF0 | (codepoint >> 18)));
+            out.push_back(char(0x80 | ((codepoint >> 12) & 0x3F)));
+            out.push_back(char(0x80 | ((codepoint >> 6) & 0x3F)));
+            out.push_back(char(0x80 | (codepoint & 0x3F)));
+        }
+    }
+
+    /// Single pass pull parser over the whole text. Each value is parsed straight into the slot it belongs to,
+    /// arrays are gathered into a scratch buffer per nesting depth, then copied into their value once their length is known
+    struct Parser final {
+        char const *cursor;
+        char const *end;
+        Simd::JsonScanners const &scanners;
+        /// Holds the last string that contained escapes
+        std::string unescaped {};
+        std::deque<std::vector<std::byte>> scratch {};
+        size_t depth = 0;
+        /// Open brackets of the values being skipped
+        std::vector<char> skipping {};
+
+        size_t Remaining() const {
+            return size_t(end - cursor);
+        }
+
+        void SkipWhitespace() {
+            if (cursor < end && uint8_t(*cursor) > ' ')
+                return;
+
+            cursor += scanners.skipWhitespace(cursor, Remaining());
+        }
+
+        /// Skips whitespace, then the character if it's next
+        bool Consume(char c) {
+            SkipWhitespace();
+            if (cursor == end || *cursor != c)
+                return false;
+
+            cursor++;
+            return true;
+        }
+
+        bool ConsumeLiteral(std::string_view literal) {
+            if (Remaining() < literal.size() || std::string_view(cursor, literal.size()) != literal)
+                return false;
+
+            cursor += literal.size();
+            return true;
+        }
+
+        /// Skips whitespace, then null if it's next
+        bool ConsumeNull() {
+            SkipWhitespace();
+            return cursor < end && *cursor == 'n' && ConsumeLiteral("null");
+        }
+
+        /// Reads the 4 hex digits of a \u escape
+        std::optional<uint32_t> ReadHex() {
+            if (Remaining() < 4)
+                return std::nullopt;
+
+            uint32_t value = 0;
+            for (size_t i = 0; i < 4; i++) {
+                int digit = HexDigit(cursor[i]);
+                if (digit < 0)
+                    return std::nullopt;
+
+                value = value << 4 | uint32_t(digit);
+            }
+
+            cursor += 4;
+            return value;
+        }
+
+        bool Unescape() {
+            if (cursor == end)
+                return false;
+
+            switch (*cursor++) {
+                case '"': unescaped.push_back('"'); return true;
+                case '\\': unescaped.push_back('\\'); return true;
+                case '/': unescaped.push_back('/'); return true;
+                case 'b': unescaped.push_back('\b'); return true;
+                case 'f': unescaped.push_back('\f'); return true;
+                case 'n': unescaped.push_back('\n'); return true;
+                case 'r': unescaped.push_back('\r'); return true;
+                case 't': unescaped.push_back('\t'); return true;
+                case 'u': {
+                    auto unit = ReadHex();
+                    if (!unit || (*unit >= 0xDC00 && *unit < 0xE000))
+                        return false;
+
+                    uint32_t codepoint = *unit;
+                    if (*unit >= 0xD800 && *unit < 0xDC00) {
+                        if (!ConsumeLiteral("\\u"))
+                            return false;
+
+                        auto low = ReadHex();
+                        if (!low || *low < 0xDC00 || *low >= 0xE000)
+                            return false;
+
+                        codepoint = 0x10000 + ((*unit - 0xD800) << 10) + (*low - 0xDC00);
+                    }
+
+                    AppendUtf8(unescaped, codepoint);
+                    return true;
+                }
+                default:
+                    return false;
+            }
+        }
+
+        /// Skips whitespace, then reads a string. The view points into the text, or into `unescaped` until the next string is read
+        std::optional<std::string_view> ReadString() {
+            if (!Consume('"'))
+                return std::nullopt;
+
+            char const *start = cursor;
+            size_t run = scanners.stringEnd(cursor, Remaining());
+            cursor += run;
+
+            // The common case, no escapes
+            if (cursor < end && *cursor == '"')
+                return std::string_view(start, cursor++);
+
+            unescaped.assign(start, run);
+            while (cursor < end && *cursor == '\\') {
+                cursor++;
+                if (!Unescape())
+                    return std::nullopt;
+
+                run = scanners.stringEnd(cursor, Remaining());
+                unescaped.append(cursor, run);
+                cursor += run;
+            }
+
+            // Anything else is the end of the text or a control character
+            if (cursor == end || *cursor != '"')
+                return std::nullopt;
+
+            cursor++;
+            return std::string_view(unescaped);
+        }
+
+        /// Reads "key":
+        std::optional<std::string_view> ReadKey() {
+            auto key = ReadString();
+            if (!key || !Consume(':'))
+                return std::nullopt;
+
+            return key;
+        }
+
+        template <typename T>
+        bool ReadInteger(void *slot) {
+            SkipWhitespace();
+
+            T value {};
+            auto [ptr, error] = std::from_chars(cursor, end, value);
+            // Fractions and exponents are rejected rather than truncated, as are leading zeros
+            if (error != std::errc {} || (ptr < end && (*ptr == '.' || *ptr == 'e' || *ptr == 'E')))
+                return false;
+
+            char const *digits = cursor + (*cursor == '-');
+            if (*digits == '0' && ptr - digits > 1)
+                return false;
+
+            cursor = ptr;
+            Write(slot, value);
+            return true;
+        }
+
+        template <std::floating_point T>
+        bool ReadFloating(void *slot) {
+            SkipWhitespace();
+
+            // Non-finite values are written as null, which reads back as NaN
+            if (cursor < end && *cursor == 'n') {
+                if (!ConsumeLiteral("null"))
+                    return false;
+
+                Write(slot, std::numeric_limits<T>::quiet_NaN());
+                return true;
+            }
+
+            T value {};
+            auto [ptr, error] = std::from_chars(cursor, end, value);
+            if (error == std::errc::result_out_of_range) {
+                // Underflow reads as the nearest value, only overflow is an error
+                double wide = 0;
+                auto result = std::from_chars(cursor, end, wide);
+                if (result.ec == std::errc::result_out_of_range && IsUnderflow(cursor, result.ptr))
+                    wide = *cursor == '-' ? -0.0 : 0.0;
+                else if (result.ec != std::errc {} || std::abs(wide) > double(std::numeric_limits<T>::max()))
+                    return false;
+
+                ptr = result.ptr;
+                value = T(wide);
+            } else if (error != std::errc {}) {
+                return false;
+            }
+
+            if (!IsJsonNumber(cursor, ptr))
+                return false;
+
+            cursor = ptr;
+            Write(slot, value);
+            return true;
+        }
+
+        /// Skips any value without looking at its contents beyond checking it's well-formed, using an explicit stack rather than recursion
+        bool SkipValue() {
+            size_t base = skipping.size();
+
+            while (true) {
+                SkipWhitespace();
+                if (cursor == end)
+                    return false;
+
+                bool closed = true;
+                switch (*cursor) {
+                    case '{':
+                        cursor++;
+                        if (!Consume('}')) {
+                            if (!ReadKey())
+                                return false;
+
+                            skipping.push_back('{');
+                            closed = false;
+                        }
+                        break;
+                    case '[':
+                        cursor++;
+                        if (!Consume(']')) {
+                            skipping.push_back('[');
+                            closed = false;
+                        }
+                        break;
+                    case '"':
+                        if (!ReadString())
+                            return false;
+                        break;
+                    case 't':
+                        if (!ConsumeLiteral("true"))
+                            return false;
+                        break;
+                    case 'f':
+                        if (!ConsumeLiteral("false"))
+                            return false;
+                        break;
+                    case 'n':
+                        if (!ConsumeLiteral("null"))
+                            return false;
+                        break;
+                    default: {
+                        double number = 0;
+                        if (!ReadFloating<double>(&number)) {
+                            // Still a number, just not one a double holds
+                            auto [ptr, error] = std::from_chars(cursor, end, number);
+                            if (error != std::errc::result_out_of_range || !IsJsonNumber(cursor, ptr))
+                                return false;
+
+                            cursor = ptr;
+                        }
+                        break;
+                    }
+                }
+
+                // After a complete value, close any containers it finished, or move on to the next element
+                while (closed) {
+                    if (skipping.size() == base)
+                        return true;
+
+                    if (Consume(',')) {
+                        if (skipping.back() == '{' && !ReadKey())
+                            return false;
+
+                        closed = false;
+                    } else {
+                        if (!Consume(skipping.back() == '{' ? '}' : ']'))
+                            return false;
+
+                        skipping.pop_back();
+                    }
+                }
+            }
+        }
+
+        GcValue *ReadValue(Rc<GcLayout const> const &layout);
+        ArrayValue *ReadArray(ArrayLayout const &layout);
+
+        /// Reads into the slot. If the slot is initialized, whatever it held is released once the new value is read
+        bool ReadSlot(Slot const &slot, void *target, bool initialized) {
+            switch (slot.kind) {
+                case SlotKind::Bool:
+                    SkipWhitespace();
+                    if (ConsumeLiteral("true")) {
+                        Write(target, uint8_t(1));
+                        return true;
+                    }
+                    if (ConsumeLiteral("false")) {
+                        Write(target, uint8_t(0));
+                        return true;
+                    }
+                    return false;
+                case SlotKind::UInt8:
+                    return ReadInteger<uint8_t>(target);
+                case SlotKind::Int8:
+                    return ReadInteger<int8_t>(target);
+                case SlotKind::UInt16:
+                    return ReadInteger<uint16_t>(target);
+                case SlotKind::Int16:
+                    return ReadInteger<int16_t>(target);
+                case SlotKind::UInt32:
+                    return ReadInteger<uint32_t>(target);
+                case SlotKind::Int32:
+                    return ReadInteger<int32_t>(target);
+                case SlotKind::UInt64:
+                    return ReadInteger<uint64_t>(target);
+                case SlotKind::Int64:
+                    return ReadInteger<int64_t>(target);
+                case SlotKind::Float32:
+                    return ReadFloating<float>(target);
+                case SlotKind::Float64:
+                    return ReadFloating<double>(target);
+                case SlotKind::String: {
+                    auto view = ReadString();
+                    if (!view)
+                        return false;
+
+                    auto &interner = Interner::Instance();
+                    size_t index = interner.Acquire(*view);
+                    if (initialized)
+                        interner.RemoveRef(*reinterpret_cast<size_t *>(target));
+                    Write(target, index);
+                    return true;
+                }
+                case SlotKind::Unit:
+                    return ConsumeNull();
+                case SlotKind::Enum: {
+                    auto view = ReadString();
+                    if (!view)
+                        return false;
+
+                    auto const &plan = PlanOf(std::get<Rc<EnumLayout const>>(*slot.layout));
+                    auto it = plan.indices.find(*view);
+                    if (it == plan.indices.end())
+                        return false;
+
+                    WriteUnsigned(target, plan.width, it->second);
+                    return true;
+                }
+                case SlotKind::Object:
+                case SlotKind::Array: {
+                    void *child = nullptr;
+                    if (!ConsumeNull()) {
+                        if (slot.kind == SlotKind::Object)
+                            child = ReadValue(std::get<Rc<GcLayout const>>(*slot.layout));
+                        else
+                            child = ReadArray(std::get<ArrayLayout>(*slot.layout));
+
+                        if (!child)
+                            return false;
+                    }
+
+                    if (initialized)
+                        Release(*slot.layout, target);
+                    Write(target, child);
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        bool ReadObject(Plan const &plan, void *data) {
+            if (!Consume('{'))
+                return false;
+            if (Consume('}'))
+                return true;
+
+            size_t expected = 0;
+            do {
+                auto key = ReadKey();
+                if (!key)
+                    return false;
+
+                auto index = plan.Find(*key, expected);
+                if (!index) {
+                    if (!SkipValue())
+                        return false;
+                    continue;
+                }
+
+                auto const &slot = plan.slots[*index];
+                if (!ReadSlot(slot, Offset(data, slot.offset), true))
+                    return false;
+
+                expected = *index + 1;
+            } while (Consume(','));
+
+            return Consume('}');
+        }
+
+        bool ReadTuple(Plan const &plan, void *data) {
+            if (!Consume('['))
+                return false;
+
+            for (size_t i = 0; i < plan.slots.size(); i++) {
+                if (i > 0 && !Consume(','))
+                    return false;
+
+                auto const &slot = plan.slots[i];
+                if (!ReadSlot(slot, Offset(data, slot.offset), true))
+                    return false;
+            }
+
+            return Consume(']');
+        }
+
+        /// Switches the active variant, Initialize left the first one active
+        void Activate(VariantLayout const &layout, Plan const &plan, void *data, size_t tag) {
+            size_t active = ReadUnsigned(data, plan.tagSize);
+            if (tag == active)
+                return;
+
+            void *payload = Offset(data, layout.PayloadOffset());
+            Release(*plan.slots[active].layout, payload);
+            WriteUnsigned(data, plan.tagSize, tag);
+            DefaultInitialize(*plan.slots[tag].layout, payload);
+        }
+
+        bool ReadVariant(VariantLayout const &layout, Plan const &plan, void *data) {
+            SkipWhitespace();
+
+            if (!plan.variantField) {
+                // A bare name for a Unit variant
+                if (cursor < end && *cursor == '"') {
+                    auto name = ReadString();
+                    auto tag = name ? plan.Find(*name, plan.slots.size()) : std::nullopt;
+                    if (!tag || plan.slots[*tag].kind != SlotKind::Unit)
+                        return false;
+
+                    Activate(layout, plan, data, *tag);
+                    return true;
+                }
+
+                if (!Consume('{'))
+                    return false;
+
+                auto name = ReadKey();
+                auto tag = name ? plan.Find(*name, plan.slots.size()) : std::nullopt;
+                if (!tag)
+                    return false;
+
+                Activate(layout, plan, data, *tag);
+                auto const &slot = plan.slots[*tag];
+                return ReadSlot(slot, Offset(data, slot.offset), true) && Consume('}');
+            }
+
+            if (!Consume('{'))
+                return false;
+            if (Consume('}'))
+                return false;
+
+            std::optional<size_t> tag {};
+            // Where "value" started, if it came before the tag
+            char const *pending = nullptr;
+
+            do {
+                auto key = ReadKey();
+                if (!key)
+                    return false;
+
+                if (*key == *plan.variantField) {
+                    auto name = ReadString();
+                    if (tag || !name)
+                        return false;
+
+                    tag = plan.Find(*name, plan.slots.size());
+                    if (!tag)
+                        return false;
+
+                    Activate(layout, plan, data, *tag);
+
+                    if (pending) {
+                        char const *resume = cursor;
+                        cursor = pending;
+                        auto const &slot = plan.slots[*tag];
+                        if (!ReadSlot(slot, Offset(data, slot.offset), true))
+                            return false;
+                        cursor = resume;
+                    }
+                } else if (*key == "value" && tag) {
+                    auto const &slot = plan.slots[*tag];
+                    if (!ReadSlot(slot, Offset(data, slot.offset), true))
+                        return false;
+                } else {
+                    if (*key == "value")
+                        pending = cursor;
+                    if (!SkipValue())
+                        return false;
+                }
+            } while (Consume(','));
+
+            return tag && Consume('}');
+        }
+    };
+
+    GcValue *Parser::ReadValue(Rc<GcLayout const> const &layout) {
+        GcValue *value = localArena ? Allocate(localArena, layout) : Allocate(layout);
+        void *data = value->Data();
+        auto const &plan = PlanOf(layout);
+
+        // Missing fields keep their defaults
+        std::visit([data](auto const &layout) { layout.Initialize(data); }, *layout);
+
+        bool success = std::visit(
+            [this, &plan, data](auto const &layout) {
+                using T = std::decay_t<decltype(layout)>;
+                if constexpr (std::same_as<T, ObjectLayout>)
+                    return ReadObject(plan, data);
+                else if constexpr (std::same_as<T, TupleLayout>)
+                    return ReadTuple(plan, data);
+                else
+                    return ReadVariant(layout, plan, data);
+            },
+            *layout
+        );
+
+        if (success)
+            return value;
+
+        GcHandle::FromRaw(value);
+        return nullptr;
+    }
+
+    ArrayValue *Parser::ReadArray(ArrayLayout const &layout) {
+        if (!Consume('['))
+            return nullptr;
+
+        auto const &element = layout.Layout();
+        Slot slot = SlotOf(element, 0);
+        size_t stride = GetSize(element);
+
+        if (depth == scratch.size())
+            scratch.emplace_back();
+        auto &buffer = scratch[depth++];
+        size_t length = 0;
+        bool success = true;
+
+        if (!Consume(']')) {
+            do {
+                buffer.resize((length + 1) * stride);
+                success = ReadSlot(slot, buffer.data() + length * stride, false);
+                if (success)
+                    length++;
+            } while (success && Consume(','));
+
+            success = success && Consume(']');
+        }
+
+        ArrayValue *value = nullptr;
+        if (success) {
+            value = localArena ? Allocate(localArena, element, length) : Allocate(element, length);
+            if (length > 0)
+                std::memcpy(value->data, buffer.data(), length * stride);
+        } else if (IsReference(slot.kind)) {
+            for (size_t i = 0; i < length; i++)
+                Release(element, buffer.data() + i * stride);
+        }
+
+        buffer.clear();
+        depth--;
+
+        return value;
+    }
+}
+
+std::optional<Serpent::GcHandle> Serpent::ReadJson(Rc<GcLayout const> const &layout, std::string_view json) {
+    Parser parser {json.data(), json.data() + json.size(), Simd::JsonScannersForCpu()};
+    GcValue *value = parser.ReadValue(layout);
+    if (!value)
+        return std::nullopt;
+
+    auto handle = GcHandle::FromRaw(value);
+    parser.SkipWhitespace();
+    if (parser.cursor != parser.end)
+        return std::nullopt;
+
+    return handle;
+}
+
+std::optional<Serpent::ArrayHandle> Serpent::ReadJson(ArrayLayout const &layout, std::string_view json) {
+    Parser parser {json.data(), json.data() + json.size(), Simd::JsonScannersForCpu()};
+    ArrayValue *value = parser.ReadArray(layout);
+    if (!value)
+        return std::nullopt;
+
+    auto handle = ArrayHandle::FromRaw(value);
+    parser.SkipWhitespace();
+    if (parser.cursor != parser.end)
+        return std::nullopt;
+
+    return handle;
+}
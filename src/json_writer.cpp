@@ -0,0 +1,398 @@
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+#include "serpent/json.hpp"
+#include "serpent/types/interner.hpp"
+#include "gc.hpp"
+#include "json/slot.hpp"
+#include "json/table.hpp"
+#include "plan_cache.hpp"
+
+namespace {
+    using namespace Serpent;
+    using namespace Serpent::Json;
+
+    constexpr size_t BufferSize = 4096;
+    /// Longest number to_chars writes, the shortest round trip form of a double
+    constexpr size_t NumberSize = 32;
+
+    /// Buffers output and hands it on in chunks, either appended to a string or passed to a sink
+    struct Writer final {
+        std::string *out;
+        JsonSink sink;
+        Simd::JsonScanners const &scanners;
+        size_t used = 0;
+        size_t written = 0;
+        /// Left uninitialized, only the first `used` bytes are ever read
+        char buffer[BufferSize];
+
+        Writer(std::string *out, JsonSink sink, Simd::JsonScanners const &scanners) :
+            out(out),
+            sink(sink),
+            scanners(scanners)
+        {}
+
+        void Flush() {
+            if (used == 0)
+                return;
+
+            if (out)
+                out->append(buffer, used);
+            else
+                sink.write(sink.context, std::string_view(buffer, used));
+
+            written += used;
+            used = 0;
+        }
+
+        /// Room for size bytes, which must be at most BufferSize
+        char *Reserve(size_t size) {
+            if (used + size > BufferSize)
+                Flush();
+
+            return buffer + used;
+        }
+
+        void Put(char c) {
+            *Reserve(1) = c;
+            used++;
+        }
+
+        void Put(std::string_view text) {
+            while (text.size() > BufferSize - used) {
+                size_t run = BufferSize - used;
+                std::memcpy(buffer + used, text.data(), run);
+                used += run;
+                text.remove_prefix(run);
+                Flush();
+            }
+
+            std::memcpy(buffer + used, text.data(), text.size());
+            used += text.size();
+        }
+
+        template <typename T>
+        void Number(T value) {
+            if constexpr (std::floating_point<T>) {
+                if (!std::isfinite(value)) {
+                    Put("null");
+                    return;
+                }
+            }
+
+            char *start = Reserve(NumberSize);
+            used += size_t(std::to_chars(start, start + NumberSize, value).ptr - start);
+        }
+
+        void Escape(char c) {
+            switch (c) {
+                case '"': Put("\\\""); return;
+                case '\\': Put("\\\\"); return;
+                case '\b': Put("\\b"); return;
+                case '\f': Put("\\f"); return;
+                case '\n': Put("\\n"); return;
+                case '\r': Put("\\r"); return;
+                case '\t': Put("\\t"); return;
+                default: {
+                    constexpr char hex[] = "0123456789abcdef";
+                    char escaped[] = {'\\', 'u', '0', '0', hex[uint8_t(c) >> 4], hex[uint8_t(c) & 0xF]};
+                    Put(std::string_view(escaped, sizeof(escaped)));
+                    return;
+                }
+            }
+        }
+
+        /// Writes a quoted string, copying the runs between characters that need escaping as they are
+        void String(std::string_view text) {
+            Put('"');
+
+            while (true) {
+                size_t run = scanners.stringEnd(text.data(), text.size());
+                Put(text.substr(0, run));
+                if (run == text.size())
+                    break;
+
+                Escape(text[run]);
+                text.remove_prefix(run + 1);
+            }
+
+            Put('"');
+        }
+    };
+
+    /// Escapes text into a string once, for plans
+    std::string Escaped(std::string_view text) {
+        std::string escaped {};
+        Writer writer {&escaped, {}, Simd::JsonScannersForCpu()};
+        writer.String(text);
+        writer.Flush();
+
+        return escaped;
+    }
+
+    struct Field final {
+        /// Written before the field's value, punctuation included, such as `{"name":` or `,"name":`.
+        /// For a variant with a Unit payload this is the whole value
+        std::string prefix;
+        Slot slot;
+    };
+
+    /// Everything needed to write a GcLayout, with every name escaped ahead of time
+    struct Plan final {
+        std::vector<Field> fields {};
+        /// Written after the fields, or in place of them when there are none
+        std::string_view close {};
+        std::string_view empty {};
+        /// Only for VariantLayout, where fields holds one entry per variant
+        size_t tagSize = 0;
+
+        static Plan Compile(GcLayout const &layout) {
+            Plan plan {};
+
+            std::visit(
+                [&plan](auto const &layout) {
+                    using T = std::decay_t<decltype(layout)>;
+                    if constexpr (std::same_as<T, ObjectLayout>) {
+                        plan.close = "}";
+                        plan.empty = "{}";
+
+                        for (auto const &field : layout.Fields()) {
+                            std::string prefix = plan.fields.empty() ? "{" : ",";
+                            prefix += Escaped(field.layout.Name());
+                            prefix += ':';
+                            plan.fields.push_back({std::move(prefix), SlotOf(field.layout.Layout(), field.offset)});
+                        }
+                    } else if constexpr (std::same_as<T, TupleLayout>) {
+                        plan.close = "]";
+                        plan.empty = "[]";
+
+                        for (auto const &field : layout.Fields())
+                            plan.fields.push_back({plan.fields.empty() ? "[" : ",", SlotOf(field.layout, field.offset)});
+                    } else {
+                        plan.close = "}";
+                        plan.tagSize = layout.TagSize();
+
+                        for (auto const &variant : layout.Variants()) {
+                            Slot slot = SlotOf(variant.Layout(), layout.PayloadOffset());
+                            std::string name = Escaped(variant.Name());
+                            std::string prefix {};
+
+                            // Matches the forms ReadJson takes, with Unit payloads left out
+                            if (auto const &field = layout.VariantFieldName()) {
+                                prefix += '{';
+                                prefix += Escaped(field->Value());
+                                prefix += ':';
+                                prefix += name;
+                                prefix += slot.kind == SlotKind::Unit ? "}" : ",\"value\":";
+                            } else if (slot.kind == SlotKind::Unit) {
+                                prefix = std::move(name);
+                            } else {
+                                prefix += '{';
+                                prefix += name;
+                                prefix += ':';
+                            }
+
+                            plan.fields.push_back({std::move(prefix), slot});
+                        }
+                    }
+                },
+                layout
+            );
+
+            return plan;
+        }
+    };
+
+    struct EnumPlan final {
+        /// Quoted and escaped names, indexed by value
+        std::vector<std::string> names {};
+        size_t width = 0;
+
+        static EnumPlan Compile(EnumLayout const &layout) {
+            EnumPlan plan {};
+            plan.width = GetSize(layout.Backing());
+
+            for (auto const &name : layout.Names())
+                plan.names.push_back(Escaped(name.Value()));
+
+            return plan;
+        }
+    };
+
+    Plan const &PlanOf(Rc<GcLayout const> const &layout) {
+        return PlanCache<Plan>::Instance().Of(layout);
+    }
+
+    EnumPlan const &PlanOf(Rc<EnumLayout const> const &layout) {
+        return PlanCache<EnumPlan, EnumLayout>::Instance().Of(layout);
+    }
+
+    void const *Offset(void const *data, size_t offset) {
+        return reinterpret_cast<void const *>(reinterpret_cast<size_t>(data) + offset);
+    }
+
+    template <typename T>
+    T Read(void const *slot) {
+        T value;
+        std::memcpy(&value, slot, sizeof(T));
+
+        return value;
+    }
+
+    /// Tags and enum values are stored as unsigned integers in the low bytes, see WriteTag in value.cpp
+    uint64_t ReadUnsigned(void const *slot, size_t width) {
+        uint64_t value = 0;
+        std::memcpy(&value, slot, width);
+
+        return value;
+    }
+
+    void WriteValue(Writer &writer, GcValue *value, Plan const &plan);
+    void WriteArray(Writer &writer, ArrayValue *value);
+
+    void WriteSlot(Writer &writer, Slot const &slot, void const *data) {
+        switch (slot.kind) {
+            case SlotKind::Bool:
+                writer.Put(Read<uint8_t>(data) ? std::string_view("true") : std::string_view("false"));
+                return;
+            case SlotKind::UInt8:
+                return writer.Number(Read<uint8_t>(data));
+            case SlotKind::Int8:
+                return writer.Number(Read<int8_t>(data));
+            case SlotKind::UInt16:
+                return writer.Number(Read<uint16_t>(data));
+            case SlotKind::Int16:
+                return writer.Number(Read<int16_t>(data));
+            case SlotKind::UInt32:
+                return writer.Number(Read<uint32_t>(data));
+            case SlotKind::Int32:
+                return writer.Number(Read<int32_t>(data));
+            case SlotKind::UInt64:
+                return writer.Number(Read<uint64_t>(data));
+            case SlotKind::Int64:
+                return writer.Number(Read<int64_t>(data));
+            case SlotKind::Float32:
+                return writer.Number(Read<float>(data));
+            case SlotKind::Float64:
+                return writer.Number(Read<double>(data));
+            case SlotKind::String:
+                return writer.String(Interner::Instance().Get(Read<size_t>(data)));
+            case SlotKind::Unit:
+                return writer.Put("null");
+            case SlotKind::Enum: {
+                auto const &plan = PlanOf(std::get<Rc<EnumLayout const>>(*slot.layout));
+                uint64_t index = ReadUnsigned(data, plan.width);
+                return writer.Put(index < plan.names.size() ? std::string_view(plan.names[index]) : std::string_view("null"));
+            }
+            case SlotKind::Object: {
+                auto child = Read<GcValue *>(data);
+                if (!child)
+                    return writer.Put("null");
+
+                return WriteValue(writer, child, PlanOf(child->layout));
+            }
+            case SlotKind::Array: {
+                auto child = Read<ArrayValue *>(data);
+                if (!child)
+                    return writer.Put("null");
+
+                return WriteArray(writer, child);
+            }
+        }
+    }
+
+    void WriteValue(Writer &writer, GcValue *value, Plan const &plan) {
+        void const *data = value->Data();
+
+        if (plan.tagSize > 0) {
+            auto const &field = plan.fields[ReadUnsigned(data, plan.tagSize)];
+            writer.Put(field.prefix);
+            if (field.slot.kind != SlotKind::Unit) {
+                WriteSlot(writer, field.slot, Offset(data, field.slot.offset));
+                writer.Put(plan.close);
+            }
+            return;
+        }
+
+        if (plan.fields.empty())
+            return writer.Put(plan.empty);
+
+        for (auto const &field : plan.fields) {
+            writer.Put(field.prefix);
+            WriteSlot(writer, field.slot, Offset(data, field.slot.offset));
+        }
+        writer.Put(plan.close);
+    }
+
+    void WriteArray(Writer &writer, ArrayValue *value) {
+        if (value->size == 0)
+            return writer.Put("[]");
+
+        Slot slot = SlotOf(value->layout, 0);
+        size_t stride = GetSize(value->layout);
+
+        writer.Put('[');
+        if (slot.kind == SlotKind::Object) {
+            // Every element shares the array's layout, so the plan is only looked up once
+            auto const &plan = PlanOf(std::get<Rc<GcLayout const>>(value->layout));
+            for (size_t i = 0; i < value->size; i++) {
+                if (i > 0)
+                    writer.Put(',');
+
+                auto child = Read<GcValue *>(Offset(value->data, i * stride));
+                if (child)
+                    WriteValue(writer, child, plan);
+                else
+                    writer.Put("null");
+            }
+        } else {
+            for (size_t i = 0; i < value->size; i++) {
+                if (i > 0)
+                    writer.Put(',');
+
+                WriteSlot(writer, slot, Offset(value->data, i * stride));
+            }
+        }
+        writer.Put(']');
+    }
+
+    /// Writes the value and flushes, returns the number of bytes written
+    template <typename TFunc>
+    size_t Run(std::string *out, JsonSink sink, TFunc &&func) {
+        Writer writer {out, sink, Simd::JsonScannersForCpu()};
+        func(writer);
+        writer.Flush();
+
+        return writer.written;
+    }
+}
+
+size_t Serpent::WriteJson(GcHandle const &value, std::string &out) {
+    return WithRaw(value, [&out](GcValue *raw) {
+        return Run(&out, {}, [raw](Writer &writer) { WriteValue(writer, raw, PlanOf(raw->layout)); });
+    });
+}
+
+size_t Serpent::WriteJson(ArrayHandle const &value, std::string &out) {
+    return WithRaw(value, [&out](ArrayValue *raw) {
+        return Run(&out, {}, [raw](Writer &writer) { WriteArray(writer, raw); });
+    });
+}
+
+size_t Serpent::WriteJson(GcHandle const &value, JsonSink sink) {
+    return WithRaw(value, [sink](GcValue *raw) {
+        return Run(nullptr, sink, [raw](Writer &writer) { WriteValue(writer, raw, PlanOf(raw->layout)); });
+    });
+}
+
+size_t Serpent::WriteJson(ArrayHandle const &value, JsonSink sink) {
+    return WithRaw(value, [sink](ArrayValue *raw) {
+        return Run(nullptr, sink, [raw](Writer &writer) { WriteArray(writer, raw); });
+    });
+}
@@ -0,0 +1,143 @@
+#include <cstddef>
+#include <cstdint>
+#include <variant>
+
+#include "serpent/kernels.hpp"
+#include "serpent/layout.hpp"
+#include "serpent/value.hpp"
+#include "kernels/table.hpp"
+#include "simd/cpu.hpp"
+#include "simd/scalar.hpp"
+
+namespace {
+    using namespace Serpent;
+
+    Simd::KernelTable const &Kernels() {
+        static Simd::KernelTable const &table = []() -> Simd::KernelTable const & {
+            if (Simd::Detect() == Simd::Isa::Avx2) {
+                if (auto avx2 = Simd::Avx2Kernels())
+                    return *avx2;
+            }
+
+            return Simd::BaselineKernels();
+        }();
+
+        return table;
+    }
+
+    bool IsBool(ArrayHandle const &array) {
+        return Simd::KindOf(array.Layout()) == Simd::ScalarKind::Bool;
+    }
+
+    /// Bool elements only take 0 and 1
+    template <typename T>
+    bool IsValidElement(ArrayHandle const &array, T scalar) {
+        return !IsBool(array) || scalar <= 1;
+    }
+
+    template <typename T>
+    T *Elements(ArrayHandle const &array) {
+        return reinterpret_cast<T *>(array.Data());
+    }
+}
+
+bool Serpent::Fill(ArrayHandle const &array, Handle const &value) {
+    if (array.IsFrozen())
+        return false;
+
+    return Simd::WithScalar(array.Layout(), false, [&](auto *tag) {
+        using T = std::remove_pointer_t<decltype(tag)>;
+        auto scalar = std::get_if<T>(&value);
+        if (!scalar || !IsValidElement(array, *scalar))
+            return false;
+
+        Kernels().Get<T>().fill(Elements<T>(array), array.Length(), *scalar);
+        return true;
+    });
+}
+
+Serpent::Handle Serpent::Sum(ArrayHandle const &array) {
+    return Simd::WithScalar(array.Layout(), Handle {}, [&](auto *tag) -> Handle {
+        using T = std::remove_pointer_t<decltype(tag)>;
+
+        return Kernels().Get<T>().sum(Elements<T>(array), array.Length());
+    });
+}
+
+Serpent::Handle Serpent::Min(ArrayHandle const &array) {
+    return Simd::WithScalar(array.Layout(), Handle {}, [&](auto *tag) -> Handle {
+        using T = std::remove_pointer_t<decltype(tag)>;
+        if (array.Length() == 0)
+            return std::monostate {};
+
+        return Kernels().Get<T>().min(Elements<T>(array), array.Length());
+    });
+}
+
+Serpent::Handle Serpent::Max(ArrayHandle const &array) {
+    return Simd::WithScalar(array.Layout(), Handle {}, [&](auto *tag) -> Handle {
+        using T = std::remove_pointer_t<decltype(tag)>;
+        if (array.Length() == 0)
+            return std::monostate {};
+
+        return Kernels().Get<T>().max(Elements<T>(array), array.Length());
+    });
+}
+
+bool Serpent::Scale(ArrayHandle const &array, Handle const &factor) {
+    // Arithmetic on Bool elements could leave values other than 0 and 1
+    if (array.IsFrozen() || IsBool(array))
+        return false;
+
+    return Simd::WithScalar(array.Layout(), false, [&](auto *tag) {
+        using T = std::remove_pointer_t<decltype(tag)>;
+        auto scalar = std::get_if<T>(&factor);
+        if (!scalar)
+            return false;
+
+        Kernels().Get<T>().scale(Elements<T>(array), array.Length(), *scalar);
+        return true;
+    });
+}
+
+bool Serpent::Add(ArrayHandle const &array, Handle const &addend) {
+    if (array.IsFrozen() || IsBool(array))
+        return false;
+
+    return Simd::WithScalar(array.Layout(), false, [&](auto *tag) {
+        using T = std::remove_pointer_t<decltype(tag)>;
+        auto scalar = std::get_if<T>(&addend);
+        if (!scalar)
+            return false;
+
+        Kernels().Get<T>().add(Elements<T>(array), array.Length(), *scalar);
+        return true;
+    });
+}
+
+bool Serpent::Clamp(ArrayHandle const &array, Handle const &min, Handle const &max) {
+    if (array.IsFrozen())
+        return false;
+
+    return Simd::WithScalar(array.Layout(), false, [&](auto *tag) {
+        using T = std::remove_pointer_t<decltype(tag)>;
+        auto lo = std::get_if<T>(&min);
+        auto hi = std::get_if<T>(&max);
+        if (!lo || !hi || !IsValidElement(array, *lo) || !IsValidElement(array, *hi))
+            return false;
+
+        Kernels().Get<T>().clamp(Elements<T>(array), array.Length(), *lo, *hi);
+        return true;
+    });
+}
+
+Serpent::Handle Serpent::Dot(ArrayHandle const &lhs, ArrayHandle const &rhs) {
+    if (lhs.Layout() != rhs.Layout() || lhs.Length() != rhs.Length())
+        return std::monostate {};
+
+    return Simd::WithScalar(lhs.Layout(), Handle {}, [&](auto *tag) -> Handle {
+        using T = std::remove_pointer_t<decltype(tag)>;
+
+        return Kernels().Get<T>().dot(Elements<T>(lhs), Elements<T>(rhs), lhs.Length());
+    });
+}
@@ -0,0 +1,15 @@
+#include "table.hpp"
+
+#if defined(__AVX2__)
+#include "impl.hpp"
+#endif
+
+Serpent::Simd::KernelTable const *Serpent::Simd::Avx2Kernels() {
+#if defined(__AVX2__)
+    static KernelTable const table = MakeTable();
+
+    return &table;
+#else
+    return nullptr;
+#endif
+}
@@ -0,0 +1,8 @@
+#include "impl.hpp"
+#include "table.hpp"
+
+Serpent::Simd::KernelTable const &Serpent::Simd::BaselineKernels() {
+    static KernelTable const table = MakeTable();
+
+    return table;
+}
@@ -0,0 +1,250 @@
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <type_traits>
+
+#include "../simd/vec.hpp"
+#include "table.hpp"
+
+/// Kernel bodies shared by every ISA translation unit. Each one includes this header with its own target flags,
+/// so Vec<T> resolves to that ISA's registers, and anything it can't vectorize falls back to the scalar tail loops.
+namespace {
+    using Serpent::Simd::Accumulator;
+
+    /// Arithmetic in the unsigned domain, so integer overflow wraps instead of being undefined
+    template <typename T>
+    struct WrappingOf {
+        using Type = T;
+    };
+
+    template <std::integral T>
+    struct WrappingOf<T> {
+        using Type = std::conditional_t<(sizeof(T) < sizeof(unsigned)), unsigned, std::make_unsigned_t<T>>;
+    };
+
+    template <typename T>
+    using Wrapping = typename WrappingOf<T>::Type;
+
+    template <typename T>
+    T WrapAdd(T a, T b) {
+        return static_cast<T>(static_cast<Wrapping<T>>(a) + static_cast<Wrapping<T>>(b));
+    }
+
+    template <typename T>
+    T WrapMul(T a, T b) {
+        return static_cast<T>(static_cast<Wrapping<T>>(a) * static_cast<Wrapping<T>>(b));
+    }
+
+    template <typename T>
+    T ScalarMin(T a, T b) {
+        return b < a ? b : a;
+    }
+
+    template <typename T>
+    T ScalarMax(T a, T b) {
+        return a < b ? b : a;
+    }
+
+    template <typename T, typename TReduce>
+    T Reduce(typename Vec<T>::Type value, TReduce reduce) {
+        T lanes[Vec<T>::Lanes];
+        Vec<T>::Store(lanes, value);
+
+        T result = lanes[0];
+        for (size_t i = 1; i < Vec<T>::Lanes; i++)
+            result = reduce(result, lanes[i]);
+
+        return result;
+    }
+
+    template <typename T>
+    void Fill(T *data, size_t count, T value) {
+        size_t i = 0;
+
+        if constexpr (Vectorized<T>) {
+            using V = Vec<T>;
+            auto splat = V::Splat(value);
+            for (; i + V::Lanes <= count; i += V::Lanes)
+                V::Store(data + i, splat);
+        }
+
+        for (; i < count; i++)
+            data[i] = value;
+    }
+
+    template <typename T>
+    Accumulator<T> Sum(T const *data, size_t count) {
+        size_t i = 0;
+        Accumulator<T> sum = 0;
+
+        if constexpr (Vectorized<T> && std::is_floating_point_v<T>) {
+            using V = Vec<T>;
+            // Two independent accumulators hide the latency of the vector add
+            auto a = V::Splat(0);
+            auto b = V::Splat(0);
+            for (; i + 2 * V::Lanes <= count; i += 2 * V::Lanes) {
+                a = V::Add(a, V::Load(data + i));
+                b = V::Add(b, V::Load(data + i + V::Lanes));
+            }
+            sum = Reduce<T>(V::Add(a, b), WrapAdd<T>);
+        } else if constexpr (HasWideSum<T>) {
+            // Integers widen while accumulating, each vector is folded into 64 bit lanes before it's added
+            using V = Vec<T>;
+            using W = Vec<Accumulator<T>>;
+            auto a = W::Splat(0);
+            auto b = W::Splat(0);
+            for (; i + 2 * V::Lanes <= count; i += 2 * V::Lanes) {
+                a = W::Add(a, V::SumWide(V::Load(data + i)));
+                b = W::Add(b, V::SumWide(V::Load(data + i + V::Lanes)));
+            }
+            sum = Reduce<Accumulator<T>>(W::Add(a, b), WrapAdd<Accumulator<T>>);
+        }
+
+        for (; i < count; i++)
+            sum = WrapAdd<Accumulator<T>>(sum, static_cast<Accumulator<T>>(data[i]));
+
+        return sum;
+    }
+
+    template <typename T, bool IsMin>
+    T Extreme(T const *data, size_t count) {
+        constexpr auto scalar = IsMin ? ScalarMin<T> : ScalarMax<T>;
+        size_t i = 0;
+        T result = data[0];
+
+        if constexpr (HasMinMax<T>) {
+            using V = Vec<T>;
+            if (count >= V::Lanes) {
+                auto acc = V::Load(data);
+                for (i = V::Lanes; i + V::Lanes <= count; i += V::Lanes)
+                    acc = IsMin ? V::Min(acc, V::Load(data + i)) : V::Max(acc, V::Load(data + i));
+                result = Reduce<T>(acc, scalar);
+            }
+        }
+
+        for (; i < count; i++)
+            result = scalar(result, data[i]);
+
+        return result;
+    }
+
+    template <typename T>
+    T Min(T const *data, size_t count) {
+        return Extreme<T, true>(data, count);
+    }
+
+    template <typename T>
+    T Max(T const *data, size_t count) {
+        return Extreme<T, false>(data, count);
+    }
+
+    template <typename T>
+    void Scale(T *data, size_t count, T factor) {
+        size_t i = 0;
+
+        if constexpr (HasMul<T>) {
+            using V = Vec<T>;
+            auto splat = V::Splat(factor);
+            for (; i + V::Lanes <= count; i += V::Lanes)
+                V::Store(data + i, V::Mul(V::Load(data + i), splat));
+        }
+
+        for (; i < count; i++)
+            data[i] = WrapMul(data[i], factor);
+    }
+
+    template <typename T>
+    void Add(T *data, size_t count, T addend) {
+        size_t i = 0;
+
+        if constexpr (Vectorized<T>) {
+            using V = Vec<T>;
+            auto splat = V::Splat(addend);
+            for (; i + V::Lanes <= count; i += V::Lanes)
+                V::Store(data + i, V::Add(V::Load(data + i), splat));
+        }
+
+        for (; i < count; i++)
+            data[i] = WrapAdd(data[i], addend);
+    }
+
+    template <typename T>
+    void Clamp(T *data, size_t count, T min, T max) {
+        size_t i = 0;
+
+        if constexpr (HasMinMax<T>) {
+            using V = Vec<T>;
+            auto lo = V::Splat(min);
+            auto hi = V::Splat(max);
+            for (; i + V::Lanes <= count; i += V::Lanes)
+                V::Store(data + i, V::Min(V::Max(V::Load(data + i), lo), hi));
+        }
+
+        for (; i < count; i++)
+            data[i] = ScalarMin(ScalarMax(data[i], min), max);
+    }
+
+    template <typename T>
+    Accumulator<T> Dot(T const *lhs, T const *rhs, size_t count) {
+        size_t i = 0;
+        Accumulator<T> sum = 0;
+
+        if constexpr (HasMul<T> && std::is_floating_point_v<T>) {
+            using V = Vec<T>;
+            auto a = V::Splat(0);
+            auto b = V::Splat(0);
+            for (; i + 2 * V::Lanes <= count; i += 2 * V::Lanes) {
+                a = V::Add(a, V::Mul(V::Load(lhs + i), V::Load(rhs + i)));
+                b = V::Add(b, V::Mul(V::Load(lhs + i + V::Lanes), V::Load(rhs + i + V::Lanes)));
+            }
+            sum = Reduce<T>(V::Add(a, b), WrapAdd<T>);
+        } else if constexpr (HasWideDot<T>) {
+            using V = Vec<T>;
+            using W = Vec<Accumulator<T>>;
+            auto a = W::Splat(0);
+            auto b = W::Splat(0);
+            for (; i + 2 * V::Lanes <= count; i += 2 * V::Lanes) {
+                a = W::Add(a, V::DotWide(V::Load(lhs + i), V::Load(rhs + i)));
+                b = W::Add(b, V::DotWide(V::Load(lhs + i + V::Lanes), V::Load(rhs + i + V::Lanes)));
+            }
+            sum = Reduce<Accumulator<T>>(W::Add(a, b), WrapAdd<Accumulator<T>>);
+        }
+
+        for (; i < count; i++)
+            sum = WrapAdd(sum, WrapMul(static_cast<Accumulator<T>>(lhs[i]), static_cast<Accumulator<T>>(rhs[i])));
+
+        return sum;
+    }
+
+    template <typename T>
+    Serpent::Simd::KernelSet<T> MakeSet() {
+        return {
+            .fill = Fill<T>,
+            .sum = Sum<T>,
+            .min = Min<T>,
+            .max = Max<T>,
+            .scale = Scale<T>,
+            .add = Add<T>,
+            .clamp = Clamp<T>,
+            .dot = Dot<T>,
+        };
+    }
+
+    Serpent::Simd::KernelTable MakeTable() {
+        return {
+            .sets = {
+                MakeSet<uint8_t>(),
+                MakeSet<int8_t>(),
+                MakeSet<uint16_t>(),
+                MakeSet<int16_t>(),
+                MakeSet<uint32_t>(),
+                MakeSet<int32_t>(),
+                MakeSet<uint64_t>(),
+                MakeSet<int64_t>(),
+                MakeSet<float>(),
+                MakeSet<double>(),
+            },
+        };
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+
+namespace Serpent::Simd {
+    /// Integers accumulate in 64 bits of the same signedness, floats in their own type
+    template <typename T>
+    using Accumulator = std::conditional_t<
+        std::is_floating_point_v<T>,
+        T,
+        std::conditional_t<std::is_signed_v<T>, int64_t, uint64_t>
+    >;
+
+    template <typename T>
+    struct KernelSet final {
+        void (*fill)(T *data, size_t count, T value);
+        Accumulator<T> (*sum)(T const *data, size_t count);
+        /// count must be non-zero
+        T (*min)(T const *data, size_t count);
+        /// count must be non-zero
+        T (*max)(T const *data, size_t count);
+        void (*scale)(T *data, size_t count, T factor);
+        void (*add)(T *data, size_t count, T addend);
+        void (*clamp)(T *data, size_t count, T min, T max);
+        Accumulator<T> (*dot)(T const *lhs, T const *rhs, size_t count);
+    };
+
+    struct KernelTable final {
+        std::tuple<
+            KernelSet<uint8_t>,
+            KernelSet<int8_t>,
+            KernelSet<uint16_t>,
+            KernelSet<int16_t>,
+            KernelSet<uint32_t>,
+            KernelSet<int32_t>,
+            KernelSet<uint64_t>,
+            KernelSet<int64_t>,
+            KernelSet<float>,
+            KernelSet<double>
+        > sets;
+
+        template <typename T>
+        KernelSet<T> const &Get() const {
+            return std::get<KernelSet<T>>(sets);
+        }
+    };
+
+    KernelTable const &BaselineKernels();
+    /// Returns nullptr if the library was built without AVX2 kernels
+    KernelTable const *Avx2Kernels();
+}
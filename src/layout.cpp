@@ -8,6 +8,7 @@
 #include <memory>
 #include <optional>
 #include <print>
+#include <span>
 #include <string_view>
 #include <utility>
 #include <variant>
@@ -186,30 +187,93 @@ size_t Serpent::GetAlign(ValueLayout const &layout) {
     );
 }
 
+namespace {
+    using namespace Serpent;
+
+    /// Whether the rules allow a field of this layout
+    bool Allows(LayoutRules rules, ValueLayout const &layout) {
+        if (rules == LayoutRules::Native)
+            return true;
+
+        std::optional<IntegralLayout> integral {};
+        if (auto value = std::get_if<IntegralLayout>(&layout))
+            integral = *value;
+        else if (auto en = std::get_if<Rc<EnumLayout const>>(&layout))
+            integral = (*en)->Backing();
+        else
+            return std::holds_alternative<FloatingLayout>(layout);
+
+        if (*integral == IntegralLayout::Bool)
+            return false;
+
+        return rules == LayoutRules::Scalar || GetSize(layout) >= 4;
+    }
+
+    /// The alignment of a vector of `count` components, each with the given alignment
+    size_t VectorAlign(LayoutRules rules, size_t align, uint8_t count) {
+        if (rules != LayoutRules::Std140 && rules != LayoutRules::Std430)
+            return align;
+
+        return align * (count == 2 ? 2 : 4);
+    }
+
+    /// The alignment of an object or tuple whose widest field has the given alignment
+    size_t AlignUnder(LayoutRules rules, size_t align) {
+        return rules == LayoutRules::Std140 ? std::max(align, size_t(16)) : align;
+    }
+}
+
 Serpent::ObjectLayout::ObjectLayout(
     Serpent::RcArray<Field> fields,
     Serpent::InternedMap<size_t> indices,
     size_t size,
-    size_t align
+    size_t align,
+    LayoutRules rules
 ) :
     fields(fields),
     indices(indices),
     size(size),
-    align(align)
+    align(align),
+    rules(rules)
 {}
 
-std::optional<Serpent::Rc<Serpent::GcLayout const>> Serpent::ObjectLayout::Of(std::initializer_list<NamedLayout> init) {
+std::optional<Serpent::Rc<Serpent::GcLayout const>> Serpent::ObjectLayout::Of(std::initializer_list<NamedLayout> init, LayoutRules rules) {
+    return Of(std::span(init.begin(), init.size()), rules);
+}
+
+std::optional<Serpent::Rc<Serpent::GcLayout const>> Serpent::ObjectLayout::Of(std::span<NamedLayout const> init, LayoutRules rules) {
     size_t offset = 0;
     std::vector<ObjectLayout::Field> fields {};
     std::unordered_map<Serpent::InternedString, size_t> indices;
     size_t size = 0;
     size_t align = 1;
+    // Components still expected after the current field, and their layout
+    size_t components = 0;
+    ValueLayout const *component = nullptr;
 
     for (auto const &field : init) {
         auto const &layout = field.Layout();
-        size_t const fieldAlign = GetAlign(layout);
+        if (!Allows(rules, layout))
+            return std::nullopt;
+
+        size_t fieldAlign = GetAlign(layout);
         size_t const fieldSize  = GetSize(layout);
 
+        if (components > 0) {
+            if (field.Vector() != 1 || layout != *component)
+                return std::nullopt;
+
+            components--;
+        } else if (field.Vector() > 1) {
+            if (field.Vector() > 4)
+                return std::nullopt;
+
+            // Only the first component needs aligning, the others follow it without padding
+            fieldAlign = VectorAlign(rules, fieldAlign, field.Vector());
+            components = field.Vector() - 1;
+            component = &layout;
+        }
+
         offset = (offset + fieldAlign - 1) & ~(fieldAlign - 1);
 
         auto name = field.Name();
@@ -229,9 +293,13 @@ std::optional<Serpent::Rc<Serpent::GcLayout const>> Serpent::ObjectLayout::Of(st
         offset += fieldSize;
     }
 
+    if (components > 0)
+        return std::nullopt;
+
+    align = AlignUnder(rules, align);
     size = (offset + align - 1) & ~(align - 1);
 
-    return Rc<GcLayout const>::Create(ObjectLayout(Serpent::RcArray<Field>::Create(fields), InternedMap<size_t>::Create(indices), size, align));
+    return Rc<GcLayout const>::Create(ObjectLayout(Serpent::RcArray<Field>::Create(fields), InternedMap<size_t>::Create(indices), size, align, rules));
 }
 
 size_t Serpent::ObjectLayout::Size() const {
@@ -242,6 +310,21 @@ size_t Serpent::ObjectLayout::Align() const {
     return align;
 };
 
+Serpent::LayoutRules Serpent::ObjectLayout::Rules() const {
+    return rules;
+}
+
+Serpent::RcArray<Serpent::ObjectLayout::Field> const &Serpent::ObjectLayout::Fields() const {
+    return fields;
+}
+
+std::optional<size_t> Serpent::ObjectLayout::IndexOf(InternedString const &name) const {
+    if (auto index = indices.Get(name))
+        return *index;
+
+    return std::nullopt;
+}
+
 void Serpent::ObjectLayout::Initialize(void *root) const {
     for (auto &field : fields)
         DefaultInitialize(field.layout.Layout(), reinterpret_cast<void *>(reinterpret_cast<size_t>(root) + field.offset));
@@ -250,20 +333,37 @@ void Serpent::ObjectLayout::Initialize(void *root) const {
 Serpent::TupleLayout::TupleLayout(
     Serpent::RcArray<Field> fields,
     size_t size,
-    size_t align
+    size_t align,
+    LayoutRules rules
 ) :
     fields(fields),
     size(size),
-    align(align)
+    align(align),
+    rules(rules)
 {}
 
 Serpent::Rc<Serpent::GcLayout const> Serpent::TupleLayout::Of(std::initializer_list<ValueLayout> init) {
+    return *Of(std::span(init.begin(), init.size()), LayoutRules::Native);
+}
+
+Serpent::Rc<Serpent::GcLayout const> Serpent::TupleLayout::Of(std::span<ValueLayout const> init) {
+    return *Of(init, LayoutRules::Native);
+}
+
+std::optional<Serpent::Rc<Serpent::GcLayout const>> Serpent::TupleLayout::Of(std::initializer_list<ValueLayout> init, LayoutRules rules) {
+    return Of(std::span(init.begin(), init.size()), rules);
+}
+
+std::optional<Serpent::Rc<Serpent::GcLayout const>> Serpent::TupleLayout::Of(std::span<ValueLayout const> init, LayoutRules rules) {
     size_t offset = 0;
     std::vector<TupleLayout::Field> fields {};
     size_t size = 0;
     size_t align = 1;
 
     for (auto const &layout : init) {
+        if (!Allows(rules, layout))
+            return std::nullopt;
+
         size_t const fieldAlign = GetAlign(layout);
         size_t const fieldSize  = GetSize(layout);
 
@@ -279,9 +379,10 @@ Serpent::Rc<Serpent::GcLayout const> Serpent::TupleLayout::Of(std::initializer_l
         offset += fieldSize;
     }
 
+    align = AlignUnder(rules, align);
     size = (offset + align - 1) & ~(align - 1);
 
-    return Rc<GcLayout const>::Create(TupleLayout(Serpent::RcArray<Field>::Create(fields), size, align));
+    return Rc<GcLayout const>::Create(TupleLayout(Serpent::RcArray<Field>::Create(fields), size, align, rules));
 }
 
 size_t Serpent::TupleLayout::Size() const {
@@ -292,6 +393,14 @@ size_t Serpent::TupleLayout::Align() const {
     return align;
 };
 
+Serpent::LayoutRules Serpent::TupleLayout::Rules() const {
+    return rules;
+}
+
+Serpent::RcArray<Serpent::TupleLayout::Field> const &Serpent::TupleLayout::Fields() const {
+    return fields;
+}
+
 void Serpent::TupleLayout::Initialize(void *root) const {
     for (auto &field : fields)
         DefaultInitialize(field.layout, reinterpret_cast<void *>(reinterpret_cast<size_t>(root) + field.offset));
@@ -314,7 +423,11 @@ Serpent::VariantLayout::VariantLayout(
 {}
 
 std::optional<Serpent::Rc<Serpent::GcLayout const>> Serpent::VariantLayout::Of(std::initializer_list<NamedLayout> init, std::optional<std::string_view> variantFieldName) {
-    std::vector<NamedLayout> variants {init};
+    return Of(std::span(init.begin(), init.size()), variantFieldName);
+}
+
+std::optional<Serpent::Rc<Serpent::GcLayout const>> Serpent::VariantLayout::Of(std::span<NamedLayout const> init, std::optional<std::string_view> variantFieldName) {
+    std::vector<NamedLayout> variants {init.begin(), init.end()};
     std::unordered_map<InternedString, size_t> indices;
     size_t size = 0;
     size_t align = 1;
@@ -329,11 +442,16 @@ std::optional<Serpent::Rc<Serpent::GcLayout const>> Serpent::VariantLayout::Of(s
     align = std::max(tagSize, size_t(1));
 
     for (auto const &variant : variants) {
+        if (variant.Vector() != 1)
+            return std::nullopt;
+
         auto const &layout = variant.Layout();
         size_t const variantAlign = GetAlign(layout);
         align = std::max(align, variantAlign);
     }
 
+    size_t payloadSize = 0;
+
     for (size_t i = 0; i < variants.size(); i++) {
         auto const &variant = variants[i];
         auto const &layout = variant.Layout();
@@ -344,11 +462,13 @@ std::optional<Serpent::Rc<Serpent::GcLayout const>> Serpent::VariantLayout::Of(s
         if (indices.contains(name))
             return std::nullopt;
 
-        size = std::max(size, variantSize);
+        payloadSize = std::max(payloadSize, variantSize);
 
         indices.insert({name, i});
     }
 
+    // The payload lives after the tag, at the first offset aligned for every variant
+    size = align + payloadSize;
     size = (size + align - 1) & ~(align - 1);
 
     return Rc<GcLayout const>::Create(VariantLayout(Serpent::RcArray<NamedLayout>::Create(variants), InternedMap<size_t>::Create(indices), variantFieldName, tagSize, size, align));
@@ -362,6 +482,29 @@ size_t Serpent::VariantLayout::Align() const {
     return align;
 }
 
+Serpent::RcArray<Serpent::NamedLayout> const &Serpent::VariantLayout::Variants() const {
+    return variants;
+}
+
+std::optional<size_t> Serpent::VariantLayout::IndexOf(InternedString const &name) const {
+    if (auto index = indices.Get(name))
+        return *index;
+
+    return std::nullopt;
+}
+
+std::optional<Serpent::InternedString> const &Serpent::VariantLayout::VariantFieldName() const {
+    return variantFieldName;
+}
+
+size_t Serpent::VariantLayout::TagSize() const {
+    return tagSize;
+}
+
+size_t Serpent::VariantLayout::PayloadOffset() const {
+    return align;
+}
+
 void Serpent::VariantLayout::Initialize(void *root) const {
     switch (tagSize) {
         case 1:
@@ -380,7 +523,7 @@ void Serpent::VariantLayout::Initialize(void *root) const {
             std::unreachable();
     }
 
-    DefaultInitialize(variants[0].Layout(), reinterpret_cast<void *>(reinterpret_cast<size_t>(root) + align));
+    DefaultInitialize(variants[0].Layout(), reinterpret_cast<void *>(reinterpret_cast<size_t>(root) + PayloadOffset()));
 }
 
 Serpent::ArrayLayout::ArrayLayout(Serpent::ValueLayout &&layout) :
@@ -417,6 +560,10 @@ Serpent::EnumLayout::EnumLayout(
 {}
 
 std::optional<Serpent::Rc<Serpent::EnumLayout const>> Serpent::EnumLayout::Of(std::initializer_list<std::string_view> names, IntegralLayout backing) {
+    return Of(std::span(names.begin(), names.size()), backing);
+}
+
+std::optional<Serpent::Rc<Serpent::EnumLayout const>> Serpent::EnumLayout::Of(std::span<std::string_view const> names, IntegralLayout backing) {
     std::vector<InternedString> values;
     std::unordered_map<InternedString, size_t> indices;
 
@@ -424,9 +571,8 @@ std::optional<Serpent::Rc<Serpent::EnumLayout const>> Serpent::EnumLayout::Of(st
         if (indices.contains(name))
             return std::nullopt;
         
-        values.emplace_back(name);
         indices.emplace(name, values.size());
-        values.push_back(name);
+        values.emplace_back(name);
     }
 
     return Rc<EnumLayout const>::Create(EnumLayout(backing, Serpent::RcArray<InternedString>::Create(values), InternedMap<size_t>::Create(indices)));
@@ -436,18 +582,39 @@ Serpent::IntegralLayout Serpent::EnumLayout::Backing() const {
     return backing;
 }
 
+Serpent::RcArray<Serpent::InternedString> const &Serpent::EnumLayout::Names() const {
+    return names;
+}
+
+std::optional<size_t> Serpent::EnumLayout::IndexOf(InternedString const &name) const {
+    if (auto index = indices.Get(name))
+        return *index;
+
+    return std::nullopt;
+}
+
 Serpent::NamedLayout::NamedLayout(
     std::string_view name,
-    ValueLayout layout
+    ValueLayout layout,
+    uint8_t vector
 ) :
     name(name),
-    layout(layout)
+    layout(layout),
+    vector(vector)
 {}
 
 std::string_view Serpent::NamedLayout::Name() const {
     return name.Value();
 }
 
+Serpent::InternedString const &Serpent::NamedLayout::InternedName() const {
+    return name;
+}
+
 Serpent::ValueLayout const &Serpent::NamedLayout::Layout() const {
     return layout;
 }
+
+uint8_t Serpent::NamedLayout::Vector() const {
+    return vector;
+}
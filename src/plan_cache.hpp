@@ -0,0 +1,43 @@
+#pragma once
+
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <utility>
+
+#include "serpent/layout.hpp"
+#include "serpent/types/rc.hpp"
+
+namespace Serpent {
+    /// Per-layout plans, compiled by TPlan::Compile(TLayout const &, args...) on first use and kept for the life of the cache.
+    /// Each entry holds on to its layout so the address can't be reused, and so plans may point into the layout.
+    /// Instance() is the process-wide cache, for plans that depend on nothing but the layout
+    template <typename TPlan, typename TLayout = GcLayout>
+    struct PlanCache final {
+        std::shared_mutex mutex {};
+        std::unordered_map<TLayout const *, std::pair<Rc<TLayout const>, TPlan>> plans {};
+
+        static PlanCache &Instance() {
+            static PlanCache value {};
+
+            return value;
+        }
+
+        template <typename... TArgs>
+        TPlan const &Of(Rc<TLayout const> const &layout, TArgs const &...args) {
+            {
+                std::shared_lock<std::shared_mutex> lock {mutex};
+                auto it = plans.find(&*layout);
+                if (it != plans.end())
+                    return it->second.second;
+            }
+
+            std::unique_lock<std::shared_mutex> lock {mutex};
+            auto [it, inserted] = plans.try_emplace(&*layout, layout, TPlan {});
+            if (inserted)
+                it->second.second = TPlan::Compile(*layout, args...);
+
+            return it->second.second;
+        }
+    };
+}
@@ -0,0 +1,278 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <thread>
+#include <variant>
+#include <vector>
+
+#include "serpent/layout.hpp"
+#include "serpent/pool.hpp"
+#include "serpent/refcount.hpp"
+#include "serpent/value.hpp"
+#include "binary.hpp"
+#include "gc.hpp"
+
+namespace {
+    using namespace Serpent;
+
+    /// How long an idle worker sleeps before checking for released values to merge
+    constexpr auto IdleWait = std::chrono::milliseconds(50);
+
+    constexpr size_t CacheLine = 64;
+    /// Fewest elements in a chunk, so cheap per-element work isn't drowned out by scheduling
+    constexpr size_t MinimumChunk = 256;
+    /// Chunks per thread, enough for stealing to even out uneven work
+    constexpr size_t ChunksPerThread = 16;
+
+    struct Job final {
+        void *context;
+        void (*func)(void *context, size_t begin, size_t end);
+        size_t grain;
+        /// Indices not run yet, the caller waits for this to reach 0
+        std::atomic_size_t remaining;
+    };
+
+    struct Task final {
+        Job *job;
+        size_t begin;
+        size_t end;
+    };
+
+    struct Queue final {
+        std::mutex mutex {};
+        std::deque<Task> tasks {};
+    };
+
+    /// Whether elements of this layout can be seen as a scalar of this kind and size
+    bool Matches(ValueLayout const &layout, bool floating, bool sign, size_t size) {
+        std::optional<IntegralLayout> integral {};
+        if (auto value = std::get_if<IntegralLayout>(&layout))
+            integral = *value;
+        else if (auto en = std::get_if<Rc<EnumLayout const>>(&layout))
+            integral = (*en)->Backing();
+        else if (std::holds_alternative<FloatingLayout>(layout))
+            return floating && GetSize(layout) == size;
+        else
+            return false;
+
+        switch (*integral) {
+            case IntegralLayout::Int8:
+            case IntegralLayout::Int16:
+            case IntegralLayout::Int32:
+            case IntegralLayout::Int64:
+                return !floating && sign && GetSize(layout) == size;
+            default:
+                return !floating && !sign && GetSize(layout) == size;
+        }
+    }
+}
+
+struct Serpent::ThreadPoolState final {
+    /// One queue per worker, then one shared by threads outside the pool
+    std::vector<Queue> queues;
+    /// Tasks in all queues, so idle workers know when to sleep
+    std::atomic_size_t queued = 0;
+    std::mutex mutex {};
+    std::condition_variable wake {};
+    bool stopping = false;
+    std::vector<std::jthread> threads {};
+
+    /// The pool and queue the calling thread works from, if it's a worker
+    static thread_local ThreadPoolState *localPool;
+    static thread_local size_t localQueue;
+
+    explicit ThreadPoolState(size_t workers) :
+        queues(workers + 1)
+    {
+        for (size_t i = 0; i < workers; i++)
+            threads.emplace_back([this, i] { Work(i); });
+    }
+
+    ~ThreadPoolState() {
+        {
+            std::unique_lock<std::mutex> lock {mutex};
+            stopping = true;
+        }
+        wake.notify_all();
+        threads.clear();
+    }
+
+    size_t Own() const {
+        return localPool == this ? localQueue : queues.size() - 1;
+    }
+
+    void Push(Task task) {
+        auto &queue = queues[Own()];
+        {
+            std::unique_lock<std::mutex> lock {queue.mutex};
+            queue.tasks.push_back(task);
+        }
+        queued.fetch_add(1, std::memory_order_release);
+
+        // Taking the lock orders this with a worker deciding to sleep, so the wakeup can't be lost
+        { std::unique_lock<std::mutex> lock {mutex}; }
+        wake.notify_one();
+    }
+
+    /// Pops the newest task from the thread's own queue, or steals the oldest from another
+    bool TryTake(Task &task) {
+        if (queued.load(std::memory_order_acquire) == 0)
+            return false;
+
+        size_t own = Own();
+        for (size_t i = 0; i < queues.size(); i++) {
+            auto &queue = queues[(own + i) % queues.size()];
+            std::unique_lock<std::mutex> lock {queue.mutex};
+            if (queue.tasks.empty())
+                continue;
+
+            if (i == 0) {
+                task = queue.tasks.back();
+                queue.tasks.pop_back();
+            } else {
+                task = queue.tasks.front();
+                queue.tasks.pop_front();
+            }
+
+            queued.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        return false;
+    }
+
+    /// Splits off the back half of the task until it's small enough, leaving the halves for other threads to steal, then runs it
+    void Execute(Task task) {
+        Job &job = *task.job;
+        while (task.end - task.begin > job.grain) {
+            size_t middle = task.begin + (task.end - task.begin) / 2;
+            Push({task.job, middle, task.end});
+            task.end = middle;
+        }
+
+        job.func(job.context, task.begin, task.end);
+        job.remaining.fetch_sub(task.end - task.begin, std::memory_order_acq_rel);
+    }
+
+    void Work(size_t index) {
+        localPool = this;
+        localQueue = index;
+
+        while (true) {
+            Task task;
+            if (TryTake(task)) {
+                Execute(task);
+                continue;
+            }
+
+            MergeReleased();
+
+            std::unique_lock<std::mutex> lock {mutex};
+            if (stopping)
+                return;
+
+            wake.wait_for(lock, IdleWait, [this] { return stopping || queued.load(std::memory_order_acquire) > 0; });
+        }
+    }
+
+    void Run(size_t count, size_t grain, void *context, void (*func)(void *, size_t, size_t)) {
+        grain = std::max(grain, size_t(1));
+        if (threads.empty() || count <= grain) {
+            func(context, 0, count);
+            return;
+        }
+
+        Job job {context, func, grain, count};
+        Execute({&job, 0, count});
+
+        // Helps with whatever is queued, this job or any other, until every part of this one is done
+        while (job.remaining.load(std::memory_order_acquire) > 0) {
+            Task task;
+            if (TryTake(task))
+                Execute(task);
+            else
+                std::this_thread::yield();
+        }
+    }
+};
+
+thread_local Serpent::ThreadPoolState *Serpent::ThreadPoolState::localPool = nullptr;
+thread_local size_t Serpent::ThreadPoolState::localQueue = 0;
+
+Serpent::ThreadPool::ThreadPool(size_t concurrency) :
+    state(std::make_unique<ThreadPoolState>((concurrency > 0 ? concurrency : std::max<size_t>(std::thread::hardware_concurrency(), 1)) - 1))
+{}
+
+Serpent::ThreadPool::~ThreadPool() = default;
+
+Serpent::ThreadPool &Serpent::ThreadPool::Default() {
+    static ThreadPool pool {};
+    return pool;
+}
+
+size_t Serpent::ThreadPool::Concurrency() const {
+    return state->threads.size() + 1;
+}
+
+void Serpent::ThreadPool::Run(size_t count, size_t grain, void *context, void (*func)(void *, size_t, size_t)) {
+    state->Run(count, grain, context, func);
+}
+
+std::optional<Serpent::ThreadPool::Elements> Serpent::ThreadPool::Describe(ArrayHandle const &array, ElementKind kind, size_t size, size_t align, bool writes) const {
+    if (writes && array.IsFrozen())
+        return std::nullopt;
+
+    auto const &layout = array.Layout();
+    Elements elements {static_cast<std::byte *>(array.Data()), GetSize(layout), array.Length(), false, 0, 0, 0, 0};
+
+    if (auto object = std::get_if<Rc<GcLayout const>>(&layout)) {
+        auto [objectSize, objectAlign] = std::visit([](auto const &layout) { return std::pair {layout.Size(), layout.Align()}; }, **object);
+        if (kind != ElementKind::Object || size != objectSize || align > objectAlign)
+            return std::nullopt;
+        // Strings, objects and arrays are stored as interned indices and pointers, raw writes would bypass their reference counts.
+        // A raw write to a variant's tag would also switch variants without initializing the payload
+        if (writes && (Binary::PlanOf(*object).references || std::holds_alternative<VariantLayout>(**object)))
+            return std::nullopt;
+
+        elements.objects = true;
+        elements.dataOffset = GcValue::DataOffset(objectAlign);
+    } else if (kind == ElementKind::Object || !Matches(layout, kind == ElementKind::Floating, kind == ElementKind::Signed, size)) {
+        return std::nullopt;
+    }
+
+    // The fewest elements that span a whole number of cache lines, and how many of them fit before the first line boundary
+    size_t const perLine = CacheLine / std::gcd(CacheLine, elements.stride);
+    size_t head = 0;
+    for (size_t i = 0; i < perLine; i++) {
+        if ((reinterpret_cast<uintptr_t>(elements.data) + i * elements.stride) % CacheLine == 0) {
+            head = i;
+            break;
+        }
+    }
+
+    elements.shift = (perLine - head) % perLine;
+
+    size_t const span = elements.length + elements.shift;
+    size_t const lines = (span + perLine - 1) / perLine;
+    size_t const target = Concurrency() * ChunksPerThread;
+    size_t const chunkLines = std::max((MinimumChunk + perLine - 1) / perLine, (lines + target - 1) / target);
+
+    elements.chunk = chunkLines * perLine;
+    elements.chunks = elements.length > 0 ? (span + elements.chunk - 1) / elements.chunk : 0;
+
+    return elements;
+}
+
+void Serpent::ThreadPool::Resolve(Elements const &elements, size_t begin, size_t end, bool writes, void **out) {
+    auto values = reinterpret_cast<GcValue *const *>(elements.data);
+    for (size_t i = begin; i < end; i++) {
+        GcValue *value = values[i];
+        bool skip = !value || (writes && value->header.IsFrozen());
+        out[i - begin] = skip ? nullptr : reinterpret_cast<std::byte *>(value) + elements.dataOffset;
+    }
+}
@@ -0,0 +1,300 @@
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <variant>
+#include <vector>
+
+#include "serpent/layout.hpp"
+#include "serpent/query.hpp"
+#include "serpent/value.hpp"
+#include "query/table.hpp"
+#include "simd/cpu.hpp"
+#include "simd/gather.hpp"
+#include "simd/scalar.hpp"
+#include "gc.hpp"
+
+namespace {
+    using namespace Serpent;
+
+    /// Elements evaluated at a time, a whole number of selection words, small enough that the gathered fields stay in L1
+    constexpr size_t Block = 256;
+
+    Simd::QueryKernels const &Kernels() {
+        static Simd::QueryKernels const &kernels = []() -> Simd::QueryKernels const & {
+            if (Simd::Detect() == Simd::Isa::Avx2) {
+                if (auto avx2 = Simd::Avx2QueryKernels())
+                    return *avx2;
+            }
+
+            return Simd::BaselineQueryKernels();
+        }();
+
+        return kernels;
+    }
+
+    struct Field final {
+        size_t offset;
+        Simd::ScalarKind kind;
+        ValueLayout layout;
+        /// The layout values are stored as, the backing type for enums
+        ValueLayout scalar;
+    };
+
+    /// Returns nullopt if the field doesn't exist or isn't IntegralLayout, FloatingLayout or an enum
+    std::optional<Field> Resolve(ObjectLayout const &object, std::string_view name) {
+        auto index = object.IndexOf(InternedString(name));
+        if (!index)
+            return std::nullopt;
+
+        auto const &field = object.Fields()[*index];
+        ValueLayout const &layout = field.layout.Layout();
+        ValueLayout scalar = layout;
+        if (auto en = std::get_if<Rc<EnumLayout const>>(&layout))
+            scalar = (*en)->Backing();
+
+        auto kind = Simd::KindOf(scalar);
+        if (!kind)
+            return std::nullopt;
+
+        return Field {field.offset, *kind, layout, scalar};
+    }
+
+    bool IsArrayOf(ArrayHandle const &array, Rc<GcLayout const> const &layout) {
+        auto element = std::get_if<Rc<GcLayout const>>(&array.Layout());
+
+        return element && **element == *layout;
+    }
+
+    /// Size of the layout, and the offset of its data from the start of each GcValue
+    std::pair<size_t, size_t> Measure(Rc<GcLayout const> const &layout) {
+        auto [size, align] = std::visit([](auto const &layout) { return std::pair {layout.Size(), layout.Align()}; }, *layout);
+
+        return {size, GcValue::DataOffset(align)};
+    }
+}
+
+size_t Serpent::Selection::Count() const {
+    size_t count = 0;
+    for (uint64_t word : words)
+        count += size_t(std::popcount(word));
+
+    return count;
+}
+
+bool Serpent::Selection::Contains(size_t position) const {
+    return position < length && (words[position / 64] >> (position % 64)) & 1;
+}
+
+void Serpent::Selection::And(Selection const &other) {
+    for (size_t i = 0; i < words.size(); i++)
+        words[i] &= i < other.words.size() ? other.words[i] : 0;
+}
+
+void Serpent::Selection::Or(Selection const &other) {
+    for (size_t i = 0; i < std::min(words.size(), other.words.size()); i++)
+        words[i] |= other.words[i];
+}
+
+size_t Serpent::Selection::Positions(std::vector<size_t> &out) const {
+    size_t first = out.size();
+    out.reserve(first + Count());
+
+    for (size_t i = 0; i < words.size(); i++) {
+        for (uint64_t word = words[i]; word != 0; word &= word - 1)
+            out.push_back(i * 64 + size_t(std::countr_zero(word)));
+    }
+
+    return out.size() - first;
+}
+
+Serpent::Query::Query(Rc<GcLayout const> layout, RcArray<Term> terms) :
+    layout(layout),
+    terms(terms)
+{}
+
+std::optional<Serpent::Query> Serpent::Query::Of(Rc<GcLayout const> const &layout, std::span<Predicate const> predicates) {
+    auto object = std::get_if<ObjectLayout>(&*layout);
+    if (!object)
+        return std::nullopt;
+
+    std::vector<Term> terms {};
+    for (auto const &predicate : predicates) {
+        auto field = Resolve(*object, predicate.field);
+        if (!field || size_t(predicate.op) >= CompareOpCount)
+            return std::nullopt;
+
+        auto value = Simd::WithScalar(field->scalar, std::optional<uint64_t> {}, [&predicate](auto *tag) -> std::optional<uint64_t> {
+            using T = std::remove_pointer_t<decltype(tag)>;
+            auto value = std::get_if<T>(&predicate.value);
+            if (!value)
+                return std::nullopt;
+
+            uint64_t bits = 0;
+            std::memcpy(&bits, value, sizeof(T));
+
+            return bits;
+        });
+        if (!value)
+            return std::nullopt;
+
+        terms.push_back(Term {
+            .offset = field->offset,
+            .kind = uint8_t(field->kind),
+            .op = predicate.op,
+            .value = *value,
+        });
+    }
+
+    return Query(layout, RcArray<Term>::Create(terms));
+}
+
+Serpent::Rc<Serpent::GcLayout const> const &Serpent::Query::Layout() const {
+    return layout;
+}
+
+Serpent::RcArray<Serpent::Query::Term> const &Serpent::Query::Terms() const {
+    return terms;
+}
+
+bool Serpent::Query::Select(ArrayHandle const &array, Selection &selection) const {
+    if (!IsArrayOf(array, layout))
+        return false;
+
+    size_t const length = array.Length();
+    selection.length = length;
+    selection.words.assign((length + 63) / 64, 0);
+
+    auto [size, dataOffset] = Measure(layout);
+    auto elements = static_cast<GcValue *const *>(array.Data());
+    auto const &kernels = Kernels();
+
+    // Empty elements read their fields from here instead, they're already out of the selection
+    std::vector<std::byte> zeros(size);
+
+    std::byte const *sources[Block];
+    alignas(8) std::byte gathered[Block * 8];
+
+    for (size_t begin = 0; begin < length; begin += Block) {
+        size_t const count = std::min(Block, length - begin);
+        uint64_t *mask = selection.words.data() + begin / 64;
+        size_t const words = (count + 63) / 64;
+
+        bool any = false;
+        for (size_t i = 0; i < count; i++) {
+            auto value = elements[begin + i];
+            if (value) {
+                sources[i] = reinterpret_cast<std::byte const *>(value) + dataOffset;
+                mask[i / 64] |= uint64_t(1) << (i % 64);
+                any = true;
+            } else {
+                sources[i] = zeros.data();
+            }
+        }
+
+        for (auto const &term : terms) {
+            if (!any)
+                break;
+
+            auto kind = Simd::ScalarKind(term.kind);
+            Simd::Gather(sources, count, term.offset, Simd::SizeOf(kind), gathered);
+            kernels.filters[term.kind][size_t(term.op)](gathered, count, &term.value, mask);
+
+            any = std::any_of(mask, mask + words, [](uint64_t word) { return word != 0; });
+        }
+    }
+
+    return true;
+}
+
+std::optional<size_t> Serpent::Query::Select(ArrayHandle const &array, std::vector<size_t> &out) const {
+    Selection selection {};
+    if (!Select(array, selection))
+        return std::nullopt;
+
+    return selection.Positions(out);
+}
+
+Serpent::Projection::Projection(Rc<GcLayout const> layout, RcArray<Column> columns) :
+    layout(layout),
+    columns(columns)
+{}
+
+std::optional<Serpent::Projection> Serpent::Projection::Of(Rc<GcLayout const> const &layout, std::span<std::string_view const> fields) {
+    auto object = std::get_if<ObjectLayout>(&*layout);
+    if (!object)
+        return std::nullopt;
+
+    std::vector<Column> columns {};
+    for (auto name : fields) {
+        auto field = Resolve(*object, name);
+        if (!field)
+            return std::nullopt;
+
+        columns.push_back(Column {
+            .offset = field->offset,
+            .size = Simd::SizeOf(field->kind),
+            .layout = field->layout,
+        });
+    }
+
+    return Projection(layout, RcArray<Column>::Create(columns));
+}
+
+Serpent::Rc<Serpent::GcLayout const> const &Serpent::Projection::Layout() const {
+    return layout;
+}
+
+Serpent::RcArray<Serpent::Projection::Column> const &Serpent::Projection::Columns() const {
+    return columns;
+}
+
+bool Serpent::Projection::Project(ArrayHandle const &array, Selection const &selection, std::span<std::span<std::byte> const> targets) const {
+    if (!IsArrayOf(array, layout))
+        return false;
+    if (selection.length != array.Length() || selection.words.size() != (selection.length + 63) / 64 || targets.size() < columns.size())
+        return false;
+
+    size_t const count = selection.Count();
+    for (size_t i = 0; i < columns.size(); i++) {
+        if (targets[i].size() / columns[i].size < count)
+            return false;
+    }
+
+    auto [size, dataOffset] = Measure(layout);
+    auto elements = static_cast<GcValue *const *>(array.Data());
+    std::vector<std::byte> zeros(size);
+
+    std::byte const *sources[Block];
+    size_t pending = 0;
+    size_t written = 0;
+
+    // Gathers each column for a block of selected elements at a time
+    auto flush = [&] {
+        for (size_t i = 0; i < columns.size(); i++)
+            Simd::Gather(sources, pending, columns[i].offset, columns[i].size, targets[i].data() + written * columns[i].size);
+
+        written += pending;
+        pending = 0;
+    };
+
+    for (size_t i = 0; i < selection.words.size(); i++) {
+        for (uint64_t word = selection.words[i]; word != 0; word &= word - 1) {
+            size_t position = i * 64 + size_t(std::countr_zero(word));
+            if (position >= selection.length)
+                break;
+
+            auto value = elements[position];
+            sources[pending++] = value ? reinterpret_cast<std::byte const *>(value) + dataOffset : zeros.data();
+            if (pending == Block)
+                flush();
+        }
+    }
+
+    flush();
+
+    return true;
+}
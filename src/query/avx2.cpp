@@ -0,0 +1,15 @@
+#include "table.hpp"
+
+#if defined(__AVX2__)
+#include "impl.hpp"
+#endif
+
+Serpent::Simd::QueryKernels const *Serpent::Simd::Avx2QueryKernels() {
+#if defined(__AVX2__)
+    static QueryKernels const kernels = MakeQueryKernels();
+
+    return &kernels;
+#else
+    return nullptr;
+#endif
+}
@@ -0,0 +1,8 @@
+#include "impl.hpp"
+#include "table.hpp"
+
+Serpent::Simd::QueryKernels const &Serpent::Simd::BaselineQueryKernels() {
+    static QueryKernels const kernels = MakeQueryKernels();
+
+    return kernels;
+}
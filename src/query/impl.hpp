@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+#include "../simd/scalar.hpp"
+#include "../simd/vec.hpp"
+#include "table.hpp"
+
+/// Kernel bodies shared by every ISA translation unit, see kernels/impl.hpp
+namespace {
+    using Serpent::CompareOp;
+
+    template <CompareOp Op, typename T>
+    bool Compare(T lhs, T rhs) {
+        if constexpr (Op == CompareOp::Less)
+            return lhs < rhs;
+        else if constexpr (Op == CompareOp::LessEqual)
+            return lhs <= rhs;
+        else if constexpr (Op == CompareOp::Greater)
+            return lhs > rhs;
+        else if constexpr (Op == CompareOp::GreaterEqual)
+            return lhs >= rhs;
+        else if constexpr (Op == CompareOp::Equal)
+            return lhs == rhs;
+        else
+            return lhs != rhs;
+    }
+
+    template <typename T, CompareOp Op>
+    void Filter(void const *data, size_t count, void const *constant, uint64_t *mask) {
+        auto values = static_cast<T const *>(data);
+        T value;
+        std::memcpy(&value, constant, sizeof(T));
+        size_t i = 0;
+
+        if constexpr (HasMask<uint8_t>) {
+            using V = Vec<uint8_t>;
+            // Lanes divides 64, so a chunk's bits never straddle two words
+            constexpr uint64_t Lanes = V::Lanes == 64 ? ~uint64_t(0) : (uint64_t(1) << V::Lanes) - 1;
+            alignas(32) uint8_t matches[V::Lanes];
+
+            for (; i + V::Lanes <= count; i += V::Lanes) {
+                // A fixed number of lanes compared into bytes, which the compiler turns into vector compares and packs,
+                // then a single movemask collapses them into bits
+                for (size_t j = 0; j < V::Lanes; j++)
+                    matches[j] = Compare<Op>(values[i + j], value) ? 0xFF : 0;
+
+                uint64_t fails = ~uint64_t(V::Mask(V::Load(matches))) & Lanes;
+                mask[i / 64] &= ~(fails << (i % 64));
+            }
+        }
+
+        for (; i < count; i++) {
+            if (!Compare<Op>(values[i], value))
+                mask[i / 64] &= ~(uint64_t(1) << (i % 64));
+        }
+    }
+
+    template <typename T, size_t... Ops>
+    void MakeFilters(Serpent::Simd::FilterKernel *filters, std::index_sequence<Ops...>) {
+        ((filters[Ops] = Filter<T, CompareOp(Ops)>), ...);
+    }
+
+    template <Serpent::Simd::ScalarKind Kind>
+    void MakeFilters(Serpent::Simd::QueryKernels &kernels) {
+        MakeFilters<Serpent::Simd::Scalar<Kind>>(kernels.filters[size_t(Kind)], std::make_index_sequence<Serpent::CompareOpCount>());
+    }
+
+    Serpent::Simd::QueryKernels MakeQueryKernels() {
+        using Serpent::Simd::ScalarKind;
+
+        Serpent::Simd::QueryKernels kernels {};
+        MakeFilters<ScalarKind::UInt8>(kernels);
+        MakeFilters<ScalarKind::Int8>(kernels);
+        MakeFilters<ScalarKind::UInt16>(kernels);
+        MakeFilters<ScalarKind::Int16>(kernels);
+        MakeFilters<ScalarKind::UInt32>(kernels);
+        MakeFilters<ScalarKind::Int32>(kernels);
+        MakeFilters<ScalarKind::UInt64>(kernels);
+        MakeFilters<ScalarKind::Int64>(kernels);
+        MakeFilters<ScalarKind::Float32>(kernels);
+        MakeFilters<ScalarKind::Float64>(kernels);
+        MakeFilters<ScalarKind::Bool>(kernels);
+
+        return kernels;
+    }
+}
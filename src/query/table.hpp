@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "serpent/query.hpp"
+#include "../simd/scalar.hpp"
+
+namespace Serpent::Simd {
+    /// Clears bit i of mask for each of the count values that doesn't compare true against value. Both are of the kernel's scalar type
+    using FilterKernel = void (*)(void const *values, size_t count, void const *value, uint64_t *mask);
+
+    struct QueryKernels final {
+        /// Indexed by ScalarKind, then CompareOp
+        FilterKernel filters[ScalarKindCount][CompareOpCount];
+    };
+
+    QueryKernels const &BaselineQueryKernels();
+    /// Returns nullptr if the library was built without AVX2 kernels
+    QueryKernels const *Avx2QueryKernels();
+}
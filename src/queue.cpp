@@ -0,0 +1,153 @@
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <optional>
+
+#include "serpent/layout.hpp"
+#include "serpent/queue.hpp"
+#include "binary.hpp"
+
+namespace {
+    constexpr size_t CacheLine = 64;
+}
+
+struct Serpent::RecordQueueState final {
+    Rc<GcLayout const> layout;
+    size_t size;
+    size_t stride;
+    /// Capacity - 1, capacity being a power of two
+    size_t mask;
+
+    /// Each slot's sequence number. A slot is free for the producer claiming `position` when it equals position,
+    /// and published for the consumer when it equals position + 1
+    std::unique_ptr<std::atomic_uint64_t[]> sequences;
+    std::byte *records;
+
+    /// Next position to claim, on its own line since every producer hits it
+    alignas(CacheLine) std::atomic_uint64_t tail = 0;
+    /// Next position to drain, only touched by the consumer
+    alignas(CacheLine) uint64_t head = 0;
+
+    RecordQueueState(Rc<GcLayout const> const &layout, size_t size, size_t stride, size_t capacity) :
+        layout(layout),
+        size(size),
+        stride(stride),
+        mask(capacity - 1),
+        sequences(std::make_unique<std::atomic_uint64_t[]>(capacity)),
+        records(static_cast<std::byte *>(::operator new(stride * capacity, std::align_val_t(CacheLine))))
+    {
+        for (size_t i = 0; i < capacity; i++)
+            sequences[i].store(i, std::memory_order_relaxed);
+    }
+
+    ~RecordQueueState() {
+        ::operator delete(records, std::align_val_t(CacheLine));
+    }
+
+    std::optional<RecordQueue::Slot> Claim() {
+        uint64_t position = tail.load(std::memory_order_relaxed);
+        while (true) {
+            uint64_t sequence = sequences[position & mask].load(std::memory_order_acquire);
+            auto distance = int64_t(sequence - position);
+
+            if (distance == 0) {
+                if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    break;
+            } else if (distance < 0) {
+                // The consumer hasn't freed the slot from the previous lap yet
+                return std::nullopt;
+            } else {
+                position = tail.load(std::memory_order_relaxed);
+            }
+        }
+
+        // Queued layouts hold no references, so every field defaults to zero
+        void *data = records + (position & mask) * stride;
+        std::memset(data, 0, size);
+
+        return RecordQueue::Slot {data, position};
+    }
+
+    void Publish(RecordQueue::Slot const &slot) {
+        sequences[slot.position & mask].store(slot.position + 1, std::memory_order_release);
+    }
+
+    size_t Drain(size_t max, void *context, void (*func)(void *, std::byte const *, size_t)) {
+        size_t drained = 0;
+
+        while (drained < max) {
+            // A run of published records, stopping at the end of the ring so it stays contiguous
+            size_t first = head & mask;
+            size_t limit = std::min(max - drained, mask + 1 - first);
+            size_t count = 0;
+            while (count < limit && sequences[first + count].load(std::memory_order_acquire) == head + count + 1)
+                count++;
+
+            if (count == 0)
+                break;
+
+            func(context, records + first * stride, count);
+
+            for (size_t i = 0; i < count; i++)
+                sequences[first + i].store(head + i + mask + 1, std::memory_order_release);
+
+            head += count;
+            drained += count;
+        }
+
+        return drained;
+    }
+};
+
+Serpent::RecordQueue::RecordQueue(std::unique_ptr<RecordQueueState> state) :
+    state(std::move(state))
+{}
+
+Serpent::RecordQueue::RecordQueue(RecordQueue &&move) = default;
+
+Serpent::RecordQueue::~RecordQueue() = default;
+
+Serpent::RecordQueue &Serpent::RecordQueue::operator = (RecordQueue &&move) = default;
+
+std::optional<Serpent::RecordQueue> Serpent::RecordQueue::Of(Rc<GcLayout const> const &layout, size_t capacity) {
+    if (capacity == 0 || capacity > (SIZE_MAX >> 1) + 1 || Binary::PlanOf(layout).references)
+        return std::nullopt;
+
+    auto [size, align] = std::visit([](auto const &layout) { return std::pair {layout.Size(), layout.Align()}; }, *layout);
+    size_t stride = std::max((size + align - 1) & ~(align - 1), size_t(1));
+
+    capacity = std::bit_ceil(capacity);
+    if (capacity > SIZE_MAX / stride)
+        return std::nullopt;
+
+    return RecordQueue(std::make_unique<RecordQueueState>(layout, size, stride, capacity));
+}
+
+Serpent::Rc<Serpent::GcLayout const> const &Serpent::RecordQueue::Layout() const {
+    return state->layout;
+}
+
+size_t Serpent::RecordQueue::Capacity() const {
+    return state->mask + 1;
+}
+
+size_t Serpent::RecordQueue::Stride() const {
+    return state->stride;
+}
+
+std::optional<Serpent::RecordQueue::Slot> Serpent::RecordQueue::Claim() {
+    return state->Claim();
+}
+
+void Serpent::RecordQueue::Publish(Slot const &slot) {
+    state->Publish(slot);
+}
+
+size_t Serpent::RecordQueue::Drain(size_t max, void *context, void (*func)(void *, std::byte const *, size_t)) {
+    return state->Drain(max, context, func);
+}
@@ -0,0 +1,110 @@
+#include <atomic>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "serpent/refcount.hpp"
+#include "gc.hpp"
+
+struct Serpent::RefOwner final {
+    std::mutex mutex {};
+    std::vector<GcHeader *> queue {};
+    std::atomic_bool pending = false;
+    /// Cleared when the thread exits, after which other threads merge its values themselves
+    bool alive = true;
+};
+
+namespace {
+    using namespace Serpent;
+
+    void Destroy(GcHeader *header) {
+        if (header->flags.load(std::memory_order_relaxed) & GcHeader::Array)
+            Serpent::Destroy(reinterpret_cast<ArrayValue *>(header));
+        else
+            Serpent::Destroy(reinterpret_cast<GcValue *>(header));
+    }
+
+    /// Folds the owner's count into the shared count. Must run on the owning thread, or after it exited.
+    /// Returns true if the value is now unreferenced
+    bool Merge(GcHeader *header) {
+        if (!(header->shared.load() & GcHeader::Merged)) {
+            size_t biased = std::exchange(header->biased, 0);
+            header->owner.store(nullptr, std::memory_order_relaxed);
+            header->shared.fetch_add(intptr_t(biased) * GcHeader::SharedOne + GcHeader::Merged, std::memory_order_acq_rel);
+        }
+
+        intptr_t old = header->shared.fetch_and(~intptr_t(GcHeader::Queued), std::memory_order_acq_rel);
+
+        return (old >> 2) == 0;
+    }
+
+    void MergeAll(std::vector<GcHeader *> const &queue) {
+        for (auto header : queue) {
+            if (Merge(header))
+                Destroy(header);
+        }
+    }
+
+    std::vector<GcHeader *> Take(RefOwner &owner) {
+        std::vector<GcHeader *> queue {};
+
+        std::unique_lock<std::mutex> lock {owner.mutex};
+        std::swap(queue, owner.queue);
+        owner.pending.store(false, std::memory_order_relaxed);
+
+        return queue;
+    }
+
+    struct LocalRecord final {
+        /// Never freed, values outlive the thread that owned them
+        RefOwner *owner = new RefOwner();
+
+        LocalRecord() {
+            localOwner = owner;
+        }
+
+        ~LocalRecord() {
+            std::vector<GcHeader *> queue {};
+            {
+                std::unique_lock<std::mutex> lock {owner->mutex};
+                owner->alive = false;
+                std::swap(queue, owner->queue);
+            }
+
+            MergeAll(queue);
+
+            localOwner = nullptr;
+        }
+    };
+}
+
+Serpent::RefOwner *Serpent::LocalOwner() {
+    thread_local LocalRecord record {};
+
+    if (record.owner->pending.load(std::memory_order_relaxed))
+        MergeAll(Take(*record.owner));
+
+    return record.owner;
+}
+
+bool Serpent::QueueMerge(RefOwner *owner, GcHeader *header) {
+    {
+        std::unique_lock<std::mutex> lock {owner->mutex};
+        if (owner->alive) {
+            owner->queue.push_back(header);
+            owner->pending.store(true, std::memory_order_relaxed);
+
+            return false;
+        }
+    }
+
+    // Nothing else can touch the biased count once the owner is gone, and only one thread gets to queue a value
+    return Merge(header);
+}
+
+void Serpent::MergeReleased() {
+    if (!localOwner)
+        return;
+
+    MergeAll(Take(*localOwner));
+}
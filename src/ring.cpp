@@ -0,0 +1,481 @@
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "serpent/ring.hpp"
+#include "serpent/schema.hpp"
+#include "image.hpp"
+
+namespace {
+    using namespace Serpent;
+
+    constexpr size_t CacheLine = 64;
+    constexpr size_t RecordAlign = 8;
+    /// "SERPRING" read as a little endian uint64
+    constexpr uint64_t Magic = 0x474e495250524553;
+    constexpr uint32_t Version = 1;
+    /// Written in place of a record's size when the record didn't fit before the end of the ring, and continues at its start
+    constexpr uint64_t Wrap = UINT64_MAX;
+
+    static_assert(std::atomic_uint64_t::is_always_lock_free, "positions are shared between processes, so they must be lock-free");
+
+    /// Start of the segment, followed by the string table and then the ring.
+    /// Positions count bytes since the segment was created, and only ever grow
+    struct Header final {
+        /// Written last, so a segment that's still being created doesn't open
+        std::atomic_uint64_t magic;
+        uint32_t version;
+        uint8_t littleEndian;
+        uint8_t wordSize;
+        uint64_t fingerprint;
+        uint64_t capacity;
+        uint64_t stringCapacity;
+
+        /// End of the last published record, only written by the producer
+        alignas(CacheLine) std::atomic_uint64_t tail;
+        /// Start of the oldest record, only written by the consumer
+        alignas(CacheLine) std::atomic_uint64_t head;
+        /// Bytes of the string table in use, only written by the producer
+        alignas(CacheLine) std::atomic_uint64_t strings;
+    };
+
+    size_t AlignUp(size_t offset, size_t align) {
+        return (offset + align - 1) & ~(align - 1);
+    }
+
+    struct Mapping final {
+        std::byte *data;
+        size_t size;
+        /// Platform handle kept open alongside the mapping, if the platform needs one
+        void *handle;
+    };
+
+    std::string SegmentName(std::string_view name) {
+#if defined(_WIN32)
+        return std::string(name);
+#else
+        std::string path(1, '/');
+        path.append(name);
+
+        return path;
+#endif
+    }
+
+    std::optional<Mapping> CreateSegment(std::string_view name, size_t size) {
+        auto path = SegmentName(name);
+
+#if defined(_WIN32)
+        HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, DWORD(uint64_t(size) >> 32), DWORD(size), path.c_str());
+        if (!mapping)
+            return std::nullopt;
+
+        if (GetLastError() == ERROR_ALREADY_EXISTS) {
+            CloseHandle(mapping);
+            return std::nullopt;
+        }
+
+        void *data = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+        if (!data) {
+            CloseHandle(mapping);
+            return std::nullopt;
+        }
+
+        return Mapping {static_cast<std::byte *>(data), size, mapping};
+#else
+        int file = shm_open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (file < 0)
+            return std::nullopt;
+
+        if (ftruncate(file, off_t(size)) != 0) {
+            close(file);
+            shm_unlink(path.c_str());
+            return std::nullopt;
+        }
+
+        void *data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+        close(file);
+        if (data == MAP_FAILED) {
+            shm_unlink(path.c_str());
+            return std::nullopt;
+        }
+
+        return Mapping {static_cast<std::byte *>(data), size, nullptr};
+#endif
+    }
+
+    std::optional<Mapping> OpenSegment(std::string_view name) {
+        auto path = SegmentName(name);
+
+#if defined(_WIN32)
+        HANDLE mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, path.c_str());
+        if (!mapping)
+            return std::nullopt;
+
+        void *data = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+        MEMORY_BASIC_INFORMATION info;
+        if (!data || VirtualQuery(data, &info, sizeof(info)) == 0) {
+            if (data)
+                UnmapViewOfFile(data);
+
+            CloseHandle(mapping);
+            return std::nullopt;
+        }
+
+        return Mapping {static_cast<std::byte *>(data), size_t(info.RegionSize), mapping};
+#else
+        int file = shm_open(path.c_str(), O_RDWR, 0);
+        if (file < 0)
+            return std::nullopt;
+
+        struct stat info;
+        if (fstat(file, &info) != 0 || info.st_size <= 0) {
+            close(file);
+            return std::nullopt;
+        }
+
+        void *data = mmap(nullptr, size_t(info.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+        close(file);
+        if (data == MAP_FAILED)
+            return std::nullopt;
+
+        return Mapping {static_cast<std::byte *>(data), size_t(info.st_size), nullptr};
+#endif
+    }
+
+    void CloseSegment(Mapping const &mapping) {
+#if defined(_WIN32)
+        UnmapViewOfFile(mapping.data);
+        CloseHandle(mapping.handle);
+#else
+        munmap(mapping.data, mapping.size);
+#endif
+    }
+
+    /// Sets the calling thread's image string table for as long as it lives
+    struct StringScope final {
+        Images::StringTable const *previous;
+
+        StringScope(Images::StringTable const &table) :
+            previous(Images::localStrings)
+        {
+            Images::localStrings = &table;
+        }
+
+        ~StringScope() {
+            Images::localStrings = previous;
+        }
+    };
+}
+
+struct Serpent::SharedRingState final {
+    /// The oldest record, as found by Peek
+    struct Record final {
+        size_t offset;
+        size_t size;
+        /// Head once the record is popped
+        uint64_t next;
+    };
+
+    Rc<GcLayout const> layout;
+    Mapping mapping;
+    Header *header;
+    std::byte *strings;
+    std::byte *ring;
+    size_t capacity;
+    size_t stringCapacity;
+    Images::StringTable table;
+
+    /// Producer side: table ids of the strings this process added, holding a reference so the interned index isn't reused
+    std::unordered_map<size_t, std::pair<InternedString, uint64_t>> ids {};
+    /// Producer side: each record's image is written here before it's copied into the ring
+    std::vector<std::byte> scratch {};
+
+    /// Consumer side: the interned string for each table id translated so far
+    std::unordered_map<uint64_t, InternedString> translated {};
+    bool corrupt = false;
+
+    SharedRingState(Rc<GcLayout const> const &layout, Mapping const &mapping, Header *header) :
+        layout(layout),
+        mapping(mapping),
+        header(header),
+        strings(mapping.data + sizeof(Header)),
+        ring(strings + header->stringCapacity),
+        capacity(size_t(header->capacity)),
+        stringCapacity(size_t(header->stringCapacity)),
+        table {
+            .context = this,
+            .add = [](void *context, size_t index) { return static_cast<SharedRingState *>(context)->Add(index); },
+            .get = [](void const *context, uint64_t id) { return static_cast<SharedRingState const *>(context)->String(id); },
+        }
+    {}
+
+    ~SharedRingState() {
+        CloseSegment(mapping);
+    }
+
+    std::optional<uint64_t> Add(size_t index) {
+        auto found = ids.find(index);
+        if (found != ids.end())
+            return found->second.second;
+
+        auto view = Interner::Instance().Get(index);
+        uint64_t used = header->strings.load(std::memory_order_relaxed);
+        size_t needed = sizeof(uint64_t) + AlignUp(view.size(), RecordAlign);
+        if (used > stringCapacity || needed > stringCapacity - used)
+            return std::nullopt;
+
+        uint64_t size = view.size();
+        std::memcpy(strings + used, &size, sizeof(uint64_t));
+        std::memcpy(strings + used + sizeof(uint64_t), view.data(), view.size());
+        header->strings.store(used + needed, std::memory_order_release);
+
+        ids.emplace(index, std::pair {InternedString::FromIndex(index), used});
+
+        return used;
+    }
+
+    std::optional<std::string_view> String(uint64_t id) const {
+        uint64_t used = std::min<uint64_t>(header->strings.load(std::memory_order_acquire), stringCapacity);
+        if (id % RecordAlign != 0 || id > used || used - id < sizeof(uint64_t))
+            return std::nullopt;
+
+        uint64_t size;
+        std::memcpy(&size, strings + id, sizeof(uint64_t));
+        if (size > used - id - sizeof(uint64_t))
+            return std::nullopt;
+
+        return std::string_view(reinterpret_cast<char const *>(strings + id + sizeof(uint64_t)), size_t(size));
+    }
+
+    bool Push(GcHandle const &value) {
+        if (!(*value.Layout() == *layout))
+            return false;
+
+        {
+            StringScope scope {table};
+            Images::WriteImage(value, scratch);
+        }
+
+        uint64_t size = scratch.size();
+        size_t needed = sizeof(uint64_t) + AlignUp(scratch.size(), RecordAlign);
+
+        uint64_t tail = header->tail.load(std::memory_order_relaxed);
+        uint64_t head = header->head.load(std::memory_order_acquire);
+        if (tail - head > capacity)
+            return false;
+
+        // Records never straddle the end of the ring, so the consumer can read them in place
+        size_t offset = tail % capacity;
+        size_t skip = needed > capacity - offset ? capacity - offset : 0;
+        if (needed > capacity || skip + needed > capacity - (tail - head))
+            return false;
+
+        if (skip != 0) {
+            std::memcpy(ring + offset, &Wrap, sizeof(uint64_t));
+            offset = 0;
+        }
+
+        std::memcpy(ring + offset, &size, sizeof(uint64_t));
+        std::memcpy(ring + offset + sizeof(uint64_t), scratch.data(), scratch.size());
+        header->tail.store(tail + skip + needed, std::memory_order_release);
+
+        return true;
+    }
+
+    /// Finds the oldest record, popping a wrap marker in front of it
+    std::optional<Record> Peek() {
+        if (corrupt)
+            return std::nullopt;
+
+        uint64_t tail = header->tail.load(std::memory_order_acquire);
+        uint64_t head = header->head.load(std::memory_order_relaxed);
+
+        while (head != tail) {
+            uint64_t available = tail - head;
+            size_t offset = head % capacity;
+            if (available > capacity || available % RecordAlign != 0 || head % RecordAlign != 0) {
+                corrupt = true;
+                return std::nullopt;
+            }
+
+            uint64_t size;
+            std::memcpy(&size, ring + offset, sizeof(uint64_t));
+
+            if (size == Wrap) {
+                if (capacity - offset > available) {
+                    corrupt = true;
+                    return std::nullopt;
+                }
+
+                head += capacity - offset;
+                header->head.store(head, std::memory_order_release);
+                continue;
+            }
+
+            if (size > capacity - offset - sizeof(uint64_t) || sizeof(uint64_t) + AlignUp(size_t(size), RecordAlign) > available) {
+                corrupt = true;
+                return std::nullopt;
+            }
+
+            return Record {offset + sizeof(uint64_t), size_t(size), head + sizeof(uint64_t) + AlignUp(size_t(size), RecordAlign)};
+        }
+
+        return std::nullopt;
+    }
+
+    std::optional<Image> Front() {
+        auto record = Peek();
+        if (!record)
+            return std::nullopt;
+
+        StringScope scope {table};
+        auto image = Image::Open(std::span<std::byte const>(ring + record->offset, record->size), layout);
+        if (!image)
+            corrupt = true;
+
+        return image;
+    }
+
+    void Pop() {
+        if (auto record = Peek())
+            header->head.store(record->next, std::memory_order_release);
+    }
+
+    InternedString Intern(std::string_view view) {
+        auto address = reinterpret_cast<uintptr_t>(view.data());
+        auto begin = reinterpret_cast<uintptr_t>(strings) + sizeof(uint64_t);
+
+        // Only whole strings from the table are remembered, anything else is interned as is
+        if (address >= begin && address - begin < stringCapacity && (address - begin) % RecordAlign == 0) {
+            uint64_t id = address - begin;
+            auto string = String(id);
+            if (string && string->data() == view.data() && string->size() == view.size()) {
+                auto found = translated.find(id);
+                if (found != translated.end())
+                    return found->second;
+
+                return translated.emplace(id, InternedString(view)).first->second;
+            }
+        }
+
+        return InternedString(view);
+    }
+};
+
+Serpent::SharedRing::SharedRing(std::unique_ptr<SharedRingState> state) :
+    state(std::move(state))
+{}
+
+Serpent::SharedRing::SharedRing(SharedRing &&move) = default;
+
+Serpent::SharedRing::~SharedRing() = default;
+
+Serpent::SharedRing &Serpent::SharedRing::operator = (SharedRing &&move) = default;
+
+std::optional<Serpent::SharedRing> Serpent::SharedRing::Create(
+    std::string_view name,
+    Rc<GcLayout const> const &layout,
+    size_t capacity,
+    size_t stringCapacity
+) {
+    if (capacity == 0 || capacity > SIZE_MAX / 4 || stringCapacity > SIZE_MAX / 4)
+        return std::nullopt;
+
+    capacity = AlignUp(capacity, RecordAlign);
+    stringCapacity = AlignUp(stringCapacity, RecordAlign);
+
+    auto mapping = CreateSegment(name, sizeof(Header) + stringCapacity + capacity);
+    if (!mapping)
+        return std::nullopt;
+
+    auto header = new (mapping->data) Header {};
+    header->version = Version;
+    header->littleEndian = std::endian::native == std::endian::little;
+    header->wordSize = sizeof(size_t);
+    header->fingerprint = Fingerprint(layout);
+    header->capacity = capacity;
+    header->stringCapacity = stringCapacity;
+    header->magic.store(Magic, std::memory_order_release);
+
+    return SharedRing(std::make_unique<SharedRingState>(layout, *mapping, header));
+}
+
+std::optional<Serpent::SharedRing> Serpent::SharedRing::Open(std::string_view name, Rc<GcLayout const> const &layout) {
+    auto mapping = OpenSegment(name);
+    if (!mapping)
+        return std::nullopt;
+
+    auto header = reinterpret_cast<Header *>(mapping->data);
+    bool compatible = mapping->size >= sizeof(Header) && header->magic.load(std::memory_order_acquire) == Magic && header->version == Version &&
+        header->littleEndian == (std::endian::native == std::endian::little) && header->wordSize == sizeof(size_t) &&
+        header->fingerprint == Fingerprint(layout) &&
+        header->capacity != 0 && header->capacity % RecordAlign == 0 && header->stringCapacity % RecordAlign == 0 &&
+        header->capacity <= mapping->size && header->stringCapacity <= mapping->size - header->capacity &&
+        sizeof(Header) <= mapping->size - header->capacity - header->stringCapacity;
+
+    if (!compatible) {
+        CloseSegment(*mapping);
+        return std::nullopt;
+    }
+
+    return SharedRing(std::make_unique<SharedRingState>(layout, *mapping, header));
+}
+
+bool Serpent::SharedRing::Unlink(std::string_view name) {
+#if defined(_WIN32)
+    return true;
+#else
+    return shm_unlink(SegmentName(name).c_str()) == 0;
+#endif
+}
+
+Serpent::Rc<Serpent::GcLayout const> const &Serpent::SharedRing::Layout() const {
+    return state->layout;
+}
+
+size_t Serpent::SharedRing::Capacity() const {
+    return state->capacity;
+}
+
+bool Serpent::SharedRing::Push(GcHandle const &value) {
+    return state->Push(value);
+}
+
+std::optional<Serpent::Image> Serpent::SharedRing::Front() {
+    return state->Front();
+}
+
+void Serpent::SharedRing::Pop() {
+    state->Pop();
+}
+
+bool Serpent::SharedRing::IsCorrupt() const {
+    return state->corrupt;
+}
+
+Serpent::InternedString Serpent::SharedRing::Intern(std::string_view view) {
+    return state->Intern(view);
+}
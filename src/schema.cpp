@@ -0,0 +1,685 @@
+#include <algorithm>
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "serpent/binary.hpp"
+#include "serpent/schema.hpp"
+#include "serpent/types/interner.hpp"
+#include "binary.hpp"
+#include "plan_cache.hpp"
+
+namespace {
+    using namespace Serpent;
+
+    enum struct LayoutKind : uint8_t {
+        Integral,
+        Floating,
+        Primitive,
+        Array,
+        Enum,
+        Object,
+        Tuple,
+        Variant,
+    };
+
+    enum struct RecordKind : uint8_t {
+        Value,
+        Definition,
+    };
+
+    /// Deepest nesting DecodeLayout accepts, so a hostile definition can't run the decoder out of stack
+    constexpr size_t MaxDepth = 64;
+
+    /// String markers, anything from Referenced up is a dictionary index plus Referenced
+    constexpr uint32_t Inline = 0;
+    constexpr uint32_t Added = 1;
+    constexpr uint32_t Referenced = 2;
+
+    template <std::unsigned_integral T>
+    void StoreInt(std::byte *target, T value) {
+        for (size_t i = 0; i < sizeof(T); i++)
+            target[i] = std::byte(uint8_t(uint64_t(value) >> (i * 8)));
+    }
+
+    template <std::unsigned_integral T>
+    T LoadInt(std::byte const *source) {
+        T value = 0;
+        for (size_t i = 0; i < sizeof(T); i++)
+            value |= T(T(uint8_t(source[i])) << (i * 8));
+
+        return value;
+    }
+
+    template <std::unsigned_integral T>
+    void PutInt(std::vector<std::byte> &out, T value) {
+        size_t start = out.size();
+        out.resize(start + sizeof(T));
+        StoreInt(out.data() + start, value);
+    }
+
+    void PutName(std::vector<std::byte> &out, std::string_view name) {
+        PutInt(out, uint32_t(name.size()));
+        auto bytes = reinterpret_cast<std::byte const *>(name.data());
+        out.insert(out.end(), bytes, bytes + name.size());
+    }
+
+    void Define(ValueLayout const &layout, std::vector<std::byte> &out);
+
+    void Define(GcLayout const &layout, std::vector<std::byte> &out) {
+        std::visit(
+            [&out](auto const &layout) {
+                using T = std::decay_t<decltype(layout)>;
+                if constexpr (std::same_as<T, ObjectLayout>) {
+                    PutInt(out, uint8_t(LayoutKind::Object));
+                    PutInt(out, uint8_t(layout.Rules()));
+                    PutInt(out, uint32_t(layout.Fields().size()));
+                    for (auto const &field : layout.Fields()) {
+                        PutName(out, field.layout.Name());
+                        PutInt(out, field.layout.Vector());
+                        Define(field.layout.Layout(), out);
+                    }
+                } else if constexpr (std::same_as<T, TupleLayout>) {
+                    PutInt(out, uint8_t(LayoutKind::Tuple));
+                    PutInt(out, uint8_t(layout.Rules()));
+                    PutInt(out, uint32_t(layout.Fields().size()));
+                    for (auto const &field : layout.Fields())
+                        Define(field.layout, out);
+                } else {
+                    PutInt(out, uint8_t(LayoutKind::Variant));
+                    PutInt(out, uint8_t(layout.VariantFieldName().has_value()));
+                    if (auto const &field = layout.VariantFieldName())
+                        PutName(out, field->Value());
+
+                    PutInt(out, uint32_t(layout.Variants().size()));
+                    for (auto const &variant : layout.Variants()) {
+                        PutName(out, variant.Name());
+                        Define(variant.Layout(), out);
+                    }
+                }
+            },
+            layout
+        );
+    }
+
+    void Define(ValueLayout const &layout, std::vector<std::byte> &out) {
+        std::visit(
+            [&out](auto const &layout) {
+                using T = std::decay_t<decltype(layout)>;
+                if constexpr (std::same_as<T, IntegralLayout>) {
+                    PutInt(out, uint8_t(LayoutKind::Integral));
+                    PutInt(out, uint8_t(layout));
+                } else if constexpr (std::same_as<T, FloatingLayout>) {
+                    PutInt(out, uint8_t(LayoutKind::Floating));
+                    PutInt(out, uint8_t(layout));
+                } else if constexpr (std::same_as<T, PrimitiveLayout>) {
+                    PutInt(out, uint8_t(LayoutKind::Primitive));
+                    PutInt(out, uint8_t(layout));
+                } else if constexpr (std::same_as<T, ArrayLayout>) {
+                    PutInt(out, uint8_t(LayoutKind::Array));
+                    Define(layout.Layout(), out);
+                } else if constexpr (std::same_as<T, Rc<EnumLayout const>>) {
+                    PutInt(out, uint8_t(LayoutKind::Enum));
+                    PutInt(out, uint8_t(layout->Backing()));
+                    PutInt(out, uint32_t(layout->Names().size()));
+                    for (auto const &name : layout->Names())
+                        PutName(out, name.Value());
+                } else {
+                    Define(*layout, out);
+                }
+            },
+            layout
+        );
+    }
+
+    uint64_t Fnv1a(std::span<std::byte const> bytes) {
+        uint64_t hash = 0xCBF29CE484222325ull;
+        for (auto byte : bytes) {
+            hash ^= uint8_t(byte);
+            hash *= 0x100000001B3ull;
+        }
+
+        return hash;
+    }
+
+    /// A layout's definition and fingerprint, worked out once per layout
+    struct Schema final {
+        std::vector<std::byte> definition {};
+        uint64_t fingerprint = 0;
+
+        static Schema Compile(GcLayout const &layout) {
+            Schema schema {};
+            Define(layout, schema.definition);
+            schema.fingerprint = Fnv1a(schema.definition);
+
+            return schema;
+        }
+    };
+
+    Schema const &SchemaOf(Rc<GcLayout const> const &layout) {
+        return PlanCache<Schema>::Instance().Of(layout);
+    }
+
+    struct Reader final {
+        std::byte const *cursor;
+        std::byte const *end;
+
+        size_t Remaining() const {
+            return size_t(end - cursor);
+        }
+
+        template <std::unsigned_integral T>
+        bool ReadInt(T &value) {
+            if (Remaining() < sizeof(T))
+                return false;
+
+            value = LoadInt<T>(cursor);
+            cursor += sizeof(T);
+
+            return true;
+        }
+
+        std::optional<std::string_view> ReadName() {
+            uint32_t size = 0;
+            if (!ReadInt(size) || Remaining() < size)
+                return std::nullopt;
+
+            std::string_view name {reinterpret_cast<char const *>(cursor), size};
+            cursor += size;
+
+            return name;
+        }
+
+        /// Reads an entry count, rejecting counts the rest of the input can't hold before anything is reserved for them
+        std::optional<uint32_t> ReadCount() {
+            uint32_t count = 0;
+            if (!ReadInt(count) || count > Remaining())
+                return std::nullopt;
+
+            return count;
+        }
+    };
+
+    std::optional<ValueLayout> ReadLayout(Reader &reader, size_t depth);
+
+    /// Object fields carry a vector count, variants don't
+    std::optional<std::vector<NamedLayout>> ReadNamed(Reader &reader, size_t depth, bool vectors) {
+        auto count = reader.ReadCount();
+        if (!count)
+            return std::nullopt;
+
+        std::vector<NamedLayout> fields {};
+        fields.reserve(*count);
+
+        for (uint32_t i = 0; i < *count; i++) {
+            auto name = reader.ReadName();
+            if (!name)
+                return std::nullopt;
+
+            uint8_t vector = 1;
+            if (vectors && !reader.ReadInt(vector))
+                return std::nullopt;
+
+            auto layout = ReadLayout(reader, depth + 1);
+            if (!layout)
+                return std::nullopt;
+
+            fields.emplace_back(*name, std::move(*layout), vector);
+        }
+
+        return fields;
+    }
+
+    std::optional<LayoutRules> ReadRules(Reader &reader) {
+        uint8_t rules = 0;
+        if (!reader.ReadInt(rules) || rules > uint8_t(LayoutRules::Scalar))
+            return std::nullopt;
+
+        return LayoutRules(rules);
+    }
+
+    std::optional<Rc<GcLayout const>> ReadGcLayout(Reader &reader, LayoutKind kind, size_t depth) {
+        switch (kind) {
+            case LayoutKind::Object: {
+                auto rules = ReadRules(reader);
+                if (!rules)
+                    return std::nullopt;
+
+                auto fields = ReadNamed(reader, depth, true);
+                if (!fields)
+                    return std::nullopt;
+
+                return ObjectLayout::Of(std::span<NamedLayout const>(*fields), *rules);
+            }
+            case LayoutKind::Tuple: {
+                auto rules = ReadRules(reader);
+                if (!rules)
+                    return std::nullopt;
+
+                auto count = reader.ReadCount();
+                if (!count)
+                    return std::nullopt;
+
+                std::vector<ValueLayout> fields {};
+                fields.reserve(*count);
+
+                for (uint32_t i = 0; i < *count; i++) {
+                    auto layout = ReadLayout(reader, depth + 1);
+                    if (!layout)
+                        return std::nullopt;
+
+                    fields.push_back(std::move(*layout));
+                }
+
+                return TupleLayout::Of(std::span<ValueLayout const>(fields), *rules);
+            }
+            case LayoutKind::Variant: {
+                uint8_t named = 0;
+                if (!reader.ReadInt(named) || named > 1)
+                    return std::nullopt;
+
+                std::optional<std::string_view> fieldName {};
+                if (named && !(fieldName = reader.ReadName()))
+                    return std::nullopt;
+
+                auto variants = ReadNamed(reader, depth, false);
+                // A variant needs at least one case to be initialized with
+                if (!variants || variants->empty())
+                    return std::nullopt;
+
+                return VariantLayout::Of(std::span<NamedLayout const>(*variants), fieldName);
+            }
+            default:
+                return std::nullopt;
+        }
+    }
+
+    std::optional<ValueLayout> ReadLayout(Reader &reader, size_t depth) {
+        uint8_t kind = 0;
+        if (depth > MaxDepth || !reader.ReadInt(kind))
+            return std::nullopt;
+
+        switch (LayoutKind(kind)) {
+            case LayoutKind::Integral: {
+                uint8_t value = 0;
+                if (!reader.ReadInt(value) || value > uint8_t(IntegralLayout::Int64))
+                    return std::nullopt;
+
+                return IntegralLayout(value);
+            }
+            case LayoutKind::Floating: {
+                uint8_t value = 0;
+                if (!reader.ReadInt(value) || value > uint8_t(FloatingLayout::Float64))
+                    return std::nullopt;
+
+                return FloatingLayout(value);
+            }
+            case LayoutKind::Primitive: {
+                uint8_t value = 0;
+                if (!reader.ReadInt(value) || value > uint8_t(PrimitiveLayout::Unit))
+                    return std::nullopt;
+
+                return PrimitiveLayout(value);
+            }
+            case LayoutKind::Array: {
+                auto element = ReadLayout(reader, depth + 1);
+                if (!element)
+                    return std::nullopt;
+
+                return ArrayLayout::Of(std::move(*element));
+            }
+            case LayoutKind::Enum: {
+                uint8_t backing = 0;
+                if (!reader.ReadInt(backing) || backing > uint8_t(IntegralLayout::Int64))
+                    return std::nullopt;
+
+                auto count = reader.ReadCount();
+                if (!count)
+                    return std::nullopt;
+
+                std::vector<std::string_view> names {};
+                names.reserve(*count);
+
+                for (uint32_t i = 0; i < *count; i++) {
+                    auto name = reader.ReadName();
+                    if (!name)
+                        return std::nullopt;
+
+                    names.push_back(*name);
+                }
+
+                auto layout = EnumLayout::Of(std::span<std::string_view const>(names), IntegralLayout(backing));
+                if (!layout)
+                    return std::nullopt;
+
+                return *layout;
+            }
+            default: {
+                auto layout = ReadGcLayout(reader, LayoutKind(kind), depth);
+                if (!layout)
+                    return std::nullopt;
+
+                return *layout;
+            }
+        }
+    }
+
+    /// Points Encode and Decode at a string table for as long as it's alive
+    struct StringScope final {
+        Binary::StringTable const *previous;
+
+        StringScope(Binary::StringTable const &table) :
+            previous(Binary::localStrings)
+        {
+            Binary::localStrings = &table;
+        }
+
+        ~StringScope() {
+            Binary::localStrings = previous;
+        }
+    };
+}
+
+struct Serpent::SchemaRegistryState final {
+    mutable std::shared_mutex mutex {};
+    std::unordered_map<uint64_t, Rc<GcLayout const>> layouts {};
+};
+
+struct Serpent::WireEncoderState final {
+    struct Entry final {
+        /// Keeps the interned index from being reused for another string while the dictionary refers to it
+        InternedString string;
+        uint32_t index;
+        /// False between measuring and writing the message that adds the string
+        bool sent;
+    };
+
+    size_t capacity;
+    /// Dictionary entries by interned index
+    std::unordered_map<size_t, Entry> strings {};
+    /// Fingerprints whose definitions have been sent
+    std::unordered_set<uint64_t> defined {};
+
+    static size_t Measure(void *context, size_t index) {
+        auto &state = *static_cast<WireEncoderState *>(context);
+
+        if (state.strings.contains(index))
+            return sizeof(uint32_t);
+
+        // Added here so the string's later appearances in the same message are measured as references, Write sends it in full the first time
+        if (state.strings.size() < state.capacity)
+            state.strings.emplace(index, Entry {InternedString::FromIndex(index), uint32_t(state.strings.size()), false});
+
+        return 2 * sizeof(uint32_t) + Interner::Instance().Get(index).size();
+    }
+
+    static void Write(void *context, size_t index, std::byte *&cursor) {
+        auto &state = *static_cast<WireEncoderState *>(context);
+        uint32_t marker = Inline;
+
+        if (auto it = state.strings.find(index); it != state.strings.end()) {
+            if (it->second.sent) {
+                StoreInt(cursor, uint32_t(it->second.index + Referenced));
+                cursor += sizeof(uint32_t);
+                return;
+            }
+
+            it->second.sent = true;
+            marker = Added;
+        }
+
+        auto view = Interner::Instance().Get(index);
+        StoreInt(cursor, marker);
+        StoreInt(cursor + sizeof(uint32_t), uint32_t(view.size()));
+        cursor += 2 * sizeof(uint32_t);
+
+        std::memcpy(cursor, view.data(), view.size());
+        cursor += view.size();
+    }
+};
+
+struct Serpent::WireDecoderState final {
+    SchemaRegistry &registry;
+    size_t capacity;
+    /// Most definitions the connection may decode, see WireDecoder
+    size_t definitions;
+    /// Dictionary entries in the order the encoder added them
+    std::vector<InternedString> strings {};
+    /// Layouts already looked up in the registry, so most messages don't touch its lock
+    std::unordered_map<uint64_t, Rc<GcLayout const>> layouts {};
+    /// Definitions from the message being decoded, registered only once the whole message is valid
+    std::vector<std::pair<uint64_t, Rc<GcLayout const>>> pending {};
+    /// Definitions decoded so far, counting those from rejected messages
+    size_t decoded = 0;
+
+    static std::optional<size_t> Read(void *context, std::byte const *&cursor, std::byte const *end) {
+        auto &state = *static_cast<WireDecoderState *>(context);
+        auto &interner = Interner::Instance();
+
+        if (size_t(end - cursor) < sizeof(uint32_t))
+            return std::nullopt;
+
+        uint32_t marker = LoadInt<uint32_t>(cursor);
+        if (marker >= Referenced) {
+            if (marker - Referenced >= state.strings.size())
+                return std::nullopt;
+
+            cursor += sizeof(uint32_t);
+            return interner.AddRef(state.strings[marker - Referenced].Index());
+        }
+
+        if (size_t(end - cursor) < 2 * sizeof(uint32_t))
+            return std::nullopt;
+
+        uint32_t size = LoadInt<uint32_t>(cursor + sizeof(uint32_t));
+        if (size_t(end - cursor) - 2 * sizeof(uint32_t) < size || (marker == Added && state.strings.size() >= state.capacity))
+            return std::nullopt;
+
+        cursor += 2 * sizeof(uint32_t);
+        size_t index = interner.Acquire(std::string_view(reinterpret_cast<char const *>(cursor), size));
+        cursor += size;
+
+        if (marker == Added)
+            state.strings.push_back(InternedString::FromIndex(index));
+
+        return index;
+    }
+
+    /// Returns the layout for a fingerprint, from this connection, the message being decoded or the registry
+    std::optional<Rc<GcLayout const>> Find(uint64_t fingerprint) {
+        if (auto it = layouts.find(fingerprint); it != layouts.end())
+            return it->second;
+
+        for (auto const &[defined, layout] : pending) {
+            if (defined == fingerprint)
+                return layout;
+        }
+
+        auto layout = registry.Find(fingerprint);
+        if (layout)
+            layouts.emplace(fingerprint, *layout);
+
+        return layout;
+    }
+
+    /// Decodes a definition unless the fingerprint is already known, and holds it until Commit.
+    /// Returns false if it doesn't match the fingerprint, or if the connection already decoded as many definitions as it may
+    bool Define(uint64_t fingerprint, std::span<std::byte const> definition) {
+        if (Find(fingerprint))
+            return true;
+        if (decoded >= definitions || Fnv1a(definition) != fingerprint)
+            return false;
+
+        // Counted even if the message is rejected later, decoding a value compiles plans that keep the layout alive
+        decoded++;
+
+        auto layout = DecodeLayout(definition);
+        if (!layout || !definition.empty())
+            return false;
+
+        pending.emplace_back(fingerprint, *layout);
+        return true;
+    }
+
+    /// Registers the definitions of a message that decoded successfully, returns false if one collides with a different registered layout
+    bool Commit() {
+        for (auto const &[fingerprint, layout] : pending) {
+            auto registered = registry.Register(layout);
+            if (!registered)
+                return false;
+
+            layouts.emplace(fingerprint, *registered);
+        }
+
+        pending.clear();
+        return true;
+    }
+};
+
+size_t Serpent::EncodeLayout(Rc<GcLayout const> const &layout, std::vector<std::byte> &out) {
+    auto const &definition = SchemaOf(layout).definition;
+    out.insert(out.end(), definition.begin(), definition.end());
+
+    return definition.size();
+}
+
+std::optional<Serpent::Rc<Serpent::GcLayout const>> Serpent::DecodeLayout(std::span<std::byte const> &input) {
+    Reader reader {input.data(), input.data() + input.size()};
+
+    uint8_t kind = 0;
+    if (!reader.ReadInt(kind))
+        return std::nullopt;
+
+    auto layout = ReadGcLayout(reader, LayoutKind(kind), 0);
+    if (!layout)
+        return std::nullopt;
+
+    input = input.subspan(size_t(reader.cursor - input.data()));
+    return layout;
+}
+
+uint64_t Serpent::Fingerprint(Rc<GcLayout const> const &layout) {
+    return SchemaOf(layout).fingerprint;
+}
+
+Serpent::SchemaRegistry::SchemaRegistry() :
+    state(std::make_unique<SchemaRegistryState>())
+{}
+
+Serpent::SchemaRegistry::SchemaRegistry(SchemaRegistry &&move) = default;
+
+Serpent::SchemaRegistry::~SchemaRegistry() = default;
+
+Serpent::SchemaRegistry &Serpent::SchemaRegistry::operator = (SchemaRegistry &&move) = default;
+
+std::optional<Serpent::Rc<Serpent::GcLayout const>> Serpent::SchemaRegistry::Register(Rc<GcLayout const> const &layout) {
+    uint64_t fingerprint = Fingerprint(layout);
+
+    std::unique_lock<std::shared_mutex> lock {state->mutex};
+    auto [it, inserted] = state->layouts.try_emplace(fingerprint, layout);
+    if (!inserted && it->second != layout)
+        return std::nullopt;
+
+    return it->second;
+}
+
+std::optional<Serpent::Rc<Serpent::GcLayout const>> Serpent::SchemaRegistry::Find(uint64_t fingerprint) const {
+    std::shared_lock<std::shared_mutex> lock {state->mutex};
+    auto it = state->layouts.find(fingerprint);
+    if (it == state->layouts.end())
+        return std::nullopt;
+
+    return it->second;
+}
+
+Serpent::WireEncoder::WireEncoder(size_t capacity) :
+    state(std::make_unique<WireEncoderState>(std::min(capacity, size_t(std::numeric_limits<uint32_t>::max() - Referenced))))
+{}
+
+Serpent::WireEncoder::WireEncoder(WireEncoder &&move) = default;
+
+Serpent::WireEncoder::~WireEncoder() = default;
+
+Serpent::WireEncoder &Serpent::WireEncoder::operator = (WireEncoder &&move) = default;
+
+size_t Serpent::WireEncoder::Encode(GcHandle const &value, std::vector<std::byte> &out) {
+    auto const &schema = SchemaOf(value.Layout());
+    size_t start = out.size();
+
+    if (state->defined.insert(schema.fingerprint).second) {
+        PutInt(out, uint8_t(RecordKind::Definition));
+        PutInt(out, schema.fingerprint);
+        PutInt(out, uint32_t(schema.definition.size()));
+        out.insert(out.end(), schema.definition.begin(), schema.definition.end());
+    }
+
+    PutInt(out, uint8_t(RecordKind::Value));
+    PutInt(out, schema.fingerprint);
+
+    Binary::StringTable table {state.get(), WireEncoderState::Measure, WireEncoderState::Write, nullptr};
+    StringScope scope {table};
+    Serpent::Encode(value, out);
+
+    return out.size() - start;
+}
+
+Serpent::WireDecoder::WireDecoder(SchemaRegistry &registry, size_t capacity, size_t definitions) :
+    state(std::make_unique<WireDecoderState>(registry, std::min(capacity, size_t(std::numeric_limits<uint32_t>::max() - Referenced)), definitions))
+{}
+
+Serpent::WireDecoder::WireDecoder(WireDecoder &&move) = default;
+
+Serpent::WireDecoder::~WireDecoder() = default;
+
+Serpent::WireDecoder &Serpent::WireDecoder::operator = (WireDecoder &&move) = default;
+
+std::optional<Serpent::GcHandle> Serpent::WireDecoder::Decode(std::span<std::byte const> &input) {
+    Reader reader {input.data(), input.data() + input.size()};
+    size_t added = state->strings.size();
+    state->pending.clear();
+
+    while (true) {
+        uint8_t kind = 0;
+        uint64_t fingerprint = 0;
+        if (!reader.ReadInt(kind) || !reader.ReadInt(fingerprint))
+            break;
+
+        if (RecordKind(kind) == RecordKind::Definition) {
+            uint32_t size = 0;
+            if (!reader.ReadInt(size) || reader.Remaining() < size || !state->Define(fingerprint, {reader.cursor, size}))
+                break;
+
+            reader.cursor += size;
+            continue;
+        }
+
+        auto layout = RecordKind(kind) == RecordKind::Value ? state->Find(fingerprint) : std::nullopt;
+        if (!layout)
+            break;
+
+        std::span<std::byte const> rest {reader.cursor, reader.end};
+        Binary::StringTable table {state.get(), nullptr, nullptr, WireDecoderState::Read};
+        StringScope scope {table};
+
+        auto value = Serpent::Decode(*layout, rest);
+        if (!value || !state->Commit())
+            break;
+
+        input = rest;
+        return value;
+    }
+
+    state->strings.erase(state->strings.begin() + ptrdiff_t(added), state->strings.end());
+    state->pending.clear();
+    return std::nullopt;
+}
@@ -0,0 +1,41 @@
+#include "cpu.hpp"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+namespace {
+    Serpent::Simd::Isa DetectUncached() {
+#if defined(SERPENT_HAS_AVX2_KERNELS)
+    #if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7)
+            return Serpent::Simd::Isa::Baseline;
+
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+            return Serpent::Simd::Isa::Baseline;
+
+        __cpuidex(info, 7, 0);
+        if (info[1] & (1 << 5))
+            return Serpent::Simd::Isa::Avx2;
+    #else
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            return Serpent::Simd::Isa::Avx2;
+    #endif
+#endif
+
+        return Serpent::Simd::Isa::Baseline;
+    }
+}
+
+Serpent::Simd::Isa Serpent::Simd::Detect() {
+    static Isa const isa = DetectUncached();
+
+    return isa;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Serpent::Simd {
+    /// Instruction sets with their own kernel translation units, ordered from narrowest to widest.
+    /// Baseline is whatever the library itself is compiled for, SSE2 on x86-64 and scalar elsewhere.
+    enum struct Isa : uint8_t {
+        Baseline,
+        Avx2,
+    };
+
+    /// Detected once, on first use
+    Isa Detect();
+}
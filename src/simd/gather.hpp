@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+
+#include "scalar.hpp"
+
+/// Moves fields between objects scattered across the heap and packed runs the kernels can work on
+namespace Serpent::Simd {
+    template <size_t Size>
+    void Gather(std::byte const *const *sources, size_t count, size_t offset, std::byte *target) {
+        for (size_t i = 0; i < count; i++)
+            std::memcpy(target + i * Size, sources[i] + offset, Size);
+    }
+
+    /// Copies the field at offset out of each source into a packed run
+    inline void Gather(std::byte const *const *sources, size_t count, size_t offset, size_t size, std::byte *target) {
+        switch (size) {
+            case 1:
+                return Gather<1>(sources, count, offset, target);
+            case 2:
+                return Gather<2>(sources, count, offset, target);
+            case 4:
+                return Gather<4>(sources, count, offset, target);
+            default:
+                return Gather<8>(sources, count, offset, target);
+        }
+    }
+
+    template <size_t Size>
+    void Scatter(std::byte const *source, size_t count, std::byte *target, size_t stride) {
+        for (size_t i = 0; i < count; i++)
+            std::memcpy(target + i * stride, source + i * Size, Size);
+    }
+
+    /// Copies a packed run out to every stride bytes of target
+    inline void Scatter(std::byte const *source, size_t count, size_t size, std::byte *target, size_t stride) {
+        switch (size) {
+            case 1:
+                return Scatter<1>(source, count, target, stride);
+            case 2:
+                return Scatter<2>(source, count, target, stride);
+            case 4:
+                return Scatter<4>(source, count, target, stride);
+            default:
+                return Scatter<8>(source, count, target, stride);
+        }
+    }
+
+    inline size_t SizeOf(ScalarKind kind) {
+        switch (kind) {
+            case ScalarKind::UInt8:
+            case ScalarKind::Int8:
+            case ScalarKind::Bool:
+                return 1;
+            case ScalarKind::UInt16:
+            case ScalarKind::Int16:
+                return 2;
+            case ScalarKind::UInt32:
+            case ScalarKind::Int32:
+            case ScalarKind::Float32:
+                return 4;
+            default:
+                return 8;
+        }
+    }
+}
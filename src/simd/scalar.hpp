@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <variant>
+
+#include "serpent/layout.hpp"
+
+namespace Serpent::Simd {
+    /// The numeric element types kernels operate on, flattened out of IntegralLayout and FloatingLayout
+    enum struct ScalarKind : uint8_t {
+        UInt8,
+        Int8,
+        UInt16,
+        Int16,
+        UInt32,
+        Int32,
+        UInt64,
+        Int64,
+        Float32,
+        Float64,
+        Bool,
+    };
+
+    constexpr size_t ScalarKindCount = 11;
+
+    /// Storage type of each kind, Bool is stored as a uint8_t
+    template <ScalarKind Kind>
+    struct ScalarOf;
+
+    template <> struct ScalarOf<ScalarKind::UInt8> { using Type = uint8_t; };
+    template <> struct ScalarOf<ScalarKind::Int8> { using Type = int8_t; };
+    template <> struct ScalarOf<ScalarKind::UInt16> { using Type = uint16_t; };
+    template <> struct ScalarOf<ScalarKind::Int16> { using Type = int16_t; };
+    template <> struct ScalarOf<ScalarKind::UInt32> { using Type = uint32_t; };
+    template <> struct ScalarOf<ScalarKind::Int32> { using Type = int32_t; };
+    template <> struct ScalarOf<ScalarKind::UInt64> { using Type = uint64_t; };
+    template <> struct ScalarOf<ScalarKind::Int64> { using Type = int64_t; };
+    template <> struct ScalarOf<ScalarKind::Float32> { using Type = float; };
+    template <> struct ScalarOf<ScalarKind::Float64> { using Type = double; };
+    template <> struct ScalarOf<ScalarKind::Bool> { using Type = uint8_t; };
+
+    template <ScalarKind Kind>
+    using Scalar = typename ScalarOf<Kind>::Type;
+
+    /// Returns nullopt if the layout isn't IntegralLayout or FloatingLayout
+    inline std::optional<ScalarKind> KindOf(ValueLayout const &layout) {
+        if (auto integral = std::get_if<IntegralLayout>(&layout)) {
+            switch (*integral) {
+                case IntegralLayout::Bool:
+                    return ScalarKind::Bool;
+                case IntegralLayout::UInt8:
+                    return ScalarKind::UInt8;
+                case IntegralLayout::Int8:
+                    return ScalarKind::Int8;
+                case IntegralLayout::UInt16:
+                    return ScalarKind::UInt16;
+                case IntegralLayout::Int16:
+                    return ScalarKind::Int16;
+                case IntegralLayout::UInt32:
+                    return ScalarKind::UInt32;
+                case IntegralLayout::Int32:
+                    return ScalarKind::Int32;
+                case IntegralLayout::UInt64:
+                    return ScalarKind::UInt64;
+                case IntegralLayout::Int64:
+                    return ScalarKind::Int64;
+            }
+        } else if (auto floating = std::get_if<FloatingLayout>(&layout)) {
+            switch (*floating) {
+                case FloatingLayout::Float32:
+                    return ScalarKind::Float32;
+                case FloatingLayout::Float64:
+                    return ScalarKind::Float64;
+            }
+        }
+
+        return std::nullopt;
+    }
+
+    /// Calls `func` with a typed null pointer matching the element layout, or returns `fallback` if the element isn't numeric.
+    /// Bool is passed as uint8_t
+    template <typename TResult, typename TFunc>
+    TResult WithScalar(ValueLayout const &layout, TResult fallback, TFunc &&func) {
+        auto kind = KindOf(layout);
+        if (!kind)
+            return fallback;
+
+        switch (*kind) {
+            case ScalarKind::Bool:
+            case ScalarKind::UInt8:
+                return func(static_cast<uint8_t *>(nullptr));
+            case ScalarKind::Int8:
+                return func(static_cast<int8_t *>(nullptr));
+            case ScalarKind::UInt16:
+                return func(static_cast<uint16_t *>(nullptr));
+            case ScalarKind::Int16:
+                return func(static_cast<int16_t *>(nullptr));
+            case ScalarKind::UInt32:
+                return func(static_cast<uint32_t *>(nullptr));
+            case ScalarKind::Int32:
+                return func(static_cast<int32_t *>(nullptr));
+            case ScalarKind::UInt64:
+                return func(static_cast<uint64_t *>(nullptr));
+            case ScalarKind::Int64:
+                return func(static_cast<int64_t *>(nullptr));
+            case ScalarKind::Float32:
+                return func(static_cast<float *>(nullptr));
+            case ScalarKind::Float64:
+                return func(static_cast<double *>(nullptr));
+        }
+
+        return fallback;
+    }
+}
@@ -0,0 +1,350 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#define SERPENT_SIMD_AVX2
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SERPENT_SIMD_SSE2
+#include <immintrin.h>
+#endif
+
+/// Thin wrappers over the widest vector registers the current translation unit is compiled for.
+/// Each ISA specific translation unit includes this header with different target flags, so everything here has internal linkage.
+/// Vec<T> is only defined for element types the instruction set can operate on, operations a given ISA lacks are simply left out.
+namespace {
+    template <typename T>
+    struct Vec;
+
+    template <typename T>
+    concept Vectorized = requires { Vec<T>::Lanes; };
+
+    template <typename T>
+    concept HasMul = Vectorized<T> && requires (typename Vec<T>::Type a) { Vec<T>::Mul(a, a); };
+
+    template <typename T>
+    concept HasMinMax = Vectorized<T> && requires (typename Vec<T>::Type a) { Vec<T>::Min(a, a); Vec<T>::Max(a, a); };
+
+    /// Byte comparisons that collapse into a bitmask, one bit per lane, for scanning text
+    template <typename T>
+    concept HasMask = Vectorized<T> && requires (typename Vec<T>::Type a) { Vec<T>::Eq(a, a); Vec<T>::Or(a, a); Vec<T>::Mask(a); };
+
+    /// Integer lanes folded into 64 bit lanes without losing anything, so they can be accumulated in 64 bits like the scalar kernels do.
+    /// SumWide keeps the total of the lanes, DotWide the total of the lanes' products
+    template <typename T>
+    concept HasWideSum = Vectorized<T> && requires (typename Vec<T>::Type a) { Vec<T>::SumWide(a); };
+
+    template <typename T>
+    concept HasWideDot = Vectorized<T> && requires (typename Vec<T>::Type a) { Vec<T>::DotWide(a, a); };
+
+#if defined(SERPENT_SIMD_AVX2)
+    template <>
+    struct Vec<float> {
+        using Type = __m256;
+        static constexpr size_t Lanes = 8;
+
+        static Type Load(float const *ptr) { return _mm256_loadu_ps(ptr); }
+        static void Store(float *ptr, Type value) { _mm256_storeu_ps(ptr, value); }
+        static Type Splat(float value) { return _mm256_set1_ps(value); }
+        static Type Add(Type a, Type b) { return _mm256_add_ps(a, b); }
+        static Type Mul(Type a, Type b) { return _mm256_mul_ps(a, b); }
+        static Type Min(Type a, Type b) { return _mm256_min_ps(a, b); }
+        static Type Max(Type a, Type b) { return _mm256_max_ps(a, b); }
+    };
+
+    template <>
+    struct Vec<double> {
+        using Type = __m256d;
+        static constexpr size_t Lanes = 4;
+
+        static Type Load(double const *ptr) { return _mm256_loadu_pd(ptr); }
+        static void Store(double *ptr, Type value) { _mm256_storeu_pd(ptr, value); }
+        static Type Splat(double value) { return _mm256_set1_pd(value); }
+        static Type Add(Type a, Type b) { return _mm256_add_pd(a, b); }
+        static Type Mul(Type a, Type b) { return _mm256_mul_pd(a, b); }
+        static Type Min(Type a, Type b) { return _mm256_min_pd(a, b); }
+        static Type Max(Type a, Type b) { return _mm256_max_pd(a, b); }
+    };
+
+    template <typename T>
+    struct VecInt256 {
+        using Type = __m256i;
+        static constexpr size_t Lanes = 32 / sizeof(T);
+
+        static Type Load(T const *ptr) { return _mm256_loadu_si256(reinterpret_cast<__m256i const *>(ptr)); }
+        static void Store(T *ptr, Type value) { _mm256_storeu_si256(reinterpret_cast<__m256i *>(ptr), value); }
+    };
+
+    /// Folds 32 bit lanes into 64 bit lanes, keeping their total
+    inline __m256i FoldEpi32(__m256i value) {
+        return _mm256_add_epi64(_mm256_cvtepi32_epi64(_mm256_castsi256_si128(value)), _mm256_cvtepi32_epi64(_mm256_extracti128_si256(value, 1)));
+    }
+
+    inline __m256i FoldEpu32(__m256i value) {
+        return _mm256_add_epi64(_mm256_cvtepu32_epi64(_mm256_castsi256_si128(value)), _mm256_cvtepu32_epi64(_mm256_extracti128_si256(value, 1)));
+    }
+
+    /// Products of 16 bit lanes in 32 bit lanes, folded into 64 bit lanes one half at a time since two of them can overflow 32 bits
+    inline __m256i FoldProducts16(__m256i low, __m256i high, bool isSigned) {
+        __m256i a = _mm256_unpacklo_epi16(low, high);
+        __m256i b = _mm256_unpackhi_epi16(low, high);
+
+        return isSigned ? _mm256_add_epi64(FoldEpi32(a), FoldEpi32(b)) : _mm256_add_epi64(FoldEpu32(a), FoldEpu32(b));
+    }
+
+    template <>
+    struct Vec<int8_t> : VecInt256<int8_t> {
+        static Type Splat(int8_t value) { return _mm256_set1_epi8(value); }
+        static Type Add(Type a, Type b) { return _mm256_add_epi8(a, b); }
+        static Type Min(Type a, Type b) { return _mm256_min_epi8(a, b); }
+        static Type Max(Type a, Type b) { return _mm256_max_epi8(a, b); }
+        // Flipping the sign bit biases every byte by 128 so the unsigned sum of absolute differences can add them, the bias is taken back out per group of 8
+        static Type SumWide(Type a) {
+            Type sums = _mm256_sad_epu8(_mm256_xor_si256(a, _mm256_set1_epi8(static_cast<char>(0x80))), _mm256_setzero_si256());
+            return _mm256_sub_epi64(sums, _mm256_set1_epi64x(8 * 128));
+        }
+        static Type DotWide(Type a, Type b) {
+            Type low = _mm256_madd_epi16(_mm256_cvtepi8_epi16(_mm256_castsi256_si128(a)), _mm256_cvtepi8_epi16(_mm256_castsi256_si128(b)));
+            Type high = _mm256_madd_epi16(_mm256_cvtepi8_epi16(_mm256_extracti128_si256(a, 1)), _mm256_cvtepi8_epi16(_mm256_extracti128_si256(b, 1)));
+            return FoldEpi32(_mm256_add_epi32(low, high));
+        }
+    };
+
+    template <>
+    struct Vec<uint8_t> : VecInt256<uint8_t> {
+        static Type Splat(uint8_t value) { return _mm256_set1_epi8(static_cast<char>(value)); }
+        static Type Add(Type a, Type b) { return _mm256_add_epi8(a, b); }
+        static Type Min(Type a, Type b) { return _mm256_min_epu8(a, b); }
+        static Type Max(Type a, Type b) { return _mm256_max_epu8(a, b); }
+        static Type Eq(Type a, Type b) { return _mm256_cmpeq_epi8(a, b); }
+        static Type Or(Type a, Type b) { return _mm256_or_si256(a, b); }
+        static uint32_t Mask(Type value) { return static_cast<uint32_t>(_mm256_movemask_epi8(value)); }
+        static Type SumWide(Type a) { return _mm256_sad_epu8(a, _mm256_setzero_si256()); }
+        static Type DotWide(Type a, Type b) {
+            Type low = _mm256_madd_epi16(_mm256_cvtepu8_epi16(_mm256_castsi256_si128(a)), _mm256_cvtepu8_epi16(_mm256_castsi256_si128(b)));
+            Type high = _mm256_madd_epi16(_mm256_cvtepu8_epi16(_mm256_extracti128_si256(a, 1)), _mm256_cvtepu8_epi16(_mm256_extracti128_si256(b, 1)));
+            return FoldEpi32(_mm256_add_epi32(low, high));
+        }
+    };
+
+    template <>
+    struct Vec<int16_t> : VecInt256<int16_t> {
+        static Type Splat(int16_t value) { return _mm256_set1_epi16(value); }
+        static Type Add(Type a, Type b) { return _mm256_add_epi16(a, b); }
+        static Type Mul(Type a, Type b) { return _mm256_mullo_epi16(a, b); }
+        static Type Min(Type a, Type b) { return _mm256_min_epi16(a, b); }
+        static Type Max(Type a, Type b) { return _mm256_max_epi16(a, b); }
+        static Type SumWide(Type a) { return FoldEpi32(_mm256_madd_epi16(a, _mm256_set1_epi16(1))); }
+        static Type DotWide(Type a, Type b) { return FoldProducts16(_mm256_mullo_epi16(a, b), _mm256_mulhi_epi16(a, b), true); }
+    };
+
+    template <>
+    struct Vec<uint16_t> : VecInt256<uint16_t> {
+        static Type Splat(uint16_t value) { return _mm256_set1_epi16(static_cast<short>(value)); }
+        static Type Add(Type a, Type b) { return _mm256_add_epi16(a, b); }
+        static Type Mul(Type a, Type b) { return _mm256_mullo_epi16(a, b); }
+        static Type Min(Type a, Type b) { return _mm256_min_epu16(a, b); }
+        static Type Max(Type a, Type b) { return _mm256_max_epu16(a, b); }
+        static Type SumWide(Type a) { return FoldEpu32(_mm256_add_epi32(_mm256_and_si256(a, _mm256_set1_epi32(0xFFFF)), _mm256_srli_epi32(a, 16))); }
+        static Type DotWide(Type a, Type b) { return FoldProducts16(_mm256_mullo_epi16(a, b), _mm256_mulhi_epu16(a, b), false); }
+    };
+
+    template <>
+    struct Vec<int32_t> : VecInt256<int32_t> {
+        static Type Splat(int32_t value) { return _mm256_set1_epi32(value); }
+        static Type Add(Type a, Type b) { return _mm256_add_epi32(a, b); }
+        static Type Mul(Type a, Type b) { return _mm256_mullo_epi32(a, b); }
+        static Type Min(Type a, Type b) { return _mm256_min_epi32(a, b); }
+        static Type Max(Type a, Type b) { return _mm256_max_epi32(a, b); }
+        static Type SumWide(Type a) { return FoldEpi32(a); }
+        // Full 64 bit products of the even lanes, then of the odd lanes shifted down into their place
+        static Type DotWide(Type a, Type b) {
+            return _mm256_add_epi64(_mm256_mul_epi32(a, b), _mm256_mul_epi32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32)));
+        }
+    };
+
+    template <>
+    struct Vec<uint32_t> : VecInt256<uint32_t> {
+        static Type Splat(uint32_t value) { return _mm256_set1_epi32(static_cast<int>(value)); }
+        static Type Add(Type a, Type b) { return _mm256_add_epi32(a, b); }
+        static Type Mul(Type a, Type b) { return _mm256_mullo_epi32(a, b); }
+        static Type Min(Type a, Type b) { return _mm256_min_epu32(a, b); }
+        static Type Max(Type a, Type b) { return _mm256_max_epu32(a, b); }
+        static Type SumWide(Type a) { return FoldEpu32(a); }
+        static Type DotWide(Type a, Type b) {
+            return _mm256_add_epi64(_mm256_mul_epu32(a, b), _mm256_mul_epu32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32)));
+        }
+    };
+
+    template <>
+    struct Vec<int64_t> : VecInt256<int64_t> {
+        static Type Splat(int64_t value) { return _mm256_set1_epi64x(value); }
+        static Type Add(Type a, Type b) { return _mm256_add_epi64(a, b); }
+        // Already as wide as the accumulator. There's no 64 bit multiply, so DotWide is left out
+        static Type SumWide(Type a) { return a; }
+    };
+
+    template <>
+    struct Vec<uint64_t> : VecInt256<uint64_t> {
+        static Type Splat(uint64_t value) { return _mm256_set1_epi64x(static_cast<long long>(value)); }
+        static Type Add(Type a, Type b) { return _mm256_add_epi64(a, b); }
+        static Type SumWide(Type a) { return a; }
+    };
+#elif defined(SERPENT_SIMD_SSE2)
+    template <>
+    struct Vec<float> {
+        using Type = __m128;
+        static constexpr size_t Lanes = 4;
+
+        static Type Load(float const *ptr) { return _mm_loadu_ps(ptr); }
+        static void Store(float *ptr, Type value) { _mm_storeu_ps(ptr, value); }
+        static Type Splat(float value) { return _mm_set1_ps(value); }
+        static Type Add(Type a, Type b) { return _mm_add_ps(a, b); }
+        static Type Mul(Type a, Type b) { return _mm_mul_ps(a, b); }
+        static Type Min(Type a, Type b) { return _mm_min_ps(a, b); }
+        static Type Max(Type a, Type b) { return _mm_max_ps(a, b); }
+    };
+
+    template <>
+    struct Vec<double> {
+        using Type = __m128d;
+        static constexpr size_t Lanes = 2;
+
+        static Type Load(double const *ptr) { return _mm_loadu_pd(ptr); }
+        static void Store(double *ptr, Type value) { _mm_storeu_pd(ptr, value); }
+        static Type Splat(double value) { return _mm_set1_pd(value); }
+        static Type Add(Type a, Type b) { return _mm_add_pd(a, b); }
+        static Type Mul(Type a, Type b) { return _mm_mul_pd(a, b); }
+        static Type Min(Type a, Type b) { return _mm_min_pd(a, b); }
+        static Type Max(Type a, Type b) { return _mm_max_pd(a, b); }
+    };
+
+    template <typename T>
+    struct VecInt128 {
+        using Type = __m128i;
+        static constexpr size_t Lanes = 16 / sizeof(T);
+
+        static Type Load(T const *ptr) { return _mm_loadu_si128(reinterpret_cast<__m128i const *>(ptr)); }
+        static void Store(T *ptr, Type value) { _mm_storeu_si128(reinterpret_cast<__m128i *>(ptr), value); }
+    };
+
+    /// Folds 32 bit lanes into 64 bit lanes, keeping their total. SSE2 has no widening moves, so lanes are interleaved with their extension
+    inline __m128i FoldEpi32(__m128i value) {
+        __m128i sign = _mm_srai_epi32(value, 31);
+        return _mm_add_epi64(_mm_unpacklo_epi32(value, sign), _mm_unpackhi_epi32(value, sign));
+    }
+
+    inline __m128i FoldEpu32(__m128i value) {
+        __m128i zero = _mm_setzero_si128();
+        return _mm_add_epi64(_mm_unpacklo_epi32(value, zero), _mm_unpackhi_epi32(value, zero));
+    }
+
+    /// Products of 16 bit lanes in 32 bit lanes, folded into 64 bit lanes one half at a time since two of them can overflow 32 bits
+    inline __m128i FoldProducts16(__m128i low, __m128i high, bool isSigned) {
+        __m128i a = _mm_unpacklo_epi16(low, high);
+        __m128i b = _mm_unpackhi_epi16(low, high);
+
+        return isSigned ? _mm_add_epi64(FoldEpi32(a), FoldEpi32(b)) : _mm_add_epi64(FoldEpu32(a), FoldEpu32(b));
+    }
+
+    /// Sums of the products of 8 bit lanes, widened to 16 bits by interleaving them with their extension
+    inline __m128i DotBytes(__m128i a, __m128i b, __m128i aExtension, __m128i bExtension) {
+        __m128i low = _mm_madd_epi16(_mm_unpacklo_epi8(a, aExtension), _mm_unpacklo_epi8(b, bExtension));
+        __m128i high = _mm_madd_epi16(_mm_unpackhi_epi8(a, aExtension), _mm_unpackhi_epi8(b, bExtension));
+
+        return FoldEpi32(_mm_add_epi32(low, high));
+    }
+
+    template <>
+    struct Vec<int8_t> : VecInt128<int8_t> {
+        static Type Splat(int8_t value) { return _mm_set1_epi8(value); }
+        static Type Add(Type a, Type b) { return _mm_add_epi8(a, b); }
+        // Flipping the sign bit biases every byte by 128 so the unsigned sum of absolute differences can add them, the bias is taken back out per group of 8
+        static Type SumWide(Type a) {
+            Type sums = _mm_sad_epu8(_mm_xor_si128(a, _mm_set1_epi8(static_cast<char>(0x80))), _mm_setzero_si128());
+            return _mm_sub_epi64(sums, _mm_set1_epi64x(8 * 128));
+        }
+        static Type DotWide(Type a, Type b) {
+            Type zero = _mm_setzero_si128();
+            return DotBytes(a, b, _mm_cmpgt_epi8(zero, a), _mm_cmpgt_epi8(zero, b));
+        }
+    };
+
+    template <>
+    struct Vec<uint8_t> : VecInt128<uint8_t> {
+        static Type Splat(uint8_t value) { return _mm_set1_epi8(static_cast<char>(value)); }
+        static Type Add(Type a, Type b) { return _mm_add_epi8(a, b); }
+        static Type Min(Type a, Type b) { return _mm_min_epu8(a, b); }
+        static Type Max(Type a, Type b) { return _mm_max_epu8(a, b); }
+        static Type Eq(Type a, Type b) { return _mm_cmpeq_epi8(a, b); }
+        static Type Or(Type a, Type b) { return _mm_or_si128(a, b); }
+        static uint32_t Mask(Type value) { return static_cast<uint32_t>(_mm_movemask_epi8(value)); }
+        static Type SumWide(Type a) { return _mm_sad_epu8(a, _mm_setzero_si128()); }
+        static Type DotWide(Type a, Type b) { return DotBytes(a, b, _mm_setzero_si128(), _mm_setzero_si128()); }
+    };
+
+    template <>
+    struct Vec<int16_t> : VecInt128<int16_t> {
+        static Type Splat(int16_t value) { return _mm_set1_epi16(value); }
+        static Type Add(Type a, Type b) { return _mm_add_epi16(a, b); }
+        static Type Mul(Type a, Type b) { return _mm_mullo_epi16(a, b); }
+        static Type Min(Type a, Type b) { return _mm_min_epi16(a, b); }
+        static Type Max(Type a, Type b) { return _mm_max_epi16(a, b); }
+        static Type SumWide(Type a) { return FoldEpi32(_mm_madd_epi16(a, _mm_set1_epi16(1))); }
+        static Type DotWide(Type a, Type b) { return FoldProducts16(_mm_mullo_epi16(a, b), _mm_mulhi_epi16(a, b), true); }
+    };
+
+    template <>
+    struct Vec<uint16_t> : VecInt128<uint16_t> {
+        static Type Splat(uint16_t value) { return _mm_set1_epi16(static_cast<short>(value)); }
+        static Type Add(Type a, Type b) { return _mm_add_epi16(a, b); }
+        static Type Mul(Type a, Type b) { return _mm_mullo_epi16(a, b); }
+        static Type SumWide(Type a) { return FoldEpu32(_mm_add_epi32(_mm_and_si128(a, _mm_set1_epi32(0xFFFF)), _mm_srli_epi32(a, 16))); }
+        static Type DotWide(Type a, Type b) { return FoldProducts16(_mm_mullo_epi16(a, b), _mm_mulhi_epu16(a, b), false); }
+    };
+
+    template <>
+    struct Vec<int32_t> : VecInt128<int32_t> {
+        static Type Splat(int32_t value) { return _mm_set1_epi32(value); }
+        static Type Add(Type a, Type b) { return _mm_add_epi32(a, b); }
+        // SSE2 has no 32 bit min/max, so emulate them with a compare and a blend
+        static Type Min(Type a, Type b) {
+            Type gt = _mm_cmpgt_epi32(a, b);
+            return _mm_or_si128(_mm_and_si128(gt, b), _mm_andnot_si128(gt, a));
+        }
+        static Type Max(Type a, Type b) {
+            Type gt = _mm_cmpgt_epi32(a, b);
+            return _mm_or_si128(_mm_and_si128(gt, a), _mm_andnot_si128(gt, b));
+        }
+        // The signed 32 bit multiply into 64 bits needs SSE4.1, so DotWide is left out
+        static Type SumWide(Type a) { return FoldEpi32(a); }
+    };
+
+    template <>
+    struct Vec<uint32_t> : VecInt128<uint32_t> {
+        static Type Splat(uint32_t value) { return _mm_set1_epi32(static_cast<int>(value)); }
+        static Type Add(Type a, Type b) { return _mm_add_epi32(a, b); }
+        static Type SumWide(Type a) { return FoldEpu32(a); }
+        static Type DotWide(Type a, Type b) {
+            return _mm_add_epi64(_mm_mul_epu32(a, b), _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32)));
+        }
+    };
+
+    template <>
+    struct Vec<int64_t> : VecInt128<int64_t> {
+        static Type Splat(int64_t value) { return _mm_set1_epi64x(value); }
+        static Type Add(Type a, Type b) { return _mm_add_epi64(a, b); }
+        static Type SumWide(Type a) { return a; }
+    };
+
+    template <>
+    struct Vec<uint64_t> : VecInt128<uint64_t> {
+        static Type Splat(uint64_t value) { return _mm_set1_epi64x(static_cast<long long>(value)); }
+        static Type Add(Type a, Type b) { return _mm_add_epi64(a, b); }
+        static Type SumWide(Type a) { return a; }
+    };
+#endif
+}
@@ -0,0 +1,424 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+#include "serpent/stream.hpp"
+#include "serpent/types/interner.hpp"
+#include "binary.hpp"
+#include "gc.hpp"
+
+namespace {
+    using namespace Serpent;
+    using namespace Serpent::Binary;
+
+    /// Deepest nesting of objects and arrays the decoder follows, its frames are allocated up front
+    constexpr size_t MaxDepth = 64;
+
+    /// What the decoder is in the middle of reading
+    enum struct Step : uint8_t {
+        /// Nothing, the top frame decides what comes next
+        Next,
+        /// A run of scalars, copied straight into place
+        Bytes,
+        /// A string's bytes, gathered in scratch
+        StringBytes,
+        /// The rest are small unsigned integers, gathered in scalar
+        Presence,
+        Length,
+        Tag,
+        StringSize,
+    };
+
+    enum struct Phase : uint8_t {
+        /// Working through the plan's ops, or an array's elements
+        Ops,
+        /// Only for VariantLayout, the tag comes after the ops
+        Tag,
+        /// Checks are run, then the frame is popped
+        End,
+    };
+
+    struct Frame final {
+        /// Null for arrays
+        GcValue *object;
+        ArrayValue *array;
+        std::byte *data;
+        /// The object's plan, or the plan of an array's object elements
+        Plan const *plan;
+        /// The element op, for arrays
+        Op op;
+        /// The next op or element, and the active variant once the tag is read
+        size_t index;
+        Phase phase;
+    };
+
+    template <typename T>
+    T Read(void const *slot) {
+        T value;
+        std::memcpy(&value, slot, sizeof(T));
+
+        return value;
+    }
+
+    template <typename T>
+    void Write(void *slot, T value) {
+        std::memcpy(slot, &value, sizeof(T));
+    }
+
+    /// Swaps a run of little endian scalars into host order, in place
+    void ToNative(std::byte *data, size_t size, size_t width) {
+        if constexpr (std::endian::native != std::endian::little) {
+            for (size_t i = 0; i < size; i += width)
+                std::reverse(data + i, data + i + width);
+        }
+    }
+}
+
+struct Serpent::StreamDecoderState final {
+    GcHandle target;
+    GcValue *root;
+    StreamStatus status = StreamStatus::NeedMore;
+    std::vector<Frame> frames {};
+    /// Holds strings split across chunks, sized to the budget
+    std::vector<std::byte> scratch;
+    size_t maxLength;
+
+    Step step = Step::Next;
+    /// Where the current step's result goes
+    std::byte *slot = nullptr;
+    /// The field's layout, for Presence and Length
+    ValueLayout const *layout = nullptr;
+    /// Bytes the current step needs and has so far, and the width of its scalars
+    size_t size = 0;
+    size_t done = 0;
+    size_t width = 0;
+    std::byte scalar[sizeof(uint64_t)] {};
+
+    StreamDecoderState(GcHandle const &target, size_t budget, size_t maxLength) :
+        target(target),
+        root(WithRaw(target, [](GcValue *raw) { return raw; })),
+        scratch(budget),
+        maxLength(maxLength)
+    {
+        frames.reserve(MaxDepth);
+        Reset();
+    }
+
+    void Reset() {
+        frames.clear();
+        PushObject(root);
+        step = Step::Next;
+        status = StreamStatus::NeedMore;
+    }
+
+    void Fail(StreamStatus failure) {
+        status = failure;
+    }
+
+    void PushObject(GcValue *value) {
+        frames.push_back({value, nullptr, static_cast<std::byte *>(value->Data()), &PlanOf(value->layout), {}, 0, Phase::Ops});
+    }
+
+    void BeginScalar(Step next, size_t bytes, std::byte *target) {
+        step = next;
+        slot = target;
+        size = bytes;
+        done = 0;
+    }
+
+    void Begin(Op const &op, std::byte *base) {
+        std::byte *target = base + op.offset;
+
+        switch (op.kind) {
+            case SlotKind::Bytes:
+                if (op.size > 0) {
+                    BeginScalar(Step::Bytes, op.size, target);
+                    width = op.width;
+                }
+                return;
+            case SlotKind::String:
+                return BeginScalar(Step::StringSize, sizeof(uint32_t), target);
+            case SlotKind::Object:
+            case SlotKind::Array:
+                layout = op.layout;
+                return BeginScalar(Step::Presence, 1, target);
+        }
+    }
+
+    /// Validates the fields a frame decoded, resetting any that fail so the target stays valid
+    bool Passes(Check const &check, std::byte *data) {
+        if (Binary::Passes(check, data))
+            return true;
+
+        std::memset(data + check.offset, 0, check.width);
+        return false;
+    }
+
+    /// Sets up the next step from the top frame, returns false if the frame's fields fail validation
+    bool Advance() {
+        Frame &frame = frames.back();
+
+        if (frame.array) {
+            ArrayValue *array = frame.array;
+            size_t stride = GetSize(array->layout);
+
+            if (frame.op.kind == SlotKind::Bytes && frame.index < array->size) {
+                // Plain elements are one run, copied as it arrives
+                if (frame.op.size > 0) {
+                    BeginScalar(Step::Bytes, frame.op.size * array->size, frame.data);
+                    width = frame.op.width;
+                }
+                frame.index = array->size;
+                return true;
+            }
+
+            if (frame.index < array->size) {
+                Begin(frame.op, frame.data + frame.index++ * stride);
+                return true;
+            }
+
+            auto check = CheckOf(array->layout, 0);
+            for (size_t i = 0; check && i < array->size; i++) {
+                if (!Passes(*check, frame.data + i * stride))
+                    return false;
+            }
+
+            frames.pop_back();
+            return true;
+        }
+
+        Plan const &plan = *frame.plan;
+        switch (frame.phase) {
+            case Phase::Ops:
+                if (frame.index < plan.ops.size()) {
+                    Begin(plan.ops[frame.index++], frame.data);
+                    return true;
+                }
+
+                for (auto const &check : plan.checks) {
+                    if (!Passes(check, frame.data))
+                        return false;
+                }
+
+                frame.phase = plan.tagSize > 0 ? Phase::Tag : Phase::End;
+                return true;
+            case Phase::Tag:
+                BeginScalar(Step::Tag, plan.tagSize, frame.data);
+                return true;
+            case Phase::End:
+                if (plan.tagSize > 0 && plan.payloadChecks[frame.index] && !Passes(*plan.payloadChecks[frame.index], frame.data))
+                    return false;
+
+                frames.pop_back();
+                return true;
+        }
+
+        return false;
+    }
+
+    void StoreString(std::string_view view) {
+        auto &interner = Interner::Instance();
+        size_t index = interner.Acquire(view);
+        interner.RemoveRef(Read<size_t>(slot));
+        Write(slot, index);
+    }
+
+    /// Returns the child to decode into, replacing the field's value unless nothing else references it
+    GcValue *ChildObject() {
+        auto const &child = std::get<Rc<GcLayout const>>(*layout);
+        auto current = Read<GcValue *>(slot);
+        if (current && current->header.IsUnique())
+            return current;
+
+        GcValue *value = Allocate(child);
+        std::visit([value](auto const &layout) { layout.Initialize(value->Data()); }, *child);
+
+        Release(*layout, slot);
+        Write(slot, value);
+        return value;
+    }
+
+    ArrayValue *ChildArray(size_t length) {
+        auto const &element = std::get<ArrayLayout>(*layout).Layout();
+        auto current = Read<ArrayValue *>(slot);
+        if (current && current->size == length && current->header.IsUnique())
+            return current;
+
+        ArrayValue *value = Allocate(element, length);
+        size_t stride = GetSize(element);
+
+        if (OpOf(element, 0).kind == SlotKind::String) {
+            for (size_t i = 0; i < value->size; i++)
+                DefaultInitialize(element, static_cast<std::byte *>(value->data) + i * stride);
+        } else if (value->data) {
+            std::memset(value->data, 0, stride * value->size);
+        }
+
+        Release(*layout, slot);
+        Write(slot, value);
+        return value;
+    }
+
+    /// Handles a small integer once all its bytes are in
+    void Complete(std::span<std::byte const> &chunk) {
+        alignas(uint64_t) std::byte native[sizeof(uint64_t)] {};
+        CopyScalars(native, scalar, size, size);
+        uint64_t value = LoadUnsigned(native, size);
+
+        Step finished = step;
+        step = Step::Next;
+
+        switch (finished) {
+            case Step::Presence:
+                if (value > 1)
+                    return Fail(StreamStatus::Malformed);
+
+                if (value == 0) {
+                    Release(*layout, slot);
+                    Write<void *>(slot, nullptr);
+                    return;
+                }
+
+                if (std::holds_alternative<ArrayLayout>(*layout)) {
+                    BeginScalar(Step::Length, sizeof(uint64_t), slot);
+                    return;
+                }
+
+                if (frames.size() == MaxDepth)
+                    return Fail(StreamStatus::OverBudget);
+
+                PushObject(ChildObject());
+                return;
+            case Step::Length: {
+                if (value > maxLength || frames.size() == MaxDepth)
+                    return Fail(StreamStatus::OverBudget);
+
+                auto const &element = std::get<ArrayLayout>(*layout).Layout();
+                ArrayValue *array = ChildArray(size_t(value));
+                Op op = OpOf(element, 0);
+                Plan const *plan = op.kind == SlotKind::Object ? &PlanOf(std::get<Rc<GcLayout const>>(element)) : nullptr;
+
+                frames.push_back({nullptr, array, static_cast<std::byte *>(array->data), plan, op, 0, Phase::Ops});
+                return;
+            }
+            case Step::Tag: {
+                Frame &frame = frames.back();
+                Plan const &plan = *frame.plan;
+                if (value >= plan.payloads.size())
+                    return Fail(StreamStatus::Malformed);
+
+                auto const &payload = plan.payloads[value];
+                uint64_t current = LoadUnsigned(frame.data, plan.tagSize);
+
+                // A different variant replaces the payload, the same one is decoded into in place
+                if (value != current) {
+                    auto const &variants = std::get<VariantLayout>(*frame.object->layout).Variants();
+                    std::byte *target = frame.data + payload.offset;
+                    Release(variants[current].Layout(), target);
+                    std::memcpy(frame.data, native, plan.tagSize);
+                    DefaultInitialize(variants[value].Layout(), target);
+                }
+
+                frame.index = size_t(value);
+                frame.phase = Phase::End;
+                Begin(payload, frame.data);
+                return;
+            }
+            case Step::StringSize:
+                // Strings that arrive whole are interned straight from the chunk
+                if (chunk.size() >= value) {
+                    StoreString(std::string_view(reinterpret_cast<char const *>(chunk.data()), size_t(value)));
+                    chunk = chunk.subspan(size_t(value));
+                    return;
+                }
+
+                if (value > scratch.size())
+                    return Fail(StreamStatus::OverBudget);
+
+                step = Step::StringBytes;
+                size = size_t(value);
+                done = 0;
+                return;
+            default:
+                return;
+        }
+    }
+
+    /// Copies as much of the current step's bytes as the chunk holds, returns true once they're all in
+    bool Gather(std::byte *target, std::span<std::byte const> &chunk) {
+        size_t take = std::min(size - done, chunk.size());
+        std::memcpy(target + done, chunk.data(), take);
+        chunk = chunk.subspan(take);
+        done += take;
+
+        return done == size;
+    }
+
+    StreamStatus Feed(std::span<std::byte const> &chunk) {
+        while (status == StreamStatus::NeedMore) {
+            switch (step) {
+                case Step::Next:
+                    if (frames.empty())
+                        return status = StreamStatus::Done;
+                    if (!Advance())
+                        Fail(StreamStatus::Malformed);
+                    break;
+                case Step::Bytes:
+                    if (!Gather(slot, chunk))
+                        return status;
+
+                    ToNative(slot, size, width);
+                    step = Step::Next;
+                    break;
+                case Step::StringBytes:
+                    if (!Gather(scratch.data(), chunk))
+                        return status;
+
+                    StoreString(std::string_view(reinterpret_cast<char const *>(scratch.data()), size));
+                    step = Step::Next;
+                    break;
+                default:
+                    if (!Gather(scalar, chunk))
+                        return status;
+
+                    Complete(chunk);
+                    break;
+            }
+        }
+
+        return status;
+    }
+};
+
+Serpent::StreamDecoder::StreamDecoder(std::unique_ptr<StreamDecoderState> state) :
+    state(std::move(state))
+{}
+
+Serpent::StreamDecoder::StreamDecoder(StreamDecoder &&move) = default;
+
+Serpent::StreamDecoder::~StreamDecoder() = default;
+
+Serpent::StreamDecoder &Serpent::StreamDecoder::operator = (StreamDecoder &&move) = default;
+
+std::optional<Serpent::StreamDecoder> Serpent::StreamDecoder::Into(GcHandle const &target, size_t budget, size_t maxLength) {
+    if (target.IsFrozen())
+        return std::nullopt;
+
+    return StreamDecoder(std::make_unique<StreamDecoderState>(target, budget, maxLength));
+}
+
+Serpent::StreamStatus Serpent::StreamDecoder::Feed(std::span<std::byte const> &chunk) {
+    return state->Feed(chunk);
+}
+
+void Serpent::StreamDecoder::Reset() {
+    state->Reset();
+}
+
+Serpent::GcHandle const &Serpent::StreamDecoder::Target() const {
+    return state->target;
+}
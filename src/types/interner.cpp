@@ -114,6 +114,13 @@ Serpent::InternedString::InternedString() :
     index(Interner::Instance().Acquire(""))
 {}
 
+Serpent::InternedString Serpent::InternedString::FromIndex(size_t index) {
+    InternedString value {};
+    value.index = Interner::Instance().AddRef(index);
+
+    return value;
+}
+
 Serpent::InternedString::InternedString(Serpent::InternedString const &copy) :
     index(Interner::Instance().AddRef(copy.index))
 {}
@@ -1,46 +1,1014 @@
 #include "serpent/value.hpp"
+#include <algorithm>
 #include <atomic>
+#include <concepts>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <utility>
+#include <variant>
+#include <vector>
 #include "serpent/layout.hpp"
+#include "serpent/types/interner.hpp"
 #include "serpent/types/rc.hpp"
+#include "gc.hpp"
 
-namespace Serpent {
-    struct GcHeader final {
-        std::atomic_size_t refCount;
+bool Serpent::IsTraceable(ValueLayout const &layout) {
+    return std::holds_alternative<Rc<GcLayout const>>(layout) || std::holds_alternative<ArrayLayout>(layout);
+}
+
+bool Serpent::IsTraceable(GcLayout const &layout) {
+    return std::visit(
+        [](auto const &layout) {
+            using T = std::decay_t<decltype(layout)>;
+            if constexpr (std::same_as<T, VariantLayout>) {
+                return std::ranges::any_of(layout.Variants(), [](auto const &variant) { return IsTraceable(variant.Layout()); });
+            } else if constexpr (std::same_as<T, ObjectLayout>) {
+                return std::ranges::any_of(layout.Fields(), [](auto const &field) { return IsTraceable(field.layout.Layout()); });
+            } else {
+                return std::ranges::any_of(layout.Fields(), [](auto const &field) { return IsTraceable(field.layout); });
+            }
+        },
+        layout
+    );
+}
+
+void Serpent::Release(ValueLayout const &layout, void *slot) {
+    if (std::holds_alternative<PrimitiveLayout>(layout)) {
+        if (std::get<PrimitiveLayout>(layout) == PrimitiveLayout::String)
+            Interner::Instance().RemoveRef(*reinterpret_cast<size_t *>(slot));
+    } else if (std::holds_alternative<Rc<GcLayout const>>(layout)) {
+        auto value = *reinterpret_cast<GcValue **>(slot);
+        if (value && value->RemoveRef())
+            Destroy(value);
+    } else if (std::holds_alternative<ArrayLayout>(layout)) {
+        auto value = *reinterpret_cast<ArrayValue **>(slot);
+        if (value && value->RemoveRef())
+            Destroy(value);
+    }
+}
+
+void Serpent::ReleaseFields(GcValue *value) {
+    ForEachSlot(value, [](ValueLayout const &layout, void *slot) { Release(layout, slot); });
+}
+
+void Serpent::ReleaseFields(ArrayValue *value) {
+    ForEachSlot(value, [](ValueLayout const &layout, void *slot) { Release(layout, slot); });
+}
+
+void Serpent::Free(GcValue *value) {
+    size_t align = std::max(alignof(GcValue), std::visit([](auto const &layout) { return layout.Align(); }, *value->layout));
+
+    value->~GcValue();
+    ::operator delete(reinterpret_cast<void *>(value), std::align_val_t(align));
+}
+
+void Serpent::Free(ArrayValue *value) {
+    if (value->data)
+        ::operator delete(value->data, std::align_val_t(GetAlign(value->layout)));
+
+    delete value;
+}
+
+void Serpent::Destroy(GcValue *value) {
+    ReleaseFields(value);
+    Free(value);
+}
+
+void Serpent::Destroy(ArrayValue *value) {
+    ReleaseFields(value);
+    Free(value);
+}
+
+namespace {
+    using namespace Serpent;
+
+    IntegralLayout AsIntegral(ValueLayout const &layout) {
+        if (auto en = std::get_if<Rc<EnumLayout const>>(&layout))
+            return (*en)->Backing();
+
+        return std::get<IntegralLayout>(layout);
+    }
+
+    /// Bool only takes 0 and 1, and an enum only the indices of its names. Handles of the wrong type are left for StoreScalar to reject
+    bool IsInRange(ValueLayout const &layout, Handle const &value) {
+        uint64_t count = 2;
+        if (auto en = std::get_if<Rc<EnumLayout const>>(&layout))
+            count = (*en)->Names().size();
+        else if (std::get<IntegralLayout>(layout) != IntegralLayout::Bool)
+            return true;
+
+        return std::visit(
+            [count](auto const &scalar) {
+                using T = std::decay_t<decltype(scalar)>;
+                if constexpr (std::signed_integral<T>)
+                    return scalar >= 0 && uint64_t(scalar) < count;
+                else if constexpr (std::unsigned_integral<T>)
+                    return uint64_t(scalar) < count;
+                else
+                    return true;
+            },
+            value
+        );
+    }
+
+    template <typename T>
+    bool StoreScalar(Handle const &value, void *slot) {
+        auto scalar = std::get_if<T>(&value);
+        if (!scalar)
+            return false;
+
+        std::memcpy(slot, scalar, sizeof(T));
+
+        return true;
+    }
+
+    template <typename T>
+    Handle LoadScalar(void const *slot) {
+        T scalar;
+        std::memcpy(&scalar, slot, sizeof(T));
+
+        return scalar;
+    }
+
+    Handle Load(ValueLayout const &layout, void const *slot) {
+        if (std::holds_alternative<IntegralLayout>(layout) || std::holds_alternative<Rc<EnumLayout const>>(layout)) {
+            switch (AsIntegral(layout)) {
+                case IntegralLayout::Bool:
+                case IntegralLayout::UInt8:
+                    return LoadScalar<uint8_t>(slot);
+                case IntegralLayout::Int8:
+                    return LoadScalar<int8_t>(slot);
+                case IntegralLayout::UInt16:
+                    return LoadScalar<uint16_t>(slot);
+                case IntegralLayout::Int16:
+                    return LoadScalar<int16_t>(slot);
+                case IntegralLayout::UInt32:
+                    return LoadScalar<uint32_t>(slot);
+                case IntegralLayout::Int32:
+                    return LoadScalar<int32_t>(slot);
+                case IntegralLayout::UInt64:
+                    return LoadScalar<uint64_t>(slot);
+                case IntegralLayout::Int64:
+                    return LoadScalar<int64_t>(slot);
+            }
+        } else if (auto floating = std::get_if<FloatingLayout>(&layout)) {
+            switch (*floating) {
+                case FloatingLayout::Float32:
+                    return LoadScalar<float>(slot);
+                case FloatingLayout::Float64:
+                    return LoadScalar<double>(slot);
+            }
+        } else if (auto primitive = std::get_if<PrimitiveLayout>(&layout)) {
+            switch (*primitive) {
+                case PrimitiveLayout::String:
+                    return InternedString::FromIndex(*reinterpret_cast<size_t const *>(slot));
+                case PrimitiveLayout::Unit:
+                    return std::monostate {};
+            }
+        } else if (std::holds_alternative<Rc<GcLayout const>>(layout)) {
+            auto value = *reinterpret_cast<GcValue * const *>(slot);
+            if (!value)
+                return std::nullopt;
 
-        void AddRef() {
-            refCount.fetch_add(1);
+            value->AddRef();
+            return GcHandle::FromRaw(value);
+        } else if (std::holds_alternative<ArrayLayout>(layout)) {
+            auto value = *reinterpret_cast<ArrayValue * const *>(slot);
+            if (!value)
+                return std::nullopt;
+
+            value->AddRef();
+            return ArrayHandle::FromRaw(value);
         }
-        /// Returns true if refCount reaches 0
-        bool RemoveRef() {
-            return refCount.fetch_sub(1) == 1;
+
+        std::unreachable();
+    }
+
+    /// Returns true if the handle is the layout's handle type and in range for it, and parent may reference it. Touches neither the handle's count nor any slot
+    bool Accepts(GcHeader const &parent, ValueLayout const &layout, Handle &value) {
+        if (std::holds_alternative<IntegralLayout>(layout) || std::holds_alternative<Rc<EnumLayout const>>(layout)) {
+            if (!IsInRange(layout, value))
+                return false;
+
+            switch (AsIntegral(layout)) {
+                case IntegralLayout::Bool:
+                case IntegralLayout::UInt8:
+                    return std::holds_alternative<uint8_t>(value);
+                case IntegralLayout::Int8:
+                    return std::holds_alternative<int8_t>(value);
+                case IntegralLayout::UInt16:
+                    return std::holds_alternative<uint16_t>(value);
+                case IntegralLayout::Int16:
+                    return std::holds_alternative<int16_t>(value);
+                case IntegralLayout::UInt32:
+                    return std::holds_alternative<uint32_t>(value);
+                case IntegralLayout::Int32:
+                    return std::holds_alternative<int32_t>(value);
+                case IntegralLayout::UInt64:
+                    return std::holds_alternative<uint64_t>(value);
+                case IntegralLayout::Int64:
+                    return std::holds_alternative<int64_t>(value);
+            }
+        } else if (auto floating = std::get_if<FloatingLayout>(&layout)) {
+            switch (*floating) {
+                case FloatingLayout::Float32:
+                    return std::holds_alternative<float>(value);
+                case FloatingLayout::Float64:
+                    return std::holds_alternative<double>(value);
+            }
+        } else if (auto primitive = std::get_if<PrimitiveLayout>(&layout)) {
+            switch (*primitive) {
+                case PrimitiveLayout::String:
+                    return std::holds_alternative<InternedString>(value);
+                case PrimitiveLayout::Unit:
+                    return std::holds_alternative<std::monostate>(value);
+            }
+        } else if (auto gcLayout = std::get_if<Rc<GcLayout const>>(&layout)) {
+            if (auto handle = std::get_if<GcHandle>(&value)) {
+                if (handle->Layout() != *gcLayout)
+                    return false;
+
+                // Borrowed out of the handle and straight back, rather than copied, so the count isn't touched
+                GcValue *raw = handle->IntoRaw();
+                bool allowed = MayReference(parent, raw->header);
+                *handle = GcHandle::FromRaw(raw);
+
+                return allowed;
+            }
+
+            return std::holds_alternative<std::nullopt_t>(value);
+        } else if (auto arrayLayout = std::get_if<ArrayLayout>(&layout)) {
+            if (auto handle = std::get_if<ArrayHandle>(&value)) {
+                if (handle->Layout() != arrayLayout->Layout())
+                    return false;
+
+                ArrayValue *raw = handle->IntoRaw();
+                bool allowed = MayReference(parent, raw->header);
+                *handle = ArrayHandle::FromRaw(raw);
+
+                return allowed;
+            }
+
+            return std::holds_alternative<std::nullopt_t>(value);
         }
+
+        std::unreachable();
+    }
+
+    /// Returns false without touching the slot if the handle isn't accepted, see Accepts
+    bool Store(GcHeader const &parent, ValueLayout const &layout, void *slot, Handle &&value) {
+        if (!Accepts(parent, layout, value))
+            return false;
+
+        if (std::holds_alternative<IntegralLayout>(layout) || std::holds_alternative<Rc<EnumLayout const>>(layout)) {
+            switch (AsIntegral(layout)) {
+                case IntegralLayout::Bool:
+                case IntegralLayout::UInt8:
+                    return StoreScalar<uint8_t>(value, slot);
+                case IntegralLayout::Int8:
+                    return StoreScalar<int8_t>(value, slot);
+                case IntegralLayout::UInt16:
+                    return StoreScalar<uint16_t>(value, slot);
+                case IntegralLayout::Int16:
+                    return StoreScalar<int16_t>(value, slot);
+                case IntegralLayout::UInt32:
+                    return StoreScalar<uint32_t>(value, slot);
+                case IntegralLayout::Int32:
+                    return StoreScalar<int32_t>(value, slot);
+                case IntegralLayout::UInt64:
+                    return StoreScalar<uint64_t>(value, slot);
+                case IntegralLayout::Int64:
+                    return StoreScalar<int64_t>(value, slot);
+            }
+        } else if (auto floating = std::get_if<FloatingLayout>(&layout)) {
+            switch (*floating) {
+                case FloatingLayout::Float32:
+                    return StoreScalar<float>(value, slot);
+                case FloatingLayout::Float64:
+                    return StoreScalar<double>(value, slot);
+            }
+        } else if (auto primitive = std::get_if<PrimitiveLayout>(&layout)) {
+            if (*primitive == PrimitiveLayout::Unit)
+                return true;
+
+            auto &interner = Interner::Instance();
+            size_t index = interner.AddRef(std::get<InternedString>(value).Index());
+            interner.RemoveRef(*reinterpret_cast<size_t *>(slot));
+            *reinterpret_cast<size_t *>(slot) = index;
+
+            return true;
+        } else if (std::holds_alternative<Rc<GcLayout const>>(layout)) {
+            auto handle = std::get_if<GcHandle>(&value);
+            GcValue *raw = handle ? handle->IntoRaw() : nullptr;
+
+            Release(layout, slot);
+            *reinterpret_cast<GcValue **>(slot) = raw;
+
+            return true;
+        } else if (std::holds_alternative<ArrayLayout>(layout)) {
+            auto handle = std::get_if<ArrayHandle>(&value);
+            ArrayValue *raw = handle ? handle->IntoRaw() : nullptr;
+
+            Release(layout, slot);
+            *reinterpret_cast<ArrayValue **>(slot) = raw;
+
+            return true;
+        }
+
+        std::unreachable();
+    }
+
+    size_t ReadTag(VariantLayout const &layout, void const *data) {
+        size_t tag = 0;
+        std::memcpy(&tag, data, layout.TagSize());
+
+        return tag;
+    }
+
+    void WriteTag(VariantLayout const &layout, void *data, size_t tag) {
+        std::memcpy(data, &tag, layout.TagSize());
+    }
+
+    void *Offset(void *data, size_t offset) {
+        return reinterpret_cast<void *>(reinterpret_cast<size_t>(data) + offset);
+    }
+
+    struct Slot final {
+        ValueLayout const *layout;
+        void *data;
     };
 
-    struct GcValue final {
-        GcHeader header;
-        Rc<GcLayout const> layout;
+    /// The field at index, or the payload if it's the active variant
+    std::optional<Slot> FieldSlot(GcValue *value, size_t index) {
+        void *data = value->Data();
+
+        return std::visit(
+            [data, index](auto const &layout) -> std::optional<Slot> {
+                using T = std::decay_t<decltype(layout)>;
+                if constexpr (std::same_as<T, ObjectLayout> || std::same_as<T, TupleLayout>) {
+                    auto const &fields = layout.Fields();
+                    if (index >= fields.size())
+                        return std::nullopt;
+
+                    auto const &field = fields[index];
+                    if constexpr (std::same_as<T, ObjectLayout>)
+                        return Slot {&field.layout.Layout(), Offset(data, field.offset)};
+                    else
+                        return Slot {&field.layout, Offset(data, field.offset)};
+                } else {
+                    if (index >= layout.Variants().size() || ReadTag(layout, data) != index)
+                        return std::nullopt;
+
+                    return Slot {&layout.Variants()[index].Layout(), Offset(data, layout.PayloadOffset())};
+                }
+            },
+            *value->layout
+        );
+    }
 
-        void AddRef() {
-            header.AddRef();
+    /// Layout of the field at index, or of the variant at index whether it's active or not. Null if there isn't one
+    ValueLayout const *FieldLayout(GcLayout const &layout, size_t index) {
+        return std::visit(
+            [index](auto const &layout) -> ValueLayout const * {
+                using T = std::decay_t<decltype(layout)>;
+                if constexpr (std::same_as<T, ObjectLayout>) {
+                    return index < layout.Fields().size() ? &layout.Fields()[index].layout.Layout() : nullptr;
+                } else if constexpr (std::same_as<T, TupleLayout>) {
+                    return index < layout.Fields().size() ? &layout.Fields()[index].layout : nullptr;
+                } else {
+                    return index < layout.Variants().size() ? &layout.Variants()[index].Layout() : nullptr;
+                }
+            },
+            layout
+        );
+    }
+
+    /// Marks the children of a value that was just copied, they're now shared between the copy and whatever still references the original
+    template <typename TValue>
+    void MarkChildrenShared(TValue *value) {
+        ForEachChild(value, [](auto *child) {
+            if (!child->header.IsFrozen())
+                child->header.flags.fetch_or(GcHeader::Snapshotted, std::memory_order_relaxed);
+        });
+    }
+
+    /// Replaces value with a shallow copy only it references, if it's referenced from anywhere else. Returns true if it was copied
+    template <typename TValue>
+    bool CopyIfShared(TValue *&value) {
+        if (value->header.IsUnique()) {
+            // Whatever shared it is gone, later writes can skip the check
+            value->header.flags.fetch_and(uint8_t(~GcHeader::Snapshotted), std::memory_order_relaxed);
+            return false;
         }
 
-        bool RemoveRef() {
-            return header.RemoveRef();
+        TValue *old = std::exchange(value, ShallowCopy(value));
+        MarkChildrenShared(value);
+        if (old->RemoveRef())
+            Destroy(old);
+
+        return true;
+    }
+
+    /// Copy on write ahead of a write through a handle, for values a snapshot may share.
+    /// Values that were never snapshotted are written in place, like any other shared reference
+    template <typename TValue>
+    void CopyIfSnapshotted(TValue *&value) {
+        if (value->header.flags.load(std::memory_order_relaxed) & GcHeader::Snapshotted)
+            CopyIfShared(value);
+    }
+
+    /// Ahead of a Get through a handle to a value a snapshot may share, marks the child in the slot, since the snapshot shares it too.
+    /// Writes through the returned handle then copy the child rather than changing what the snapshot sees
+    template <typename TValue>
+    void MarkChildIfSnapshotted(TValue *parent, ValueLayout const &layout, void *slot) {
+        auto &flags = parent->header.flags;
+        if (!(flags.load(std::memory_order_relaxed) & GcHeader::Snapshotted))
+            return;
+
+        // Whatever shared it is gone, later reads can skip the check
+        if (parent->header.IsUnique()) {
+            flags.fetch_and(uint8_t(~GcHeader::Snapshotted), std::memory_order_relaxed);
+            return;
         }
+
+        if (auto child = ChildIn(layout, slot); child && !child->IsFrozen())
+            child->flags.fetch_or(GcHeader::Snapshotted, std::memory_order_relaxed);
+    }
+
+    /// Copy on write for a slot holding an object or array, replaces a value referenced from elsewhere with a copy only the slot references
+    void UnshareSlot(ValueLayout const &layout, void *slot) {
+        if (std::holds_alternative<Rc<GcLayout const>>(layout)) {
+            if (auto &value = *reinterpret_cast<GcValue **>(slot))
+                CopyIfShared(value);
+        } else if (std::holds_alternative<ArrayLayout>(layout)) {
+            if (auto &value = *reinterpret_cast<ArrayValue **>(slot))
+                CopyIfShared(value);
+        }
+    }
+}
+
+Serpent::GcValue *Serpent::Allocate(Rc<GcLayout const> const &layout) {
+    auto [size, align] = std::visit([](auto const &layout) { return std::pair {layout.Size(), layout.Align()}; }, *layout);
+    size_t allocAlign = std::max(alignof(GcValue), align);
+
+    void *memory = ::operator new(GcValue::DataOffset(align) + size, std::align_val_t(allocAlign));
+
+    return new (memory) GcValue {
+        .header = GcHeader::Owned(0),
+        .layout = layout,
     };
+}
+
+Serpent::ArrayValue *Serpent::Allocate(ValueLayout const &element, size_t length) {
+    size_t stride = GetSize(element);
+
+    void *data = nullptr;
+    if (stride * length > 0)
+        data = ::operator new(stride * length, std::align_val_t(GetAlign(element)));
+
+    return new ArrayValue {
+        .header = GcHeader::Owned(GcHeader::Array),
+        .layout = element,
+        .size = length,
+        .data = data,
+    };
+}
+
+void Serpent::Acquire(ValueLayout const &layout, void *slot) {
+    if (std::holds_alternative<PrimitiveLayout>(layout)) {
+        if (std::get<PrimitiveLayout>(layout) == PrimitiveLayout::String)
+            Interner::Instance().AddRef(*reinterpret_cast<size_t *>(slot));
+    } else if (std::holds_alternative<Rc<GcLayout const>>(layout)) {
+        if (auto value = *reinterpret_cast<GcValue **>(slot))
+            value->AddRef();
+    } else if (std::holds_alternative<ArrayLayout>(layout)) {
+        if (auto value = *reinterpret_cast<ArrayValue **>(slot))
+            value->AddRef();
+    }
+}
+
+void Serpent::Freeze(GcHeader *root) {
+    // Heap values can't reference arena values, so only an arena root can reach them
+    if (root->IsArena() || (root->flags.fetch_or(GcHeader::Frozen) & GcHeader::Frozen))
+        return;
+
+    std::vector<GcHeader *> stack {root};
+    auto visit = [&stack](auto *child) {
+        if (!(child->header.flags.fetch_or(GcHeader::Frozen) & GcHeader::Frozen))
+            stack.push_back(&child->header);
+    };
+
+    while (!stack.empty()) {
+        GcHeader *header = stack.back();
+        stack.pop_back();
+
+        if (header->flags.load(std::memory_order_relaxed) & GcHeader::Array)
+            ForEachChild(reinterpret_cast<ArrayValue *>(header), visit);
+        else
+            ForEachChild(reinterpret_cast<GcValue *>(header), visit);
+    }
+}
+
+Serpent::GcValue *Serpent::ShallowCopy(GcValue *value) {
+    Arena *arena = ArenaOf(value->header);
+    GcValue *copy = arena ? Allocate(arena, value->layout) : Allocate(value->layout);
+
+    std::memcpy(copy->Data(), value->Data(), std::visit([](auto const &layout) { return layout.Size(); }, *value->layout));
+    ForEachSlot(copy, [](ValueLayout const &layout, void *slot) { Acquire(layout, slot); });
 
-    struct ArrayValue final {
-        GcHeader header;
-        ValueLayout layout;
-        size_t size;
+    return copy;
+}
+
+Serpent::ArrayValue *Serpent::ShallowCopy(ArrayValue *value) {
+    Arena *arena = ArenaOf(value->header);
+    ArrayValue *copy = arena ? Allocate(arena, value->layout, value->size) : Allocate(value->layout, value->size);
+
+    if (copy->data)
+        std::memcpy(copy->data, value->data, GetSize(value->layout) * value->size);
+    // Strings hold references too, only plain numeric elements can skip this
+    if (IsTraceable(copy->layout) || std::holds_alternative<PrimitiveLayout>(copy->layout))
+        ForEachSlot(copy, [](ValueLayout const &layout, void *slot) { Acquire(layout, slot); });
+
+    return copy;
+}
+
+Serpent::GcHandle::GcHandle(GcValue *value) :
+    value(value)
+{}
+
+Serpent::GcHandle::GcHandle(GcHandle const &copy) :
+    value(copy.value)
+{
+    if (value)
+        value->AddRef();
+}
+
+Serpent::GcHandle::GcHandle(GcHandle &&move) :
+    value(move.value)
+{
+    move.value = nullptr;
+}
+
+Serpent::GcHandle::~GcHandle() {
+    if (value && value->RemoveRef())
+        Destroy(value);
+
+    value = nullptr;
+}
+
+Serpent::GcHandle &Serpent::GcHandle::operator = (GcHandle const &copy) {
+    if (value != copy.value) {
+        if (copy.value)
+            copy.value->AddRef();
+        if (value && value->RemoveRef())
+            Destroy(value);
+        value = copy.value;
+    }
+
+    return *this;
+}
+
+Serpent::GcHandle &Serpent::GcHandle::operator = (GcHandle &&move) {
+    if (this != &move) {
+        if (value && value->RemoveRef())
+            Destroy(value);
+        value = move.value;
+        move.value = nullptr;
+    }
+
+    return *this;
+}
+
+Serpent::GcHandle Serpent::GcHandle::Create(Rc<GcLayout const> const &layout) {
+    GcValue *value = localArena ? Allocate(localArena, layout) : Allocate(layout);
+
+    std::visit([value](auto const &layout) { layout.Initialize(value->Data()); }, *layout);
+
+    return GcHandle(value);
+}
+
+Serpent::GcHandle Serpent::GcHandle::FromRaw(GcValue *SERPENT_NONNULL raw) {
+    return GcHandle(raw);
+}
+
+Serpent::Rc<Serpent::GcLayout const> const &Serpent::GcHandle::Layout() const {
+    return value->layout;
+}
+
+void *Serpent::GcHandle::Data() const {
+    return value->Data();
+}
 
-        void AddRef() {
-            header.AddRef();
+Serpent::Handle Serpent::GcHandle::Get(std::string_view key) {
+    InternedString name = key;
+
+    return std::visit(
+        [this, &name](auto const &layout) -> Handle {
+            using T = std::decay_t<decltype(layout)>;
+            if constexpr (std::same_as<T, TupleLayout>) {
+                return std::monostate {};
+            } else {
+                auto index = layout.IndexOf(name);
+                if (!index)
+                    return std::monostate {};
+
+                return Get(*index);
+            }
+        },
+        *value->layout
+    );
+}
+
+Serpent::Handle Serpent::GcHandle::Get(size_t index) {
+    auto slot = FieldSlot(value, index);
+    if (!slot)
+        return std::monostate {};
+
+    MarkChildIfSnapshotted(value, *slot->layout, slot->data);
+
+    return Load(*slot->layout, slot->data);
+}
+
+bool Serpent::GcHandle::Set(std::string_view key, Handle value) {
+    InternedString name = key;
+
+    return std::visit(
+        [this, &name, &value](auto const &layout) -> bool {
+            using T = std::decay_t<decltype(layout)>;
+            if constexpr (std::same_as<T, TupleLayout>) {
+                return false;
+            } else {
+                auto index = layout.IndexOf(name);
+                if (!index)
+                    return false;
+
+                return Set(*index, std::move(value));
+            }
+        },
+        *this->value->layout
+    );
+}
+
+bool Serpent::GcHandle::Set(size_t index, Handle value) {
+    if (this->value->header.IsFrozen())
+        return false;
+
+    // Checked before copying, so a rejected handle never unshares a snapshotted value
+    auto target = FieldLayout(*this->value->layout, index);
+    if (!target || !Accepts(this->value->header, *target, value))
+        return false;
+
+    CopyIfSnapshotted(this->value);
+
+    void *data = this->value->Data();
+    GcHeader const &header = this->value->header;
+
+    return std::visit(
+        [data, index, &value, &header](auto const &layout) -> bool {
+            using T = std::decay_t<decltype(layout)>;
+            if constexpr (std::same_as<T, ObjectLayout> || std::same_as<T, TupleLayout>) {
+                auto const &fields = layout.Fields();
+                if (index >= fields.size())
+                    return false;
+
+                auto const &field = fields[index];
+                if constexpr (std::same_as<T, ObjectLayout>)
+                    return Store(header, field.layout.Layout(), Offset(data, field.offset), std::move(value));
+                else
+                    return Store(header, field.layout, Offset(data, field.offset), std::move(value));
+            } else {
+                if (index >= layout.Variants().size())
+                    return false;
+
+                auto const &variant = layout.Variants()[index].Layout();
+                void *payload = Offset(data, layout.PayloadOffset());
+                size_t tag = ReadTag(layout, data);
+
+                if (tag == index)
+                    return Store(header, variant, payload, std::move(value));
+
+                // Build the new variant separately, so a mismatched handle leaves the active variant untouched.
+                // Every ValueLayout fits in 8 bytes, since objects and arrays are stored by pointer.
+                alignas(uint64_t) std::byte temporary[sizeof(uint64_t)];
+
+                DefaultInitialize(variant, temporary);
+                if (!Store(header, variant, temporary, std::move(value))) {
+                    Release(variant, temporary);
+                    return false;
+                }
+
+                Release(layout.Variants()[tag].Layout(), payload);
+                std::memcpy(payload, temporary, GetSize(variant));
+                WriteTag(layout, data, index);
+
+                return true;
+            }
+        },
+        *this->value->layout
+    );
+}
+
+bool Serpent::GcHandle::GetMany(FieldSet const &set, void *buffer) {
+    if (set.Layout() != value->layout)
+        return false;
+
+    void *data = value->Data();
+
+    for (auto const &run : set.runs)
+        std::memcpy(Offset(buffer, run.target), Offset(data, run.source), run.size);
+
+    for (auto const &reference : set.references) {
+        void *source = Offset(data, reference.source);
+        void *target = Offset(buffer, reference.target);
+
+        switch (reference.kind) {
+            case FieldSet::Reference::Kind::String:
+                *reinterpret_cast<size_t *>(target) = Interner::Instance().AddRef(*reinterpret_cast<size_t *>(source));
+                break;
+            case FieldSet::Reference::Kind::Object:
+                if (auto child = *reinterpret_cast<GcValue **>(source))
+                    child->AddRef();
+                *reinterpret_cast<GcValue **>(target) = *reinterpret_cast<GcValue **>(source);
+                break;
+            case FieldSet::Reference::Kind::Array:
+                if (auto child = *reinterpret_cast<ArrayValue **>(source))
+                    child->AddRef();
+                *reinterpret_cast<ArrayValue **>(target) = *reinterpret_cast<ArrayValue **>(source);
+                break;
         }
+    }
 
-        bool RemoveRef() {
-            return header.RemoveRef();
+    return true;
+}
+
+bool Serpent::GcHandle::SetMany(FieldSet const &set, void const *buffer) {
+    if (value->header.IsFrozen() || set.Layout() != value->layout)
+        return false;
+
+    // Checked up front, so that a rejected buffer leaves the value untouched
+    for (auto const &reference : set.references) {
+        void *source = Offset(const_cast<void *>(buffer), reference.target);
+        GcHeader const *child = nullptr;
+        if (reference.kind == FieldSet::Reference::Kind::Object) {
+            if (auto object = *reinterpret_cast<GcValue **>(source)) {
+                if (object->layout != std::get<Rc<GcLayout const>>(reference.layout))
+                    return false;
+                child = &object->header;
+            }
+        } else if (reference.kind == FieldSet::Reference::Kind::Array) {
+            if (auto array = *reinterpret_cast<ArrayValue **>(source)) {
+                if (array->layout != std::get<ArrayLayout>(reference.layout).Layout())
+                    return false;
+                child = &array->header;
+            }
         }
-    };
+
+        if (child && !MayReference(value->header, *child))
+            return false;
+    }
+
+    CopyIfSnapshotted(value);
+    void *data = value->Data();
+
+    for (auto const &run : set.runs)
+        std::memcpy(Offset(data, run.source), Offset(const_cast<void *>(buffer), run.target), run.size);
+
+    // Acquire the new reference before releasing the old one, in case they're the same
+    for (auto const &reference : set.references) {
+        void *source = Offset(const_cast<void *>(buffer), reference.target);
+        void *target = Offset(data, reference.source);
+
+        switch (reference.kind) {
+            case FieldSet::Reference::Kind::String: {
+                size_t index = Interner::Instance().AddRef(*reinterpret_cast<size_t *>(source));
+                Release(PrimitiveLayout::String, target);
+                *reinterpret_cast<size_t *>(target) = index;
+                break;
+            }
+            case FieldSet::Reference::Kind::Object: {
+                auto child = *reinterpret_cast<GcValue **>(source);
+                if (child)
+                    child->AddRef();
+                if (auto old = *reinterpret_cast<GcValue **>(target); old && old->RemoveRef())
+                    Destroy(old);
+                *reinterpret_cast<GcValue **>(target) = child;
+                break;
+            }
+            case FieldSet::Reference::Kind::Array: {
+                auto child = *reinterpret_cast<ArrayValue **>(source);
+                if (child)
+                    child->AddRef();
+                if (auto old = *reinterpret_cast<ArrayValue **>(target); old && old->RemoveRef())
+                    Destroy(old);
+                *reinterpret_cast<ArrayValue **>(target) = child;
+                break;
+            }
+        }
+    }
+
+    return true;
+}
+
+void Serpent::GcHandle::Freeze() {
+    Serpent::Freeze(&value->header);
+}
+
+bool Serpent::GcHandle::IsFrozen() const {
+    return value->header.IsFrozen();
+}
+
+Serpent::GcHandle Serpent::GcHandle::Snapshot() const {
+    if (!value->header.IsFrozen())
+        value->header.flags.fetch_or(GcHeader::Snapshotted, std::memory_order_relaxed);
+
+    return *this;
+}
+
+bool Serpent::GcHandle::MakeUnique() {
+    return CopyIfShared(value);
+}
+
+Serpent::Handle Serpent::GcHandle::GetUnique(std::string_view key) {
+    InternedString name = key;
+
+    return std::visit(
+        [this, &name](auto const &layout) -> Handle {
+            using T = std::decay_t<decltype(layout)>;
+            if constexpr (std::same_as<T, TupleLayout>) {
+                return std::monostate {};
+            } else {
+                auto index = layout.IndexOf(name);
+                if (!index)
+                    return std::monostate {};
+
+                return GetUnique(*index);
+            }
+        },
+        *value->layout
+    );
+}
+
+Serpent::Handle Serpent::GcHandle::GetUnique(size_t index) {
+    if (!FieldSlot(value, index))
+        return std::monostate {};
+
+    // The path to the field is unshared from the root down, so the field's copy isn't stored into a value a snapshot still sees
+    if (!value->header.IsFrozen())
+        CopyIfSnapshotted(value);
+
+    auto slot = FieldSlot(value, index);
+    if (!value->header.IsFrozen())
+        UnshareSlot(*slot->layout, slot->data);
+
+    return Load(*slot->layout, slot->data);
+}
+
+Serpent::GcValue *SERPENT_NONNULL Serpent::GcHandle::IntoRaw() {
+    GcValue *raw = value;
+    value = nullptr;
+
+    return raw;
+}
+
+bool Serpent::GcHandle::PointerEq(GcHandle const &other) const {
+    return value == other.value;
+}
+
+Serpent::ArrayHandle::ArrayHandle(ArrayValue *value) :
+    value(value)
+{}
+
+Serpent::ArrayHandle::ArrayHandle(ArrayHandle const &copy) :
+    value(copy.value)
+{
+    if (value)
+        value->AddRef();
+}
+
+Serpent::ArrayHandle::ArrayHandle(ArrayHandle &&move) :
+    value(move.value)
+{
+    move.value = nullptr;
+}
+
+Serpent::ArrayHandle::~ArrayHandle() {
+    if (value && value->RemoveRef())
+        Destroy(value);
+
+    value = nullptr;
+}
+
+Serpent::ArrayHandle &Serpent::ArrayHandle::operator = (ArrayHandle const &copy) {
+    if (value != copy.value) {
+        if (copy.value)
+            copy.value->AddRef();
+        if (value && value->RemoveRef())
+            Destroy(value);
+        value = copy.value;
+    }
+
+    return *this;
+}
+
+Serpent::ArrayHandle &Serpent::ArrayHandle::operator = (ArrayHandle &&move) {
+    if (this != &move) {
+        if (value && value->RemoveRef())
+            Destroy(value);
+        value = move.value;
+        move.value = nullptr;
+    }
+
+    return *this;
+}
+
+Serpent::ArrayHandle Serpent::ArrayHandle::Create(ArrayLayout const &layout, size_t length) {
+    auto const &element = layout.Layout();
+    size_t stride = GetSize(element);
+    ArrayValue *value = localArena ? Allocate(localArena, element, length) : Allocate(element, length);
+
+    for (size_t i = 0; i < length; i++)
+        DefaultInitialize(element, Offset(value->data, i * stride));
+
+    return ArrayHandle(value);
+}
+
+Serpent::ArrayHandle Serpent::ArrayHandle::FromRaw(ArrayValue *SERPENT_NONNULL raw) {
+    return ArrayHandle(raw);
+}
+
+Serpent::ValueLayout const &Serpent::ArrayHandle::Layout() const {
+    return value->layout;
+}
+
+void *Serpent::ArrayHandle::Data() const {
+    return value->data;
+}
+
+size_t Serpent::ArrayHandle::Length() const {
+    return value->size;
+}
+
+Serpent::Handle Serpent::ArrayHandle::Get(size_t index) {
+    if (index >= value->size)
+        return std::monostate {};
+
+    void *slot = Offset(value->data, index * GetSize(value->layout));
+    MarkChildIfSnapshotted(value, value->layout, slot);
+
+    return Load(value->layout, slot);
+}
+
+bool Serpent::ArrayHandle::Set(size_t index, Handle value) {
+    if (index >= this->value->size || this->value->header.IsFrozen() || !Accepts(this->value->header, this->value->layout, value))
+        return false;
+
+    CopyIfSnapshotted(this->value);
+
+    return Store(this->value->header, this->value->layout, Offset(this->value->data, index * GetSize(this->value->layout)), std::move(value));
+}
+
+void Serpent::ArrayHandle::Freeze() {
+    Serpent::Freeze(&value->header);
+}
+
+bool Serpent::ArrayHandle::IsFrozen() const {
+    return value->header.IsFrozen();
+}
+
+Serpent::ArrayHandle Serpent::ArrayHandle::Snapshot() const {
+    if (!value->header.IsFrozen())
+        value->header.flags.fetch_or(GcHeader::Snapshotted, std::memory_order_relaxed);
+
+    return *this;
+}
+
+bool Serpent::ArrayHandle::MakeUnique() {
+    return CopyIfShared(value);
+}
+
+Serpent::Handle Serpent::ArrayHandle::GetUnique(size_t index) {
+    if (index >= value->size)
+        return std::monostate {};
+
+    if (!value->header.IsFrozen())
+        CopyIfSnapshotted(value);
+
+    void *slot = Offset(value->data, index * GetSize(value->layout));
+    if (!value->header.IsFrozen())
+        UnshareSlot(value->layout, slot);
+
+    return Load(value->layout, slot);
+}
+
+Serpent::ArrayValue *SERPENT_NONNULL Serpent::ArrayHandle::IntoRaw() {
+    ArrayValue *raw = value;
+    value = nullptr;
+
+    return raw;
+}
+
+bool Serpent::ArrayHandle::PointerEq(ArrayHandle const &other) const {
+    return value == other.value;
 }
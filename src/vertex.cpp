@@ -0,0 +1,189 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "serpent/layout.hpp"
+#include "serpent/value.hpp"
+#include "serpent/vertex.hpp"
+#include "convert/table.hpp"
+#include "simd/gather.hpp"
+#include "simd/scalar.hpp"
+#include "gc.hpp"
+
+namespace {
+    using namespace Serpent;
+
+    /// Vertices gathered and converted at a time, small enough that the scratch buffers stay in L1
+    constexpr size_t Block = 256;
+
+    size_t AlignUp(size_t offset, size_t align) {
+        return (offset + align - 1) & ~(align - 1);
+    }
+}
+
+Serpent::VertexFormat::VertexFormat(
+    Rc<GcLayout const> layout,
+    RcArray<Attribute> attributes,
+    RcArray<Component> components,
+    RcArray<size_t> strides
+) :
+    layout(layout),
+    attributes(attributes),
+    components(components),
+    strides(strides)
+{}
+
+std::optional<Serpent::VertexFormat> Serpent::VertexFormat::Of(
+    Rc<GcLayout const> const &layout,
+    std::span<VertexAttribute const> requested,
+    VertexStreams streams,
+    size_t stride
+) {
+    auto object = std::get_if<ObjectLayout>(&*layout);
+    if (!object || requested.empty())
+        return std::nullopt;
+
+    std::vector<Attribute> attributes {};
+    std::vector<Component> components {};
+    std::vector<size_t> strides {};
+    size_t offset = 0;
+    size_t align = 1;
+
+    for (size_t i = 0; i < requested.size(); i++) {
+        auto const &attribute = requested[i];
+        auto to = Simd::KindOf(attribute.format);
+        if (!to || attribute.fields.empty() || attribute.fields.size() > 4)
+            return std::nullopt;
+
+        size_t const size = GetSize(attribute.format);
+        size_t const stream = streams == VertexStreams::Interleaved ? 0 : i;
+        if (streams == VertexStreams::Separate)
+            offset = 0;
+
+        offset = AlignUp(offset, size);
+
+        for (size_t j = 0; j < attribute.fields.size(); j++) {
+            auto index = object->IndexOf(InternedString(attribute.fields[j]));
+            if (!index)
+                return std::nullopt;
+
+            auto const &field = object->Fields()[*index];
+            auto from = Simd::KindOf(field.layout.Layout());
+            if (!from)
+                return std::nullopt;
+
+            components.push_back(Component {
+                .source = field.offset,
+                .target = offset + j * size,
+                .stream = stream,
+                .from = uint8_t(*from),
+                .to = uint8_t(*to),
+                .mode = uint8_t(Simd::ModeOf(attribute.options)),
+            });
+        }
+
+        attributes.push_back(Attribute {
+            .stream = stream,
+            .offset = offset,
+            .stride = 0,
+            .components = attribute.fields.size(),
+            .format = attribute.format,
+            .normalized = attribute.options.normalized,
+        });
+
+        offset += size * attribute.fields.size();
+        align = std::max(align, size);
+
+        if (streams == VertexStreams::Separate)
+            strides.push_back(offset);
+    }
+
+    if (streams == VertexStreams::Interleaved) {
+        if (stride == 0)
+            stride = AlignUp(offset, align);
+        else if (stride < offset)
+            return std::nullopt;
+
+        strides.push_back(stride);
+    }
+
+    for (auto &attribute : attributes)
+        attribute.stride = strides[attribute.stream];
+
+    return VertexFormat(
+        layout,
+        RcArray<Attribute>::Create(attributes),
+        RcArray<Component>::Create(components),
+        RcArray<size_t>::Create(strides)
+    );
+}
+
+Serpent::Rc<Serpent::GcLayout const> const &Serpent::VertexFormat::Layout() const {
+    return layout;
+}
+
+Serpent::RcArray<Serpent::VertexFormat::Attribute> const &Serpent::VertexFormat::Attributes() const {
+    return attributes;
+}
+
+size_t Serpent::VertexFormat::Streams() const {
+    return strides.size();
+}
+
+size_t Serpent::VertexFormat::Stride(size_t stream) const {
+    return strides[stream];
+}
+
+bool Serpent::VertexFormat::Export(ArrayHandle const &vertices, std::span<std::span<std::byte> const> streams) const {
+    auto element = std::get_if<Rc<GcLayout const>>(&vertices.Layout());
+    if (!element || !(**element == *layout) || streams.size() < strides.size())
+        return false;
+
+    size_t const length = vertices.Length();
+    for (size_t i = 0; i < strides.size(); i++) {
+        if (streams[i].size() / strides[i] < length)
+            return false;
+    }
+
+    auto [size, align] = std::visit([](auto const &layout) { return std::pair {layout.Size(), layout.Align()}; }, *layout);
+    size_t const dataOffset = GcValue::DataOffset(align);
+    auto elements = static_cast<GcValue *const *>(vertices.Data());
+    auto const &table = Simd::Conversions();
+
+    // Empty elements read their components from here instead
+    std::vector<std::byte> zeros(size);
+
+    std::byte const *sources[Block];
+    alignas(8) std::byte gathered[Block * 8];
+    alignas(8) std::byte converted[Block * 8];
+
+    for (size_t begin = 0; begin < length; begin += Block) {
+        size_t const count = std::min(Block, length - begin);
+
+        for (size_t i = 0; i < count; i++) {
+            auto value = elements[begin + i];
+            sources[i] = value ? reinterpret_cast<std::byte const *>(value) + dataOffset : zeros.data();
+        }
+
+        for (auto const &component : components) {
+            auto from = Simd::ScalarKind(component.from);
+            auto to = Simd::ScalarKind(component.to);
+
+            Simd::Gather(sources, count, component.source, Simd::SizeOf(from), gathered);
+
+            std::byte const *values = gathered;
+            if (from != to) {
+                table.Get(from, to, component.mode)(gathered, converted, count);
+                values = converted;
+            }
+
+            size_t const stride = strides[component.stream];
+            Simd::Scatter(values, count, Simd::SizeOf(to), streams[component.stream].data() + begin * stride + component.target, stride);
+        }
+    }
+
+    return true;
+}
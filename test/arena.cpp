@@ -0,0 +1,100 @@
+// The checks below are asserts, keep them in release builds too
+#undef NDEBUG
+#include <cassert>
+#include <cstdint>
+#include <optional>
+#include "serpent/arena.hpp"
+#include "serpent/deep.hpp"
+#include "serpent/layout.hpp"
+#include "serpent/value.hpp"
+
+namespace {
+    const auto HitLayout = Serpent::ObjectLayout::Of({
+        {"damage", Serpent::IntegralLayout::UInt32},
+        {"source", Serpent::PrimitiveLayout::String},
+    }).value();
+
+    const auto FrameLayout = Serpent::ObjectLayout::Of({
+        {"tick", Serpent::IntegralLayout::UInt64},
+        {"first", HitLayout},
+        {"hits", Serpent::ArrayLayout::Of(HitLayout)},
+        {"settings", HitLayout},
+    }).value();
+
+    Serpent::GcHandle Hit(uint32_t damage) {
+        auto hit = Serpent::GcHandle::Create(HitLayout);
+        hit.Set("damage", damage);
+        hit.Set("source", Serpent::InternedString("turret"));
+
+        return hit;
+    }
+
+    /// A frame whose settings are the given value, and whose other children are created where the frame is
+    Serpent::GcHandle Frame(Serpent::GcHandle const &settings) {
+        auto frame = Serpent::GcHandle::Create(FrameLayout);
+        frame.Set("tick", uint64_t(60));
+        frame.Set("first", Hit(5));
+        frame.Set("settings", settings);
+
+        auto hits = Serpent::ArrayHandle::Create(Serpent::ArrayLayout::Of(HitLayout), 3);
+        hits.Set(0, Hit(1));
+        hits.Set(2, Hit(2));
+        frame.Set("hits", hits);
+
+        return frame;
+    }
+}
+
+/// Values created in a scope can be copied out with Promote before it ends, and values can't reference anything that dies before them
+void TestArenas() {
+    auto settings = Hit(0);
+    auto expected = Frame(settings);
+
+    std::optional<Serpent::GcHandle> promoted {};
+    std::optional<Serpent::ArrayHandle> promotedHits {};
+    {
+        Serpent::ArenaScope scope {256};
+        size_t used = scope.Used();
+
+        auto frame = Frame(settings);
+        assert(scope.Used() > used);
+        assert(Serpent::Equals(frame, expected));
+
+        // Heap values can't reference arena values
+        auto heapless = expected;
+        bool rejected = !heapless.Set("first", Hit(9));
+        assert(rejected && Serpent::Equals(heapless, expected));
+
+        {
+            Serpent::ArenaScope inner {};
+            auto hit = Hit(3);
+            // Nor can outer values reference inner ones, the other way around is fine
+            bool refused = !frame.Set("first", hit);
+            assert(refused);
+
+            auto holder = Serpent::GcHandle::Create(FrameLayout);
+            bool stored = holder.Set("first", std::get<Serpent::GcHandle>(frame.Get("first")));
+            assert(stored);
+        }
+
+        promoted = Serpent::Promote(frame);
+        promotedHits = Serpent::Promote(std::get<Serpent::ArrayHandle>(frame.Get("hits")));
+
+        // Heap values are shared with the original rather than copied
+        auto heap = Serpent::Promote(settings);
+        assert(heap.PointerEq(settings));
+        assert(std::get<Serpent::GcHandle>(promoted->Get("settings")).PointerEq(settings));
+        assert(!promoted->PointerEq(frame));
+    }
+
+    // The promoted values outlive the scope and can be stored anywhere
+    assert(Serpent::Equals(*promoted, expected));
+    assert(Serpent::Equals(*promotedHits, std::get<Serpent::ArrayHandle>(expected.Get("hits"))));
+
+    bool stored = expected.Set("hits", *promotedHits);
+    assert(stored && Serpent::Equals(*promoted, expected));
+
+    // Writes to the promoted copy don't reach anything else
+    bool set = promoted->Set("tick", uint64_t(61));
+    assert(set && std::get<uint64_t>(expected.Get("tick")) == 60);
+}
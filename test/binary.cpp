@@ -0,0 +1,153 @@
+// The checks below are asserts, keep them in release builds too
+#undef NDEBUG
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+#include "serpent/binary.hpp"
+#include "serpent/deep.hpp"
+#include "serpent/layout.hpp"
+#include "serpent/value.hpp"
+
+namespace {
+    const auto TeamLayout = Serpent::EnumLayout::Of({"Red", "Blue"}).value();
+
+    const auto PointLayout = Serpent::ObjectLayout::Of({
+        {"x", Serpent::FloatingLayout::Float32},
+        {"y", Serpent::FloatingLayout::Float32},
+    }).value();
+
+    const auto ShapeLayout = Serpent::VariantLayout::Of({
+        {"Circle", Serpent::FloatingLayout::Float64},
+        {"Label", Serpent::PrimitiveLayout::String},
+        {"Empty", Serpent::PrimitiveLayout::Unit},
+    }).value();
+
+    const auto UnitLayout = Serpent::ObjectLayout::Of({
+        {"id", Serpent::IntegralLayout::UInt64},
+        {"name", Serpent::PrimitiveLayout::String},
+        {"alive", Serpent::IntegralLayout::Bool},
+        {"team", TeamLayout},
+        {"health", Serpent::IntegralLayout::Int16},
+        {"position", PointLayout},
+        {"path", Serpent::ArrayLayout::Of(PointLayout)},
+        {"samples", Serpent::ArrayLayout::Of(Serpent::IntegralLayout::Int32)},
+        {"shape", ShapeLayout},
+        {"target", PointLayout},
+    }).value();
+
+    Serpent::GcHandle Point(float x, float y) {
+        auto point = Serpent::GcHandle::Create(PointLayout);
+        point.Set("x", x);
+        point.Set("y", y);
+
+        return point;
+    }
+
+    Serpent::GcHandle Unit(uint64_t id) {
+        auto unit = Serpent::GcHandle::Create(UnitLayout);
+        unit.Set("id", id);
+        unit.Set("name", Serpent::InternedString("unit " + std::to_string(id)));
+        unit.Set("alive", uint8_t(id % 2));
+        unit.Set("team", uint32_t(id % 2));
+        unit.Set("health", int16_t(-int16_t(id)));
+        unit.Set("position", Point(float(id), 2.5f));
+
+        auto path = Serpent::ArrayHandle::Create(Serpent::ArrayLayout::Of(PointLayout), 3);
+        path.Set(0, Point(1.0f, 2.0f));
+        path.Set(2, Point(3.0f, 4.0f));
+        unit.Set("path", path);
+
+        auto samples = Serpent::ArrayHandle::Create(Serpent::ArrayLayout::Of(Serpent::IntegralLayout::Int32), id);
+        for (size_t i = 0; i < id; i++)
+            samples.Set(i, int32_t(i * i) - 7);
+        unit.Set("samples", samples);
+
+        auto shape = Serpent::GcHandle::Create(ShapeLayout);
+        if (id % 3 == 0)
+            shape.Set("Circle", 0.5 * double(id));
+        else if (id % 3 == 1)
+            shape.Set("Label", Serpent::InternedString("label"));
+        unit.Set("shape", shape);
+
+        // "target" stays empty
+        return unit;
+    }
+}
+
+/// Values of every kind of field encode and decode back to equal values, and malformed input is rejected without being consumed
+void TestBinary() {
+    for (uint64_t id = 0; id < 6; id++) {
+        auto unit = Unit(id);
+
+        std::vector<std::byte> bytes {std::byte(0xee)};
+        size_t written = Serpent::Encode(unit, bytes);
+        assert(written == Serpent::EncodedSize(unit) && written + 1 == bytes.size());
+
+        std::span<std::byte const> input {bytes};
+        input = input.subspan(1);
+        auto decoded = Serpent::Decode(UnitLayout, input);
+        assert(decoded && input.empty());
+        assert(Serpent::Equals(unit, *decoded));
+        assert(std::holds_alternative<std::nullopt_t>(decoded->Get("target")));
+
+        // Every prefix is truncated
+        for (size_t size = 0; size < written; size++) {
+            std::span<std::byte const> truncated {bytes.data() + 1, size};
+            assert(!Serpent::Decode(UnitLayout, truncated));
+            assert(truncated.size() == size);
+        }
+    }
+
+    // Two values back to back decode one at a time
+    {
+        std::vector<std::byte> bytes {};
+        Serpent::Encode(Unit(4), bytes);
+        Serpent::Encode(Unit(5), bytes);
+
+        std::span<std::byte const> input {bytes};
+        auto first = Serpent::Decode(UnitLayout, input);
+        auto second = Serpent::Decode(UnitLayout, input);
+        assert(first && second && input.empty());
+        assert(Serpent::Equals(*first, Unit(4)) && Serpent::Equals(*second, Unit(5)));
+    }
+
+    // Arrays at the root
+    {
+        auto layout = Serpent::ArrayLayout::Of(Serpent::PrimitiveLayout::String);
+        auto names = Serpent::ArrayHandle::Create(layout, 4);
+        names.Set(1, Serpent::InternedString("one"));
+        names.Set(3, Serpent::InternedString("three"));
+
+        std::vector<std::byte> bytes {};
+        Serpent::Encode(names, bytes);
+
+        std::span<std::byte const> input {bytes};
+        auto decoded = Serpent::Decode(layout, input);
+        assert(decoded && input.empty() && Serpent::Equals(names, *decoded));
+    }
+
+    // Bools other than 0 or 1, and enum values without a name
+    {
+        auto flags = Serpent::ObjectLayout::Of({{"on", Serpent::IntegralLayout::Bool}, {"team", TeamLayout}}).value();
+        auto value = Serpent::GcHandle::Create(flags);
+        value.Set("on", uint8_t(1));
+        value.Set("team", uint32_t(1));
+
+        std::vector<std::byte> bytes {};
+        Serpent::Encode(value, bytes);
+        assert(bytes.size() == 5);
+
+        auto bad = bytes;
+        bad[0] = std::byte(2);
+        std::span<std::byte const> input {bad};
+        assert(!Serpent::Decode(flags, input) && input.size() == bad.size());
+
+        bad = bytes;
+        bad[1] = std::byte(2);
+        input = bad;
+        assert(!Serpent::Decode(flags, input) && input.size() == bad.size());
+    }
+}
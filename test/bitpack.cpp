@@ -0,0 +1,107 @@
+// The checks below are asserts, keep them in release builds too
+#undef NDEBUG
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+#include "serpent/binary.hpp"
+#include "serpent/bitpack.hpp"
+#include "serpent/deep.hpp"
+#include "serpent/layout.hpp"
+#include "serpent/value.hpp"
+
+namespace {
+    const auto StanceLayout = Serpent::EnumLayout::Of({"Stand", "Crouch", "Prone"}).value();
+
+    const auto PlayerLayout = Serpent::ObjectLayout::Of({
+        {"id", Serpent::IntegralLayout::UInt32},
+        {"firing", Serpent::IntegralLayout::Bool},
+        {"stance", StanceLayout},
+        {"delta", Serpent::IntegralLayout::Int64},
+        {"yaw", Serpent::FloatingLayout::Float32},
+        {"x", Serpent::FloatingLayout::Float64},
+        {"name", Serpent::PrimitiveLayout::String},
+        {"slots", Serpent::ArrayLayout::Of(Serpent::IntegralLayout::Int8)},
+    }).value();
+
+    Serpent::GcHandle Player(uint32_t id) {
+        auto player = Serpent::GcHandle::Create(PlayerLayout);
+        player.Set("id", id);
+        player.Set("firing", uint8_t(id & 1));
+        player.Set("stance", uint32_t(id % 3));
+        player.Set("delta", -int64_t(id) * 1000);
+        player.Set("yaw", float(id) * 0.75f);
+        player.Set("x", double(id) / 3.0);
+        player.Set("name", Serpent::InternedString("p"));
+
+        auto slots = Serpent::ArrayHandle::Create(Serpent::ArrayLayout::Of(Serpent::IntegralLayout::Int8), id % 4);
+        for (size_t i = 0; i < slots.Length(); i++)
+            slots.Set(i, int8_t(-int8_t(i)));
+        player.Set("slots", slots);
+
+        return player;
+    }
+}
+
+/// Bit-packed values round trip exactly unless quantized, quantized floats land within half a step, and packing beats the binary encoding
+void TestBitpack() {
+    auto exact = Serpent::BitCodec::Of().value();
+
+    for (uint32_t id = 0; id < 9; id++) {
+        auto player = Player(id * 1000);
+
+        std::vector<std::byte> bytes {};
+        size_t written = exact.Encode(player, bytes);
+        assert(written == bytes.size());
+        assert(written < Serpent::EncodedSize(player));
+
+        std::span<std::byte const> input {bytes};
+        auto decoded = exact.Decode(PlayerLayout, input);
+        assert(decoded && input.empty() && Serpent::Equals(player, *decoded));
+
+        for (size_t size = 0; size < written; size++) {
+            std::span<std::byte const> truncated {bytes.data(), size};
+            assert(!exact.Decode(PlayerLayout, truncated) && truncated.size() == size);
+        }
+    }
+
+    // Yaw in [0, 360) over 10 bits, x over 16
+    auto quantized = Serpent::BitCodec::Of({
+        {PlayerLayout, "yaw", 0.0, 360.0, 10},
+        {PlayerLayout, "x", -100.0, 100.0, 16},
+    }).value();
+
+    auto player = Player(7);
+    std::vector<std::byte> exactBytes {};
+    std::vector<std::byte> bytes {};
+    exact.Encode(player, exactBytes);
+    quantized.Encode(player, bytes);
+    assert(bytes.size() < exactBytes.size());
+
+    std::span<std::byte const> input {bytes};
+    auto decoded = quantized.Decode(PlayerLayout, input);
+    assert(decoded && input.empty());
+    assert(std::abs(std::get<float>(decoded->Get("yaw")) - 5.25f) <= 360.0 / 1023 / 2 + 1e-4);
+    assert(std::abs(std::get<double>(decoded->Get("x")) - 7.0 / 3.0) <= 200.0 / 65535 / 2 + 1e-9);
+    assert(std::get<uint32_t>(decoded->Get("id")) == 7);
+
+    // Out of range values clamp, NaN lands on min
+    player.Set("yaw", 1000.0f);
+    player.Set("x", std::numeric_limits<double>::quiet_NaN());
+    bytes.clear();
+    quantized.Encode(player, bytes);
+    input = bytes;
+    decoded = quantized.Decode(PlayerLayout, input);
+    assert(decoded && std::get<float>(decoded->Get("yaw")) == 360.0f && std::get<double>(decoded->Get("x")) == -100.0);
+
+    // Quantizations the codec refuses
+    assert(!Serpent::BitCodec::Of({{PlayerLayout, "id", 0.0, 1.0, 8}}));
+    assert(!Serpent::BitCodec::Of({{PlayerLayout, "missing", 0.0, 1.0, 8}}));
+    assert(!Serpent::BitCodec::Of({{PlayerLayout, "yaw", 1.0, 1.0, 8}}));
+    assert(!Serpent::BitCodec::Of({{PlayerLayout, "yaw", 0.0, 1.0, 0}}));
+    assert(!Serpent::BitCodec::Of({{PlayerLayout, "yaw", 0.0, 1.0, 33}}));
+    assert(!Serpent::BitCodec::Of({{PlayerLayout, "yaw", 0.0, 1.0, 8}, {PlayerLayout, "yaw", 0.0, 2.0, 8}}));
+}
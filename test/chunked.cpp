@@ -0,0 +1,99 @@
+// The checks below are asserts, keep them in release builds too
+#undef NDEBUG
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+#include <vector>
+#include "serpent/binary.hpp"
+#include "serpent/deep.hpp"
+#include "serpent/layout.hpp"
+#include "serpent/pool.hpp"
+#include "serpent/value.hpp"
+
+namespace {
+    const auto ParticleLayout = Serpent::ObjectLayout::Of({
+        {"x", Serpent::FloatingLayout::Float32},
+        {"life", Serpent::IntegralLayout::UInt16},
+        {"emitter", Serpent::PrimitiveLayout::String},
+    }).value();
+
+    const auto ParticlesLayout = Serpent::ArrayLayout::Of(ParticleLayout);
+
+    /// Particles of varying encoded sizes, every fifth slot left empty
+    Serpent::ArrayHandle Particles(size_t length) {
+        auto particles = Serpent::ArrayHandle::Create(ParticlesLayout, length);
+        for (size_t i = 0; i < length; i++) {
+            if (i % 5 == 4)
+                continue;
+
+            auto particle = Serpent::GcHandle::Create(ParticleLayout);
+            particle.Set("x", float(i) * 0.25f);
+            particle.Set("life", uint16_t(i));
+            particle.Set("emitter", Serpent::InternedString(std::string(i % 9, 'e')));
+            particles.Set(i, particle);
+        }
+
+        return particles;
+    }
+}
+
+/// Chunked arrays decode back equal for any chunk length, and chunks that don't add up are rejected
+void TestChunked() {
+    Serpent::ThreadPool pool {4};
+
+    for (size_t length : {0, 1, 1000}) {
+        auto particles = Particles(length);
+
+        for (size_t chunkLength : {0, 1, 7, 1000, 5000}) {
+            std::vector<std::byte> bytes {std::byte(0xee)};
+            size_t written = Serpent::EncodeChunked(particles, bytes, chunkLength, pool);
+            assert(written + 1 == bytes.size());
+
+            std::span<std::byte const> input {bytes};
+            input = input.subspan(1);
+            auto decoded = Serpent::DecodeChunked(ParticlesLayout, input, pool);
+            assert(decoded && input.empty() && Serpent::Equals(*decoded, particles));
+
+            // Truncated anywhere, in the index or a chunk
+            for (size_t size = 0; size < written; size += 1 + size / 4) {
+                std::span<std::byte const> truncated {bytes.data() + 1, size};
+                bool rejected = !Serpent::DecodeChunked(ParticlesLayout, truncated, pool);
+                assert(rejected && truncated.size() == size);
+            }
+        }
+    }
+
+    // Scalar arrays, through the default pool
+    auto values = Serpent::ArrayHandle::Create(Serpent::ArrayLayout::Of(Serpent::IntegralLayout::Int64), 10000);
+    for (size_t i = 0; i < values.Length(); i++)
+        values.Set(i, int64_t(i) * -3);
+
+    std::vector<std::byte> bytes {};
+    Serpent::EncodeChunked(values, bytes, 333);
+    std::span<std::byte const> input {bytes};
+    auto decoded = Serpent::DecodeChunked(Serpent::ArrayLayout::Of(Serpent::IntegralLayout::Int64), input);
+    assert(decoded && input.empty() && Serpent::Equals(*decoded, values));
+
+    // Moving a byte from one chunk's size to the next keeps the total, but the chunks no longer hold whole elements
+    {
+        auto particles = Particles(100);
+        std::vector<std::byte> encoded {};
+        Serpent::EncodeChunked(particles, encoded, 10, pool);
+
+        uint64_t first = 0;
+        uint64_t second = 0;
+        std::memcpy(&first, encoded.data() + 16, sizeof(first));
+        std::memcpy(&second, encoded.data() + 24, sizeof(second));
+        first++;
+        second--;
+        std::memcpy(encoded.data() + 16, &first, sizeof(first));
+        std::memcpy(encoded.data() + 24, &second, sizeof(second));
+
+        std::span<std::byte const> corrupt {encoded};
+        bool rejected = !Serpent::DecodeChunked(ParticlesLayout, corrupt, pool);
+        assert(rejected && corrupt.size() == encoded.size());
+    }
+}
@@ -0,0 +1,105 @@
+// The checks below are asserts, keep them in release builds too
+#undef NDEBUG
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include "serpent/deep.hpp"
+#include "serpent/layout.hpp"
+#include "serpent/value.hpp"
+
+namespace {
+    const auto LeafLayout = Serpent::ObjectLayout::Of({
+        {"weight", Serpent::FloatingLayout::Float64},
+        {"label", Serpent::PrimitiveLayout::String},
+    }).value();
+
+    const auto OtherLeafLayout = Serpent::ObjectLayout::Of({
+        {"weight", Serpent::FloatingLayout::Float64},
+        {"tag", Serpent::PrimitiveLayout::String},
+    }).value();
+
+    const auto TreeLayout = Serpent::ObjectLayout::Of({
+        {"id", Serpent::IntegralLayout::UInt32},
+        {"left", LeafLayout},
+        {"right", LeafLayout},
+        {"leaves", Serpent::ArrayLayout::Of(LeafLayout)},
+    }).value();
+
+    Serpent::GcHandle Leaf(double weight) {
+        auto leaf = Serpent::GcHandle::Create(LeafLayout);
+        leaf.Set("weight", weight);
+        leaf.Set("label", Serpent::InternedString("leaf"));
+
+        return leaf;
+    }
+
+    Serpent::GcHandle Tree() {
+        auto tree = Serpent::GcHandle::Create(TreeLayout);
+        tree.Set("id", uint32_t(3));
+        tree.Set("left", Leaf(1.0));
+
+        auto leaves = Serpent::ArrayHandle::Create(Serpent::ArrayLayout::Of(LeafLayout), 3);
+        leaves.Set(0, Leaf(2.0));
+        leaves.Set(2, Leaf(3.0));
+        tree.Set("leaves", leaves);
+
+        return tree;
+    }
+
+    Serpent::GcHandle Child(Serpent::GcHandle value, char const *key) {
+        return std::get<Serpent::GcHandle>(value.Get(key));
+    }
+}
+
+/// Clones are deep and equal to the original, equality compares trees bitwise, and equal values hash equally
+void TestDeep() {
+    auto tree = Tree();
+    auto clone = Serpent::Clone(tree);
+    assert(!clone.PointerEq(tree) && !Child(clone, "left").PointerEq(Child(tree, "left")));
+    assert(Serpent::Equals(clone, tree) && Serpent::Hash(clone) == Serpent::Hash(tree));
+
+    // Writes to the clone's children don't reach the original
+    Child(clone, "left").Set("weight", 9.0);
+    std::get<Serpent::ArrayHandle>(clone.Get("leaves")).Set(1, Leaf(4.0));
+    assert(!Serpent::Equals(clone, tree) && Serpent::Hash(clone) != Serpent::Hash(tree));
+    assert(std::get<double>(Child(tree, "left").Get("weight")) == 1.0);
+
+    // Children shared within the graph stay shared, and compare equal to separate equal children
+    {
+        auto shared = Tree();
+        shared.Set("right", Child(shared, "left"));
+        auto copy = Serpent::Clone(shared);
+        assert(Child(copy, "left").PointerEq(Child(copy, "right")));
+
+        auto separate = Tree();
+        separate.Set("right", Leaf(1.0));
+        assert(Serpent::Equals(shared, separate) && Serpent::Hash(shared) == Serpent::Hash(separate));
+    }
+
+    // Frozen children are shared rather than copied
+    {
+        auto frozen = Leaf(5.0);
+        frozen.Freeze();
+        auto holder = Tree();
+        holder.Set("right", frozen);
+        assert(Child(Serpent::Clone(holder), "right").PointerEq(frozen));
+    }
+
+    // Floats compare bitwise
+    auto nan = Leaf(std::numeric_limits<double>::quiet_NaN());
+    assert(Serpent::Equals(nan, Serpent::Clone(nan)) && Serpent::Hash(nan) == Serpent::Hash(Serpent::Clone(nan)));
+    assert(!Serpent::Equals(Leaf(0.0), Leaf(-0.0)));
+
+    // Empty fields only equal empty fields, and layouts with the same shape still differ
+    auto empty = Tree();
+    empty.Set("left", std::nullopt);
+    assert(!Serpent::Equals(empty, Tree()) && Serpent::Equals(empty, Serpent::Clone(empty)));
+    assert(!Serpent::Equals(Leaf(1.0), Serpent::GcHandle::Create(OtherLeafLayout)));
+
+    // Arrays at the root
+    auto leaves = std::get<Serpent::ArrayHandle>(tree.Get("leaves"));
+    auto leavesClone = Serpent::Clone(leaves);
+    assert(!leavesClone.PointerEq(leaves));
+    assert(Serpent::Equals(leaves, leavesClone) && Serpent::Hash(leaves) == Serpent::Hash(leavesClone));
+    assert(!Serpent::Equals(leaves, Serpent::ArrayHandle::Create(Serpent::ArrayLayout::Of(LeafLayout), 2)));
+}
@@ -0,0 +1,111 @@
+// The checks below are asserts, keep them in release builds too
+#undef NDEBUG
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "serpent/deep.hpp"
+#include "serpent/delta.hpp"
+#include "serpent/layout.hpp"
+#include "serpent/value.hpp"
+
+namespace {
+    const auto VelocityLayout = Serpent::ObjectLayout::Of({
+        {"dx", Serpent::FloatingLayout::Float32},
+        {"dy", Serpent::FloatingLayout::Float32},
+    }).value();
+
+    // Nine fields, so the mask takes two bytes
+    const auto EntityLayout = Serpent::ObjectLayout::Of({
+        {"id", Serpent::IntegralLayout::UInt32},
+        {"x", Serpent::FloatingLayout::Float64},
+        {"y", Serpent::FloatingLayout::Float64},
+        {"name", Serpent::PrimitiveLayout::String},
+        {"grounded", Serpent::IntegralLayout::Bool},
+        {"velocity", VelocityLayout},
+        {"inventory", Serpent::ArrayLayout::Of(Serpent::IntegralLayout::UInt16)},
+        {"ammo", Serpent::IntegralLayout::Int8},
+        {"score", Serpent::IntegralLayout::Int64},
+    }).value();
+
+    Serpent::GcHandle Entity() {
+        auto entity = Serpent::GcHandle::Create(EntityLayout);
+        entity.Set("id", uint32_t(42));
+        entity.Set("x", 1.0);
+        entity.Set("name", Serpent::InternedString("scout"));
+
+        auto velocity = Serpent::GcHandle::Create(VelocityLayout);
+        velocity.Set("dx", 0.5f);
+        entity.Set("velocity", velocity);
+
+        auto inventory = Serpent::ArrayHandle::Create(Serpent::ArrayLayout::Of(Serpent::IntegralLayout::UInt16), 2);
+        inventory.Set(0, uint16_t(3));
+        entity.Set("inventory", inventory);
+
+        return entity;
+    }
+}
+
+/// Deltas carry only the changed fields, and applying one to the old value gives the new one
+void TestDelta() {
+    auto from = Entity();
+
+    // Nothing changed, only the mask is written
+    {
+        std::vector<std::byte> delta {};
+        auto size = Serpent::EncodeDelta(from, Serpent::Clone(from), delta);
+        assert(size && *size == 2 && delta.size() == 2);
+        assert(delta[0] == std::byte(0) && delta[1] == std::byte(0));
+
+        auto target = Serpent::Clone(from);
+        std::span<std::byte const> input {delta};
+        bool applied = Serpent::ApplyDelta(target, input);
+        assert(applied && input.empty() && Serpent::Equals(target, from));
+    }
+
+    auto to = Serpent::Clone(from);
+    to.Set("y", -2.0);
+    to.Set("score", int64_t(1) << 40);
+    to.Set("name", Serpent::InternedString("captain"));
+    std::get<Serpent::GcHandle>(to.Get("velocity")).Set("dy", 9.0f);
+    to.Set("inventory", std::nullopt);
+
+    std::vector<std::byte> delta {std::byte(0xee)};
+    auto size = Serpent::EncodeDelta(from, to, delta);
+    assert(size && *size + 1 == delta.size());
+    // y, name, velocity and inventory in the first byte, score in the second
+    assert(delta[1] == std::byte(0b01101100) && delta[2] == std::byte(0b1));
+
+    // Unchanged fields in the target are left alone, only the changed ones are written
+    auto target = Serpent::Clone(from);
+    target.Set("id", uint32_t(7));
+    std::span<std::byte const> input {delta};
+    input = input.subspan(1);
+    bool applied = Serpent::ApplyDelta(target, input);
+    assert(applied && input.empty());
+    assert(std::get<uint32_t>(target.Get("id")) == 7);
+    target.Set("id", uint32_t(42));
+    assert(Serpent::Equals(target, to));
+
+    // A truncated delta leaves both the target and the input untouched
+    for (size_t length = 0; length < *size; length++) {
+        auto untouched = Serpent::Clone(from);
+        std::span<std::byte const> truncated {delta.data() + 1, length};
+        bool rejected = !Serpent::ApplyDelta(untouched, truncated);
+        assert(rejected && truncated.size() == length && Serpent::Equals(untouched, from));
+    }
+
+    // Values of different layouts, variants and frozen targets
+    std::vector<std::byte> unused {};
+    assert(!Serpent::EncodeDelta(from, Serpent::GcHandle::Create(VelocityLayout), unused));
+
+    auto variant = Serpent::VariantLayout::Of({{"A", Serpent::IntegralLayout::UInt8}}).value();
+    assert(!Serpent::EncodeDelta(Serpent::GcHandle::Create(variant), Serpent::GcHandle::Create(variant), unused));
+
+    auto frozen = Serpent::Clone(from);
+    frozen.Freeze();
+    input = std::span<std::byte const> {delta}.subspan(1);
+    bool appliedFrozen = Serpent::ApplyDelta(frozen, input);
+    assert(!appliedFrozen && Serpent::Equals(frozen, from));
+}
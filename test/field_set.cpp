@@ -0,0 +1,132 @@
+// The checks below are asserts, keep them in release builds too
+#undef NDEBUG
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include "serpent/deep.hpp"
+#include "serpent/layout.hpp"
+#include "serpent/value.hpp"
+
+namespace {
+    const auto StatsLayout = Serpent::ObjectLayout::Of({
+        {"strength", Serpent::IntegralLayout::UInt8},
+    }).value();
+
+    const auto OtherStatsLayout = Serpent::ObjectLayout::Of({
+        {"agility", Serpent::IntegralLayout::UInt8},
+    }).value();
+
+    const auto HeroLayout = Serpent::ObjectLayout::Of({
+        {"x", Serpent::FloatingLayout::Float32},
+        {"y", Serpent::FloatingLayout::Float32},
+        {"z", Serpent::FloatingLayout::Float32},
+        {"name", Serpent::PrimitiveLayout::String},
+        {"level", Serpent::IntegralLayout::Int64},
+        {"stats", StatsLayout},
+        {"items", Serpent::ArrayLayout::Of(Serpent::IntegralLayout::UInt16)},
+    }).value();
+
+    // The same field names, with stats of another layout
+    const auto ImpostorLayout = Serpent::ObjectLayout::Of({
+        {"x", Serpent::FloatingLayout::Float32},
+        {"y", Serpent::FloatingLayout::Float32},
+        {"z", Serpent::FloatingLayout::Float32},
+        {"name", Serpent::PrimitiveLayout::String},
+        {"level", Serpent::IntegralLayout::Int64},
+        {"stats", OtherStatsLayout},
+        {"items", Serpent::ArrayLayout::Of(Serpent::IntegralLayout::UInt16)},
+    }).value();
+
+    Serpent::GcHandle Hero() {
+        auto hero = Serpent::GcHandle::Create(HeroLayout);
+        hero.Set("x", 1.0f);
+        hero.Set("y", 2.0f);
+        hero.Set("z", 3.0f);
+        hero.Set("name", Serpent::InternedString("Ayla"));
+        hero.Set("level", int64_t(12));
+
+        auto stats = Serpent::GcHandle::Create(StatsLayout);
+        stats.Set("strength", uint8_t(9));
+        hero.Set("stats", stats);
+
+        return hero;
+    }
+
+    /// A buffer aligned for the set
+    struct Buffer {
+        std::byte *data;
+        std::align_val_t align;
+
+        Buffer(Serpent::FieldSet const &set) :
+            data(static_cast<std::byte *>(::operator new(set.Size(), std::align_val_t(set.Align())))),
+            align(std::align_val_t(set.Align()))
+        {}
+
+        ~Buffer() {
+            ::operator delete(data, align);
+        }
+    };
+}
+
+/// GetMany and SetMany move the same values Get and Set would, and keep the references in the buffer counted
+void TestFieldSets() {
+    // The coordinates stay adjacent in the buffer, and the level is aligned for its type
+    auto set = Serpent::FieldSet::Of(HeroLayout, {"x", "y", "z", "name", "level", "stats", "items"}).value();
+    assert(set.Offset(1) == set.Offset(0) + 4 && set.Offset(2) == set.Offset(0) + 8);
+    assert(set.Offset(4) % alignof(int64_t) == 0);
+
+    Buffer buffer {set};
+    {
+        auto hero = Hero();
+        bool got = hero.GetMany(set, buffer.data);
+        assert(got);
+
+        float y = 0.0f;
+        int64_t level = 0;
+        void *items = &level;
+        std::memcpy(&y, buffer.data + set.Offset(1), sizeof(y));
+        std::memcpy(&level, buffer.data + set.Offset(4), sizeof(level));
+        std::memcpy(&items, buffer.data + set.Offset(6), sizeof(items));
+        assert(y == 2.0f && level == 12 && items == nullptr);
+    }
+
+    // The buffer's references keep the name and stats alive after the hero is gone
+    auto copy = Serpent::GcHandle::Create(HeroLayout);
+    bool stored = copy.SetMany(set, buffer.data);
+    set.Release(buffer.data);
+    assert(stored && Serpent::Equals(copy, Hero()));
+
+    // A subset of the fields, in another order
+    auto subset = Serpent::FieldSet::Of(HeroLayout, {"level", "x"}).value();
+    Buffer small {subset};
+    auto hero = Hero();
+    bool moved = hero.GetMany(subset, small.data);
+    hero.Set("x", 5.0f);
+    hero.Set("level", int64_t(0));
+    moved = moved && hero.SetMany(subset, small.data);
+    subset.Release(small.data);
+    assert(moved && std::get<float>(hero.Get("x")) == 1.0f && std::get<int64_t>(hero.Get("level")) == 12);
+
+    // Sets built for another layout, buffers holding children of the wrong layout, and frozen values
+    auto impostorSet = Serpent::FieldSet::Of(ImpostorLayout, {"x", "y", "z", "name", "level", "stats", "items"}).value();
+    bool rejected = !hero.GetMany(impostorSet, buffer.data);
+    assert(rejected);
+
+    auto impostor = Serpent::GcHandle::Create(ImpostorLayout);
+    impostor.Set("stats", Serpent::GcHandle::Create(OtherStatsLayout));
+    bool got = impostor.GetMany(impostorSet, buffer.data);
+    rejected = got && !hero.SetMany(set, buffer.data);
+    impostorSet.Release(buffer.data);
+    assert(rejected && Serpent::Equals(std::get<Serpent::GcHandle>(hero.Get("stats")), std::get<Serpent::GcHandle>(Hero().Get("stats"))));
+
+    auto frozen = Hero();
+    frozen.Freeze();
+    got = Hero().GetMany(set, buffer.data);
+    rejected = got && !frozen.SetMany(set, buffer.data);
+    set.Release(buffer.data);
+    assert(rejected);
+
+    assert(!Serpent::FieldSet::Of(HeroLayout, {"x", "missing"}));
+}
@@ -0,0 +1,95 @@
+// The checks below are asserts, keep them in release builds too
+#undef NDEBUG
+#include <cassert>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include "serpent/arena.hpp"
+#include "serpent/deep.hpp"
+#include "serpent/layout.hpp"
+#include "serpent/value.hpp"
+
+namespace {
+    const auto RuleLayout = Serpent::ObjectLayout::Of({
+        {"cost", Serpent::IntegralLayout::UInt32},
+        {"name", Serpent::PrimitiveLayout::String},
+    }).value();
+
+    const auto ConfigLayout = Serpent::ObjectLayout::Of({
+        {"version", Serpent::IntegralLayout::UInt32},
+        {"default", RuleLayout},
+        {"rules", Serpent::ArrayLayout::Of(RuleLayout)},
+    }).value();
+
+    Serpent::GcHandle Rule(uint32_t cost) {
+        auto rule = Serpent::GcHandle::Create(RuleLayout);
+        rule.Set("cost", cost);
+        rule.Set("name", Serpent::InternedString("rule"));
+
+        return rule;
+    }
+
+    Serpent::GcHandle Config() {
+        auto config = Serpent::GcHandle::Create(ConfigLayout);
+        config.Set("version", uint32_t(2));
+        config.Set("default", Rule(1));
+
+        auto rules = Serpent::ArrayHandle::Create(Serpent::ArrayLayout::Of(RuleLayout), 64);
+        for (size_t i = 0; i < rules.Length(); i++)
+            rules.Set(i, Rule(uint32_t(i)));
+        config.Set("rules", rules);
+
+        return config;
+    }
+}
+
+/// Frozen values and everything they reference reject writes, can be read from many threads at once, and MakeUnique gives back a writable copy
+void TestFreeze() {
+    auto config = Config();
+    config.Freeze();
+
+    auto rule = std::get<Serpent::GcHandle>(config.Get("default"));
+    auto rules = std::get<Serpent::ArrayHandle>(config.Get("rules"));
+    assert(config.IsFrozen() && rule.IsFrozen() && rules.IsFrozen());
+    assert(std::get<Serpent::GcHandle>(rules.Get(5)).IsFrozen());
+
+    // Writes fail anywhere in the graph, and GetUnique hands back the shared child
+    bool rejected = !config.Set("version", uint32_t(3)) && !rule.Set("cost", uint32_t(7)) && !rules.Set(0, std::nullopt);
+    assert(rejected && Serpent::Equals(config, Config()));
+    assert(std::get<Serpent::GcHandle>(config.GetUnique("default")).PointerEq(rule));
+
+    // Readers on several threads copy and drop handles without synchronizing
+    std::vector<std::thread> readers {};
+    std::vector<uint64_t> totals(4);
+    for (size_t t = 0; t < totals.size(); t++) {
+        readers.emplace_back([config, &total = totals[t]] {
+            for (int round = 0; round < 100; round++) {
+                auto shared = std::get<Serpent::ArrayHandle>(Serpent::GcHandle(config).Get("rules"));
+                for (size_t i = 0; i < shared.Length(); i++)
+                    total += std::get<uint32_t>(std::get<Serpent::GcHandle>(shared.Get(i)).Get("cost"));
+            }
+        });
+    }
+    for (auto &reader : readers)
+        reader.join();
+    for (auto total : totals)
+        assert(total == 100 * (63 * 64 / 2));
+
+    // MakeUnique swaps in a writable shallow copy, whose children stay frozen and shared
+    auto copy = config;
+    bool swapped = copy.MakeUnique();
+    assert(swapped && !copy.IsFrozen() && !copy.PointerEq(config));
+    assert(std::get<Serpent::GcHandle>(copy.Get("default")).PointerEq(rule));
+
+    bool set = copy.Set("version", uint32_t(3));
+    assert(set && std::get<uint32_t>(config.Get("version")) == 2);
+
+    // Values inside an ArenaScope stay mutable
+    {
+        Serpent::ArenaScope scope {};
+        auto scratch = Rule(1);
+        scratch.Freeze();
+        set = scratch.Set("cost", uint32_t(2));
+        assert(set && !scratch.IsFrozen());
+    }
+}
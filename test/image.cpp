@@ -0,0 +1,117 @@
+// The checks below are asserts, keep them in release builds too
+#undef NDEBUG
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <string_view>
+#include <vector>
+#include "serpent/image.hpp"
+#include "serpent/layout.hpp"
+#include "serpent/value.hpp"
+
+namespace {
+    const auto ColorLayout = Serpent::EnumLayout::Of({"Red", "Green", "Blue"}, Serpent::IntegralLayout::UInt8).value();
+
+    const auto TileLayout = Serpent::ObjectLayout::Of({
+        {"height", Serpent::FloatingLayout::Float32},
+        {"walkable", Serpent::IntegralLayout::Bool},
+        {"color", ColorLayout},
+    }).value();
+
+    const auto MapLayout = Serpent::ObjectLayout::Of({
+        {"name", Serpent::PrimitiveLayout::String},
+        {"empty", Serpent::PrimitiveLayout::String},
+        {"spawn", TileLayout},
+        {"exit", TileLayout},
+        {"tiles", Serpent::ArrayLayout::Of(TileLayout)},
+        {"seeds", Serpent::ArrayLayout::Of(Serpent::IntegralLayout::Int64)},
+    }).value();
+
+    Serpent::GcHandle Map() {
+        auto spawn = Serpent::GcHandle::Create(TileLayout);
+        spawn.Set("height", 1.5f);
+        spawn.Set("walkable", uint8_t(1));
+        spawn.Set("color", uint8_t(2));
+
+        auto map = Serpent::GcHandle::Create(MapLayout);
+        map.Set("name", Serpent::InternedString("lowlands"));
+        map.Set("spawn", spawn);
+        map.Set("exit", spawn);
+
+        auto tiles = Serpent::ArrayHandle::Create(Serpent::ArrayLayout::Of(TileLayout), 3);
+        tiles.Set(1, spawn);
+        map.Set("tiles", tiles);
+
+        auto seeds = Serpent::ArrayHandle::Create(Serpent::ArrayLayout::Of(Serpent::IntegralLayout::Int64), 100);
+        for (size_t i = 0; i < seeds.Length(); i++)
+            seeds.Set(i, int64_t(i * i) - 50);
+        map.Set("seeds", seeds);
+
+        return map;
+    }
+}
+
+/// Images read back the graph they were written from, sharing included, and records that fail validation read as std::monostate
+void TestImage() {
+    auto bytes = Serpent::WriteImage(Map());
+
+    // Read back through a memory mapped file
+    auto path = std::filesystem::temp_directory_path() / "serpent_test_image.bin";
+    {
+        std::ofstream file {path, std::ios::binary};
+        file.write(reinterpret_cast<char const *>(bytes.data()), std::streamsize(bytes.size()));
+    }
+
+    {
+        auto file = Serpent::MappedFile::Open(path).value();
+        auto image = Serpent::Image::Open(file.Bytes(), MapLayout).value();
+        auto root = std::get<Serpent::ImageObject>(image.Root());
+
+        assert(std::get<std::string_view>(root.Get("name")) == "lowlands" && std::get<std::string_view>(root.Get("empty")).empty());
+
+        auto spawn = std::get<Serpent::ImageObject>(root.Get("spawn"));
+        assert(std::get<float>(spawn.Get("height")) == 1.5f);
+        assert(std::get<uint8_t>(spawn.Get("walkable")) == 1 && std::get<uint8_t>(spawn.Get("color")) == 2);
+        assert(spawn.PointerEq(std::get<Serpent::ImageObject>(root.Get("exit"))));
+
+        auto tiles = std::get<Serpent::ImageArray>(root.Get("tiles"));
+        assert(tiles.Size() == 3 && std::holds_alternative<std::nullopt_t>(tiles.Get(0)));
+        assert(std::get<Serpent::ImageObject>(tiles.Get(1)).PointerEq(spawn));
+
+        auto seeds = std::get<Serpent::ImageArray>(root.Get("seeds"));
+        assert(std::get<int64_t>(seeds.Get(99)) == 99 * 99 - 50);
+        assert(static_cast<int64_t const *>(seeds.Data())[10] == 50);
+        assert(!image.IsCorrupt());
+    }
+    std::filesystem::remove(path);
+
+    // Roots of another layout, truncated images and misaligned bytes
+    assert(!Serpent::Image::Open(bytes, TileLayout));
+    assert(!Serpent::Image::Open(std::span {bytes}.first(bytes.size() - 8), MapLayout));
+    std::vector<std::byte> shifted(bytes.size() + 8);
+    std::copy(bytes.begin(), bytes.end(), shifted.begin() + 1);
+    assert(!Serpent::Image::Open(std::span {shifted}.subspan(1, bytes.size()), MapLayout));
+
+    // A Bool other than 0 or 1 fails the record holding it once it's reached, the rest of the image still reads
+    {
+        auto image = Serpent::Image::Open(bytes, MapLayout).value();
+        auto spawn = std::get<Serpent::ImageObject>(std::get<Serpent::ImageObject>(image.Root()).Get("spawn"));
+        size_t offset = size_t(static_cast<std::byte const *>(spawn.Data()) - bytes.data());
+        size_t walkable = std::get<Serpent::ObjectLayout>(*TileLayout).Fields()[1].offset;
+
+        auto corrupt = bytes;
+        corrupt[offset + walkable] = std::byte(2);
+        auto broken = Serpent::Image::Open(corrupt, MapLayout).value();
+        auto root = std::get<Serpent::ImageObject>(broken.Root());
+        assert(!broken.IsCorrupt());
+
+        assert(std::get<std::string_view>(root.Get("name")) == "lowlands");
+        assert(!broken.IsCorrupt());
+        assert(std::holds_alternative<std::monostate>(root.Get("spawn")) && broken.IsCorrupt());
+        assert(std::holds_alternative<std::monostate>(std::get<Serpent::ImageArray>(root.Get("tiles")).Get(1)));
+    }
+}
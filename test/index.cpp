@@ -0,0 +1,157 @@
+// The checks below are asserts, keep them in release builds too
+#undef NDEBUG
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "serpent/index.hpp"
+#include "serpent/layout.hpp"
+#include "serpent/value.hpp"
+
+namespace {
+    const auto ItemLayout = Serpent::ObjectLayout::Of({
+        {"owner", Serpent::IntegralLayout::UInt32},
+        {"weight", Serpent::FloatingLayout::Float32},
+        {"name", Serpent::PrimitiveLayout::String},
+    }).value();
+
+    Serpent::GcHandle Item(uint32_t owner, float weight) {
+        auto item = Serpent::GcHandle::Create(ItemLayout);
+        item.Set("owner", owner);
+        item.Set("weight", weight);
+        item.Set("name", Serpent::InternedString(owner % 2 ? "sword" : "shield"));
+
+        return item;
+    }
+
+    /// Positions of the elements owned by owner, by scanning the whole array
+    std::vector<size_t> Scan(Serpent::ArrayHandle array, uint32_t owner) {
+        std::vector<size_t> positions {};
+        for (size_t i = 0; i < array.Length(); i++) {
+            auto element = array.Get(i);
+            if (auto item = std::get_if<Serpent::GcHandle>(&element); item && std::get<uint32_t>(item->Get("owner")) == owner)
+                positions.push_back(i);
+        }
+
+        return positions;
+    }
+
+    /// Checks Find and FindAll against a scan for every owner
+    void CheckOwners(Serpent::FieldIndex const &index) {
+        for (uint32_t owner = 0; owner < 6; owner++) {
+            auto expected = Scan(index.Array(), owner);
+
+            std::vector<size_t> found {};
+            auto count = index.FindAll(owner, found);
+            assert(count && *count == expected.size() && found == expected);
+
+            auto first = index.Find(owner);
+            assert(expected.empty() ? !first : first == expected.front());
+        }
+    }
+}
+
+/// Indexes answer lookups the same as scanning the array, through adds, removals and changed keys
+void TestFieldIndex() {
+    auto layout = Serpent::ArrayLayout::Of(ItemLayout);
+
+    for (auto kind : {Serpent::IndexKind::Hash, Serpent::IndexKind::Sorted}) {
+        auto items = Serpent::ArrayHandle::Create(layout, 12);
+        for (size_t i = 0; i < items.Length(); i++) {
+            if (i % 4 != 3)
+                items.Set(i, Item(uint32_t(i % 5), float(i)));
+        }
+
+        auto index = Serpent::FieldIndex::Of(items, "owner", kind).value();
+        assert(index.Kind() == kind && index.Size() == 9 && index.Array().PointerEq(items));
+        CheckOwners(index);
+
+        // Removing elements, including the lowest position of a key
+        bool set = index.Set(0, std::nullopt) && index.Set(5, std::nullopt);
+        assert(set && index.Size() == 7);
+        assert(std::holds_alternative<std::nullopt_t>(items.Get(0)));
+        CheckOwners(index);
+
+        // Removing an empty slot changes nothing
+        set = index.Set(3, std::nullopt);
+        assert(set && index.Size() == 7);
+
+        // Filling empty slots and replacing elements with different keys
+        set = index.Set(3, Item(4, 1.0f)) && index.Set(1, Item(0, 2.0f)) && index.Set(0, Item(0, 3.0f));
+        assert(set && index.Size() == 9);
+        CheckOwners(index);
+
+        // Rejected elements leave the index alone
+        set = index.Set(2, Serpent::GcHandle::Create(Serpent::ObjectLayout::Of({{"owner", Serpent::IntegralLayout::UInt32}}).value()));
+        assert(!set && index.Size() == 9);
+        CheckOwners(index);
+
+        // Keys changed behind the index's back are picked up by Update and Rebuild
+        std::get<Serpent::GcHandle>(items.Get(4)).Set("owner", uint32_t(5));
+        index.Update(4);
+        CheckOwners(index);
+
+        std::get<Serpent::GcHandle>(items.Get(6)).Set("owner", uint32_t(5));
+        std::get<Serpent::GcHandle>(items.Get(8)).Set("owner", uint32_t(5));
+        index.Rebuild();
+        CheckOwners(index);
+
+        // Keys of another type
+        std::vector<size_t> unused {};
+        assert(!index.Find(int32_t(1)) && !index.FindAll(1.0, unused));
+
+        // Only sorted indexes answer ranges, in key order
+        std::vector<size_t> range {};
+        auto count = index.Range(uint32_t(1), uint32_t(3), range);
+        if (kind == Serpent::IndexKind::Hash) {
+            assert(!count);
+            continue;
+        }
+
+        std::vector<size_t> expected {};
+        for (uint32_t owner = 1; owner <= 3; owner++) {
+            auto positions = Scan(items, owner);
+            expected.insert(expected.end(), positions.begin(), positions.end());
+        }
+        assert(count && *count == expected.size() && range == expected);
+    }
+
+    // NaN keys aren't indexed, and sort after everything in ranges
+    {
+        auto items = Serpent::ArrayHandle::Create(layout, 4);
+        items.Set(0, Item(0, 2.0f));
+        items.Set(1, Item(0, std::numeric_limits<float>::quiet_NaN()));
+        items.Set(2, Item(0, -1.0f));
+
+        auto index = Serpent::FieldIndex::Of(items, "weight", Serpent::IndexKind::Sorted).value();
+        assert(index.Size() == 2);
+        assert(!index.Find(std::numeric_limits<float>::quiet_NaN()));
+
+        std::vector<size_t> range {};
+        auto count = index.Range(-std::numeric_limits<float>::infinity(), std::numeric_limits<float>::quiet_NaN(), range);
+        assert(count && range == (std::vector<size_t> {2, 0}));
+    }
+
+    // Strings hash by their interned index and sort by their bytes
+    {
+        auto items = Serpent::ArrayHandle::Create(layout, 3);
+        for (uint32_t i = 0; i < 3; i++)
+            items.Set(i, Item(i, 0.0f));
+
+        for (auto kind : {Serpent::IndexKind::Hash, Serpent::IndexKind::Sorted}) {
+            auto index = Serpent::FieldIndex::Of(items, "name", kind).value();
+
+            std::vector<size_t> swords {};
+            auto count = index.FindAll(Serpent::InternedString("sword"), swords);
+            assert(count && swords == (std::vector<size_t> {1}));
+            assert(index.Find(Serpent::InternedString("shield")) == 0);
+            assert(!index.Find(Serpent::InternedString("bow")));
+        }
+    }
+
+    // Fields that can't be indexed
+    auto items = Serpent::ArrayHandle::Create(layout, 1);
+    assert(!Serpent::FieldIndex::Of(items, "missing"));
+    assert(!Serpent::FieldIndex::Of(Serpent::ArrayHandle::Create(Serpent::ArrayLayout::Of(Serpent::IntegralLayout::UInt8)), "owner"));
+}
@@ -0,0 +1,167 @@
+// The checks below are asserts, keep them in release builds too
+#undef NDEBUG
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include "serpent/deep.hpp"
+#include "serpent/json.hpp"
+#include "serpent/layout.hpp"
+#include "serpent/value.hpp"
+
+namespace {
+    const auto KindLayout = Serpent::EnumLayout::Of({"Walker", "Flyer"}).value();
+
+    const auto StatsLayout = Serpent::ObjectLayout::Of({
+        {"speed", Serpent::FloatingLayout::Float64},
+        {"armor", Serpent::IntegralLayout::UInt8},
+    }).value();
+
+    const auto OrderLayout = Serpent::VariantLayout::Of({
+        {"Move", StatsLayout},
+        {"Hold", Serpent::PrimitiveLayout::Unit},
+    }, "type").value();
+
+    const auto CreatureLayout = Serpent::ObjectLayout::Of({
+        {"name", Serpent::PrimitiveLayout::String},
+        {"level", Serpent::IntegralLayout::Int16},
+        {"tame", Serpent::IntegralLayout::Bool},
+        {"kind", KindLayout},
+        {"weight", Serpent::FloatingLayout::Float32},
+        {"stats", StatsLayout},
+        {"tags", Serpent::ArrayLayout::Of(Serpent::PrimitiveLayout::String)},
+        {"order", OrderLayout},
+    }).value();
+
+    bool Reads(std::string_view json) {
+        return Serpent::ReadJson(CreatureLayout, json).has_value();
+    }
+}
+
+/// JSON is read into every kind of field, and text that isn't JSON or doesn't match the layout is rejected
+void TestJsonRead() {
+    auto creature = Serpent::ReadJson(CreatureLayout, R"( {
+        "name": "Gull é\n",
+        "level": -12,
+        "unknown": [1, {"a": null}, "x"],
+        "tame": true,
+        "kind": "Flyer",
+        "weight": 2.5e-1,
+        "stats": {"speed": 3, "armor": 255},
+        "tags": ["sea", "loud"],
+        "order": {"type": "Move", "value": {"speed": -0.5}}
+    } )");
+    assert(creature);
+    assert(std::get<Serpent::InternedString>(creature->Get("name")) == Serpent::InternedString("Gull \xc3\xa9\n"));
+    assert(std::get<int16_t>(creature->Get("level")) == -12);
+    assert(std::get<uint8_t>(creature->Get("tame")) == 1);
+    assert(std::get<uint32_t>(creature->Get("kind")) == 1);
+    assert(std::get<float>(creature->Get("weight")) == 0.25f);
+
+    auto stats = std::get<Serpent::GcHandle>(creature->Get("stats"));
+    assert(std::get<double>(stats.Get("speed")) == 3.0 && std::get<uint8_t>(stats.Get("armor")) == 255);
+
+    auto tags = std::get<Serpent::ArrayHandle>(creature->Get("tags"));
+    assert(tags.Length() == 2 && std::get<Serpent::InternedString>(tags.Get(1)) == Serpent::InternedString("loud"));
+
+    auto order = std::get<Serpent::GcHandle>(creature->Get("order"));
+    auto move = std::get<Serpent::GcHandle>(order.Get("Move"));
+    assert(std::get<double>(move.Get("speed")) == -0.5 && std::get<uint8_t>(move.Get("armor")) == 0);
+
+    // Missing fields keep their defaults, null empties object fields and reads as NaN for floats
+    auto sparse = Serpent::ReadJson(CreatureLayout, R"({"stats": null, "weight": null, "order": {"type": "Hold"}})");
+    assert(sparse);
+    assert(std::get<int16_t>(sparse->Get("level")) == 0);
+    assert(std::holds_alternative<std::nullopt_t>(sparse->Get("stats")));
+    assert(std::isnan(std::get<float>(sparse->Get("weight"))));
+    assert(!std::holds_alternative<Serpent::GcHandle>(std::get<Serpent::GcHandle>(sparse->Get("order")).Get("Move")));
+
+    // Numbers JSON doesn't allow, or that don't fit the field
+    assert(!Reads(R"({"level": 012})"));
+    assert(!Reads(R"({"level": +1})"));
+    assert(!Reads(R"({"level": 1.5})"));
+    assert(!Reads(R"({"level": 40000})"));
+    assert(!Reads(R"({"weight": .5})"));
+    assert(!Reads(R"({"weight": 1.})"));
+    assert(!Reads(R"({"weight": NaN})"));
+    assert(!Reads(R"({"stats": {"armor": -1}})"));
+    // Underflow reads as zero, overflow doesn't fit
+    assert(Reads(R"({"weight": 1e-999999})"));
+    assert(!Reads(R"({"weight": 1e999999})"));
+
+    // Types, names and structure
+    assert(!Reads(R"({"tame": 1})"));
+    assert(!Reads(R"({"kind": "Swimmer"})"));
+    assert(!Reads(R"({"name": 5})"));
+    assert(!Reads(R"({"order": {"type": "Jump"}})"));
+    assert(!Reads(R"({"name": "unterminated})"));
+    assert(!Reads(R"({"level": 1,})"));
+    assert(!Reads(R"({"level": 1} {})"));
+    assert(!Reads(R"([])"));
+    assert(!Reads(""));
+}
+
+/// Values written as JSON read back equal, including strings that need escaping and non-finite floats
+void TestJsonWrite() {
+    auto creature = Serpent::GcHandle::Create(CreatureLayout);
+    creature.Set("name", Serpent::InternedString("quote \" slash \\ tab \t bell \x07 \xc3\xa9"));
+    creature.Set("level", int16_t(-32768));
+    creature.Set("tame", uint8_t(1));
+    creature.Set("kind", uint32_t(1));
+    creature.Set("weight", 0.1f);
+
+    auto stats = Serpent::GcHandle::Create(StatsLayout);
+    stats.Set("speed", 1e300);
+    stats.Set("armor", uint8_t(7));
+    creature.Set("stats", stats);
+
+    auto tags = Serpent::ArrayHandle::Create(Serpent::ArrayLayout::Of(Serpent::PrimitiveLayout::String), 3);
+    tags.Set(0, Serpent::InternedString(""));
+    tags.Set(2, Serpent::InternedString("last"));
+    creature.Set("tags", tags);
+
+    auto order = Serpent::GcHandle::Create(OrderLayout);
+    order.Set("Move", Serpent::GcHandle::Create(StatsLayout));
+    creature.Set("order", order);
+
+    std::string json {};
+    size_t written = Serpent::WriteJson(creature, json);
+    assert(written == json.size());
+
+    auto read = Serpent::ReadJson(CreatureLayout, json);
+    assert(read && Serpent::Equals(creature, *read));
+
+    // The string form appends, and the sink form writes the same text
+    std::string again = "prefix";
+    Serpent::WriteJson(creature, again);
+    assert(again == "prefix" + json);
+
+    std::string chunks {};
+    size_t sunk = Serpent::WriteJson(creature, Serpent::JsonSink {&chunks, [](void *context, std::string_view chunk) {
+        *static_cast<std::string *>(context) += chunk;
+    }});
+    assert(sunk == json.size() && chunks == json);
+
+    // Non-finite floats are written as null, and read back as NaN
+    stats.Set("speed", std::numeric_limits<double>::infinity());
+    creature.Set("weight", std::numeric_limits<float>::quiet_NaN());
+    json.clear();
+    Serpent::WriteJson(creature, json);
+    assert(json.find("\"weight\":null") != std::string::npos && json.find("\"speed\":null") != std::string::npos);
+
+    read = Serpent::ReadJson(CreatureLayout, json);
+    assert(read && std::isnan(std::get<float>(read->Get("weight"))));
+    assert(std::isnan(std::get<double>(std::get<Serpent::GcHandle>(read->Get("stats")).Get("speed"))));
+
+    // Arrays at the root
+    auto values = Serpent::ArrayHandle::Create(Serpent::ArrayLayout::Of(Serpent::FloatingLayout::Float64), 4);
+    for (size_t i = 0; i < values.Length(); i++)
+        values.Set(i, 1.0 / double(i + 3));
+
+    json.clear();
+    Serpent::WriteJson(values, json);
+    auto array = Serpent::ReadJson(Serpent::ArrayLayout::Of(Serpent::FloatingLayout::Float64), json);
+    assert(array && Serpent::Equals(values, *array));
+}
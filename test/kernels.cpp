@@ -0,0 +1,97 @@
+// The checks below are asserts, keep them in release builds too
+#undef NDEBUG
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include "serpent/kernels.hpp"
+#include "serpent/layout.hpp"
+#include "serpent/value.hpp"
+
+namespace {
+    const auto Int32s = Serpent::ArrayLayout::Of(Serpent::IntegralLayout::Int32);
+    const auto UInt8s = Serpent::ArrayLayout::Of(Serpent::IntegralLayout::UInt8);
+    const auto Float64s = Serpent::ArrayLayout::Of(Serpent::FloatingLayout::Float64);
+
+    Serpent::ArrayHandle Ints(size_t length) {
+        auto array = Serpent::ArrayHandle::Create(Int32s, length);
+        for (size_t i = 0; i < length; i++)
+            array.Set(i, int32_t(i * 37 % 1001) - 500);
+
+        return array;
+    }
+}
+
+/// Bulk kernels give the same results as scalar loops, including the tails that don't fill a vector
+void TestKernels() {
+    for (size_t length : {0, 1, 7, 33, 1000}) {
+        auto ints = Ints(length);
+
+        int64_t sum = 0;
+        int32_t min = INT32_MAX;
+        int32_t max = INT32_MIN;
+        int64_t dot = 0;
+        for (size_t i = 0; i < length; i++) {
+            auto value = std::get<int32_t>(ints.Get(i));
+            sum += value;
+            min = std::min(min, value);
+            max = std::max(max, value);
+            dot += int64_t(value) * value;
+        }
+
+        assert(std::get<int64_t>(Serpent::Sum(ints)) == sum);
+        assert(std::get<int64_t>(Serpent::Dot(ints, Ints(length))) == dot);
+        if (length == 0) {
+            assert(std::holds_alternative<std::monostate>(Serpent::Min(ints)));
+            assert(std::holds_alternative<std::monostate>(Serpent::Max(ints)));
+        } else {
+            assert(std::get<int32_t>(Serpent::Min(ints)) == min && std::get<int32_t>(Serpent::Max(ints)) == max);
+        }
+
+        // Element-wise operations, checked against the original values
+        auto original = Ints(length);
+        bool done = Serpent::Scale(ints, int32_t(3)) && Serpent::Add(ints, int32_t(-7)) && Serpent::Clamp(ints, int32_t(-1000), int32_t(1000));
+        assert(done);
+        for (size_t i = 0; i < length; i++)
+            assert(std::get<int32_t>(ints.Get(i)) == std::clamp(std::get<int32_t>(original.Get(i)) * 3 - 7, -1000, 1000));
+
+        // Unsigned bytes sum without wrapping, but wrap when written
+        auto bytes = Serpent::ArrayHandle::Create(UInt8s, length);
+        done = Serpent::Fill(bytes, uint8_t(200));
+        assert(done && std::get<uint64_t>(Serpent::Sum(bytes)) == 200 * length);
+        done = Serpent::Add(bytes, uint8_t(100));
+        assert(done && std::get<uint64_t>(Serpent::Sum(bytes)) == 44 * length);
+
+        // Floats holding small integers sum exactly in any order
+        auto floats = Serpent::ArrayHandle::Create(Float64s, length);
+        double floatSum = 0.0;
+        for (size_t i = 0; i < length; i++) {
+            floats.Set(i, double(i) * 0.5);
+            floatSum += double(i) * 0.5;
+        }
+        assert(std::get<double>(Serpent::Sum(floats)) == floatSum);
+    }
+
+    // Bool arrays take 0 or 1 and can't be scaled or added to
+    auto flags = Serpent::ArrayHandle::Create(Serpent::ArrayLayout::Of(Serpent::IntegralLayout::Bool), 10);
+    bool filled = Serpent::Fill(flags, uint8_t(1));
+    assert(filled && std::get<uint64_t>(Serpent::Sum(flags)) == 10);
+    bool rejected = !Serpent::Fill(flags, uint8_t(2)) && !Serpent::Clamp(flags, uint8_t(0), uint8_t(2));
+    rejected = rejected && !Serpent::Scale(flags, uint8_t(1)) && !Serpent::Add(flags, uint8_t(0));
+    assert(rejected && std::get<uint64_t>(Serpent::Sum(flags)) == 10);
+
+    // Arguments of the wrong type, arrays that aren't numeric, mismatched and frozen arrays
+    auto ints = Ints(8);
+    rejected = !Serpent::Fill(ints, int64_t(1)) && !Serpent::Scale(ints, 2.0);
+    assert(rejected);
+
+    auto names = Serpent::ArrayHandle::Create(Serpent::ArrayLayout::Of(Serpent::PrimitiveLayout::String), 2);
+    auto kinds = Serpent::ArrayHandle::Create(Serpent::ArrayLayout::Of(Serpent::EnumLayout::Of({"A", "B"}).value()), 2);
+    assert(std::holds_alternative<std::monostate>(Serpent::Sum(names)) && std::holds_alternative<std::monostate>(Serpent::Sum(kinds)));
+    assert(std::holds_alternative<std::monostate>(Serpent::Dot(ints, Ints(9))));
+    assert(std::holds_alternative<std::monostate>(Serpent::Dot(ints, Serpent::ArrayHandle::Create(Float64s, 8))));
+
+    ints.Freeze();
+    rejected = !Serpent::Fill(ints, int32_t(0));
+    assert(rejected && std::get<int32_t>(ints.Get(1)) == 37 - 500);
+}
@@ -0,0 +1,70 @@
+// The checks below are asserts, keep them in release builds too
+#undef NDEBUG
+#include <cassert>
+#include <cstddef>
+#include <vector>
+#include "serpent/layout.hpp"
+
+namespace {
+    std::vector<size_t> Offsets(Serpent::Rc<Serpent::GcLayout const> const &layout) {
+        std::vector<size_t> offsets {};
+        for (auto const &field : std::get<Serpent::ObjectLayout>(*layout).Fields())
+            offsets.push_back(field.offset);
+
+        return offsets;
+    }
+
+    Serpent::ObjectLayout const &Object(Serpent::Rc<Serpent::GcLayout const> const &layout) {
+        return std::get<Serpent::ObjectLayout>(*layout);
+    }
+}
+
+/// Objects under the GPU rules place their fields where a shader reads the matching block members
+void TestGpuLayouts() {
+    auto f32 = Serpent::FloatingLayout::Float32;
+    auto f64 = Serpent::FloatingLayout::Float64;
+
+    // struct { float a; vec3 b; float c; }: b aligns to 16, and c fills the fourth slot of b
+    for (auto rules : {Serpent::LayoutRules::Std140, Serpent::LayoutRules::Std430}) {
+        auto block = Serpent::ObjectLayout::Of({
+            {"a", f32},
+            {"b.x", f32, 3}, {"b.y", f32}, {"b.z", f32},
+            {"c", f32},
+        }, rules).value();
+        assert((Offsets(block) == std::vector<size_t> {0, 16, 20, 24, 28}));
+        assert(Object(block).Size() == 32 && Object(block).Align() == 16);
+    }
+
+    // The scalar rules align vectors like their components
+    auto scalar = Serpent::ObjectLayout::Of({
+        {"a", f32},
+        {"b.x", f32, 3}, {"b.y", f32}, {"b.z", f32},
+        {"c", f32},
+    }, Serpent::LayoutRules::Scalar).value();
+    assert((Offsets(scalar) == std::vector<size_t> {0, 4, 8, 12, 16}));
+    assert(Object(scalar).Size() == 20 && Object(scalar).Align() == 4);
+
+    // vec2 aligns to twice its component, dvec3 to four times
+    auto mixed = Serpent::ObjectLayout::Of({
+        {"a", f32},
+        {"uv.x", f32, 2}, {"uv.y", f32},
+        {"d.x", f64, 3}, {"d.y", f64}, {"d.z", f64},
+    }, Serpent::LayoutRules::Std430).value();
+    assert((Offsets(mixed) == std::vector<size_t> {0, 8, 12, 32, 40, 48}));
+    assert(Object(mixed).Size() == 64 && Object(mixed).Align() == 32);
+
+    // Std140 rounds objects up to 16 bytes, Std430 doesn't
+    auto single140 = Serpent::ObjectLayout::Of({{"a", f32}}, Serpent::LayoutRules::Std140).value();
+    auto single430 = Serpent::ObjectLayout::Of({{"a", f32}}, Serpent::LayoutRules::Std430).value();
+    assert(Object(single140).Size() == 16 && Object(single140).Align() == 16);
+    assert(Object(single430).Size() == 4 && Object(single430).Align() == 4);
+
+    // Fields and vectors the rules don't allow
+    assert(!Serpent::ObjectLayout::Of({{"on", Serpent::IntegralLayout::Bool}}, Serpent::LayoutRules::Std430));
+    assert(!Serpent::ObjectLayout::Of({{"small", Serpent::IntegralLayout::Int16}}, Serpent::LayoutRules::Std140));
+    assert(Serpent::ObjectLayout::Of({{"small", Serpent::IntegralLayout::Int16}}, Serpent::LayoutRules::Scalar));
+    assert(!Serpent::ObjectLayout::Of({{"name", Serpent::PrimitiveLayout::String}}, Serpent::LayoutRules::Scalar));
+    assert(!Serpent::ObjectLayout::Of({{"v.x", f32, 5}, {"v.y", f32}, {"v.z", f32}, {"v.w", f32}, {"v.u", f32}}, Serpent::LayoutRules::Std430));
+    assert(!Serpent::ObjectLayout::Of({{"v.x", f32, 2}, {"v.y", f64}}, Serpent::LayoutRules::Std430));
+    assert(!Serpent::ObjectLayout::Of({{"v.x", f32, 3}, {"v.y", f32}}, Serpent::LayoutRules::Std430));
+}
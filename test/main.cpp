@@ -35,6 +35,30 @@ const auto TestLayout = Serpent::ObjectLayout::Of({
     {"position", Vec3fLayout} // offset 40 size 8
 }).value(); // Size 48 align 8
 
+void TestArenas();
+void TestBiasedCounts();
+void TestBinary();
+void TestBitpack();
+void TestChunked();
+void TestDeep();
+void TestDelta();
+void TestFieldIndex();
+void TestFieldSets();
+void TestFreeze();
+void TestGpuLayouts();
+void TestImage();
+void TestJsonRead();
+void TestJsonWrite();
+void TestKernels();
+void TestQuery();
+void TestRecordQueue();
+void TestSharedRing();
+void TestSnapshots();
+void TestStream();
+void TestThreadPool();
+void TestVertexFormat();
+void TestWire();
+
 void test(std::span<int const> span) {
     for (auto const &value : span) {
         std::println("{}", value);
@@ -61,5 +85,29 @@ int main(int argc, char **argv) {
         test(ia);
     }
 
+    TestArenas();
+    TestBiasedCounts();
+    TestBinary();
+    TestBitpack();
+    TestChunked();
+    TestDeep();
+    TestDelta();
+    TestFieldIndex();
+    TestFieldSets();
+    TestFreeze();
+    TestGpuLayouts();
+    TestImage();
+    TestJsonRead();
+    TestJsonWrite();
+    TestKernels();
+    TestQuery();
+    TestRecordQueue();
+    TestSharedRing();
+    TestSnapshots();
+    TestStream();
+    TestThreadPool();
+    TestVertexFormat();
+    TestWire();
+
     return 0;
 }
@@ -0,0 +1,138 @@
+// The checks below are asserts, keep them in release builds too
+#undef NDEBUG
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "serpent/layout.hpp"
+#include "serpent/pool.hpp"
+#include "serpent/value.hpp"
+
+namespace {
+    const auto BodyLayout = Serpent::ObjectLayout::Of({
+        {"x", Serpent::FloatingLayout::Float32},
+        {"vx", Serpent::FloatingLayout::Float32},
+        {"id", Serpent::IntegralLayout::UInt32},
+    }).value();
+
+    const auto NamedBodyLayout = Serpent::ObjectLayout::Of({
+        {"x", Serpent::FloatingLayout::Float32},
+        {"name", Serpent::PrimitiveLayout::String},
+    }).value();
+
+    /// Mirrors BodyLayout
+    struct Body {
+        float x;
+        float vx;
+        uint32_t id;
+    };
+
+    Serpent::ArrayHandle Ints(size_t length) {
+        auto ints = Serpent::ArrayHandle::Create(Serpent::ArrayLayout::Of(Serpent::IntegralLayout::Int32), length);
+        for (size_t i = 0; i < length; i++)
+            ints.Set(i, int32_t(i) - 5000);
+
+        return ints;
+    }
+}
+
+/// Parallel loops visit every index or element exactly once, and give the same results as running them in order
+void TestThreadPool() {
+    Serpent::ThreadPool pool {4};
+    assert(pool.Concurrency() == 4);
+
+    // Every index once, in ranges no longer than the grain, including from inside another For
+    {
+        std::vector<std::atomic<uint32_t>> visits(10000);
+        std::atomic<bool> shortRanges = true;
+        pool.For(100, 3, [&](size_t begin, size_t end) {
+            shortRanges = shortRanges && end - begin <= 3;
+            for (size_t outer = begin; outer < end; outer++) {
+                pool.For(100, 7, [&](size_t innerBegin, size_t innerEnd) {
+                    shortRanges = shortRanges && innerEnd - innerBegin <= 7;
+                    for (size_t inner = innerBegin; inner < innerEnd; inner++)
+                        visits[outer * 100 + inner]++;
+                });
+            }
+        });
+
+        assert(shortRanges);
+        for (auto &visit : visits)
+            assert(visit == 1);
+    }
+
+    // Scalar arrays, against scalar loops
+    for (size_t length : {0, 1, 15, 16, 17, 10000}) {
+        auto ints = Ints(length);
+        bool ran = pool.ForEach<int32_t>(ints, [](int32_t &value) { value *= 3; });
+        assert(ran);
+
+        int64_t expected = 0;
+        for (size_t i = 0; i < length; i++) {
+            assert(std::get<int32_t>(ints.Get(i)) == (int32_t(i) - 5000) * 3);
+            expected += (int64_t(i) - 5000) * 3;
+        }
+
+        auto sum = pool.Reduce<int32_t>(ints, int64_t(0), [](int64_t total, int32_t value) { return total + value; }, [](int64_t lhs, int64_t rhs) { return lhs + rhs; });
+        assert(sum && *sum == expected);
+
+        auto halves = Serpent::ArrayHandle::Create(Serpent::ArrayLayout::Of(Serpent::FloatingLayout::Float64), length);
+        bool mapped = pool.Map<int32_t, double>(ints, halves, [](int32_t value) { return value / 2.0; });
+        assert(mapped);
+        for (size_t i = 0; i < length; i++)
+            assert(std::get<double>(halves.Get(i)) == std::get<int32_t>(ints.Get(i)) / 2.0);
+    }
+
+    // Objects, through a mirroring struct, skipping empty elements
+    {
+        auto bodies = Serpent::ArrayHandle::Create(Serpent::ArrayLayout::Of(BodyLayout), 1000);
+        for (size_t i = 0; i < bodies.Length(); i++) {
+            if (i % 3 == 0)
+                continue;
+
+            auto body = Serpent::GcHandle::Create(BodyLayout);
+            body.Set("x", float(i));
+            body.Set("vx", 0.5f);
+            body.Set("id", uint32_t(i));
+            bodies.Set(i, body);
+        }
+
+        bool ran = pool.ForEach<Body>(bodies, [](Body &body) { body.x += body.vx; });
+        assert(ran);
+        for (size_t i = 0; i < bodies.Length(); i++) {
+            auto element = bodies.Get(i);
+            if (auto body = std::get_if<Serpent::GcHandle>(&element))
+                assert(std::get<float>(body->Get("x")) == float(i) + 0.5f);
+        }
+
+        auto ids = pool.Reduce<Body>(bodies, uint64_t(0), [](uint64_t total, Body const &body) { return total + body.id; }, [](uint64_t lhs, uint64_t rhs) { return lhs + rhs; });
+        uint64_t expected = 0;
+        for (size_t i = 0; i < bodies.Length(); i++)
+            expected += i % 3 == 0 ? 0 : i;
+        assert(ids && *ids == expected);
+    }
+
+    // Element types that don't match, objects holding references, frozen arrays and mismatched lengths
+    auto ints = Ints(10);
+    bool rejected = !pool.ForEach<int64_t>(ints, [](int64_t &) {}) && !pool.ForEach<uint32_t>(ints, [](uint32_t &) {});
+    rejected = rejected && !pool.Map<int32_t, int32_t>(ints, Ints(11), [](int32_t value) { return value; });
+    assert(rejected);
+
+    // Strings are stored as their interned index
+    struct NamedBody {
+        float x;
+        size_t name;
+    };
+    auto named = Serpent::ArrayHandle::Create(Serpent::ArrayLayout::Of(NamedBodyLayout), 4);
+    named.Set(1, Serpent::GcHandle::Create(NamedBodyLayout));
+    std::atomic<size_t> visited = 0;
+    bool read = pool.ForEach<NamedBody const>(named, [&visited](NamedBody const &) { visited++; });
+    rejected = !pool.ForEach<NamedBody>(named, [](NamedBody &) {});
+    assert(read && visited == 1 && rejected);
+
+    ints.Freeze();
+    rejected = !pool.ForEach<int32_t>(ints, [](int32_t &value) { value = 0; });
+    auto sum = pool.Reduce<int32_t>(ints, int64_t(0), [](int64_t total, int32_t value) { return total + value; }, [](int64_t lhs, int64_t rhs) { return lhs + rhs; });
+    assert(rejected && sum && *sum == 45 - 50000);
+}
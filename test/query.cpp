@@ -0,0 +1,220 @@
+// The checks below are asserts, keep them in release builds too
+#undef NDEBUG
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <span>
+#include <string_view>
+#include <vector>
+#include "serpent/layout.hpp"
+#include "serpent/query.hpp"
+#include "serpent/value.hpp"
+
+namespace {
+    const auto ClassLayout = Serpent::EnumLayout::Of({"Tank", "Healer", "Scout"}).value();
+
+    const auto EntityLayout = Serpent::ObjectLayout::Of({
+        {"name", Serpent::PrimitiveLayout::String},
+        {"health", Serpent::FloatingLayout::Float32},
+        {"team", Serpent::IntegralLayout::UInt8},
+        {"armor", Serpent::IntegralLayout::Int16},
+        {"class", ClassLayout},
+        {"score", Serpent::IntegralLayout::UInt64},
+        {"alive", Serpent::IntegralLayout::Bool},
+        {"x", Serpent::FloatingLayout::Float64},
+    }).value();
+
+    constexpr Serpent::CompareOp Ops[] = {
+        Serpent::CompareOp::Less,
+        Serpent::CompareOp::LessEqual,
+        Serpent::CompareOp::Greater,
+        Serpent::CompareOp::GreaterEqual,
+        Serpent::CompareOp::Equal,
+        Serpent::CompareOp::NotEqual,
+    };
+
+    template<typename T>
+    bool Compare(T lhs, Serpent::CompareOp op, T rhs) {
+        switch (op) {
+            case Serpent::CompareOp::Less: return lhs < rhs;
+            case Serpent::CompareOp::LessEqual: return lhs <= rhs;
+            case Serpent::CompareOp::Greater: return lhs > rhs;
+            case Serpent::CompareOp::GreaterEqual: return lhs >= rhs;
+            case Serpent::CompareOp::Equal: return lhs == rhs;
+            case Serpent::CompareOp::NotEqual: return lhs != rhs;
+        }
+
+        return false;
+    }
+
+    /// Entities with a spread of values, every seventh slot left empty and every thirteenth health NaN
+    Serpent::ArrayHandle Entities(size_t length) {
+        auto entities = Serpent::ArrayHandle::Create(Serpent::ArrayLayout::Of(EntityLayout), length);
+        for (size_t i = 0; i < length; i++) {
+            if (i % 7 == 3)
+                continue;
+
+            uint32_t mixed = uint32_t(i * 2654435761u);
+            auto entity = Serpent::GcHandle::Create(EntityLayout);
+            entity.Set("health", i % 13 == 5 ? std::numeric_limits<float>::quiet_NaN() : float(mixed % 200) - 50.0f);
+            entity.Set("team", uint8_t(mixed >> 8));
+            entity.Set("armor", int16_t(int32_t(mixed >> 4) % 2000 - 1000));
+            entity.Set("class", uint32_t(mixed % 3));
+            entity.Set("score", uint64_t(mixed) << (i % 32));
+            entity.Set("alive", uint8_t(mixed >> 31));
+            entity.Set("x", double(int32_t(mixed)) / 1000.0);
+            entities.Set(i, entity);
+        }
+
+        return entities;
+    }
+
+    /// The positions where the field of a non-empty element compares true against value, by looping over the elements
+    template<typename T>
+    std::vector<size_t> Scalar(Serpent::ArrayHandle entities, std::string_view field, Serpent::CompareOp op, T value) {
+        std::vector<size_t> positions {};
+        for (size_t i = 0; i < entities.Length(); i++) {
+            auto element = entities.Get(i);
+            if (auto entity = std::get_if<Serpent::GcHandle>(&element); entity && Compare(std::get<T>(entity->Get(field)), op, value))
+                positions.push_back(i);
+        }
+
+        return positions;
+    }
+
+    /// Checks a single predicate against the scalar loop for every operator
+    template<typename T>
+    void CheckField(Serpent::ArrayHandle entities, std::string_view field, T value) {
+        for (auto op : Ops) {
+            Serpent::Predicate predicate {field, op, value};
+            auto query = Serpent::Query::Of(EntityLayout, {&predicate, 1}).value();
+
+            std::vector<size_t> positions {};
+            auto count = query.Select(entities, positions);
+            auto expected = Scalar(entities, field, op, value);
+            assert(count && *count == expected.size() && positions == expected);
+
+            Serpent::Selection selection {};
+            bool selected = query.Select(entities, selection);
+            assert(selected && selection.length == entities.Length() && selection.Count() == expected.size());
+            for (size_t i = 0; i < entities.Length(); i++)
+                assert(selection.Contains(i) == std::binary_search(expected.begin(), expected.end(), i));
+        }
+    }
+}
+
+/// Queries select the same elements as comparing each element's fields in a loop, and projections read back what was selected
+void TestQuery() {
+    // Lengths around the block size and the selection's words
+    for (size_t length : {0, 1, 63, 64, 65, 1000}) {
+        auto entities = Entities(length);
+
+        CheckField(entities, "health", 10.0f);
+        CheckField(entities, "health", std::numeric_limits<float>::quiet_NaN());
+        CheckField(entities, "team", uint8_t(128));
+        CheckField(entities, "armor", int16_t(-3));
+        CheckField(entities, "class", uint32_t(1));
+        CheckField(entities, "score", uint64_t(1) << 40);
+        CheckField(entities, "alive", uint8_t(1));
+        CheckField(entities, "x", 0.0);
+
+        // Several predicates must all hold
+        Serpent::Predicate predicates[] = {
+            {"health", Serpent::CompareOp::Less, 100.0f},
+            {"team", Serpent::CompareOp::GreaterEqual, uint8_t(64)},
+            {"class", Serpent::CompareOp::NotEqual, uint32_t(2)},
+        };
+        auto query = Serpent::Query::Of(EntityLayout, predicates).value();
+
+        std::vector<size_t> expected {};
+        for (size_t i = 0; i < entities.Length(); i++) {
+            auto element = entities.Get(i);
+            auto entity = std::get_if<Serpent::GcHandle>(&element);
+            if (entity && std::get<float>(entity->Get("health")) < 100.0f && std::get<uint8_t>(entity->Get("team")) >= 64 && std::get<uint32_t>(entity->Get("class")) != 2)
+                expected.push_back(i);
+        }
+
+        std::vector<size_t> positions {};
+        auto count = query.Select(entities, positions);
+        assert(count && positions == expected);
+
+        // And and Or over single predicate selections give the same positions
+        Serpent::Selection all {};
+        Serpent::Selection any {};
+        for (size_t i = 0; i < std::size(predicates); i++) {
+            auto single = Serpent::Query::Of(EntityLayout, {&predicates[i], 1}).value();
+            Serpent::Selection selection {};
+            single.Select(entities, selection);
+
+            if (i == 0) {
+                all = selection;
+                any = selection;
+            } else {
+                all.And(selection);
+                any.Or(selection);
+            }
+        }
+
+        positions.clear();
+        all.Positions(positions);
+        assert(positions == expected);
+        for (size_t i = 0; i < entities.Length(); i++) {
+            auto element = entities.Get(i);
+            auto entity = std::get_if<Serpent::GcHandle>(&element);
+            bool matches = entity && (std::get<float>(entity->Get("health")) < 100.0f || std::get<uint8_t>(entity->Get("team")) >= 64 || std::get<uint32_t>(entity->Get("class")) != 2);
+            assert(any.Contains(i) == matches);
+        }
+
+        // An empty query selects every element that isn't empty
+        auto everything = Serpent::Query::Of(EntityLayout, {}).value();
+        positions.clear();
+        everything.Select(entities, positions);
+        assert(positions.size() == entities.Length() - (entities.Length() + 3) / 7);
+
+        // Projections copy the selected elements' fields out, in position order
+        std::string_view fields[] = {"armor", "x"};
+        auto projection = Serpent::Projection::Of(EntityLayout, fields).value();
+
+        Serpent::Selection selection {};
+        query.Select(entities, selection);
+        std::vector<int16_t> armor(selection.Count());
+        std::vector<double> x(selection.Count());
+        std::span<std::byte> columns[] = {std::as_writable_bytes(std::span {armor}), std::as_writable_bytes(std::span {x})};
+        bool projected = projection.Project(entities, selection, columns);
+        assert(projected);
+
+        for (size_t i = 0; i < expected.size(); i++) {
+            auto entity = std::get<Serpent::GcHandle>(entities.Get(expected[i]));
+            assert(armor[i] == std::get<int16_t>(entity.Get("armor")));
+            // Compared bit for bit, so NaN reads back as itself
+            double value = std::get<double>(entity.Get("x"));
+            assert(std::memcmp(&x[i], &value, sizeof(double)) == 0);
+        }
+
+        // Columns too small to hold the selection
+        if (selection.Count() > 0) {
+            std::span<std::byte> small[] = {columns[0], columns[1].first(columns[1].size() - 1)};
+            bool rejected = !projection.Project(entities, selection, small);
+            assert(rejected);
+        }
+    }
+
+    // Fields and values a query can't take, and arrays of another layout
+    Serpent::Predicate wrongType {"health", Serpent::CompareOp::Less, 1.0};
+    Serpent::Predicate missing {"mana", Serpent::CompareOp::Less, 1.0f};
+    Serpent::Predicate string {"name", Serpent::CompareOp::Equal, Serpent::InternedString("a")};
+    assert(!Serpent::Query::Of(EntityLayout, {&wrongType, 1}));
+    assert(!Serpent::Query::Of(EntityLayout, {&missing, 1}));
+    assert(!Serpent::Query::Of(EntityLayout, {&string, 1}));
+
+    std::string_view name[] = {"name"};
+    assert(!Serpent::Projection::Of(EntityLayout, name));
+
+    auto query = Serpent::Query::Of(EntityLayout, {}).value();
+    std::vector<size_t> unused {};
+    assert(!query.Select(Serpent::ArrayHandle::Create(Serpent::ArrayLayout::Of(Serpent::IntegralLayout::UInt8), 4), unused));
+}
@@ -0,0 +1,120 @@
+// The checks below are asserts, keep them in release builds too
+#undef NDEBUG
+#include <cassert>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "serpent/layout.hpp"
+#include "serpent/queue.hpp"
+
+namespace {
+    const auto EventLayout = Serpent::ObjectLayout::Of({
+        {"producer", Serpent::IntegralLayout::UInt32},
+        {"amount", Serpent::FloatingLayout::Float32},
+        {"sequence", Serpent::IntegralLayout::UInt64},
+    }).value();
+
+    /// Mirrors EventLayout
+    struct Event final {
+        uint32_t producer;
+        float amount;
+        uint64_t sequence;
+    };
+
+    Event ReadEvent(void const *record) {
+        Event event;
+        std::memcpy(&event, record, sizeof(Event));
+
+        return event;
+    }
+}
+
+/// Records from several producers are drained exactly once, each producer's in the order it pushed them
+void TestRecordQueue() {
+    assert(!Serpent::RecordQueue::Of(EventLayout, 0));
+    assert(!Serpent::RecordQueue::Of(Serpent::ObjectLayout::Of({{"name", Serpent::PrimitiveLayout::String}}).value(), 8));
+
+    auto queue = Serpent::RecordQueue::Of(EventLayout, 100).value();
+    assert(queue.Capacity() == 128);
+    assert(queue.Stride() == sizeof(Event));
+
+    // A record claimed later but published first waits for the one claimed before it
+    {
+        auto first = *queue.Claim();
+        auto second = *queue.Claim();
+        Event event {0, 1.0f, 1};
+        std::memcpy(second.data, &event, sizeof(Event));
+        queue.Publish(second);
+        size_t early = queue.Drain([](void const *) { assert(false); });
+        assert(early == 0);
+
+        event.sequence = 0;
+        std::memcpy(first.data, &event, sizeof(Event));
+        queue.Publish(first);
+
+        uint64_t next = 0;
+        size_t drained = queue.Drain([&next](void const *record) {
+            assert(ReadEvent(record).sequence == next);
+            next++;
+        });
+        assert(drained == 2 && next == 2);
+    }
+
+    constexpr uint32_t Producers = 4;
+    constexpr uint64_t PerProducer = 50000;
+
+    std::vector<std::thread> producers {};
+    for (uint32_t p = 0; p < Producers; p++) {
+        producers.emplace_back([&queue, p]() {
+            for (uint64_t i = 0; i < PerProducer;) {
+                if (queue.Push([p, i](void *record) { Event event {p, 0.5f, i}; std::memcpy(record, &event, sizeof(Event)); }))
+                    i++;
+                else
+                    std::this_thread::yield();
+            }
+        });
+    }
+
+    std::vector<uint64_t> next(Producers, 0);
+    uint64_t total = 0;
+    while (total < Producers * PerProducer) {
+        // Small batches so the consumer keeps racing the producers around the ring
+        size_t drained = queue.Drain([&next](void const *record) {
+            auto event = ReadEvent(record);
+            assert(event.producer < Producers && event.amount == 0.5f);
+            assert(event.sequence == next[event.producer]);
+            next[event.producer]++;
+        }, 37);
+
+        if (drained == 0)
+            std::this_thread::yield();
+
+        total += drained;
+    }
+
+    for (auto &producer : producers)
+        producer.join();
+
+    for (auto count : next)
+        assert(count == PerProducer);
+
+    size_t left = queue.Drain([](void const *) { assert(false); });
+    assert(left == 0);
+
+    // Claimed slots come back with their fields defaulted, and a full queue refuses more
+    for (size_t i = 0; i < queue.Capacity(); i++) {
+        auto slot = *queue.Claim();
+        auto event = ReadEvent(slot.data);
+        assert(event.producer == 0 && event.amount == 0.0f && event.sequence == 0);
+        queue.Publish(slot);
+    }
+    auto full = queue.Claim();
+    assert(!full);
+
+    size_t freed = queue.Drain([](void const *) {});
+    assert(freed == queue.Capacity());
+    if (auto slot = queue.Claim())
+        queue.Publish(*slot);
+    else
+        assert(false);
+}
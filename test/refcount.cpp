@@ -0,0 +1,87 @@
+// The checks below are asserts, keep them in release builds too
+#undef NDEBUG
+#include <cassert>
+#include <thread>
+#include <vector>
+#include "serpent/layout.hpp"
+#include "serpent/refcount.hpp"
+#include "serpent/value.hpp"
+
+namespace {
+    const auto LeafLayout = Serpent::ObjectLayout::Of({
+        {"x", Serpent::IntegralLayout::Int32},
+    }).value();
+
+    const auto NodeLayout = Serpent::ObjectLayout::Of({
+        {"leaf", LeafLayout},
+        {"y", Serpent::IntegralLayout::Int32},
+    }).value();
+}
+
+/// Handles copied and dropped on other threads are merged back into the creating thread's count
+void TestBiasedCounts() {
+    constexpr int Threads = 4;
+    constexpr int Copies = 1000;
+
+    std::vector<Serpent::GcHandle> values {};
+    for (int i = 0; i < 64; i++) {
+        auto node = Serpent::GcHandle::Create(NodeLayout);
+        node.Set("y", int32_t(i));
+        node.Set("leaf", Serpent::GcHandle::Create(LeafLayout));
+        values.push_back(node);
+    }
+
+    std::vector<std::thread> threads {};
+    for (int t = 0; t < Threads; t++) {
+        threads.emplace_back([copies = values]() {
+            for (int i = 0; i < Copies; i++) {
+                for (auto const &value : copies) {
+                    Serpent::GcHandle copy = value;
+                    auto leaf = std::get<Serpent::GcHandle>(copy.Get("leaf"));
+                    assert(std::holds_alternative<int32_t>(leaf.Get("x")));
+                }
+            }
+        });
+    }
+
+    // The owner keeps copying and dropping its own references while the other threads release theirs
+    for (int i = 0; i < Copies; i++) {
+        for (auto const &value : values) {
+            Serpent::GcHandle copy = value;
+            (void)copy;
+        }
+        Serpent::MergeReleased();
+    }
+
+    for (auto &thread : threads)
+        thread.join();
+
+    Serpent::MergeReleased();
+
+    for (int i = 0; i < int(values.size()); i++) {
+        assert(std::get<int32_t>(values[i].Get("y")) == i);
+        // Every other reference has been merged away, so the value is unique and isn't copied
+        bool copied = values[i].MakeUnique();
+        assert(!copied);
+    }
+
+    // Values created by a thread that has since exited, and released from this one
+    std::vector<Serpent::GcHandle> orphans {};
+    std::thread([&orphans]() {
+        for (int i = 0; i < 64; i++) {
+            auto node = Serpent::GcHandle::Create(NodeLayout);
+            node.Set("y", int32_t(i));
+            orphans.push_back(node);
+            orphans.push_back(node);
+        }
+    }).join();
+
+    for (size_t i = 0; i < orphans.size(); i += 2) {
+        assert(orphans[i].PointerEq(orphans[i + 1]));
+        bool copied = orphans[i].MakeUnique();
+        bool copiedAgain = orphans[i + 1].MakeUnique();
+        assert(copied && !copiedAgain);
+        assert(std::get<int32_t>(orphans[i].Get("y")) == int32_t(i / 2));
+    }
+    orphans.clear();
+}
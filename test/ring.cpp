@@ -0,0 +1,151 @@
+// The checks below are asserts, keep them in release builds too
+#undef NDEBUG
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include "serpent/image.hpp"
+#include "serpent/layout.hpp"
+#include "serpent/ring.hpp"
+#include "serpent/value.hpp"
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    const auto MessageLayout = Serpent::ObjectLayout::Of({
+        {"id", Serpent::IntegralLayout::UInt64},
+        {"text", Serpent::PrimitiveLayout::String},
+    }).value();
+
+    constexpr size_t Capacity = 512;
+
+    std::string RingName(std::string_view suffix) {
+#if defined(_WIN32)
+        return "serpent_tests_" + std::string(suffix);
+#else
+        return "serpent_tests_" + std::to_string(getpid()) + "_" + std::string(suffix);
+#endif
+    }
+
+    Serpent::GcHandle Message(uint64_t id) {
+        auto message = Serpent::GcHandle::Create(MessageLayout);
+        message.Set("id", id);
+        // Lengths vary so records land at every offset, and some don't fit before the end of the ring
+        message.Set("text", Serpent::InternedString(std::string(id % 61, char('a' + id % 26))));
+
+        return message;
+    }
+
+    bool IsMessage(Serpent::SharedRing &ring, uint64_t id) {
+        auto image = ring.Front();
+        if (!image)
+            return false;
+
+        auto root = std::get<Serpent::ImageObject>(image->Root());
+        auto text = root.Get("text");
+        std::string expected(id % 61, char('a' + id % 26));
+
+        if (expected.empty())
+            return std::get<uint64_t>(root.Get("id")) == id && std::get<std::string_view>(text).empty();
+
+        return std::get<uint64_t>(root.Get("id")) == id && std::get<std::string_view>(text) == expected;
+    }
+}
+
+/// Records wrap around the end of the ring in order, and damaged framing is reported rather than read
+void TestSharedRing() {
+    auto name = RingName("wrap");
+    Serpent::SharedRing::Unlink(name);
+
+    {
+        // No string table, so every string is written into its record and record sizes follow the text
+        auto ring = Serpent::SharedRing::Create(name, MessageLayout, Capacity, 0);
+        assert(ring);
+        assert(!Serpent::SharedRing::Create(name, MessageLayout, Capacity, 0));
+        assert(!Serpent::SharedRing::Open(name, Serpent::ObjectLayout::Of({{"id", Serpent::IntegralLayout::UInt32}}).value()));
+
+        uint64_t pushed = 0;
+        uint64_t popped = 0;
+        while (popped < 2000) {
+            // Fill the ring as far as it goes, then free part of it so the producer keeps chasing the consumer around
+            while (ring->Push(Message(pushed)))
+                pushed++;
+            assert(pushed > popped);
+
+            for (int i = 0; i < 3 && popped < pushed; i++) {
+                assert(IsMessage(*ring, popped));
+                ring->Pop();
+                popped++;
+            }
+        }
+
+        while (popped < pushed) {
+            assert(IsMessage(*ring, popped));
+            ring->Pop();
+            popped++;
+        }
+
+        assert(!ring->Front());
+        assert(!ring->IsCorrupt());
+
+        auto other = Serpent::ObjectLayout::Of({{"id", Serpent::IntegralLayout::UInt64}}).value();
+        bool pushedOther = ring->Push(Serpent::GcHandle::Create(other));
+        assert(!pushedOther);
+    }
+
+    bool unlinked = Serpent::SharedRing::Unlink(name);
+    assert(unlinked);
+
+#if !defined(_WIN32)
+    // The ring sits at the end of the segment, the first record's size comes first
+    auto corrupt = [](std::string const &name, size_t at, uint64_t value) {
+        int file = shm_open(("/" + name).c_str(), O_RDWR, 0600);
+        assert(file >= 0);
+
+        struct stat info;
+        fstat(file, &info);
+        void *data = mmap(nullptr, size_t(info.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+        close(file);
+        assert(data != MAP_FAILED);
+
+        std::memcpy(static_cast<std::byte *>(data) + size_t(info.st_size) - Capacity + at, &value, sizeof(value));
+        munmap(data, size_t(info.st_size));
+    };
+
+    // A size running past the end of the ring
+    name = RingName("size");
+    Serpent::SharedRing::Unlink(name);
+    {
+        auto ring = Serpent::SharedRing::Create(name, MessageLayout, Capacity, 0);
+        bool pushed = ring->Push(Message(1));
+        assert(pushed);
+
+        corrupt(name, 0, Capacity * 2);
+        assert(!ring->Front());
+        assert(ring->IsCorrupt());
+
+        ring->Pop();
+        assert(!ring->Front());
+    }
+    Serpent::SharedRing::Unlink(name);
+
+    // A record whose image header is damaged
+    name = RingName("image");
+    Serpent::SharedRing::Unlink(name);
+    {
+        auto ring = Serpent::SharedRing::Create(name, MessageLayout, Capacity, 0);
+        bool pushed = ring->Push(Message(1));
+        assert(pushed);
+
+        corrupt(name, sizeof(uint64_t), 0);
+        assert(!ring->Front());
+        assert(ring->IsCorrupt());
+    }
+    Serpent::SharedRing::Unlink(name);
+#endif
+}
@@ -0,0 +1,112 @@
+// The checks below are asserts, keep them in release builds too
+#undef NDEBUG
+#include <cassert>
+#include <cstdint>
+#include "serpent/deep.hpp"
+#include "serpent/layout.hpp"
+#include "serpent/value.hpp"
+
+namespace {
+    const auto PositionLayout = Serpent::ObjectLayout::Of({
+        {"x", Serpent::FloatingLayout::Float32},
+        {"y", Serpent::FloatingLayout::Float32},
+    }).value();
+
+    const auto ActorLayout = Serpent::ObjectLayout::Of({
+        {"hp", Serpent::IntegralLayout::Int32},
+        {"position", PositionLayout},
+        {"scores", Serpent::ArrayLayout::Of(Serpent::IntegralLayout::UInt16)},
+    }).value();
+
+    Serpent::GcHandle Actor() {
+        auto actor = Serpent::GcHandle::Create(ActorLayout);
+        actor.Set("hp", int32_t(100));
+
+        auto position = Serpent::GcHandle::Create(PositionLayout);
+        position.Set("x", 1.0f);
+        actor.Set("position", position);
+
+        auto scores = Serpent::ArrayHandle::Create(Serpent::ArrayLayout::Of(Serpent::IntegralLayout::UInt16), 3);
+        scores.Set(1, uint16_t(7));
+        actor.Set("scores", scores);
+
+        return actor;
+    }
+
+    float X(Serpent::GcHandle actor) {
+        return std::get<float>(std::get<Serpent::GcHandle>(actor.Get("position")).Get("x"));
+    }
+}
+
+/// Snapshots keep seeing values as they were, however the writer changes them afterwards
+void TestSnapshots() {
+    auto writer = Actor();
+    auto snapshot = writer.Snapshot();
+    assert(writer.PointerEq(snapshot));
+
+    // Writing a field swaps the writer's handle for a copy
+    bool set = writer.Set("hp", int32_t(50));
+    assert(set && !writer.PointerEq(snapshot));
+    assert(std::get<int32_t>(writer.Get("hp")) == 50 && std::get<int32_t>(snapshot.Get("hp")) == 100);
+
+    // Children fetched from a value that's still shared copy on write, and leave both parents as they were
+    auto position = std::get<Serpent::GcHandle>(writer.Get("position"));
+    set = position.Set("x", 2.0f);
+    assert(set && std::get<float>(position.Get("x")) == 2.0f);
+    assert(X(writer) == 1.0f && X(snapshot) == 1.0f);
+
+    auto scores = std::get<Serpent::ArrayHandle>(writer.Get("scores"));
+    set = scores.Set(1, uint16_t(8));
+    assert(set && std::get<uint16_t>(scores.Get(1)) == 8);
+    assert(std::get<uint16_t>(std::get<Serpent::ArrayHandle>(snapshot.Get("scores")).Get(1)) == 7);
+
+    // GetUnique unshares the path, so the write lands in the writer's value only
+    set = std::get<Serpent::GcHandle>(writer.GetUnique("position")).Set("x", 3.0f);
+    assert(set && X(writer) == 3.0f && X(snapshot) == 1.0f);
+
+    set = std::get<Serpent::ArrayHandle>(writer.GetUnique("scores")).Set(2, uint16_t(9));
+    assert(set && std::get<uint16_t>(std::get<Serpent::ArrayHandle>(writer.Get("scores")).Get(2)) == 9);
+    assert(std::get<uint16_t>(std::get<Serpent::ArrayHandle>(snapshot.Get("scores")).Get(2)) == 0);
+
+    auto expected = Actor();
+    assert(Serpent::Equals(snapshot, expected));
+
+    // A rejected Set doesn't copy
+    {
+        auto value = Actor();
+        auto copy = value.Snapshot();
+        bool rejected = !value.Set("hp", uint8_t(1)) && !value.Set("missing", int32_t(1));
+        assert(rejected && value.PointerEq(copy));
+    }
+
+    // Once the snapshot is gone, the writer writes in place again
+    {
+        auto value = Actor();
+        void *data = value.Data();
+        {
+            auto copy = value.Snapshot();
+            set = value.Set("hp", int32_t(1));
+            assert(set && value.Data() != data);
+            data = value.Data();
+        }
+        set = value.Set("hp", int32_t(2));
+        assert(set && value.Data() == data);
+    }
+
+    // Values that were never snapshotted are written in place through every handle
+    {
+        auto value = Actor();
+        auto alias = value;
+        set = alias.Set("hp", int32_t(3));
+        assert(set && alias.PointerEq(value) && std::get<int32_t>(value.Get("hp")) == 3);
+    }
+
+    // Arrays at the root
+    {
+        auto array = Serpent::ArrayHandle::Create(Serpent::ArrayLayout::Of(Serpent::IntegralLayout::UInt16), 2);
+        auto copy = array.Snapshot();
+        set = array.Set(0, uint16_t(4));
+        assert(set && !array.PointerEq(copy));
+        assert(std::get<uint16_t>(array.Get(0)) == 4 && std::get<uint16_t>(copy.Get(0)) == 0);
+    }
+}
@@ -0,0 +1,164 @@
+// The checks below are asserts, keep them in release builds too
+#undef NDEBUG
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+#include "serpent/binary.hpp"
+#include "serpent/deep.hpp"
+#include "serpent/layout.hpp"
+#include "serpent/stream.hpp"
+#include "serpent/value.hpp"
+
+namespace {
+    const auto ReadingLayout = Serpent::ObjectLayout::Of({
+        {"celsius", Serpent::FloatingLayout::Float64},
+        {"valid", Serpent::IntegralLayout::Bool},
+    }).value();
+
+    const auto SourceLayout = Serpent::VariantLayout::Of({
+        {"Probe", Serpent::IntegralLayout::UInt16},
+        {"Manual", Serpent::PrimitiveLayout::String},
+    }).value();
+
+    const auto SensorLayout = Serpent::ObjectLayout::Of({
+        {"id", Serpent::IntegralLayout::UInt32},
+        {"label", Serpent::PrimitiveLayout::String},
+        {"last", ReadingLayout},
+        {"history", Serpent::ArrayLayout::Of(ReadingLayout)},
+        {"raw", Serpent::ArrayLayout::Of(Serpent::IntegralLayout::Int16)},
+        {"source", SourceLayout},
+    }).value();
+
+    Serpent::GcHandle Reading(double celsius) {
+        auto reading = Serpent::GcHandle::Create(ReadingLayout);
+        reading.Set("celsius", celsius);
+        reading.Set("valid", uint8_t(celsius > 0));
+
+        return reading;
+    }
+
+    Serpent::GcHandle Sensor(uint32_t id) {
+        auto sensor = Serpent::GcHandle::Create(SensorLayout);
+        sensor.Set("id", id);
+        sensor.Set("label", Serpent::InternedString("sensor " + std::to_string(id)));
+        sensor.Set("last", Reading(double(id) - 1.5));
+
+        auto history = Serpent::ArrayHandle::Create(Serpent::ArrayLayout::Of(ReadingLayout), id % 4);
+        for (size_t i = 0; i < history.Length(); i += 2)
+            history.Set(i, Reading(double(i)));
+        sensor.Set("history", history);
+
+        auto raw = Serpent::ArrayHandle::Create(Serpent::ArrayLayout::Of(Serpent::IntegralLayout::Int16), id * 3);
+        for (size_t i = 0; i < raw.Length(); i++)
+            raw.Set(i, int16_t(int16_t(i) * -100));
+        sensor.Set("raw", raw);
+
+        auto source = Serpent::GcHandle::Create(SourceLayout);
+        if (id % 2)
+            source.Set("Probe", uint16_t(id));
+        else
+            source.Set("Manual", Serpent::InternedString("by hand"));
+        sensor.Set("source", source);
+
+        return sensor;
+    }
+
+    /// Feeds the bytes one at a time, returns the final status and how many bytes were used
+    std::pair<Serpent::StreamStatus, size_t> FeedBytes(Serpent::StreamDecoder &decoder, std::span<std::byte const> bytes) {
+        auto status = Serpent::StreamStatus::NeedMore;
+        size_t used = 0;
+        while (used < bytes.size() && status == Serpent::StreamStatus::NeedMore) {
+            std::span<std::byte const> chunk = bytes.subspan(used, 1);
+            status = decoder.Feed(chunk);
+            used += 1 - chunk.size();
+        }
+
+        return {status, used};
+    }
+}
+
+/// Values fed one byte at a time decode equal to the values encoded, into fresh targets and over earlier values alike,
+/// and malformed or oversized input is caught
+void TestStream() {
+    auto target = Serpent::GcHandle::Create(SensorLayout);
+    auto decoder = Serpent::StreamDecoder::Into(target).value();
+
+    // Each value decodes over the previous one, with arrays of different lengths and variants switching tags
+    for (uint32_t id = 0; id < 6; id++) {
+        auto sensor = Sensor(id);
+        std::vector<std::byte> bytes {};
+        Serpent::Encode(sensor, bytes);
+
+        decoder.Reset();
+        auto [status, used] = FeedBytes(decoder, bytes);
+        assert(status == Serpent::StreamStatus::Done && used == bytes.size());
+        assert(Serpent::Equals(decoder.Target(), sensor));
+    }
+
+    // Done stops right after the value, and keeps returning Done without using input
+    {
+        std::vector<std::byte> bytes {};
+        Serpent::Encode(Sensor(7), bytes);
+        size_t first = bytes.size();
+        Serpent::Encode(Sensor(8), bytes);
+
+        decoder.Reset();
+        std::span<std::byte const> chunk {bytes};
+        auto status = decoder.Feed(chunk);
+        assert(status == Serpent::StreamStatus::Done && chunk.size() == bytes.size() - first);
+        assert(Serpent::Equals(target, Sensor(7)));
+        status = decoder.Feed(chunk);
+        assert(status == Serpent::StreamStatus::Done && chunk.size() == bytes.size() - first);
+
+        decoder.Reset();
+        status = decoder.Feed(chunk);
+        assert(status == Serpent::StreamStatus::Done && chunk.empty());
+        assert(Serpent::Equals(target, Sensor(8)));
+    }
+
+    // A Bool other than 0 or 1
+    {
+        auto reading = Serpent::GcHandle::Create(ReadingLayout);
+        std::vector<std::byte> bytes {};
+        Serpent::Encode(Reading(1.0), bytes);
+        bytes.back() = std::byte(2);
+
+        auto readings = Serpent::StreamDecoder::Into(reading).value();
+        auto [status, used] = FeedBytes(readings, bytes);
+        assert(status == Serpent::StreamStatus::Malformed && used == bytes.size());
+
+        std::span<std::byte const> more {bytes};
+        status = readings.Feed(more);
+        assert(status == Serpent::StreamStatus::Malformed && more.size() == bytes.size());
+    }
+
+    // Strings split across chunks must fit the budget, and arrays the maximum length
+    {
+        auto sensor = Sensor(5);
+        sensor.Set("label", Serpent::InternedString(std::string(100, 'x')));
+        std::vector<std::byte> bytes {};
+        Serpent::Encode(sensor, bytes);
+
+        auto small = Serpent::StreamDecoder::Into(Serpent::GcHandle::Create(SensorLayout), 16).value();
+        auto status = FeedBytes(small, bytes).first;
+        assert(status == Serpent::StreamStatus::OverBudget);
+
+        // Whole in one chunk, the string is never held by the decoder
+        small.Reset();
+        std::span<std::byte const> whole {bytes};
+        status = small.Feed(whole);
+        assert(status == Serpent::StreamStatus::Done && Serpent::Equals(small.Target(), sensor));
+
+        auto shortArrays = Serpent::StreamDecoder::Into(Serpent::GcHandle::Create(SensorLayout), 64 * 1024, 8).value();
+        status = FeedBytes(shortArrays, bytes).first;
+        assert(status == Serpent::StreamStatus::OverBudget);
+    }
+
+    auto frozen = Sensor(1);
+    frozen.Freeze();
+    assert(!Serpent::StreamDecoder::Into(frozen));
+}
@@ -0,0 +1,124 @@
+// The checks below are asserts, keep them in release builds too
+#undef NDEBUG
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <vector>
+#include "serpent/layout.hpp"
+#include "serpent/value.hpp"
+#include "serpent/vertex.hpp"
+
+namespace {
+    const auto VertexLayout = Serpent::ObjectLayout::Of({
+        {"px", Serpent::FloatingLayout::Float32},
+        {"py", Serpent::FloatingLayout::Float32},
+        {"pz", Serpent::FloatingLayout::Float32},
+        {"nx", Serpent::FloatingLayout::Float32},
+        {"ny", Serpent::FloatingLayout::Float32},
+        {"nz", Serpent::FloatingLayout::Float32},
+        {"r", Serpent::IntegralLayout::UInt8},
+        {"g", Serpent::IntegralLayout::UInt8},
+        {"b", Serpent::IntegralLayout::UInt8},
+        {"a", Serpent::IntegralLayout::UInt8},
+        {"u", Serpent::FloatingLayout::Float64},
+        {"v", Serpent::FloatingLayout::Float64},
+        {"name", Serpent::PrimitiveLayout::String},
+    }).value();
+
+    /// Position as is, normals normalized to Int16, colors normalized to Float32 and texture coordinates narrowed to Float32
+    const std::vector<Serpent::VertexAttribute> Attributes {
+        {{"px", "py", "pz"}, Serpent::FloatingLayout::Float32},
+        {{"nx", "ny", "nz"}, Serpent::IntegralLayout::Int16, {.normalized = true}},
+        {{"r", "g", "b", "a"}, Serpent::FloatingLayout::Float32, {.normalized = true}},
+        {{"u", "v"}, Serpent::FloatingLayout::Float32},
+    };
+
+    Serpent::GcHandle Vertex(float x) {
+        auto vertex = Serpent::GcHandle::Create(VertexLayout);
+        vertex.Set("px", x);
+        vertex.Set("py", x + 1.0f);
+        vertex.Set("pz", x + 2.0f);
+        vertex.Set("ny", 1.0f);
+        vertex.Set("nz", -1.0f);
+        vertex.Set("r", uint8_t(255));
+        vertex.Set("a", uint8_t(255));
+        vertex.Set("u", 0.5);
+        vertex.Set("v", 0.25);
+
+        return vertex;
+    }
+
+    template <typename T>
+    T Read(std::vector<std::byte> const &stream, size_t offset) {
+        T value {};
+        std::memcpy(&value, stream.data() + offset, sizeof(T));
+
+        return value;
+    }
+}
+
+/// Vertex formats place attributes the way a vertex input binding expects, and export converted components into them
+void TestVertexFormat() {
+    auto vertices = Serpent::ArrayHandle::Create(Serpent::ArrayLayout::Of(VertexLayout), 3);
+    vertices.Set(0, Vertex(10.0f));
+    vertices.Set(2, Vertex(20.0f));
+
+    // Interleaved: position at 0, normal at 12, color aligned to 20, uv at 36, 44 bytes per vertex
+    auto interleaved = Serpent::VertexFormat::Of(VertexLayout, Attributes).value();
+    assert(interleaved.Streams() == 1 && interleaved.Stride(0) == 44);
+    size_t offsets[] = {0, 12, 20, 36};
+    for (size_t i = 0; i < 4; i++)
+        assert(interleaved.Attributes()[i].offset == offsets[i] && interleaved.Attributes()[i].stride == 44);
+    assert(interleaved.Attributes()[1].normalized && interleaved.Attributes()[2].components == 4);
+
+    std::vector<std::byte> stream(3 * 44, std::byte(0xab));
+    std::span<std::byte> streams[] = {stream};
+    bool exported = interleaved.Export(vertices, streams);
+    assert(exported);
+
+    size_t second = 2 * 44;
+    assert(Read<float>(stream, second) == 20.0f && Read<float>(stream, second + 8) == 22.0f);
+    assert(Read<int16_t>(stream, second + 12) == 0 && Read<int16_t>(stream, second + 14) == 32767 && Read<int16_t>(stream, second + 16) == -32767);
+    assert(Read<float>(stream, second + 20) == 1.0f && Read<float>(stream, second + 24) == 0.0f && Read<float>(stream, second + 32) == 1.0f);
+    assert(Read<float>(stream, second + 36) == 0.5f && Read<float>(stream, second + 40) == 0.25f);
+
+    // Padding after the normal is left alone, and empty elements export as zeros
+    assert(stream[second + 18] == std::byte(0xab) && stream[second + 19] == std::byte(0xab));
+    for (size_t i = 44; i < 88; i++)
+        assert(stream[i] == ((i == 62 || i == 63) ? std::byte(0xab) : std::byte(0)));
+
+    // Separate streams are tightly packed
+    auto separate = Serpent::VertexFormat::Of(VertexLayout, Attributes, Serpent::VertexStreams::Separate).value();
+    assert(separate.Streams() == 4);
+    size_t strides[] = {12, 6, 16, 8};
+    for (size_t i = 0; i < 4; i++)
+        assert(separate.Stride(i) == strides[i] && separate.Attributes()[i].stream == i && separate.Attributes()[i].offset == 0);
+
+    std::vector<std::byte> positions(36), normals(18), colors(48), uvs(24);
+    std::span<std::byte> separateStreams[] = {positions, normals, colors, uvs};
+    exported = separate.Export(vertices, separateStreams);
+    assert(exported);
+    assert(Read<float>(positions, 24) == 20.0f && Read<int16_t>(normals, 16) == -32767 && Read<float>(uvs, 20) == 0.25f);
+
+    // Padded strides, and strides too small for a vertex
+    auto padded = Serpent::VertexFormat::Of(VertexLayout, Attributes, Serpent::VertexStreams::Interleaved, 64).value();
+    assert(padded.Stride(0) == 64);
+    assert(!Serpent::VertexFormat::Of(VertexLayout, Attributes, Serpent::VertexStreams::Interleaved, 40));
+
+    // Streams too small are rejected without writing anything
+    std::vector<std::byte> small(3 * 44 - 1, std::byte(0xab));
+    std::span<std::byte> smallStreams[] = {small};
+    bool rejected = !interleaved.Export(vertices, smallStreams) && !separate.Export(vertices, streams);
+    assert(rejected && small[0] == std::byte(0xab));
+
+    // Attributes that can't be resolved
+    std::vector<Serpent::VertexAttribute> missing {{{"px", "w"}, Serpent::FloatingLayout::Float32}};
+    std::vector<Serpent::VertexAttribute> string {{{"name"}, Serpent::FloatingLayout::Float32}};
+    std::vector<Serpent::VertexAttribute> wide {{{"px", "py", "pz", "nx", "ny"}, Serpent::FloatingLayout::Float32}};
+    std::vector<Serpent::VertexAttribute> format {{{"px"}, Serpent::PrimitiveLayout::String}};
+    assert(!Serpent::VertexFormat::Of(VertexLayout, missing) && !Serpent::VertexFormat::Of(VertexLayout, string));
+    assert(!Serpent::VertexFormat::Of(VertexLayout, wide) && !Serpent::VertexFormat::Of(VertexLayout, format));
+    assert(!Serpent::VertexFormat::Of(VertexLayout, {}));
+}
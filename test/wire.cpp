@@ -0,0 +1,138 @@
+// The checks below are asserts, keep them in release builds too
+#undef NDEBUG
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "serpent/deep.hpp"
+#include "serpent/layout.hpp"
+#include "serpent/schema.hpp"
+#include "serpent/value.hpp"
+
+namespace {
+    const auto ChatLayout = Serpent::ObjectLayout::Of({
+        {"channel", Serpent::PrimitiveLayout::String},
+        {"sender", Serpent::PrimitiveLayout::String},
+        {"sequence", Serpent::IntegralLayout::UInt64},
+        {"mentions", Serpent::ArrayLayout::Of(Serpent::PrimitiveLayout::String)},
+    }).value();
+
+    const auto PingLayout = Serpent::ObjectLayout::Of({
+        {"sent", Serpent::IntegralLayout::Int64},
+    }, Serpent::LayoutRules::Std430).value();
+
+    Serpent::GcHandle Chat(uint64_t sequence) {
+        auto chat = Serpent::GcHandle::Create(ChatLayout);
+        chat.Set("channel", Serpent::InternedString("general"));
+        chat.Set("sender", Serpent::InternedString(sequence % 2 ? "alice" : "bob"));
+        chat.Set("sequence", sequence);
+
+        auto mentions = Serpent::ArrayHandle::Create(Serpent::ArrayLayout::Of(Serpent::PrimitiveLayout::String), 2);
+        mentions.Set(0, Serpent::InternedString("general"));
+        mentions.Set(1, Serpent::InternedString("bob"));
+        chat.Set("mentions", mentions);
+
+        return chat;
+    }
+}
+
+/// Messages decode on the other end of a connection, definitions and repeated strings are only sent once,
+/// and definitions from rejected messages aren't registered
+void TestWire() {
+    // Layout definitions
+    {
+        std::vector<std::byte> definition {};
+        size_t size = Serpent::EncodeLayout(ChatLayout, definition);
+        assert(size == definition.size());
+
+        std::span<std::byte const> input {definition};
+        auto decoded = Serpent::DecodeLayout(input);
+        assert(decoded && input.empty() && *decoded == ChatLayout);
+        assert(Serpent::Fingerprint(*decoded) == Serpent::Fingerprint(ChatLayout));
+        assert(Serpent::Fingerprint(PingLayout) != Serpent::Fingerprint(ChatLayout));
+
+        for (size_t length = 0; length < size; length++) {
+            std::span<std::byte const> truncated {definition.data(), length};
+            assert(!Serpent::DecodeLayout(truncated) && truncated.size() == length);
+        }
+    }
+
+    Serpent::SchemaRegistry registry {};
+    Serpent::WireEncoder encoder {};
+    Serpent::WireDecoder decoder {registry};
+
+    std::vector<size_t> sizes {};
+    std::vector<std::byte> stream {};
+    for (uint64_t i = 0; i < 4; i++) {
+        sizes.push_back(encoder.Encode(Chat(i), stream));
+
+        auto ping = Serpent::GcHandle::Create(PingLayout);
+        ping.Set("sent", int64_t(i));
+        encoder.Encode(ping, stream);
+    }
+
+    // The first message carries the definition and the strings, later ones only refer to them
+    assert(sizes[0] > sizes[1] && sizes[1] > sizes[2] && sizes[2] == sizes[3]);
+
+    std::span<std::byte const> input {stream};
+    for (uint64_t i = 0; i < 4; i++) {
+        auto chat = decoder.Decode(input);
+        assert(chat && Serpent::Equals(*chat, Chat(i)));
+
+        auto ping = decoder.Decode(input);
+        assert(ping && std::get<int64_t>(ping->Get("sent")) == int64_t(i));
+    }
+    assert(input.empty());
+
+    // Decoded values share the registry's canonical layout
+    auto registered = registry.Find(Serpent::Fingerprint(ChatLayout));
+    assert(registered && *registered == ChatLayout);
+
+    // A message whose value is truncated is rejected along with its definition
+    {
+        Serpent::SchemaRegistry fresh {};
+        Serpent::WireEncoder sender {};
+        Serpent::WireDecoder receiver {fresh};
+
+        std::vector<std::byte> message {};
+        sender.Encode(Chat(1), message);
+
+        std::span<std::byte const> truncated {message.data(), message.size() - 1};
+        assert(!receiver.Decode(truncated) && truncated.size() == message.size() - 1);
+        assert(!fresh.Find(Serpent::Fingerprint(ChatLayout)));
+
+        // A corrupted fingerprint doesn't match the definition
+        auto corrupt = message;
+        corrupt[1] ^= std::byte(1);
+        std::span<std::byte const> bad {corrupt};
+        assert(!receiver.Decode(bad));
+
+        std::span<std::byte const> whole {message};
+        auto chat = receiver.Decode(whole);
+        assert(chat && whole.empty() && Serpent::Equals(*chat, Chat(1)));
+        assert(fresh.Find(Serpent::Fingerprint(ChatLayout)));
+    }
+
+    // A connection may only bring so many definitions
+    {
+        Serpent::SchemaRegistry fresh {};
+        Serpent::WireEncoder sender {};
+        Serpent::WireDecoder receiver {fresh, 64 * 1024, 1};
+
+        std::vector<std::byte> messages {};
+        sender.Encode(Chat(1), messages);
+        sender.Encode(Serpent::GcHandle::Create(PingLayout), messages);
+
+        std::span<std::byte const> input {messages};
+        assert(receiver.Decode(input));
+        assert(!receiver.Decode(input) && !input.empty());
+        assert(!fresh.Find(Serpent::Fingerprint(PingLayout)));
+
+        // Layouts the registry already knows don't count
+        bool known = fresh.Register(PingLayout).has_value();
+        assert(known);
+        auto ping = receiver.Decode(input);
+        assert(ping && input.empty());
+    }
+}